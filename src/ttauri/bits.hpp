@@ -6,8 +6,10 @@
 
 #include "exception.hpp"
 #include "assert.hpp"
+#include "endian.hpp"
 #include <span>
 #include <cstddef>
+#include <cstring>
 
 namespace tt {
 
@@ -74,4 +76,118 @@ namespace tt {
     return value;
 } 
 
+/** Read bits from a span of bytes without advancing the index.
+ * Bits are ordered LSB first, see `get_bits()`.
+ *
+ * @param buffer The buffer of bytes to extract bits from.
+ * @param index The index of the bit in the byte span.
+ * @param length the number of bits to return.
+ */
+[[nodiscard]] inline int peek_bits(std::span<std::byte const> buffer, ssize_t index, int length) noexcept
+{
+    return get_bits(buffer, index, length);
+}
+
+/** A reader of bits from a span of bytes.
+ * Bits are ordered LSB first, see `get_bits()`.
+ *
+ * The reader keeps a 64 bit accumulator which is refilled a whole word at a time.
+ * Bounds checking is only done when refilling, after which at least 56 bits can be
+ * read from the accumulator without any further checks.
+ */
+class bit_reader {
+public:
+    /** Create a bit reader.
+     *
+     * @param bytes The bytes to read from.
+     * @param hold Bits that were already read from before the start of `bytes`.
+     * @param hold_size The number of bits in `hold`.
+     */
+    bit_reader(std::span<std::byte const> bytes, uint64_t hold = 0, int hold_size = 0) noexcept :
+        _ptr(bytes.data()), _end(bytes.data() + bytes.size()), _hold(hold), _hold_size(hold_size)
+    {
+        tt_axiom(hold_size >= 0 && hold_size < 64);
+    }
+
+    /** Refill the accumulator.
+     *
+     * @return true if the accumulator holds at least 56 bits; false when fewer
+     *         than 8 bytes remain in the buffer, in which case nothing is read.
+     */
+    [[nodiscard]] bool refill() noexcept
+    {
+        if (_end - _ptr < 8) {
+            return false;
+        }
+
+        uint64_t word;
+        std::memcpy(&word, _ptr, sizeof(word));
+        _hold |= little_to_native(word) << _hold_size;
+        _ptr += (63 - _hold_size) >> 3;
+        _hold_size |= 56;
+        return true;
+    }
+
+    /** The number of bits in the accumulator.
+     */
+    [[nodiscard]] int size() const noexcept
+    {
+        return _hold_size;
+    }
+
+    /** Get the bits in the accumulator without consuming them.
+     * Bits above `size()` have an undefined value.
+     */
+    [[nodiscard]] uint64_t peek() const noexcept
+    {
+        return _hold;
+    }
+
+    /** Consume bits from the accumulator.
+     */
+    void skip(int nr_bits) noexcept
+    {
+        tt_axiom(nr_bits <= _hold_size);
+        _hold >>= nr_bits;
+        _hold_size -= nr_bits;
+    }
+
+    /** Get and consume bits from the accumulator.
+     */
+    [[nodiscard]] int get(int nr_bits) noexcept
+    {
+        ttlet r = static_cast<int>(_hold & ((uint64_t{1} << nr_bits) - 1));
+        skip(nr_bits);
+        return r;
+    }
+
+    /** Return whole unconsumed bytes from the accumulator to the buffer.
+     * After this call less than 8 bits remain in the accumulator, and the
+     * bits above `size()` are zero.
+     *
+     * The `hold` passed to the constructor must have been less than 8 bits, otherwise
+     * bytes from before the start of the buffer would be returned.
+     */
+    void unread() noexcept
+    {
+        ttlet nr_bytes = _hold_size >> 3;
+        _ptr -= nr_bytes;
+        _hold_size &= 7;
+        _hold &= (uint64_t{1} << _hold_size) - 1;
+    }
+
+    /** The bytes that have not been loaded into the accumulator.
+     */
+    [[nodiscard]] std::span<std::byte const> remaining() const noexcept
+    {
+        return {_ptr, _end};
+    }
+
+private:
+    std::byte const *_ptr;
+    std::byte const *_end;
+    uint64_t _hold;
+    int _hold_size;
+};
+
 }
@@ -3,9 +3,49 @@
 
 
 #include "BON8.hpp"
+#include "BON8_view.hpp"
+#include "BON8_writer.hpp"
 
 namespace tt {
+namespace detail {
 
+[[nodiscard]] datum decode_BON8(cbyteptr &ptr, cbyteptr last)
+{
+    ttlet view = BON8_view{std::span<std::byte const>{ptr, narrow_cast<size_t>(last - ptr)}};
+    auto r = static_cast<datum>(view);
+    ptr += view.bytes().size();
+    return r;
+}
 
+} // namespace detail
 
-}
\ No newline at end of file
+[[nodiscard]] datum decode_BON8(std::span<const std::byte> buffer)
+{
+    auto *ptr = buffer.data();
+    auto *last = ptr + buffer.size();
+    return detail::decode_BON8(ptr, last);
+}
+
+[[nodiscard]] datum decode_BON8(bstring const &buffer)
+{
+    auto *ptr = buffer.data();
+    auto *last = ptr + buffer.size();
+    return detail::decode_BON8(ptr, last);
+}
+
+[[nodiscard]] datum decode_BON8(bstring_view buffer)
+{
+    auto *ptr = buffer.data();
+    auto *last = ptr + buffer.size();
+    return detail::decode_BON8(ptr, last);
+}
+
+[[nodiscard]] bstring encode_BON8(datum const &value)
+{
+    auto r = bstring{};
+    auto writer = BON8_writer{std::back_inserter(r)};
+    writer.add(value);
+    return r;
+}
+
+}
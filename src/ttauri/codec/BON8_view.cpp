@@ -0,0 +1,474 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "BON8_view.hpp"
+#include "BON8.hpp"
+#include "../check.hpp"
+#include "../exception.hpp"
+#if TT_X86_64_V2
+#include <emmintrin.h> // SSE2
+#endif
+#include <bit>
+#include <cstring>
+#include <limits>
+
+namespace tt {
+using namespace detail;
+
+/** Find the first byte which is not an ASCII character.
+ *
+ * @return The first byte with the top bit set, or last.
+ */
+[[nodiscard]] static cbyteptr BON8_find_non_ascii_scalar(cbyteptr first, cbyteptr last) noexcept
+{
+    for (; first != last; ++first) {
+        if (static_cast<uint8_t>(*first) > 0x7f) {
+            break;
+        }
+    }
+    return first;
+}
+
+#if TT_X86_64_V2
+[[nodiscard]] static cbyteptr BON8_find_non_ascii_sse(cbyteptr first, cbyteptr last) noexcept
+{
+    for (; last - first >= 16; first += 16) {
+        ttlet chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(first));
+        ttlet non_ascii_mask = static_cast<unsigned int>(_mm_movemask_epi8(chunk));
+        if (non_ascii_mask != 0) {
+            return first + std::countr_zero(non_ascii_mask);
+        }
+    }
+
+    return BON8_find_non_ascii_scalar(first, last);
+}
+#endif
+
+[[nodiscard]] static cbyteptr BON8_find_non_ascii(cbyteptr first, cbyteptr last) noexcept
+{
+#if TT_X86_64_V2
+    return BON8_find_non_ascii_sse(first, last);
+#else
+    return BON8_find_non_ascii_scalar(first, last);
+#endif
+}
+
+/** The number of bytes of a UTF-8-like multi-byte sequence.
+ *
+ * @param ptr Pointer to a start byte between 0xc2 and 0xf7.
+ * @return When positive: the number of bytes in the UTF-8 character.
+ *         When negative: the number of bytes in the integer.
+ * @throw parse_error When the sequence is beyond the end of the buffer.
+ */
+[[nodiscard]] static int BON8_multibyte_count(cbyteptr ptr, cbyteptr last)
+{
+    ttlet c0 = static_cast<uint8_t>(*ptr);
+    ttlet count = c0 <= 0xdf ? 2 : c0 <= 0xef ? 3 : 4;
+
+    tt_parse_check(last - ptr >= count, "Incomplete multi-byte sequence at end of buffer");
+
+    ttlet c1 = static_cast<uint8_t>(*(ptr + 1));
+    return (c1 < 0x80 || c1 > 0xbf) ? -count : count;
+}
+
+/** Check if a value starts with a string.
+ */
+[[nodiscard]] static bool BON8_is_string(cbyteptr ptr, cbyteptr last)
+{
+    ttlet c = static_cast<uint8_t>(*ptr);
+    if (c <= 0x7f || c == BON8_code_eot) {
+        return true;
+    } else if (c >= 0xc2 && c <= 0xf7) {
+        return BON8_multibyte_count(ptr, last) > 0;
+    } else {
+        return false;
+    }
+}
+
+/** Find the end of a string.
+ *
+ * A string ends with an end-of-text, or at the first byte that is not a character.
+ *
+ * @param ptr Pointer to the first byte of the string.
+ * @return The end of the characters, and the start of the next value.
+ */
+[[nodiscard]] static std::pair<cbyteptr, cbyteptr> BON8_string_end(cbyteptr ptr, cbyteptr last)
+{
+    while (true) {
+        ptr = BON8_find_non_ascii(ptr, last);
+        if (ptr == last) {
+            return {ptr, ptr};
+        }
+
+        ttlet c = static_cast<uint8_t>(*ptr);
+        if (c == BON8_code_eot) {
+            return {ptr, ptr + 1};
+        } else if (c >= 0xc2 && c <= 0xf7) {
+            ttlet count = BON8_multibyte_count(ptr, last);
+            if (count < 0) {
+                return {ptr, ptr};
+            }
+            ptr += count;
+        } else {
+            return {ptr, ptr};
+        }
+    }
+}
+
+/** Find the end of a value, including nested arrays and objects.
+ *
+ * @param ptr Pointer to the first byte of the value.
+ * @return Pointer beyond the value.
+ */
+[[nodiscard]] static cbyteptr BON8_skip(cbyteptr ptr, cbyteptr last)
+{
+    auto depth = 0;
+    do {
+        tt_parse_check(ptr != last, "Unexpected end-of-buffer");
+
+        ttlet c = static_cast<uint8_t>(*ptr);
+        if (c <= 0x7f || c == BON8_code_eot) {
+            ptr = BON8_string_end(ptr, last).second;
+
+        } else if (c >= 0xc2 && c <= 0xf7) {
+            ttlet count = BON8_multibyte_count(ptr, last);
+            if (count > 0) {
+                ptr = BON8_string_end(ptr, last).second;
+            } else {
+                ptr -= count;
+            }
+
+        } else if (c <= 0xc1) {
+            // Small integers, special floats, empty containers, null and booleans.
+            ++ptr;
+
+        } else {
+            switch (c) {
+            case BON8_code_int32:
+            case BON8_code_binary32:
+                tt_parse_check(last - ptr >= 5, "Incomplete number at end of buffer");
+                ptr += 5;
+                break;
+
+            case BON8_code_int64:
+            case BON8_code_binary64:
+                tt_parse_check(last - ptr >= 9, "Incomplete number at end of buffer");
+                ptr += 9;
+                break;
+
+            case BON8_code_array:
+            case BON8_code_object:
+                ++depth;
+                ++ptr;
+                break;
+
+            case BON8_code_eoc:
+                tt_parse_check(depth != 0, "Unexpected end-of-container");
+                --depth;
+                ++ptr;
+                break;
+
+            default: tt_no_default();
+            }
+        }
+    } while (depth != 0);
+
+    return ptr;
+}
+
+/** Read a big-endian number of 4 or 8 bytes following the code.
+ */
+[[nodiscard]] static uint64_t BON8_load_big_endian(cbyteptr ptr, cbyteptr last, int count)
+{
+    tt_parse_check(last - ptr > count, "Incomplete number at end of buffer");
+
+    auto u64 = uint64_t{0};
+    for (int i = 1; i <= count; ++i) {
+        u64 <<= 8;
+        u64 |= static_cast<uint8_t>(ptr[i]);
+    }
+    return u64;
+}
+
+/** Decode a UTF-8-like multi-byte integer.
+ *
+ * The top bits of the second byte select between positive integers (0x00-0x7f) and
+ * negative integers (0xc0-0xff); negative integers are stored as `-value - 1`.
+ */
+[[nodiscard]] static long long BON8_decode_multibyte_integer(cbyteptr ptr, int count) noexcept
+{
+    ttlet c0 = static_cast<uint8_t>(ptr[0]);
+    ttlet c1 = static_cast<uint8_t>(ptr[1]);
+    ttlet is_positive = c1 <= 0x7f;
+
+    long long value;
+    switch (count) {
+    case 2: value = c0 - 0xc2; break;
+    case 3: value = c0 & 0x0f; break;
+    default: value = c0 & 0x07;
+    }
+
+    if (is_positive) {
+        value = (value << 7) | c1;
+    } else {
+        value = (value << 6) | (c1 & 0x3f);
+    }
+
+    for (int i = 2; i != count; ++i) {
+        value = (value << 8) | static_cast<uint8_t>(ptr[i]);
+    }
+
+    return is_positive ? value : -value - 1;
+}
+
+datum_type_t BON8_view::type() const
+{
+    tt_parse_check(_ptr != _last, "Unexpected end-of-buffer");
+
+    ttlet c = static_cast<uint8_t>(*_ptr);
+    if (c <= 0x7f || c == BON8_code_eot) {
+        return datum_type_t::String;
+    } else if (c >= 0xc2 && c <= 0xf7) {
+        return BON8_multibyte_count(_ptr, _last) > 0 ? datum_type_t::String : datum_type_t::Integer;
+    } else if (c <= 0xb9) {
+        return datum_type_t::Integer;
+    }
+
+    switch (c) {
+    case BON8_code_float_min_one:
+    case BON8_code_float_zero:
+    case BON8_code_float_one:
+    case BON8_code_binary32:
+    case BON8_code_binary64: return datum_type_t::Float;
+    case BON8_code_array_empty:
+    case BON8_code_array: return datum_type_t::Vector;
+    case BON8_code_object_empty:
+    case BON8_code_object: return datum_type_t::Map;
+    case BON8_code_null: return datum_type_t::Null;
+    case BON8_code_bool_false:
+    case BON8_code_bool_true: return datum_type_t::Boolean;
+    case BON8_code_int32:
+    case BON8_code_int64: return datum_type_t::Integer;
+    case BON8_code_eoc: throw parse_error("Unexpected end-of-container");
+    default: tt_no_default();
+    }
+}
+
+BON8_view::operator bool() const
+{
+    ttlet type_ = type();
+    if (type_ != datum_type_t::Boolean) {
+        throw operation_error("BON8 value of type {} can not be converted to a boolean", to_const_string(type_));
+    }
+    return static_cast<uint8_t>(*_ptr) == BON8_code_bool_true;
+}
+
+BON8_view::operator signed long long() const
+{
+    ttlet type_ = type();
+    if (type_ != datum_type_t::Integer) {
+        throw operation_error("BON8 value of type {} can not be converted to an integer", to_const_string(type_));
+    }
+
+    ttlet c = static_cast<uint8_t>(*_ptr);
+    if (c <= 0xaf) {
+        return c - 0x80;
+    } else if (c <= 0xb9) {
+        return -static_cast<long long>(c - 0xb0) - 1;
+    } else if (c == BON8_code_int32) {
+        return static_cast<int32_t>(static_cast<uint32_t>(BON8_load_big_endian(_ptr, _last, 4)));
+    } else if (c == BON8_code_int64) {
+        return static_cast<int64_t>(BON8_load_big_endian(_ptr, _last, 8));
+    } else {
+        return BON8_decode_multibyte_integer(_ptr, -BON8_multibyte_count(_ptr, _last));
+    }
+}
+
+BON8_view::operator signed int() const
+{
+    ttlet v = static_cast<signed long long>(*this);
+    if (v < std::numeric_limits<signed int>::min() || v > std::numeric_limits<signed int>::max()) {
+        throw operation_error("BON8 integer {} can not be converted to a signed int", v);
+    }
+    return static_cast<signed int>(v);
+}
+
+BON8_view::operator double() const
+{
+    ttlet type_ = type();
+    if (type_ == datum_type_t::Integer) {
+        return static_cast<double>(static_cast<signed long long>(*this));
+    } else if (type_ != datum_type_t::Float) {
+        throw operation_error("BON8 value of type {} can not be converted to a double", to_const_string(type_));
+    }
+
+    switch (static_cast<uint8_t>(*_ptr)) {
+    case BON8_code_float_min_one: return -1.0;
+    case BON8_code_float_zero: return 0.0;
+    case BON8_code_float_one: return 1.0;
+    case BON8_code_binary32: {
+        ttlet u32 = static_cast<uint32_t>(BON8_load_big_endian(_ptr, _last, 4));
+        float f32;
+        std::memcpy(&f32, &u32, sizeof(f32));
+        return f32;
+    }
+    default: {
+        ttlet u64 = BON8_load_big_endian(_ptr, _last, 8);
+        double f64;
+        std::memcpy(&f64, &u64, sizeof(f64));
+        return f64;
+    }
+    }
+}
+
+BON8_view::operator std::string_view() const
+{
+    ttlet type_ = type();
+    if (type_ != datum_type_t::String) {
+        throw operation_error("BON8 value of type {} can not be converted to a string", to_const_string(type_));
+    }
+
+    ttlet string_last = BON8_string_end(_ptr, _last).first;
+    return std::string_view{reinterpret_cast<char const *>(_ptr), narrow_cast<size_t>(string_last - _ptr)};
+}
+
+BON8_view::operator datum() const
+{
+    switch (type()) {
+    case datum_type_t::Null: return datum{datum::null{}};
+    case datum_type_t::Boolean: return datum{static_cast<bool>(*this)};
+    case datum_type_t::Integer: return datum{static_cast<signed long long>(*this)};
+    case datum_type_t::Float: return datum{static_cast<double>(*this)};
+    case datum_type_t::String: return datum{static_cast<std::string_view>(*this)};
+
+    case datum_type_t::Vector: {
+        auto r = datum::vector{};
+        for (auto i = begin(); i != end(); ++i) {
+            r.push_back(static_cast<datum>(*i));
+        }
+        return datum{std::move(r)};
+    }
+
+    case datum_type_t::Map: {
+        auto r = datum::map{};
+        for (auto i = begin(); i != end(); ++i) {
+            r.insert_or_assign(datum{i.key()}, static_cast<datum>(*i));
+        }
+        return datum{std::move(r)};
+    }
+
+    default: tt_no_default();
+    }
+}
+
+std::span<std::byte const> BON8_view::bytes() const
+{
+    ttlet value_last = BON8_skip(_ptr, _last);
+    return {_ptr, narrow_cast<size_t>(value_last - _ptr)};
+}
+
+BON8_view::const_iterator BON8_view::begin() const
+{
+    ttlet type_ = type();
+    if (type_ != datum_type_t::Vector && type_ != datum_type_t::Map) {
+        throw operation_error("BON8 value of type {} is not an array or object", to_const_string(type_));
+    }
+
+    ttlet c = static_cast<uint8_t>(*_ptr);
+    if (c == BON8_code_array_empty || c == BON8_code_object_empty) {
+        return {};
+    }
+    return const_iterator{_ptr + 1, _last, type_ == datum_type_t::Map};
+}
+
+ssize_t BON8_view::size() const
+{
+    ssize_t count = 0;
+    for (auto i = begin(); i != end(); ++i) {
+        ++count;
+    }
+    return count;
+}
+
+std::optional<BON8_view> BON8_view::find(std::string_view key) const
+{
+    ttlet type_ = type();
+    if (type_ != datum_type_t::Map) {
+        throw operation_error("BON8 value of type {} can not be indexed with a key", to_const_string(type_));
+    }
+
+    for (auto i = begin(); i != end(); ++i) {
+        if (i.key() == key) {
+            return *i;
+        }
+    }
+    return {};
+}
+
+bool BON8_view::contains(std::string_view key) const
+{
+    return find(key).has_value();
+}
+
+BON8_view BON8_view::operator[](std::string_view key) const
+{
+    if (auto r = find(key)) {
+        return *r;
+    } else {
+        throw operation_error("Could not find key '{}' in BON8 object", key);
+    }
+}
+
+BON8_view BON8_view::operator[](ssize_t index) const
+{
+    ttlet type_ = type();
+    if (type_ != datum_type_t::Vector) {
+        throw operation_error("BON8 value of type {} can not be indexed with an integer", to_const_string(type_));
+    }
+
+    auto todo = index < 0 ? index + size() : index;
+    if (todo >= 0) {
+        for (auto i = begin(); i != end(); ++i) {
+            if (todo-- == 0) {
+                return *i;
+            }
+        }
+    }
+    throw operation_error("Index {} out of range of BON8 array", index);
+}
+
+BON8_view::const_iterator::const_iterator(cbyteptr ptr, cbyteptr last, bool is_object) :
+    _ptr(ptr), _last(last), _is_object(is_object)
+{
+    load();
+}
+
+void BON8_view::const_iterator::load()
+{
+    tt_parse_check(_ptr != _last, "Incomplete container at end of buffer");
+
+    if (static_cast<uint8_t>(*_ptr) == BON8_code_eoc) {
+        _ptr = nullptr;
+
+    } else if (_is_object) {
+        tt_parse_check(BON8_is_string(_ptr, _last), "Key in object is not a string");
+        ttlet [key_last, value] = BON8_string_end(_ptr, _last);
+        _key = std::string_view{reinterpret_cast<char const *>(_ptr), narrow_cast<size_t>(key_last - _ptr)};
+        _value = value;
+        tt_parse_check(_value != _last, "Missing value of member in object");
+
+    } else {
+        _value = _ptr;
+    }
+}
+
+BON8_view::const_iterator &BON8_view::const_iterator::operator++()
+{
+    tt_axiom(_ptr != nullptr);
+    _ptr = BON8_skip(_value, _last);
+    load();
+    return *this;
+}
+
+} // namespace tt
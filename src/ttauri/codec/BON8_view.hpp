@@ -0,0 +1,282 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "../required.hpp"
+#include "../byte_string.hpp"
+#include "../datum.hpp"
+#include "../resource_view.hpp"
+#include <span>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <iterator>
+
+namespace tt {
+
+/** A view on a BON8 encoded value.
+ *
+ * The view reads the encoded bytes in place; nothing is decoded or allocated until a value
+ * is accessed, and only the bytes up to that value are visited. Strings are returned as a
+ * `std::string_view` into the encoded bytes, since a BON8 string is plain UTF-8.
+ *
+ * Arrays and objects are iterated lazily; for objects the iterator also returns the key
+ * of each member. Finding the n-th element of an array or the member with a key is linear
+ * in the number of bytes that are skipped; use iteration when visiting many members.
+ *
+ * The view does not own the bytes, the buffer or `resource_view` must outlive the view.
+ * Malformed messages are detected when the malformed part is accessed, which throws a `parse_error`.
+ *
+ * Typical usage, on a memory-mapped file:
+ * ```
+ * auto file = file_view{URL{"file:cache.bon8"}};
+ * auto message = BON8_view{file};
+ * auto version = static_cast<long long>(message["version"]);
+ * for (auto i = message["fonts"].begin(); i != message["fonts"].end(); ++i) {
+ *     fonts.emplace_back(i.key(), static_cast<std::string_view>(*i));
+ * }
+ * ```
+ */
+class BON8_view {
+public:
+    class const_iterator;
+    using iterator = const_iterator;
+
+    /** View a BON8 encoded message.
+     *
+     * @param bytes The encoded message, which must outlive the view.
+     */
+    explicit BON8_view(std::span<std::byte const> bytes) noexcept : _ptr(bytes.data()), _last(bytes.data() + bytes.size()) {}
+
+    /** View a BON8 encoded message.
+     *
+     * @param bytes The encoded message, which must outlive the view.
+     */
+    explicit BON8_view(bstring_view bytes) noexcept : _ptr(bytes.data()), _last(bytes.data() + bytes.size()) {}
+
+    /** View a BON8 encoded message in a resource, such as a memory-mapped `file_view`.
+     *
+     * @param view The resource which holds the encoded message, which must outlive this view.
+     */
+    explicit BON8_view(resource_view const &view) noexcept : BON8_view(view.bytes()) {}
+
+    BON8_view(BON8_view const &) noexcept = default;
+    BON8_view(BON8_view &&) noexcept = default;
+    BON8_view &operator=(BON8_view const &) noexcept = default;
+    BON8_view &operator=(BON8_view &&) noexcept = default;
+
+    /** The type of the value.
+     * The types are the same as that of the `datum` which `decode_BON8()` would return.
+     *
+     * @throw parse_error
+     */
+    [[nodiscard]] datum_type_t type() const;
+
+    [[nodiscard]] bool is_null() const
+    {
+        return type() == datum_type_t::Null;
+    }
+
+    [[nodiscard]] bool is_bool() const
+    {
+        return type() == datum_type_t::Boolean;
+    }
+
+    [[nodiscard]] bool is_integer() const
+    {
+        return type() == datum_type_t::Integer;
+    }
+
+    [[nodiscard]] bool is_float() const
+    {
+        return type() == datum_type_t::Float;
+    }
+
+    [[nodiscard]] bool is_string() const
+    {
+        return type() == datum_type_t::String;
+    }
+
+    [[nodiscard]] bool is_vector() const
+    {
+        return type() == datum_type_t::Vector;
+    }
+
+    [[nodiscard]] bool is_map() const
+    {
+        return type() == datum_type_t::Map;
+    }
+
+    /** Get a boolean.
+     * @throw parse_error, operation_error when the value is not a boolean.
+     */
+    explicit operator bool() const;
+
+    /** Get an integer.
+     * @throw parse_error, operation_error when the value is not an integer.
+     */
+    explicit operator signed long long() const;
+
+    /** Get an integer.
+     * @throw parse_error, operation_error when the value is not an integer or does not fit.
+     */
+    explicit operator signed int() const;
+
+    /** Get a floating point number, integers are converted.
+     * @throw parse_error, operation_error when the value is not a number.
+     */
+    explicit operator double() const;
+
+    /** Get a floating point number, integers are converted.
+     * @throw parse_error, operation_error when the value is not a number.
+     */
+    explicit operator float() const
+    {
+        return static_cast<float>(static_cast<double>(*this));
+    }
+
+    /** Get a string; the string points into the encoded message.
+     * @throw parse_error, operation_error when the value is not a string.
+     */
+    explicit operator std::string_view() const;
+
+    /** Get a copy of a string.
+     * @throw parse_error, operation_error when the value is not a string.
+     */
+    explicit operator std::string() const
+    {
+        return std::string{static_cast<std::string_view>(*this)};
+    }
+
+    /** Decode the value, including nested arrays and objects.
+     * @throw parse_error
+     */
+    explicit operator datum() const;
+
+    /** The encoded bytes of this value, including nested arrays and objects.
+     * @throw parse_error
+     */
+    [[nodiscard]] std::span<std::byte const> bytes() const;
+
+    /** The number of elements of an array, or the number of members of an object.
+     * @throw parse_error, operation_error when the value is not an array or object.
+     */
+    [[nodiscard]] ssize_t size() const;
+
+    /** Iterate over the elements of an array or the values of the members of an object.
+     * @throw parse_error, operation_error when the value is not an array or object.
+     */
+    [[nodiscard]] const_iterator begin() const;
+
+    [[nodiscard]] std::default_sentinel_t end() const noexcept
+    {
+        return {};
+    }
+
+    /** Find a member of an object.
+     *
+     * @param key The key of the member.
+     * @return The value of the member, or empty when there is no member with the key.
+     * @throw parse_error, operation_error when the value is not an object.
+     */
+    [[nodiscard]] std::optional<BON8_view> find(std::string_view key) const;
+
+    /** Check if an object has a member.
+     * @throw parse_error, operation_error when the value is not an object.
+     */
+    [[nodiscard]] bool contains(std::string_view key) const;
+
+    /** Get the value of a member of an object.
+     * @throw parse_error, operation_error when the value is not an object or has no member with the key.
+     */
+    [[nodiscard]] BON8_view operator[](std::string_view key) const;
+
+    /** Get an element of an array.
+     * @param index The index of the element, a negative index counts from the end of the array.
+     * @throw parse_error, operation_error when the value is not an array or the index is out of range.
+     */
+    [[nodiscard]] BON8_view operator[](ssize_t index) const;
+
+private:
+    /** The first byte of the value.
+     */
+    cbyteptr _ptr;
+
+    /** One beyond the end of the message.
+     */
+    cbyteptr _last;
+
+    BON8_view(cbyteptr ptr, cbyteptr last) noexcept : _ptr(ptr), _last(last) {}
+
+    friend class const_iterator;
+};
+
+/** An iterator over the elements of an array or members of an object.
+ * The iterator is compared with `std::default_sentinel` for the end of the container.
+ */
+class BON8_view::const_iterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = BON8_view;
+    using difference_type = ptrdiff_t;
+    using reference = BON8_view;
+
+    const_iterator() noexcept = default;
+
+    /** The current element, or the value of the current member.
+     */
+    [[nodiscard]] BON8_view operator*() const noexcept
+    {
+        return BON8_view{_value, _last};
+    }
+
+    /** The key of the current member of an object.
+     */
+    [[nodiscard]] std::string_view key() const noexcept
+    {
+        return _key;
+    }
+
+    /** Skip to the next element.
+     * @throw parse_error
+     */
+    const_iterator &operator++();
+
+    const_iterator operator++(int)
+    {
+        auto tmp = *this;
+        ++(*this);
+        return tmp;
+    }
+
+    [[nodiscard]] friend bool operator==(const_iterator const &lhs, const_iterator const &rhs) noexcept
+    {
+        return lhs._ptr == rhs._ptr;
+    }
+
+    [[nodiscard]] friend bool operator==(const_iterator const &lhs, std::default_sentinel_t) noexcept
+    {
+        return lhs._ptr == nullptr;
+    }
+
+private:
+    /** The start of the current element or member; nullptr at the end of the container.
+     */
+    cbyteptr _ptr = nullptr;
+    cbyteptr _last = nullptr;
+    cbyteptr _value = nullptr;
+    std::string_view _key;
+    bool _is_object = false;
+
+    const_iterator(cbyteptr ptr, cbyteptr last, bool is_object);
+
+    /** Read the key of the member at _ptr, or find the end of the container.
+     */
+    void load();
+
+    friend class BON8_view;
+};
+
+} // namespace tt
@@ -0,0 +1,149 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/codec/BON8_view.hpp"
+#include "ttauri/codec/BON8.hpp"
+#include "ttauri/required.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <limits>
+
+using namespace std;
+using namespace tt;
+
+static bstring make_message(std::initializer_list<std::variant<int, std::string_view>> items)
+{
+    auto r = bstring{};
+    for (ttlet &item : items) {
+        if (ttlet *code = std::get_if<int>(&item)) {
+            r += static_cast<std::byte>(*code);
+        } else {
+            for (ttlet c : std::get<std::string_view>(item)) {
+                r += static_cast<std::byte>(c);
+            }
+        }
+    }
+    return r;
+}
+
+TEST(BON8_view, Object)
+{
+    // {"name": "foo", "size": 10, "list": [1, "x"], "empty": {}, "pi": 3.14}
+    ttlet message = make_message(
+        {0xfd,
+         "name", 0xff, "foo", 0xff,
+         "size", 0x8a,
+         "list", 0xfc, 0x81, "x", 0xfe,
+         "empty", 0xbe,
+         "pi", 0xfb, 0x40, 0x09, 0x1e, 0xb8, 0x51, 0xeb, 0x85, 0x1f,
+         0xfe});
+
+    ttlet view = BON8_view{bstring_view{message}};
+    ASSERT_TRUE(view.is_map());
+    ASSERT_EQ(view.size(), 5);
+
+    ASSERT_EQ(static_cast<std::string_view>(view["name"]), "foo");
+    ASSERT_EQ(static_cast<long long>(view["size"]), 10);
+    ASSERT_EQ(static_cast<double>(view["pi"]), 3.14);
+    ASSERT_TRUE(view["list"].is_vector());
+    ASSERT_EQ(view["list"].size(), 2);
+    ASSERT_EQ(static_cast<int>(view["list"][0]), 1);
+    ASSERT_EQ(static_cast<std::string_view>(view["list"][-1]), "x");
+    ASSERT_EQ(view["empty"].size(), 0);
+    ASSERT_FALSE(view.contains("foo"));
+    ASSERT_THROW((void)view["foo"], operation_error);
+    ASSERT_THROW((void)static_cast<long long>(view["name"]), operation_error);
+
+    auto i = view.begin();
+    ASSERT_EQ(i.key(), "name");
+    ++i;
+    ASSERT_EQ(i.key(), "size");
+
+    // The string of the view points into the message.
+    ttlet name = static_cast<std::string_view>(view["name"]);
+    ASSERT_EQ(reinterpret_cast<std::byte const *>(name.data()), message.data() + 6);
+
+    ASSERT_EQ(view.bytes().size(), message.size());
+    ASSERT_EQ(view["list"].bytes().size(), 4);
+
+    auto expected = datum::map{};
+    expected["name"] = "foo";
+    expected["size"] = 10;
+    expected["list"] = datum::vector{1, "x"};
+    expected["empty"] = datum::map{};
+    expected["pi"] = 3.14;
+    ASSERT_EQ(static_cast<datum>(view), expected);
+    ASSERT_EQ(decode_BON8(message), expected);
+}
+
+TEST(BON8_view, Integers)
+{
+    for (ttlet value : std::initializer_list<long long>{
+             0,
+             47,
+             48,
+             3839,
+             3840,
+             524287,
+             524288,
+             67108863,
+             67108864,
+             std::numeric_limits<int32_t>::max(),
+             std::numeric_limits<int32_t>::max() + 1LL,
+             std::numeric_limits<long long>::max(),
+             -1,
+             -10,
+             -11,
+             -1920,
+             -1921,
+             -262144,
+             -262145,
+             -33554432,
+             -33554433,
+             std::numeric_limits<int32_t>::min(),
+             std::numeric_limits<int32_t>::min() - 1LL,
+             std::numeric_limits<long long>::min()}) {
+        ttlet message = encode_BON8(datum{value});
+        ttlet view = BON8_view{bstring_view{message}};
+        ASSERT_TRUE(view.is_integer()) << value;
+        ASSERT_EQ(static_cast<long long>(view), value);
+        ASSERT_EQ(view.bytes().size(), message.size());
+    }
+}
+
+TEST(BON8_view, Floats)
+{
+    for (ttlet value : {-1.0, 0.0, 1.0, 0.5, 3.14, -1e300}) {
+        ttlet message = encode_BON8(datum{value});
+        ttlet view = BON8_view{bstring_view{message}};
+        ASSERT_TRUE(view.is_float());
+        ASSERT_EQ(static_cast<double>(view), value);
+    }
+}
+
+TEST(BON8_view, Strings)
+{
+    // A string ends at the end of the message, or with an integer that follows it in an array.
+    ttlet message = make_message({0xfc, "caf\xc3\xa9", 0xc2, 0x30, 0xff, 0xfe});
+    ttlet view = BON8_view{bstring_view{message}};
+    ASSERT_EQ(view.size(), 3);
+    ASSERT_EQ(static_cast<std::string_view>(view[0]), "caf\xc3\xa9");
+    ASSERT_EQ(static_cast<long long>(view[1]), 48);
+    ASSERT_EQ(static_cast<std::string_view>(view[2]), "");
+
+    ttlet single = make_message({"hello"});
+    ASSERT_EQ(static_cast<std::string_view>(BON8_view{bstring_view{single}}), "hello");
+}
+
+TEST(BON8_view, Errors)
+{
+    ttlet incomplete = make_message({0xfd, "foo", 0x81});
+    ASSERT_THROW((void)BON8_view{bstring_view{incomplete}}.size(), parse_error);
+
+    ttlet bad_key = make_message({0xfd, 0x81, 0x82, 0xfe});
+    ASSERT_THROW((void)BON8_view{bstring_view{bad_key}}.begin(), parse_error);
+
+    ttlet truncated = make_message({0xf9, 0x00, 0x00});
+    ASSERT_THROW((void)static_cast<long long>(BON8_view{bstring_view{truncated}}), parse_error);
+}
@@ -0,0 +1,677 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "BON8.hpp"
+#include "../required.hpp"
+#include "../assert.hpp"
+#include "../byte_string.hpp"
+#include "../datum.hpp"
+#include "../file.hpp"
+#include "../cast.hpp"
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <functional>
+#include <cstring>
+#include <limits>
+
+namespace tt {
+
+/** An output iterator which counts the number of bytes written to it.
+ * This is used to calculate the size of an encoded message without writing it.
+ */
+class counting_output_iterator {
+public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+
+    [[nodiscard]] size_t count() const noexcept
+    {
+        return _count;
+    }
+
+    counting_output_iterator &operator*() noexcept
+    {
+        return *this;
+    }
+
+    template<typename T>
+    counting_output_iterator &operator=(T const &) noexcept
+    {
+        return *this;
+    }
+
+    counting_output_iterator &operator++() noexcept
+    {
+        ++_count;
+        return *this;
+    }
+
+    counting_output_iterator operator++(int) noexcept
+    {
+        auto tmp = *this;
+        ++_count;
+        return tmp;
+    }
+
+private:
+    size_t _count = 0;
+};
+
+/** A streaming BON8 encoder.
+ *
+ * The encoded bytes are written to an output iterator one value at a time, so that
+ * a large message can be written, for example into a pre-allocated buffer or packet,
+ * without building a `datum` first. Arrays and objects are written with
+ * `start_array()`/`end_array()` and `start_object()`/`end_object()`; the members of an
+ * object are written as a key string followed by its value.
+ *
+ * The writer follows the rules for a canonical message: integers and floating point numbers use the
+ * least number of bytes, empty containers use the empty-container codes and strings
+ * are only terminated by end-of-text when needed. When writing an object the caller must write the keys
+ * in lexical order of their UTF-8 code units; `add(datum)` sorts the keys of a map.
+ *
+ * Strings must be valid UTF-8.
+ *
+ * Typical usage:
+ * ```
+ * auto packet = std::array<std::byte, 256>{};
+ * auto writer = BON8_writer{packet.data()};
+ * writer.start_object();
+ * writer.add("id");
+ * writer.add(id);
+ * writer.end_object();
+ * auto packet_size = writer.output() - packet.data();
+ * ```
+ *
+ * @tparam OutputIt An output iterator to which `std::byte` values are written.
+ */
+template<typename OutputIt>
+class BON8_writer {
+public:
+    explicit BON8_writer(OutputIt output) noexcept : _output(std::move(output)) {}
+
+    BON8_writer(BON8_writer const &) = delete;
+    BON8_writer(BON8_writer &&) noexcept = default;
+    BON8_writer &operator=(BON8_writer const &) = delete;
+    BON8_writer &operator=(BON8_writer &&) noexcept = default;
+
+    /** The output iterator after the bytes written so far.
+     */
+    [[nodiscard]] OutputIt const &output() const noexcept
+    {
+        return _output;
+    }
+
+    /** The number of arrays and objects the writer is in.
+     */
+    [[nodiscard]] int depth() const noexcept
+    {
+        return _depth;
+    }
+
+    void start_array() noexcept
+    {
+        start_container(detail::BON8_code_array);
+    }
+
+    void end_array() noexcept
+    {
+        end_container(detail::BON8_code_array_empty);
+    }
+
+    void start_object() noexcept
+    {
+        start_container(detail::BON8_code_object);
+    }
+
+    void end_object() noexcept
+    {
+        end_container(detail::BON8_code_object_empty);
+    }
+
+    /** Add a signed integer.
+     * @param value A signed integer.
+     */
+    void add(signed long long value) noexcept
+    {
+        start_value();
+
+        if (value < std::numeric_limits<int32_t>::min()) {
+            put_big_endian(detail::BON8_code_int64, static_cast<uint64_t>(value), 8);
+
+        } else if (value < -33554432) {
+            put_big_endian(detail::BON8_code_int32, static_cast<uint64_t>(value), 4);
+
+        } else if (value < -262144) {
+            value = -value - 1;
+            put(0xf0 + (value >> 22 & 0x07));
+            put(0xc0 + (value >> 16 & 0x3f));
+            put(value >> 8);
+            put(value);
+
+        } else if (value < -1920) {
+            value = -value - 1;
+            put(0xe0 + (value >> 14 & 0x0f));
+            put(0xc0 + (value >> 8 & 0x3f));
+            put(value);
+
+        } else if (value < -10) {
+            value = -value - 1;
+            put(0xc2 + (value >> 6 & 0x1f));
+            put(0xc0 + (value & 0x3f));
+
+        } else if (value < 0) {
+            value = -value - 1;
+            put(0xb0 + value);
+
+        } else if (value <= 47) {
+            put(0x80 + value);
+
+        } else if (value <= 3839) {
+            put(0xc2 + (value >> 7 & 0x1f));
+            put(value & 0x7f);
+
+        } else if (value <= 524287) {
+            put(0xe0 + (value >> 15 & 0x0f));
+            put(value >> 8 & 0x7f);
+            put(value);
+
+        } else if (value <= 67108863) {
+            put(0xf0 + (value >> 23 & 0x07));
+            put(value >> 16 & 0x7f);
+            put(value >> 8);
+            put(value);
+
+        } else if (value <= std::numeric_limits<int32_t>::max()) {
+            put_big_endian(detail::BON8_code_int32, static_cast<uint64_t>(value), 4);
+
+        } else {
+            put_big_endian(detail::BON8_code_int64, static_cast<uint64_t>(value), 8);
+        }
+    }
+
+    /** Add a unsigned integer.
+     * @param value A unsigned integer.
+     */
+    void add(unsigned long long value) noexcept
+    {
+        return add(narrow_cast<signed long long>(value));
+    }
+
+    /** Add a signed integer.
+     * @param value A signed integer.
+     */
+    void add(signed long value) noexcept
+    {
+        return add(narrow_cast<signed long long>(value));
+    }
+
+    /** Add a unsigned integer.
+     * @param value A unsigned integer.
+     */
+    void add(unsigned long value) noexcept
+    {
+        return add(narrow_cast<signed long long>(value));
+    }
+
+    /** Add a signed integer.
+     * @param value A signed integer.
+     */
+    void add(signed int value) noexcept
+    {
+        return add(narrow_cast<signed long long>(value));
+    }
+
+    /** Add a unsigned integer.
+     * @param value A unsigned integer.
+     */
+    void add(unsigned int value) noexcept
+    {
+        return add(narrow_cast<signed long long>(value));
+    }
+
+    /** Add a signed integer.
+     * @param value A signed integer.
+     */
+    void add(signed short value) noexcept
+    {
+        return add(narrow_cast<signed long long>(value));
+    }
+
+    /** Add a unsigned integer.
+     * @param value A unsigned integer.
+     */
+    void add(unsigned short value) noexcept
+    {
+        return add(narrow_cast<signed long long>(value));
+    }
+
+    /** Add a signed integer.
+     * @param value A signed integer.
+     */
+    void add(signed char value) noexcept
+    {
+        return add(narrow_cast<signed long long>(value));
+    }
+
+    /** Add a unsigned integer.
+     * @param value A unsigned integer.
+     */
+    void add(unsigned char value) noexcept
+    {
+        return add(narrow_cast<signed long long>(value));
+    }
+
+    /** Add a floating point number.
+     * @param value A floating point number.
+     */
+    void add(double value) noexcept
+    {
+        start_value();
+
+        ttlet f32 = static_cast<float>(value);
+        ttlet f32_64 = static_cast<double>(f32);
+
+        if (value == -1.0) {
+            put(detail::BON8_code_float_min_one);
+
+        } else if (value == 0.0 || value == -0.0) {
+            put(detail::BON8_code_float_zero);
+
+        } else if (value == 1.0) {
+            put(detail::BON8_code_float_one);
+
+        } else if (f32_64 == value) {
+            uint32_t u32;
+            std::memcpy(&u32, &f32, sizeof(u32));
+            put_big_endian(detail::BON8_code_binary32, u32, 4);
+
+        } else {
+            uint64_t u64;
+            std::memcpy(&u64, &value, sizeof(u64));
+            put_big_endian(detail::BON8_code_binary64, u64, 8);
+        }
+    }
+
+    /** Add a floating point number.
+     * @param value A floating point number.
+     */
+    void add(float value) noexcept
+    {
+        return add(narrow_cast<double>(value));
+    }
+
+    /** Add a boolean.
+     * @param value A boolean value.
+     */
+    void add(bool value) noexcept
+    {
+        start_value();
+        put(value ? detail::BON8_code_bool_true : detail::BON8_code_bool_false);
+    }
+
+    /** Add a null.
+     * @param value A null pointer.
+     */
+    void add(nullptr_t value) noexcept
+    {
+        start_value();
+        put(detail::BON8_code_null);
+    }
+
+    /** Add a UTF-8 string, or the key of a member of an object.
+     * It is important that the UTF-8 string is valid.
+     *
+     * @param value A UTF-8 string.
+     */
+    void add(std::u8string_view value) noexcept
+    {
+        if (_open_string) {
+            // A string directly following a string.
+            put(detail::BON8_code_eot);
+        }
+        start_value();
+
+        if (value.empty()) {
+            put(detail::BON8_code_eot);
+
+        } else {
+            if constexpr (build_type::current == build_type::debug) {
+                int multi_byte = 0;
+                for (ttlet _c : value) {
+                    ttlet c = static_cast<uint8_t>(_c);
+                    if (multi_byte == 0) {
+                        if (c >= 0xc2 && c <= 0xdf) {
+                            multi_byte = 1;
+                        } else if (c >= 0xe0 && c <= 0xef) {
+                            multi_byte = 2;
+                        } else if (c >= 0xf0 && c <= 0xf7) {
+                            multi_byte = 3;
+                        } else {
+                            tt_assert(c <= 0x7f);
+                        }
+                    } else {
+                        tt_assert(c >= 0x80 && c <= 0xbf);
+                        --multi_byte;
+                    }
+                }
+                tt_assert(multi_byte == 0);
+            }
+
+            _output = std::transform(value.begin(), value.end(), std::move(_output), [](ttlet c) {
+                return static_cast<std::byte>(c);
+            });
+
+            if (_depth == 0) {
+                // The full message is this string.
+                put(detail::BON8_code_eot);
+            } else {
+                _open_string = true;
+            }
+        }
+    }
+
+    /** Add a UTF-8 string.
+     * It is important that the UTF-8 string is valid.
+     *
+     * @param value A UTF-8 string.
+     */
+    void add(std::string_view value) noexcept
+    {
+        return add(std::u8string_view{reinterpret_cast<char8_t const *>(value.data()), value.size()});
+    }
+
+    /** Add a UTF-8 string.
+     * It is important that the UTF-8 string is valid.
+     *
+     * @param value A UTF-8 string.
+     */
+    void add(std::string const &value) noexcept
+    {
+        return add(std::string_view{value});
+    }
+
+    /** Add a UTF-8 string.
+     * It is important that the UTF-8 string is valid.
+     *
+     * @param value A UTF-8 string.
+     */
+    void add(char const *value) noexcept
+    {
+        return add(std::string_view{value});
+    }
+
+    /** Add a UTF-8 string.
+     * It is important that the UTF-8 string is valid.
+     *
+     * @param value A UTF-8 string
+     */
+    void add(std::u8string const &value) noexcept
+    {
+        return add(std::u8string_view{value});
+    }
+
+    /** Add a UTF-8 string.
+     * It is important that the UTF-8 string is valid.
+     *
+     * @param value A UTF-8 string.
+     */
+    void add(char8_t const *value) noexcept
+    {
+        return add(std::u8string_view{value});
+    }
+
+    /** Add a datum, including nested vectors and maps.
+     * The items of maps are written ordered by key.
+     *
+     * @param value A datum.
+     * @throw operation_error When the value can not be represented in BON8.
+     */
+    void add(datum const &value)
+    {
+        if (value.is_string() || value.is_url()) {
+            add(static_cast<std::string>(value));
+        } else if (value.is_bool()) {
+            add(static_cast<bool>(value));
+        } else if (value.is_null()) {
+            add(nullptr);
+        } else if (value.is_integer()) {
+            add(static_cast<signed long long>(value));
+        } else if (value.is_float()) {
+            add(static_cast<double>(value));
+
+        } else if (value.is_vector()) {
+            start_array();
+            for (auto i = value.vector_begin(); i != value.vector_end(); ++i) {
+                add(*i);
+            }
+            end_array();
+
+        } else if (value.is_map()) {
+            // Keys must be ordered lexically.
+            auto items = std::vector<std::pair<std::string, datum const *>>{};
+            items.reserve(value.size());
+            for (auto i = value.map_begin(); i != value.map_end(); ++i) {
+                if (!i->first.is_string()) {
+                    throw operation_error("BON8 object keys must be strings, got a {}", i->first.type_name());
+                }
+                items.emplace_back(static_cast<std::string>(i->first), &i->second);
+            }
+            std::sort(items.begin(), items.end(), [](ttlet &a, ttlet &b) {
+                return utf8_less(a.first, b.first);
+            });
+
+            start_object();
+            for (ttlet &item : items) {
+                add(item.first);
+                add(*item.second);
+            }
+            end_object();
+
+        } else {
+            throw operation_error("Datum value can not be encoded to BON8");
+        }
+    }
+
+    /** Add a vector of values of the same type.
+     * @tparam T Type of the values.
+     * @param items A vector of values.
+     */
+    template<typename T, typename Allocator>
+    void add(std::vector<T, Allocator> const &items)
+    {
+        start_array();
+        for (ttlet &item : items) {
+            add(item);
+        }
+        end_array();
+    }
+
+    /** Add a map of key/values pairs.
+     * @tparam Key A type convertable to a u8string_view; a valid UTF-8 string.
+     * @tparam Value The type of the Value.
+     * @param items The map of key/value pairs.
+     */
+    template<typename Key, typename Value>
+    void add(std::map<Key, Value> const &items)
+    {
+        using item_type = typename std::map<Key, Value>::value_type;
+
+        // Keys must be ordered lexically.
+        auto sorted_items = std::vector<std::reference_wrapper<item_type const>>{items.begin(), items.end()};
+        std::sort(sorted_items.begin(), sorted_items.end(), [](item_type const &a, item_type const &b) {
+            return static_cast<std::u8string_view>(a.first) < static_cast<std::u8string_view>(b.first);
+        });
+
+        start_object();
+        for (item_type const &item : sorted_items) {
+            add(static_cast<std::u8string_view>(item.first));
+            add(item.second);
+        }
+        end_object();
+    }
+
+private:
+    OutputIt _output;
+    int _depth = 0;
+
+    /** The last value was a string without an end-of-text.
+     */
+    bool _open_string = false;
+
+    /** The code of a container that was started, but of which no value has been written yet.
+     * The code is written with the first value, or replaced by an empty-container code.
+     */
+    uint8_t _pending_start = 0;
+
+    [[nodiscard]] static bool utf8_less(std::string_view lhs, std::string_view rhs) noexcept
+    {
+        return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](ttlet a, ttlet b) {
+            return static_cast<uint8_t>(a) < static_cast<uint8_t>(b);
+        });
+    }
+
+    void put(long long code) noexcept
+    {
+        *_output = static_cast<std::byte>(code);
+        ++_output;
+    }
+
+    void put_big_endian(uint8_t code, uint64_t value, int count) noexcept
+    {
+        put(code);
+        for (int i = count - 1; i >= 0; --i) {
+            put(static_cast<long long>(value >> (i * 8)));
+        }
+    }
+
+    void start_value() noexcept
+    {
+        _open_string = false;
+        if (_pending_start != 0) {
+            put(std::exchange(_pending_start, uint8_t{0}));
+        }
+    }
+
+    void start_container(uint8_t code) noexcept
+    {
+        start_value();
+        _pending_start = code;
+        ++_depth;
+    }
+
+    void end_container(uint8_t empty_code) noexcept
+    {
+        tt_axiom(_depth > 0);
+        --_depth;
+        _open_string = false;
+        if (_pending_start != 0) {
+            _pending_start = 0;
+            put(empty_code);
+        } else {
+            put(detail::BON8_code_eoc);
+        }
+    }
+};
+
+/** A streaming BON8 encoder which writes to a file.
+ *
+ * The encoded bytes are collected in a buffer which is written to the file each time
+ * it grows beyond `flush_size`; `flush()` must be called after the last value.
+ */
+class BON8_file_writer {
+public:
+    /** The size of the buffer after which the bytes are written to the file.
+     */
+    static constexpr size_t flush_size = 0x10000;
+
+    /**
+     * @param output The file to write to, which must outlive the writer.
+     */
+    explicit BON8_file_writer(file &output) noexcept : _file(output), _writer(std::back_inserter(_buffer)) {}
+
+    BON8_file_writer(BON8_file_writer const &) = delete;
+    BON8_file_writer(BON8_file_writer &&) = delete;
+    BON8_file_writer &operator=(BON8_file_writer const &) = delete;
+    BON8_file_writer &operator=(BON8_file_writer &&) = delete;
+
+    void start_array()
+    {
+        _writer.start_array();
+    }
+
+    void end_array()
+    {
+        _writer.end_array();
+        flush_if_full();
+    }
+
+    void start_object()
+    {
+        _writer.start_object();
+    }
+
+    void end_object()
+    {
+        _writer.end_object();
+        flush_if_full();
+    }
+
+    /** Add a value.
+     * @see BON8_writer::add()
+     * @throw io_error
+     */
+    template<typename T>
+    void add(T const &value)
+    {
+        _writer.add(value);
+        flush_if_full();
+    }
+
+    /** Write the buffered bytes to the file.
+     * @throw io_error
+     */
+    void flush()
+    {
+        _file.write(std::span<std::byte const>{_buffer.data(), _buffer.size()});
+        _buffer.clear();
+    }
+
+private:
+    file &_file;
+    bstring _buffer;
+    BON8_writer<std::back_insert_iterator<bstring>> _writer;
+
+    void flush_if_full()
+    {
+        if (_buffer.size() >= flush_size) {
+            flush();
+        }
+    }
+};
+
+/** The number of bytes of a value encoded as a BON8 message.
+ * This does not allocate memory for the message, so that a buffer of the exact size can be allocated.
+ *
+ * @param value The value to encode.
+ * @return The size of `encode_BON8(value)` in bytes.
+ * @throw operation_error When the value can not be represented in BON8.
+ */
+[[nodiscard]] inline size_t encoded_size(datum const &value)
+{
+    auto writer = BON8_writer{counting_output_iterator{}};
+    writer.add(value);
+    return writer.output().count();
+}
+
+} // namespace tt
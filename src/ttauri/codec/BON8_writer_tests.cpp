@@ -0,0 +1,99 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/codec/BON8_writer.hpp"
+#include "ttauri/codec/BON8_view.hpp"
+#include "ttauri/codec/BON8.hpp"
+#include "ttauri/required.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <array>
+
+using namespace std;
+using namespace tt;
+
+static bstring to_bstring(std::initializer_list<int> codes)
+{
+    auto r = bstring{};
+    for (ttlet code : codes) {
+        r += static_cast<std::byte>(code);
+    }
+    return r;
+}
+
+TEST(BON8_writer, Events)
+{
+    auto message = bstring{};
+    auto writer = BON8_writer{std::back_inserter(message)};
+    writer.start_object();
+    writer.add("a");
+    writer.add("b");
+    writer.add("c");
+    writer.start_array();
+    writer.add(1);
+    writer.add("d");
+    writer.end_array();
+    writer.add("e");
+    writer.start_array();
+    writer.end_array();
+    writer.add("f");
+    writer.start_object();
+    writer.end_object();
+    writer.end_object();
+    ASSERT_EQ(writer.depth(), 0);
+
+    // A string is only terminated when another string follows.
+    ASSERT_EQ(
+        message,
+        to_bstring({0xfd, 'a', 0xff, 'b', 0xff, 'c', 0xfc, 0x81, 'd', 0xfe, 'e', 0xbd, 'f', 0xbe, 0xfe}));
+}
+
+TEST(BON8_writer, Strings)
+{
+    // A message which is only a string is terminated.
+    ASSERT_EQ(encode_BON8(datum{"foo"}), to_bstring({'f', 'o', 'o', 0xff}));
+    ASSERT_EQ(encode_BON8(datum{""}), to_bstring({0xff}));
+}
+
+TEST(BON8_writer, Buffer)
+{
+    auto packet = std::array<std::byte, 16>{};
+    auto writer = BON8_writer{packet.data()};
+    writer.start_array();
+    writer.add(100);
+    writer.add(true);
+    writer.add(nullptr);
+    writer.end_array();
+
+    ttlet size = writer.output() - packet.data();
+    ASSERT_EQ(size, 6);
+
+    ttlet view = BON8_view{std::span<std::byte const>{packet.data(), narrow_cast<size_t>(size)}};
+    ASSERT_EQ(static_cast<long long>(view[0]), 100);
+    ASSERT_TRUE(static_cast<bool>(view[1]));
+    ASSERT_TRUE(view[2].is_null());
+}
+
+TEST(BON8_writer, Datum)
+{
+    auto value = datum::map{};
+    value["zeta"] = datum::vector{1, -1, 1000, -1000, 100000, -100000, 10000000, -10000000, 10000000000LL};
+    value["alpha"] = "hello";
+    value["beta"] = datum::map{};
+    value["gamma"] = 3.5;
+    value["delta"] = datum::vector{"x", "y", ""};
+    value["\xc3\xa9"] = datum{datum::null{}};
+
+    ttlet message = encode_BON8(value);
+    ASSERT_EQ(encoded_size(value), message.size());
+    ASSERT_EQ(decode_BON8(message), value);
+
+    // Keys are ordered lexically.
+    auto keys = std::vector<std::string_view>{};
+    ttlet view = BON8_view{bstring_view{message}};
+    for (auto i = view.begin(); i != view.end(); ++i) {
+        keys.push_back(i.key());
+    }
+    ASSERT_EQ(keys, (std::vector<std::string_view>{"alpha", "beta", "delta", "gamma", "zeta", "\xc3\xa9"}));
+}
@@ -1,277 +1,69 @@
-// Copyright Take Vos 2019-2020.
+// Copyright Take Vos 2019-2021.
 // Distributed under the Boost Software License, Version 1.0.
 // (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
 
 #include "JSON.hpp"
+#include "JSON_reader.hpp"
+#include "JSON_writer.hpp"
 
 namespace tt {
 
-struct parse_context_t {
-    std::string_view::const_iterator text_begin;
-
-};
-
-[[nodiscard]] static parse_result<datum> parseValue(parse_context_t &context, token_iterator token);
-
-[[nodiscard]] static parse_result<datum> parseArray(parse_context_t &context, token_iterator token)
+[[nodiscard]] static datum parse_JSON(JSON_reader &reader)
 {
-    auto array = datum{datum::vector{}};
-
-    // Required '['
-    if ((*token == tokenizer_name_t::Operator) && (*token == "[")) {
-        token++;
-    } else {
-        return {};
-    }
-
-    bool commaAfterValue = true;
-    while (true) {
-        // A ']' is required at end of configuration-items.
-        if ((*token == tokenizer_name_t::Operator) && (*token == "]")) {
-            token++;
-            break;
-
-        // Required a value.
-        } else if (auto result = parseValue(context, token)) {
-            if (!commaAfterValue) {
-                throw parse_error("{}: Missing expected ','", token->location);
-            }
+    reader.next();
+    auto root = reader.read();
 
-            array.push_back(*result);
-            token = result.next_token;
-
-            if ((*token == tokenizer_name_t::Operator) && (*token == ",")) {
-                token++;
-                commaAfterValue = true;
-            } else {
-                commaAfterValue = false;
-            }
-
-        } else {
-            throw parse_error("{}: Expecting a value as the next item in an array.", token->location);
-        }
-    }
-
-    return {std::move(array), token};
+    // Check that there is no text after the root object.
+    ttlet event = reader.next();
+    tt_axiom(event == JSON_event::end);
+    return root;
 }
 
-[[nodiscard]] static parse_result<datum> parseObject(parse_context_t &context, token_iterator token)
+[[nodiscard]] datum parse_JSON(std::string_view text)
 {
-    auto object = datum{datum::map{}};
-
-    // Required '{'
-    if ((*token == tokenizer_name_t::Operator) && (*token == "{")) {
-        token++;
-    } else {
-        return {};
-    }
-
-    bool commaAfterValue = true;
-    while (true) {
-        // A '}' is required at end of configuration-items.
-        if ((*token == tokenizer_name_t::Operator) && (*token == "}")) {
-            token++;
-            break;
-
-        // Required a string name.
-        } else if (*token == tokenizer_name_t::StringLiteral) {
-            if (!commaAfterValue) {
-                throw parse_error("{}: Missing expected ','", token->location);
-            }
-
-            auto name = static_cast<std::string>(*token++);
-
-            if ((*token == tokenizer_name_t::Operator) && (*token == ":")) {
-                token++;
-            } else {
-                throw parse_error("{}: Missing expected ':'", token->location);
-            }
-
-            if (auto result = parseValue(context, token)) {
-                object[name] = *result;
-                token = result.next_token;
-
-            } else {
-                throw parse_error("{}: Missing JSON value", token->location);
-            }
-
-            if ((*token == tokenizer_name_t::Operator) && (*token == ",")) {
-                token++;
-                commaAfterValue = true;
-            } else {
-                commaAfterValue = false;
-            }
-
-        } else {
-            throw parse_error("{}: Unexpected token {}, expected a key or close-brace.", token->location, *token);
-        }
-    }
-
-    return {std::move(object), token};
+    auto reader = JSON_reader{text};
+    return parse_JSON(reader);
 }
 
-[[nodiscard]] static parse_result<datum> parseValue(parse_context_t &context, token_iterator token)
+[[nodiscard]] datum parse_JSON(URL const &url)
 {
-    switch (token->name) {
-    case tokenizer_name_t::StringLiteral: {
-        auto value = datum{static_cast<std::string>(*token++)};
-        return {std::move(value), token};
-        } break;
-    case tokenizer_name_t::IntegerLiteral: {
-        auto value = datum{static_cast<long long>(*token++)};
-        return {std::move(value), token};
-        } break;
-    case tokenizer_name_t::FloatLiteral: {
-        auto value = datum{static_cast<double>(*token++)};
-        return {std::move(value), token};
-        } break;
-    case tokenizer_name_t::Name: {
-        ttlet name = static_cast<std::string>(*token++);
-        if (name == "true") {
-            return {datum{true}, token};
-        } else if (name == "false") {
-            return {datum{false}, token};
-        } else if (name == "null") {
-            return {datum{datum::null{}}, token};
-        } else {
-            throw parse_error("{}: Unexpected name '{}'", token->location, name);
-        }
-        } break;
-    default:
-        if (auto result1 = parseObject(context, token)) {
-            return result1;
-        } else if (auto result2 = parseArray(context, token)) {
-            return result2;
-        } else {
-            throw parse_error("{}: Unexpected token '{}'", token->location, token->name);
-        }
-    }
+    auto reader = JSON_reader{url};
+    return parse_JSON(reader);
 }
 
-[[nodiscard]] datum parse_JSON(std::string_view text)
+[[nodiscard]] static datum_document parse_JSON_document(JSON_reader &reader, size_t size)
 {
-    token_vector tokens = parseTokens(text);
+    // The parsed document is usually smaller than the text, so the first block of the arena often holds all of it.
+    auto document = datum_document{size};
 
-    datum root;
+    reader.next();
+    document.set_root(reader.read(document.arena()));
 
-    tt_axiom(tokens.back() == tokenizer_name_t::End);
-    parse_context_t context;
-    context.text_begin = text.begin();
-
-    auto token = tokens.begin();
-
-    if (auto result = parseObject(context, token)) {
-        root = std::move(*result);
-        token = result.next_token;
-
-    } else {
-        throw parse_error("{}: Missing JSON object", token->location);
-    }
-
-    if (*token != tokenizer_name_t::End) {
-        throw parse_error("{}: Unexpected text after JSON root object", token->location);
-    }
-
-    return root;
+    // Check that there is no text after the root object.
+    ttlet event = reader.next();
+    tt_axiom(event == JSON_event::end);
+    return document;
 }
 
-[[nodiscard]] datum parse_JSON(URL const &url)
+[[nodiscard]] datum_document parse_JSON_document(std::string_view text)
 {
-    return parse_JSON(url.loadView()->string_view());
+    auto reader = JSON_reader{text};
+    return parse_JSON_document(reader, text.size());
 }
 
-static void format_JSON_impl(datum const &value, std::string &result, tt::indent indent={})
+[[nodiscard]] datum_document parse_JSON_document(URL const &url)
 {
-    bool first_item = true;
-
-    switch (value.type()) {
-    case datum_type_t::Null:
-        result += "null";
-        break;
-
-    case datum_type_t::Boolean:
-        result += value ? "true" : "false";
-        break;
-
-    case datum_type_t::Integer:
-        result += tt::to_string(static_cast<long long>(value));
-        break;
-
-    case datum_type_t::Float:
-        result += tt::to_string(static_cast<double>(value));
-        break;
-
-    case datum_type_t::String:
-    case datum_type_t::URL:
-        result += '"';
-        for (ttlet c: static_cast<std::string>(value)) {
-            switch (c) {
-            case '\n': result += '\\'; result += 'n'; break;
-            case '\r': result += '\\'; result += 'r'; break;
-            case '\t': result += '\\'; result += 't'; break;
-            case '\f': result += '\\'; result += 'f'; break;
-            case '"': result += '\\'; result += '"'; break;
-            default: result += c;
-            }
-        }
-        result += '"';
-        break;
-
-    case datum_type_t::Vector:
-        result += indent;
-        result += '[';
-        result += '\n';
-
-        for (auto i = value.vector_begin(); i != value.vector_end(); i++, first_item = true) {
-            if (!first_item) {
-                result += ',';
-                result += '\n';
-            }
-            result += indent + 1;
-
-            format_JSON_impl(*i, result, indent + 1);
-        }
-
-        result += '\n';
-        result += indent;
-        result += ']';
-        break;
-
-    case datum_type_t::Map:
-        result += indent;
-        result += '{';
-        result += '\n';
-
-        for (auto i = value.map_begin(); i != value.map_end(); i++, first_item = true) {
-            if (!first_item) {
-                result += ',';
-                result += '\n';
-            }
-            result += indent + 1;
-
-            format_JSON_impl(i->first, result, indent + 1);
-            result += ':';
-            result += ' ';
-            format_JSON_impl(i->second, result, indent + 1);
-        }
-
-        result += '\n';
-        result += indent;
-        result += '}';
-        break;
-
-    default:
-        tt_no_default();
-    }
+    auto view = url.loadView();
+    ttlet size = view->size();
+    auto reader = JSON_reader{std::move(view), url};
+    return parse_JSON_document(reader, size);
 }
 
 [[nodiscard]] std::string format_JSON(datum const &root)
 {
-    auto r = std::string{};
-    format_JSON_impl(root, r);
-    r += '\n';
-    return r;
+    auto writer = JSON_writer{};
+    writer.value(root);
+    return writer.take();
 }
 
-
-}
+} // namespace tt
@@ -8,6 +8,7 @@
 #include "../required.hpp"
 #include "../URL.hpp"
 #include "../datum.hpp"
+#include "../datum_document.hpp"
 #include "../resource_view.hpp"
 #include "../strings.hpp"
 #include "../exception.hpp"
@@ -31,6 +32,22 @@ namespace tt {
  */
 [[nodiscard]] datum parse_JSON(tt::URL const &file);
 
+/** Parse a JSON string into a document.
+ * All strings, vectors and maps of the document are allocated in a single arena.
+ *
+ * @param text The text to parse.
+ * @return A document holding the parsed object.
+ */
+[[nodiscard]] datum_document parse_JSON_document(std::string_view text);
+
+/** Parse a JSON file into a document.
+ * All strings, vectors and maps of the document are allocated in a single arena.
+ *
+ * @param file URL pointing to the file to parse.
+ * @return A document holding the parsed object.
+ */
+[[nodiscard]] datum_document parse_JSON_document(tt::URL const &file);
+
 /** Dump an datum object into a JSON string.
  * @param root datum-object to serialize
  * @return The JSON serialized object as a string
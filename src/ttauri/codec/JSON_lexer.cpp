@@ -0,0 +1,601 @@
+// Copyright Take Vos 2019-2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "JSON_lexer.hpp"
+#include "UTF.hpp"
+#include "base_n.hpp"
+#include "../strings.hpp"
+#include "../cast.hpp"
+#if TT_X86_64_V2
+#include <emmintrin.h> // SSE2
+#endif
+#include <algorithm>
+#include <iterator>
+#include <bit>
+#include <utility>
+
+namespace tt {
+
+/** Skip white space one character at a time.
+ *
+ * @param first The first character.
+ * @param last One beyond the last character.
+ * @param[in,out] line The line number, incremented on each line-feed.
+ * @param[in,out] line_start The first character after the last line-feed.
+ * @return The first character which is not white space, or last.
+ */
+[[nodiscard]] static char const *
+JSON_skip_white_space_scalar(char const *first, char const *last, int &line, char const *&line_start) noexcept
+{
+    for (; first != last; ++first) {
+        ttlet c = *first;
+        if (c == '\n' || c == '\f') {
+            ++line;
+            line_start = first + 1;
+        } else if (!is_white_space(c)) {
+            break;
+        }
+    }
+    return first;
+}
+
+/** Find the first character in a string which needs special handling.
+ *
+ * @return The first double-quote, backslash, nul or line-feed character, or last.
+ */
+[[nodiscard]] static char const *JSON_find_string_special_scalar(char const *first, char const *last) noexcept
+{
+    for (; first != last; ++first) {
+        ttlet c = *first;
+        if (c == '"' || c == '\\' || c == '\0' || is_line_feed(c)) {
+            break;
+        }
+    }
+    return first;
+}
+
+#if TT_X86_64_V2
+/** Unsigned less-or-equal of bytes.
+ */
+[[nodiscard]] static __m128i JSON_le_epu8(__m128i lhs, __m128i rhs) noexcept
+{
+    return _mm_cmpeq_epi8(_mm_min_epu8(lhs, rhs), lhs);
+}
+
+[[nodiscard]] static char const *
+JSON_skip_white_space_sse(char const *first, char const *last, int &line, char const *&line_start) noexcept
+{
+    for (; last - first >= 16; first += 16) {
+        ttlet chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(first));
+
+        // White space is a space, or a character between '\t' and '\r'.
+        ttlet is_control_white_space = JSON_le_epu8(_mm_sub_epi8(chunk, _mm_set1_epi8('\t')), _mm_set1_epi8('\r' - '\t'));
+        ttlet is_white_space = _mm_or_si128(is_control_white_space, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')));
+        ttlet is_line_feed = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\f')));
+
+        ttlet not_white_space_mask = ~static_cast<unsigned int>(_mm_movemask_epi8(is_white_space)) & 0xffff;
+        ttlet nr_white_space = not_white_space_mask != 0 ? std::countr_zero(not_white_space_mask) : 16;
+
+        ttlet line_feed_mask = static_cast<unsigned int>(_mm_movemask_epi8(is_line_feed)) & ((1U << nr_white_space) - 1);
+        if (line_feed_mask != 0) {
+            line += std::popcount(line_feed_mask);
+            line_start = first + std::bit_width(line_feed_mask);
+        }
+
+        if (nr_white_space != 16) {
+            return first + nr_white_space;
+        }
+    }
+
+    return JSON_skip_white_space_scalar(first, last, line, line_start);
+}
+
+[[nodiscard]] static char const *JSON_find_string_special_sse(char const *first, char const *last) noexcept
+{
+    for (; last - first >= 16; first += 16) {
+        ttlet chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(first));
+
+        // A line-feed is a character between '\n' and '\r'.
+        ttlet is_line_feed = JSON_le_epu8(_mm_sub_epi8(chunk, _mm_set1_epi8('\n')), _mm_set1_epi8('\r' - '\n'));
+        ttlet is_quote = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'));
+        ttlet is_backslash = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'));
+        ttlet is_nul = _mm_cmpeq_epi8(chunk, _mm_setzero_si128());
+        ttlet is_special = _mm_or_si128(_mm_or_si128(is_line_feed, is_quote), _mm_or_si128(is_backslash, is_nul));
+
+        ttlet special_mask = static_cast<unsigned int>(_mm_movemask_epi8(is_special));
+        if (special_mask != 0) {
+            return first + std::countr_zero(special_mask);
+        }
+    }
+
+    return JSON_find_string_special_scalar(first, last);
+}
+#endif
+
+[[nodiscard]] static char const *JSON_skip_white_space(char const *first, char const *last, int &line, char const *&line_start) noexcept
+{
+#if TT_X86_64_V2
+    return JSON_skip_white_space_sse(first, last, line, line_start);
+#else
+    return JSON_skip_white_space_scalar(first, last, line, line_start);
+#endif
+}
+
+[[nodiscard]] static char const *JSON_find_string_special(char const *first, char const *last) noexcept
+{
+#if TT_X86_64_V2
+    return JSON_find_string_special_sse(first, last);
+#else
+    return JSON_find_string_special_scalar(first, last);
+#endif
+}
+
+[[nodiscard]] constexpr char JSON_unescape(char c) noexcept
+{
+    switch (c) {
+    case 'a': return '\a';
+    case 'b': return '\b';
+    case 'f': return '\f';
+    case 'n': return '\n';
+    case 'r': return '\r';
+    case 't': return '\t';
+    case 'v': return '\v';
+    default: return c;
+    }
+}
+
+/** Parse the four hexadecimal digits of a unicode escape sequence.
+ *
+ * @param first The first digit.
+ * @param last One beyond the last character of the text.
+ * @return The UTF-16 code unit, or -1 when there are not four hexadecimal digits.
+ */
+[[nodiscard]] static long JSON_parse_hex4(char const *first, char const *last) noexcept
+{
+    if (last - first < 4) {
+        return -1;
+    }
+
+    auto r = 0L;
+    for (auto i = 0; i != 4; ++i) {
+        ttlet digit = base16::int_from_char<int>(first[i]);
+        if (digit < 0) {
+            return -1;
+        }
+        r = r * 16 + digit;
+    }
+    return r;
+}
+
+/** Characters which the tokenizer reports as invalid characters.
+ */
+[[nodiscard]] constexpr bool JSON_is_invalid_character(char c) noexcept
+{
+    switch (c) {
+    case '\0':
+    case '"':
+    case '#':
+    case '.':
+    case ';':
+    case ',':
+    case '(':
+    case ')':
+    case '[':
+    case ']':
+    case '{':
+    case '}':
+    case '?':
+    case '@':
+    case '~':
+    case '!':
+    case '<':
+    case '>':
+    case '=':
+    case '+':
+    case '-':
+    case '*':
+    case '%':
+    case '/':
+    case '|':
+    case '&':
+    case '^':
+    case ':': return false;
+    default: return !(is_name_first(c) || is_digit(c) || is_white_space(c));
+    }
+}
+
+/** The number of characters of an operator.
+ * Characters are combined into an operator the same way as the tokenizer does.
+ *
+ * @param first The first character of the operator.
+ * @param last One beyond the last character of the text.
+ */
+[[nodiscard]] static ssize_t JSON_operator_size(char const *first, char const *last) noexcept
+{
+    switch (first[0]) {
+    case '!':
+    case '<':
+    case '>':
+    case '=':
+    case '+':
+    case '-':
+    case '*':
+    case '%':
+    case '/':
+    case '|':
+    case '&':
+    case '^':
+    case ':': break;
+    default: return 1;
+    }
+
+    if (last - first < 2) {
+        return 1;
+    }
+
+    switch (first[1]) {
+    case '=':
+    case '<':
+    case '>': return last - first >= 3 && (first[2] == '>' || first[2] == '=') ? 3 : 2;
+    case '-':
+    case '+':
+    case '*':
+    case '&':
+    case '|':
+    case '^': return 2;
+    default: return 1;
+    }
+}
+
+[[nodiscard]] parse_location JSON_lexer::location(position_type const &position) const noexcept
+{
+    if (position.is_fallback && _fallback.name != tokenizer_name_t::Operator) {
+        // The tokenizer does not set the location of operators.
+        return _fallback.location;
+    }
+
+    // Columns are calculated the same way as the tokenizer does: a tab moves to the next
+    // multiple of 8, every other character, including each byte of a UTF-8 sequence, is one column.
+    int column = 0;
+    for (auto p = position.line_start; p != position.first; ++p) {
+        column = *p == '\t' ? (column / 8 + 1) * 8 : column + 1;
+    }
+    return parse_location{_file, position.line + 1, column + 1};
+}
+
+void JSON_lexer::next() noexcept
+{
+    if (std::exchange(_operator_after_integer, false)) {
+        // The tokenizer combines a minus or colon directly after an integer into an operator.
+        start_token();
+        return parse_operator();
+    }
+
+    if (!skip_white_space_and_comments()) {
+        return;
+    }
+
+    start_token();
+    if (_ptr == _last || *_ptr == '\0') {
+        _name = tokenizer_name_t::End;
+        _value = {};
+        return;
+    }
+
+    ttlet c = *_ptr;
+    switch (c) {
+    case '"':
+        if (_last - _ptr >= 3 && _ptr[1] == '"' && _ptr[2] == '"') {
+            return parse_block_string();
+        } else {
+            return parse_string();
+        }
+
+    case '-':
+    case '+':
+        if (_last - _ptr >= 2 && (is_digit(_ptr[1]) || _ptr[1] == '.')) {
+            return parse_number();
+        } else {
+            return parse_operator();
+        }
+
+    case '.':
+        if (_last - _ptr >= 2 && is_digit(_ptr[1])) {
+            return parse_number();
+        } else {
+            return parse_operator();
+        }
+
+    case '/':
+        // Comments have already been skipped.
+        return parse_operator();
+
+    case ':':
+        if (_last - _ptr >= 3 && (_ptr[1] == '-' || _ptr[1] == '+') &&
+            (is_digit(_ptr[2]) || _ptr[2] == '.')) {
+            // Unlike the tokenizer, a number may directly follow a colon.
+            _name = tokenizer_name_t::Operator;
+            _value = {_ptr++, 1};
+            return;
+        }
+        break;
+
+    default:;
+    }
+
+    if (is_digit(c)) {
+        return parse_number();
+    } else if (is_name_first(c)) {
+        return parse_name();
+    } else {
+        return parse_operator();
+    }
+}
+
+[[nodiscard]] bool JSON_lexer::skip_white_space_and_comments() noexcept
+{
+    while (true) {
+        _ptr = JSON_skip_white_space(_ptr, _last, _line, _line_start);
+        if (_ptr == _last) {
+            return true;
+        }
+
+        if (*_ptr == '#' || (*_ptr == '/' && _last - _ptr >= 2 && _ptr[1] == '/')) {
+            // A line comment, includes the line-feed.
+            while (_ptr != _last && *_ptr != '\0') {
+                ttlet c = *_ptr++;
+                if (c == '\n' || c == '\f') {
+                    ++_line;
+                    _line_start = _ptr;
+                    break;
+                } else if (is_line_feed(c)) {
+                    break;
+                }
+            }
+
+        } else if (*_ptr == '/' && _last - _ptr >= 2 && _ptr[1] == '*') {
+            auto p = _ptr + 2;
+            auto line = _line;
+            auto line_start = _line_start;
+            for (; p != _last && *p != '\0'; ++p) {
+                if (*p == '*' && _last - p >= 2 && p[1] == '/') {
+                    break;
+                } else if (*p == '\n' || *p == '\f') {
+                    ++line;
+                    line_start = p + 1;
+                }
+            }
+
+            if (p == _last || *p == '\0') {
+                start_token();
+                fallback();
+                return false;
+            }
+
+            _ptr = p + 2;
+            _line = line;
+            _line_start = line_start;
+
+        } else if (JSON_is_invalid_character(*_ptr)) {
+            start_token();
+            fallback();
+            return false;
+
+        } else {
+            return true;
+        }
+    }
+}
+
+void JSON_lexer::fallback() noexcept
+{
+    ttlet first = _text.cbegin() + (_first - _text.data());
+    _fallback = parseToken(first, _text.cend(), location());
+    _name = _fallback.name;
+    _value = _fallback.value;
+    _is_fallback = true;
+    _ptr = _last;
+}
+
+void JSON_lexer::parse_operator() noexcept
+{
+    ttlet size = JSON_operator_size(_ptr, _last);
+    _name = tokenizer_name_t::Operator;
+    _value = {_ptr, narrow_cast<size_t>(size)};
+    _ptr += size;
+}
+
+void JSON_lexer::parse_name() noexcept
+{
+    auto p = _ptr + 1;
+    while (p != _last && (is_name_next(*p) || *p == '-')) {
+        ++p;
+    }
+
+    _name = tokenizer_name_t::Name;
+    _value = {_ptr, narrow_cast<size_t>(p - _ptr)};
+    _ptr = p;
+}
+
+void JSON_lexer::parse_number() noexcept
+{
+    auto p = _ptr;
+    _buffer.clear();
+    _name = tokenizer_name_t::IntegerLiteral;
+
+    if (*p == '-' || *p == '+') {
+        _buffer += *p++;
+    }
+
+    if (_last - p >= 2 && p[0] == '0' &&
+        (p[1] == 'x' || p[1] == 'X' || p[1] == 'd' || p[1] == 'D' || p[1] == 'o' || p[1] == 'O' || p[1] == 'b' ||
+         p[1] == 'B')) {
+        _buffer += *p++;
+        _buffer += *p++;
+    }
+
+    for (; p != _last; ++p) {
+        ttlet c = *p;
+        if (is_digit(c)) {
+            _buffer += c;
+        } else if (c == '_' || c == '\'') {
+            // Digit separator.
+        } else if (c == '.' || c == 'e' || c == 'E') {
+            _name = tokenizer_name_t::FloatLiteral;
+            break;
+        } else if (c == '-' || c == ':') {
+            if (_last - p >= 2 && is_digit(p[1])) {
+                // A date or time literal.
+                return fallback();
+            }
+            _operator_after_integer = true;
+            break;
+        } else {
+            break;
+        }
+    }
+
+    if (_name == tokenizer_name_t::FloatLiteral) {
+        _buffer += *p++;
+        for (; p != _last; ++p) {
+            ttlet c = *p;
+            if (is_digit(c) || c == 'e' || c == 'E' || c == '-') {
+                _buffer += c;
+            } else if (c == '+' && (_buffer.back() == 'e' || _buffer.back() == 'E')) {
+                _buffer += c;
+            } else if (c == '_' || c == '\'') {
+                // Digit separator.
+            } else {
+                break;
+            }
+        }
+    }
+
+    _value = _buffer;
+    _ptr = p;
+}
+
+[[nodiscard]] char const *JSON_lexer::unescape(char const *p) noexcept
+{
+    if (p[1] != 'u') {
+        _buffer += JSON_unescape(p[1]);
+        return p + 2;
+    }
+
+    auto code_unit = JSON_parse_hex4(p + 2, _last);
+    if (code_unit < 0) {
+        return nullptr;
+    }
+    p += 6;
+
+    auto code_point = static_cast<char32_t>(code_unit);
+    if (code_point >= 0xd800 && code_point <= 0xdbff && _last - p >= 2 && p[0] == '\\' && p[1] == 'u') {
+        ttlet low = JSON_parse_hex4(p + 2, _last);
+        if (low >= 0xdc00 && low <= 0xdfff) {
+            code_point = 0x10000 + ((code_point - 0xd800) << 10) + static_cast<char32_t>(low - 0xdc00);
+            p += 6;
+        }
+    }
+
+    if (code_point >= 0xd800 && code_point <= 0xdfff) {
+        code_point = 0xfffd;
+    }
+
+    auto it = std::back_inserter(_buffer);
+    utf32_to_utf8(code_point, it);
+    return p;
+}
+
+void JSON_lexer::invalid_escape(char const *p) noexcept
+{
+    _name = tokenizer_name_t::ErrorInvalidCharacter;
+    _value = {p, narrow_cast<size_t>(std::min(_last - p, ptrdiff_t{6}))};
+    _ptr = _last;
+}
+
+void JSON_lexer::parse_string() noexcept
+{
+    auto p = _ptr + 1;
+    auto q = JSON_find_string_special(p, _last);
+    if (q != _last && *q == '"') {
+        // Fast path for strings without escape sequences.
+        _name = tokenizer_name_t::StringLiteral;
+        _value = {p, narrow_cast<size_t>(q - p)};
+        _ptr = q + 1;
+        return;
+    }
+
+    _buffer.assign(p, q);
+    while (true) {
+        if (q == _last || *q == '\0' || is_line_feed(*q)) {
+            // Unterminated string, or a line-feed in a string.
+            return fallback();
+
+        } else if (*q == '"') {
+            break;
+
+        } else {
+            tt_axiom(*q == '\\');
+            if (_last - q < 2 || q[1] == '\0') {
+                return fallback();
+            }
+            p = unescape(q);
+            if (p == nullptr) {
+                return invalid_escape(q);
+            }
+        }
+
+        q = JSON_find_string_special(p, _last);
+        _buffer.append(p, q);
+    }
+
+    _name = tokenizer_name_t::StringLiteral;
+    _value = _buffer;
+    _ptr = q + 1;
+}
+
+void JSON_lexer::parse_block_string() noexcept
+{
+    _buffer.clear();
+
+    auto line = _line;
+    auto line_start = _line_start;
+    auto p = _ptr + 3;
+    while (true) {
+        if (p == _last || *p == '\0') {
+            return fallback();
+        }
+
+        ttlet c = *p;
+        if (c == '"' && _last - p >= 3 && p[1] == '"' && p[2] == '"') {
+            break;
+
+        } else if (c == '\\') {
+            if (_last - p < 2 || p[1] == '\0') {
+                return fallback();
+            }
+            ttlet escape = p;
+            p = unescape(escape);
+            if (p == nullptr) {
+                return invalid_escape(escape);
+            }
+
+        } else {
+            if (c == '\n' || c == '\f') {
+                ++line;
+                line_start = p + 1;
+            }
+            _buffer += c;
+            ++p;
+        }
+    }
+
+    _name = tokenizer_name_t::StringLiteral;
+    _value = _buffer;
+    _ptr = p + 3;
+    _line = line;
+    _line_start = line_start;
+}
+
+} // namespace tt
@@ -0,0 +1,170 @@
+// Copyright Take Vos 2019-2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "../required.hpp"
+#include "../tokenizer.hpp"
+#include "../parse_location.hpp"
+#include "../URL.hpp"
+#include <string>
+#include <string_view>
+#include <memory>
+
+namespace tt {
+
+/** A lexer for JSON which scans the text in a single pass.
+ *
+ * The lexer produces the same tokens and values as `parseTokens()`, but only holds
+ * the current token. String values without escape sequences, and names, are views into the text.
+ *
+ * Text that can not be part of a JSON document, such as an unterminated string, is an error;
+ * in that case the token is produced by `parseToken()` so that the error message is the same.
+ */
+class JSON_lexer {
+public:
+    /** The start of a token, used to calculate the location of the token.
+     */
+    struct position_type {
+        char const *first;
+        char const *line_start;
+        int line;
+        bool is_fallback;
+    };
+
+    JSON_lexer(std::string_view text, std::shared_ptr<URL> file) noexcept :
+        _text(text), _file(std::move(file)), _ptr(text.data()), _last(text.data() + text.size()), _line_start(text.data())
+    {
+        next();
+    }
+
+    [[nodiscard]] tokenizer_name_t name() const noexcept
+    {
+        return _name;
+    }
+
+    /** The value of the token.
+     * The value is valid until the next call to `next()`.
+     */
+    [[nodiscard]] std::string_view value() const noexcept
+    {
+        return _value;
+    }
+
+    [[nodiscard]] bool is_operator(char c) const noexcept
+    {
+        return _name == tokenizer_name_t::Operator && _value.size() == 1 && _value.front() == c;
+    }
+
+    /** A copy of the token, for use in error messages.
+     */
+    [[nodiscard]] token_t token() const noexcept
+    {
+        return token_t{_name, std::string{_value}};
+    }
+
+    [[nodiscard]] position_type position() const noexcept
+    {
+        return {_first, _token_line_start, _token_line, _is_fallback};
+    }
+
+    [[nodiscard]] parse_location location(position_type const &position) const noexcept;
+
+    [[nodiscard]] parse_location location() const noexcept
+    {
+        return location(position());
+    }
+
+    /** Advance to the next token.
+     */
+    void next() noexcept;
+
+private:
+    std::string_view _text;
+    std::shared_ptr<URL> _file;
+
+    /** The current position in the text.
+     */
+    char const *_ptr;
+    char const *_last;
+
+    /** The number of line-feeds before the current position, and the first character after the last line-feed.
+     */
+    int _line = 0;
+    char const *_line_start;
+
+    /** The current token.
+     */
+    tokenizer_name_t _name = tokenizer_name_t::NotAssigned;
+    std::string_view _value;
+    char const *_first = nullptr;
+    int _token_line = 0;
+    char const *_token_line_start = nullptr;
+
+    /** The token produced by the generic tokenizer, for text that is not JSON.
+     */
+    token_t _fallback;
+    bool _is_fallback = false;
+
+    /** The current integer is directly followed by a minus or colon which is not part of a date or time.
+     */
+    bool _operator_after_integer = false;
+
+    /** Buffer for values of strings with escape sequences, and of numbers.
+     */
+    std::string _buffer;
+
+    void start_token() noexcept
+    {
+        _first = _ptr;
+        _token_line = _line;
+        _token_line_start = _line_start;
+    }
+
+    /** Skip white space and comments.
+     *
+     * @return false when an unterminated block comment or an invalid character was found;
+     *         the current token is then an error.
+     */
+    [[nodiscard]] bool skip_white_space_and_comments() noexcept;
+
+    /** Use the generic tokenizer to produce the current token.
+     *
+     * This is only used for text that is not valid JSON, so the parser will throw
+     * an error on this token; the rest of the text is skipped.
+     */
+    void fallback() noexcept;
+
+    void parse_operator() noexcept;
+
+    void parse_name() noexcept;
+
+    void parse_number() noexcept;
+
+    /** Append the character of an escape sequence to the buffer.
+     *
+     * A unicode escape sequence, 'u' followed by four hexadecimal digits, is decoded as
+     * UTF-16 and appended as UTF-8. A high surrogate followed by an escaped low surrogate
+     * is combined into a single code point; a lone surrogate is replaced by U+FFFD.
+     *
+     * @param p The backslash of the escape sequence, followed by at least one character.
+     * @return One beyond the escape sequence, or nullptr when the 'u' is not followed
+     *         by four hexadecimal digits.
+     */
+    [[nodiscard]] char const *unescape(char const *p) noexcept;
+
+    /** Report an invalid escape sequence as an invalid character.
+     *
+     * @param p The backslash of the escape sequence.
+     */
+    void invalid_escape(char const *p) noexcept;
+
+    void parse_string() noexcept;
+
+    /** Parse a string delimited by triple double-quotes, which may span multiple lines.
+     */
+    void parse_block_string() noexcept;
+};
+
+} // namespace tt
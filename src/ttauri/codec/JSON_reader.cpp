@@ -0,0 +1,271 @@
+// Copyright Take Vos 2019-2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "JSON_reader.hpp"
+#include "JSON_lexer.hpp"
+#include "../strings.hpp"
+#include "../exception.hpp"
+#include "../charconv.hpp"
+#include <utility>
+
+namespace tt {
+
+JSON_reader::JSON_reader(std::string_view text) noexcept : _lexer(std::make_unique<JSON_lexer>(text, std::shared_ptr<URL>{})) {}
+
+JSON_reader::JSON_reader(URL const &file) : JSON_reader(file.loadView(), file) {}
+
+JSON_reader::JSON_reader(std::unique_ptr<resource_view> view, URL const &file) :
+    _view(std::move(view)), _lexer(std::make_unique<JSON_lexer>(_view->string_view(), std::make_shared<URL>(file)))
+{
+}
+
+JSON_reader::~JSON_reader() = default;
+JSON_reader::JSON_reader(JSON_reader &&) noexcept = default;
+JSON_reader &JSON_reader::operator=(JSON_reader &&) noexcept = default;
+
+[[nodiscard]] parse_location JSON_reader::location() const noexcept
+{
+    return _lexer->location();
+}
+
+JSON_event JSON_reader::next()
+{
+    if (std::exchange(_after_value, false)) {
+        finish_value();
+    }
+
+    if (_stack.empty()) {
+        if (!std::exchange(_started, true)) {
+            // Required '{'
+            if (!_lexer->is_operator('{')) {
+                throw parse_error("{}: Missing JSON object", location());
+            }
+            _lexer->next();
+            _stack.push_back({true, true, false, {}});
+            return _event = JSON_event::start_object;
+        }
+
+        if (_lexer->name() != tokenizer_name_t::End) {
+            throw parse_error("{}: Unexpected text after JSON root object", location());
+        }
+        return _event = JSON_event::end;
+    }
+
+    auto &frame = _stack.back();
+    if (frame.is_object) {
+        if (std::exchange(frame.after_key, false)) {
+            return _event = start_value();
+
+        // A '}' is required at end of configuration-items.
+        } else if (_lexer->is_operator('}')) {
+            _lexer->next();
+            _stack.pop_back();
+            if (!_stack.empty() && _stack.back().missing_comma) {
+                throw parse_error("{}: Missing expected ','", *_stack.back().missing_comma);
+            }
+            _after_value = true;
+            return _event = JSON_event::end_object;
+
+        // Required a string name.
+        } else if (_lexer->name() == tokenizer_name_t::StringLiteral) {
+            if (!frame.comma_after_value) {
+                throw parse_error("{}: Missing expected ','", location());
+            }
+
+            // The value of the token is only valid until the lexer advances.
+            _key = _lexer->value();
+            _lexer->next();
+
+            if (_lexer->is_operator(':')) {
+                _lexer->next();
+            } else {
+                throw parse_error("{}: Missing expected ':'", location());
+            }
+
+            frame.after_key = true;
+            return _event = JSON_event::key;
+
+        } else {
+            throw parse_error("{}: Unexpected token {}, expected a key or close-brace.", location(), _lexer->token());
+        }
+
+    } else {
+        // A ']' is required at end of configuration-items.
+        if (_lexer->is_operator(']')) {
+            _lexer->next();
+            _stack.pop_back();
+            if (!_stack.empty() && _stack.back().missing_comma) {
+                throw parse_error("{}: Missing expected ','", *_stack.back().missing_comma);
+            }
+            _after_value = true;
+            return _event = JSON_event::end_array;
+        }
+
+        if (frame.comma_after_value) {
+            return _event = start_value();
+        }
+
+        // Errors in the value itself are reported before the missing comma.
+        frame.missing_comma = location();
+        _event = start_value();
+        if (_event == JSON_event::value) {
+            [[maybe_unused]] ttlet value_ = value();
+            throw parse_error("{}: Missing expected ','", *_stack.back().missing_comma);
+        }
+        return _event;
+    }
+}
+
+JSON_event JSON_reader::start_value()
+{
+    switch (_lexer->name()) {
+    case tokenizer_name_t::StringLiteral:
+    case tokenizer_name_t::IntegerLiteral:
+    case tokenizer_name_t::FloatLiteral:
+        // The lexer is advanced on the next event, so that value() can use the current token.
+        _value_pending = true;
+        _after_value = true;
+        return JSON_event::value;
+
+    case tokenizer_name_t::Name: {
+        ttlet name = _lexer->value();
+        if (name == "true" || name == "false" || name == "null") {
+            _value_pending = true;
+            _after_value = true;
+            return JSON_event::value;
+        }
+
+        auto name_ = std::string{name};
+        _lexer->next();
+        throw parse_error("{}: Unexpected name '{}'", location(), name_);
+    }
+
+    default:
+        if (_lexer->is_operator('{')) {
+            _lexer->next();
+            _stack.push_back({true, true, false, {}});
+            return JSON_event::start_object;
+
+        } else if (_lexer->is_operator('[')) {
+            _lexer->next();
+            _stack.push_back({false, true, false, {}});
+            return JSON_event::start_array;
+
+        } else {
+            throw parse_error("{}: Unexpected token '{}'", location(), _lexer->name());
+        }
+    }
+}
+
+void JSON_reader::finish_value()
+{
+    if (std::exchange(_value_pending, false)) {
+        _lexer->next();
+    }
+
+    if (!_stack.empty()) {
+        if (_lexer->is_operator(',')) {
+            _lexer->next();
+            _stack.back().comma_after_value = true;
+        } else {
+            _stack.back().comma_after_value = false;
+        }
+    }
+}
+
+[[nodiscard]] datum JSON_reader::value(std::pmr::memory_resource *arena) const
+{
+    tt_axiom(_event == JSON_event::value && _value_pending);
+
+    switch (_lexer->name()) {
+    case tokenizer_name_t::StringLiteral: return arena ? datum{_lexer->value(), *arena} : datum{_lexer->value()};
+
+    case tokenizer_name_t::IntegerLiteral: {
+        long long value;
+        try {
+            value = from_string<long long>(_lexer->value());
+        } catch (...) {
+            throw parse_error("Could not convert token {} to {}", _lexer->token(), typeid(long long).name());
+        }
+        return arena ? datum{value, *arena} : datum{value};
+    }
+
+    case tokenizer_name_t::FloatLiteral:
+        try {
+            return datum{std::stod(std::string{_lexer->value()})};
+        } catch (...) {
+            throw parse_error("Could not convert token {} to double", _lexer->token());
+        }
+
+    case tokenizer_name_t::Name: {
+        ttlet name = _lexer->value();
+        if (name == "true") {
+            return datum{true};
+        } else if (name == "false") {
+            return datum{false};
+        } else {
+            tt_axiom(name == "null");
+            return datum{datum::null{}};
+        }
+    }
+
+    default: tt_no_default();
+    }
+}
+
+void JSON_reader::skip()
+{
+    switch (_event) {
+    case JSON_event::key:
+        if (ttlet event = next(); event == JSON_event::start_object || event == JSON_event::start_array) {
+            skip();
+        }
+        break;
+
+    case JSON_event::start_object:
+    case JSON_event::start_array: {
+        // Read until the end-event of this object or array, which leaves the current depth.
+        ttlet depth_ = depth();
+        while (depth() >= depth_) {
+            next();
+        }
+    } break;
+
+    default:;
+    }
+}
+
+[[nodiscard]] datum JSON_reader::read(std::pmr::memory_resource *arena)
+{
+    // Containers are allocated from the arena, or from the default memory resource.
+    ttlet resource = arena ? arena : std::pmr::get_default_resource();
+
+    switch (_event) {
+    case JSON_event::value: return value(arena);
+
+    case JSON_event::key: next(); return read(arena);
+
+    case JSON_event::start_array: {
+        auto array = datum::vector(resource);
+        while (next() != JSON_event::end_array) {
+            array.push_back(read(arena));
+        }
+        return arena ? datum{std::move(array), *arena} : datum{std::move(array)};
+    }
+
+    case JSON_event::start_object: {
+        auto object = datum::map(resource);
+        while (next() != JSON_event::end_object) {
+            auto name = arena ? datum{key(), *arena} : datum{key()};
+            next();
+            object.insert_or_assign(std::move(name), read(arena));
+        }
+        return arena ? datum{std::move(object), *arena} : datum{std::move(object)};
+    }
+
+    default: tt_no_default();
+    }
+}
+
+} // namespace tt
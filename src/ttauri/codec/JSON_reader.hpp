@@ -0,0 +1,237 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "../required.hpp"
+#include "../assert.hpp"
+#include "../URL.hpp"
+#include "../datum.hpp"
+#include "../resource_view.hpp"
+#include "../parse_location.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <memory_resource>
+
+namespace tt {
+class JSON_lexer;
+
+/** The events produced by a `JSON_reader`.
+ */
+enum class JSON_event {
+    /** The start of an object, followed by pairs of key and value events.
+     */
+    start_object,
+
+    /** The end of an object.
+     */
+    end_object,
+
+    /** The start of an array, followed by value events.
+     */
+    start_array,
+
+    /** The end of an array.
+     */
+    end_array,
+
+    /** The key of a member of an object; the value of the member follows.
+     */
+    key,
+
+    /** A string, number, boolean or null value.
+     */
+    value,
+
+    /** The end of the JSON document.
+     */
+    end
+};
+
+/** An event driven JSON reader.
+ *
+ * The reader returns the structure of a JSON document one event at a time, without building
+ * a `datum` tree. Only the current token and a stack of the nested objects and arrays are held
+ * in memory; subtrees that are not needed are skipped using `skip()`, and subtrees that are needed
+ * are converted to a `datum` using `read()`.
+ *
+ * Like `parse_JSON()`, the root of the document must be an object.
+ *
+ * Typical usage:
+ * ```
+ * auto reader = JSON_reader{URL{"resource:theme.json"}};
+ * reader.next(); // JSON_event::start_object
+ * while (reader.next() == JSON_event::key) {
+ *     if (reader.key() == "name") {
+ *         reader.next();
+ *         name = static_cast<std::string>(reader.value());
+ *     } else {
+ *         reader.skip();
+ *     }
+ * }
+ * ```
+ */
+class JSON_reader {
+public:
+    /** Read JSON from a text.
+     *
+     * @param text The text to read, which must outlive the reader.
+     */
+    explicit JSON_reader(std::string_view text) noexcept;
+
+    /** Read JSON from a file.
+     * The file is memory mapped, so that only the parts being read are loaded into memory.
+     *
+     * @param file URL pointing to the file to read.
+     */
+    explicit JSON_reader(URL const &file);
+
+    /** Read JSON from a resource.
+     *
+     * @param view The memory mapped resource to read.
+     * @param file URL of the resource, used in error messages.
+     */
+    JSON_reader(std::unique_ptr<resource_view> view, URL const &file);
+
+    ~JSON_reader();
+    JSON_reader(JSON_reader const &) = delete;
+    JSON_reader(JSON_reader &&) noexcept;
+    JSON_reader &operator=(JSON_reader const &) = delete;
+    JSON_reader &operator=(JSON_reader &&) noexcept;
+
+    /** Read the next event.
+     *
+     * @return The next event; `JSON_event::end` is returned when the whole document has been read.
+     * @throw parse_error When the text is not a valid JSON document.
+     */
+    JSON_event next();
+
+    /** The last event returned by `next()`.
+     */
+    [[nodiscard]] JSON_event event() const noexcept
+    {
+        return _event;
+    }
+
+    /** The number of objects and arrays the reader is in.
+     */
+    [[nodiscard]] ssize_t depth() const noexcept
+    {
+        return std::ssize(_stack);
+    }
+
+    /** The key of a `JSON_event::key` event.
+     * The key is valid until the next call to `next()`.
+     */
+    [[nodiscard]] std::string_view key() const noexcept
+    {
+        tt_axiom(_event == JSON_event::key);
+        return _key;
+    }
+
+    /** The value of a `JSON_event::value` event.
+     *
+     * @throw parse_error When the number could not be converted.
+     */
+    [[nodiscard]] datum value() const
+    {
+        return value(nullptr);
+    }
+
+    /** The value of a `JSON_event::value` event, allocated in an arena.
+     *
+     * @param arena The arena in which strings and large integers are allocated.
+     * @throw parse_error When the number could not be converted.
+     */
+    [[nodiscard]] datum value(std::pmr::memory_resource &arena) const
+    {
+        return value(&arena);
+    }
+
+    /** Skip over the current subtree.
+     *
+     * After a `JSON_event::start_object` or `JSON_event::start_array` event the rest of the
+     * object or array is skipped, including its end event. After a `JSON_event::key` event the value
+     * of the member is skipped. The skipped values are not converted.
+     *
+     * @throw parse_error When the text is not a valid JSON document.
+     */
+    void skip();
+
+    /** Read the current subtree as a datum.
+     *
+     * After a `JSON_event::start_object` or `JSON_event::start_array` event the rest of the
+     * object or array is read, including its end event. After a `JSON_event::key` event the value
+     * of the member is read. After a `JSON_event::value` event the value is returned.
+     *
+     * @throw parse_error When the text is not a valid JSON document.
+     */
+    [[nodiscard]] datum read()
+    {
+        return read(nullptr);
+    }
+
+    /** Read the current subtree as a datum, allocated in an arena.
+     *
+     * @see datum_document
+     * @param arena The monotonic arena in which all strings, vectors and maps are allocated.
+     * @throw parse_error When the text is not a valid JSON document.
+     */
+    [[nodiscard]] datum read(std::pmr::memory_resource &arena)
+    {
+        return read(&arena);
+    }
+
+    /** The location of the current token, for use in error messages.
+     */
+    [[nodiscard]] parse_location location() const noexcept;
+
+private:
+    struct frame_type {
+        bool is_object;
+
+        /** A comma was found after the last value; or this object or array has no values yet.
+         */
+        bool comma_after_value;
+
+        /** A key was read; the next event is the value of the member.
+         */
+        bool after_key;
+
+        /** The location of a value in this array which was not preceded by a comma.
+         * The error is reported after the value was read, so that errors in the value are reported first.
+         */
+        std::optional<parse_location> missing_comma;
+    };
+
+    std::unique_ptr<resource_view> _view;
+    std::unique_ptr<JSON_lexer> _lexer;
+
+    /** The objects and arrays the reader is in.
+     */
+    std::vector<frame_type> _stack;
+
+    JSON_event _event = JSON_event::end;
+    bool _started = false;
+
+    /** The last event finished a value; the next event checks for a comma.
+     */
+    bool _after_value = false;
+
+    /** The current token is a value which is still being used by `value()`.
+     */
+    bool _value_pending = false;
+
+    std::string _key;
+
+    [[nodiscard]] datum value(std::pmr::memory_resource *arena) const;
+    [[nodiscard]] datum read(std::pmr::memory_resource *arena);
+    JSON_event start_value();
+    void finish_value();
+};
+
+} // namespace tt
@@ -0,0 +1,111 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/codec/JSON_reader.hpp"
+#include "ttauri/exception.hpp"
+#include "ttauri/required.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+
+using namespace std;
+using namespace tt;
+
+TEST(JSON_reader, Events)
+{
+    auto reader = JSON_reader{"{\"foo\": [42, \"bar\"], \"baz\": {\"qux\": null}}"};
+
+    ASSERT_EQ(reader.next(), JSON_event::start_object);
+    ASSERT_EQ(reader.next(), JSON_event::key);
+    ASSERT_EQ(reader.key(), "foo");
+    ASSERT_EQ(reader.next(), JSON_event::start_array);
+    ASSERT_EQ(reader.depth(), 2);
+    ASSERT_EQ(reader.next(), JSON_event::value);
+    ASSERT_EQ(reader.value(), 42);
+    ASSERT_EQ(reader.next(), JSON_event::value);
+    ASSERT_EQ(reader.value(), "bar");
+    ASSERT_EQ(reader.next(), JSON_event::end_array);
+    ASSERT_EQ(reader.next(), JSON_event::key);
+    ASSERT_EQ(reader.key(), "baz");
+    ASSERT_EQ(reader.next(), JSON_event::start_object);
+    ASSERT_EQ(reader.next(), JSON_event::key);
+    ASSERT_EQ(reader.key(), "qux");
+    ASSERT_EQ(reader.next(), JSON_event::value);
+    ASSERT_EQ(reader.value(), datum{datum::null{}});
+    ASSERT_EQ(reader.next(), JSON_event::end_object);
+    ASSERT_EQ(reader.next(), JSON_event::end_object);
+    ASSERT_EQ(reader.depth(), 0);
+    ASSERT_EQ(reader.next(), JSON_event::end);
+}
+
+TEST(JSON_reader, EscapedKey)
+{
+    auto reader = JSON_reader{"{\"f\\too\": \"b\\nar\"}"};
+
+    ASSERT_EQ(reader.next(), JSON_event::start_object);
+    ASSERT_EQ(reader.next(), JSON_event::key);
+    ASSERT_EQ(reader.key(), "f\too");
+    ASSERT_EQ(reader.next(), JSON_event::value);
+    ASSERT_EQ(reader.value(), "b\nar");
+    ASSERT_EQ(reader.next(), JSON_event::end_object);
+    ASSERT_EQ(reader.next(), JSON_event::end);
+}
+
+TEST(JSON_reader, Skip)
+{
+    auto reader = JSON_reader{"{\"foo\": {\"a\": [1, [2, 3], {\"b\": 4}]}, \"bar\": [5, 6], \"baz\": 7, \"qux\": 8}"};
+
+    ASSERT_EQ(reader.next(), JSON_event::start_object);
+
+    // Skip the value of a member.
+    ASSERT_EQ(reader.next(), JSON_event::key);
+    ASSERT_EQ(reader.key(), "foo");
+    reader.skip();
+
+    // Skip the rest of an array.
+    ASSERT_EQ(reader.next(), JSON_event::key);
+    ASSERT_EQ(reader.key(), "bar");
+    ASSERT_EQ(reader.next(), JSON_event::start_array);
+    reader.skip();
+
+    // Skip a single value.
+    ASSERT_EQ(reader.next(), JSON_event::key);
+    ASSERT_EQ(reader.key(), "baz");
+    reader.skip();
+
+    ASSERT_EQ(reader.next(), JSON_event::key);
+    ASSERT_EQ(reader.key(), "qux");
+    ASSERT_EQ(reader.next(), JSON_event::value);
+    ASSERT_EQ(reader.value(), 8);
+    ASSERT_EQ(reader.next(), JSON_event::end_object);
+    ASSERT_EQ(reader.next(), JSON_event::end);
+}
+
+TEST(JSON_reader, Read)
+{
+    auto reader = JSON_reader{"{\"foo\": [1, 2], \"bar\": {\"baz\": true}}"};
+
+    ASSERT_EQ(reader.next(), JSON_event::start_object);
+    ASSERT_EQ(reader.next(), JSON_event::key);
+    reader.skip();
+
+    ASSERT_EQ(reader.next(), JSON_event::key);
+    ASSERT_EQ(reader.key(), "bar");
+
+    auto expected = datum::map{};
+    expected["baz"] = true;
+    ASSERT_EQ(reader.read(), expected);
+
+    ASSERT_EQ(reader.next(), JSON_event::end_object);
+    ASSERT_EQ(reader.next(), JSON_event::end);
+}
+
+TEST(JSON_reader, SkipInvalid)
+{
+    // Skipped subtrees are still checked.
+    auto reader = JSON_reader{"{\"foo\": [1 2], \"bar\": 3}"};
+
+    ASSERT_EQ(reader.next(), JSON_event::start_object);
+    ASSERT_EQ(reader.next(), JSON_event::key);
+    ASSERT_THROW(reader.skip(), parse_error);
+}
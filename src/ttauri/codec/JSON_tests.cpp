@@ -92,4 +92,75 @@ TEST(JSON, ParseTwoItemObject) {
     expected["foo"]["baz"] = 43;
     ASSERT_EQ(parse_JSON("{\"foo\": {\"bar\": 42, \"baz\": 43}}"), expected);
     ASSERT_EQ(parse_JSON("{\"foo\": {\"bar\": 42, \"baz\": 43,}}"), expected);
-}
\ No newline at end of file
+}
+TEST(JSON, ParseEscapedString) {
+    auto expected = datum::map{};
+    expected["foo"] = "a\"b\\c\nd\te";
+    ASSERT_EQ(parse_JSON("{\"foo\": \"a\\\"b\\\\c\\nd\\te\"}"), expected);
+}
+
+TEST(JSON, ParseUnicodeEscape) {
+    auto expected = datum::map{};
+    expected["foo"] = "a\x01\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80" "b";
+    ASSERT_EQ(parse_JSON("{\"foo\": \"a\\u0001\\u00E9\\u20ac\\ud83d\\ude00b\"}"), expected);
+
+    // Lone surrogates are replaced by U+FFFD.
+    expected["foo"] = "\xef\xbf\xbdx\xef\xbf\xbd";
+    ASSERT_EQ(parse_JSON("{\"foo\": \"\\ud83dx\\ude00\"}"), expected);
+
+    expected["foo"] = "\xe2\x82\xac";
+    ASSERT_EQ(parse_JSON("{\"foo\": \"\"\"\\u20ac\"\"\"}"), expected);
+}
+
+TEST(JSON, ParseLongString) {
+    auto expected = datum::map{};
+    expected["a long key of more than sixteen characters"] = "a long value with an escaped\nline-feed after more than sixteen characters";
+    ASSERT_EQ(
+        parse_JSON("{\"a long key of more than sixteen characters\": \"a long value with an escaped\\nline-feed after more than sixteen characters\"}"),
+        expected);
+}
+
+TEST(JSON, ParseComments) {
+    auto expected = datum::map{};
+    expected["foo"] = 42;
+    expected["bar"] = 43;
+    ASSERT_EQ(parse_JSON("// comment\n{\n    /* block\n     * comment */\n    \"foo\": 42, # comment\n    \"bar\": 43\n}\n"), expected);
+}
+
+TEST(JSON, ParseNumbers) {
+    auto expected = datum::map{};
+    expected["foo"] = datum::vector{-42, 1000.0, 150.0, -0.5, 0.001};
+    ASSERT_EQ(parse_JSON("{\"foo\":[-42, 1e3, 1.5e+2, -.5, 1.0e-3]}"), expected);
+    ASSERT_EQ(parse_JSON("{\"foo\":-42}")["foo"], -42);
+}
+
+TEST(JSON, ParseDocument) {
+    ttlet text = "{\"foo\": [42, \"a string longer than five characters\", {\"bar\": 1.5}], \"baz\": null}";
+    ttlet document = parse_JSON_document(text);
+    ASSERT_EQ(document.root(), parse_JSON(text));
+}
+
+static std::string parse_JSON_error(std::string_view text)
+{
+    try {
+        parse_JSON(text);
+    } catch (parse_error const &e) {
+        return e.what();
+    }
+    return {};
+}
+
+TEST(JSON, ParseErrors) {
+    ASSERT_EQ(parse_JSON_error("{\"foo\": 42\n    \"bar\": 43}"), "2:5: Missing expected ','");
+    ASSERT_EQ(parse_JSON_error("{\"foo\": [42\t43]}"), "1:17: Missing expected ','");
+    ASSERT_EQ(parse_JSON_error("{\"foo\" 42}"), "1:8: Missing expected ':'");
+    ASSERT_EQ(parse_JSON_error("{\"foo\": nope}"), "1:13: Unexpected name 'nope'");
+    ASSERT_EQ(parse_JSON_error("{\n\"foo\": \"bar\n\"}"), "2:12: Unexpected token 'ErrorLFInString'");
+    ASSERT_EQ(parse_JSON_error("{42}"), "1:2: Unexpected token IntegerLiteral\"42\", expected a key or close-brace.");
+    ASSERT_EQ(parse_JSON_error("{\"foo\": 2021-01-01}"), "1:9: Unexpected token 'DateLiteral'");
+    ASSERT_EQ(parse_JSON_error("{\"foo\": 'bar'}"), "1:9: Unexpected token 'ErrorInvalidCharacter'");
+    ASSERT_EQ(parse_JSON_error("{\"foo\": \"\\u12g4\"}"), "1:9: Unexpected token 'ErrorInvalidCharacter'");
+    ASSERT_EQ(parse_JSON_error("{\"foo\": \"\\u12"), "1:9: Unexpected token 'ErrorInvalidCharacter'");
+    ASSERT_EQ(parse_JSON_error("[42]"), "1:1: Missing JSON object");
+    ASSERT_EQ(parse_JSON_error("{} 42"), "1:4: Unexpected text after JSON root object");
+}
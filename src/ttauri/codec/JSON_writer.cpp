@@ -0,0 +1,302 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "JSON_writer.hpp"
+#include "../assert.hpp"
+#include "../cast.hpp"
+#if TT_X86_64_V2
+#include <emmintrin.h> // SSE2
+#endif
+#include <bit>
+#include <array>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+namespace tt {
+
+[[nodiscard]] constexpr bool JSON_needs_escape(char c) noexcept
+{
+    return static_cast<uint8_t>(c) < 0x20 || c == '"' || c == '\\';
+}
+
+/** Find the first character in a string which needs to be escaped.
+ *
+ * @return The first control character, double-quote or backslash, or last.
+ */
+[[nodiscard]] static char const *JSON_find_escape_scalar(char const *first, char const *last) noexcept
+{
+    for (; first != last; ++first) {
+        if (JSON_needs_escape(*first)) {
+            break;
+        }
+    }
+    return first;
+}
+
+#if TT_X86_64_V2
+[[nodiscard]] static char const *JSON_find_escape_sse(char const *first, char const *last) noexcept
+{
+    for (; last - first >= 16; first += 16) {
+        ttlet chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(first));
+
+        // Unsigned less-or-equal to 0x1f, so that bytes of UTF-8 sequences are not matched.
+        ttlet is_control = _mm_cmpeq_epi8(_mm_min_epu8(chunk, _mm_set1_epi8(0x1f)), chunk);
+        ttlet is_quote = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'));
+        ttlet is_backslash = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'));
+        ttlet is_escape = _mm_or_si128(is_control, _mm_or_si128(is_quote, is_backslash));
+
+        ttlet escape_mask = static_cast<unsigned int>(_mm_movemask_epi8(is_escape));
+        if (escape_mask != 0) {
+            return first + std::countr_zero(escape_mask);
+        }
+    }
+
+    return JSON_find_escape_scalar(first, last);
+}
+#endif
+
+[[nodiscard]] static char const *JSON_find_escape(char const *first, char const *last) noexcept
+{
+#if TT_X86_64_V2
+    return JSON_find_escape_sse(first, last);
+#else
+    return JSON_find_escape_scalar(first, last);
+#endif
+}
+
+JSON_writer::JSON_writer(int indent) noexcept : _indent(indent) {}
+
+JSON_writer::JSON_writer(file &output, int indent) noexcept : _file(&output), _indent(indent) {}
+
+void JSON_writer::flush()
+{
+    tt_axiom(_file != nullptr);
+    _file->write(_output.data(), std::ssize(_output));
+    _output.clear();
+}
+
+void JSON_writer::new_line() noexcept
+{
+    if (_indent != 0) {
+        _output += '\n';
+        _output.append(narrow_cast<size_t>(std::ssize(_stack) * _indent), ' ');
+    }
+}
+
+void JSON_writer::start_value() noexcept
+{
+    if (std::exchange(_after_key, false)) {
+        return;
+    }
+
+    if (!_stack.empty()) {
+        tt_axiom(!_stack.back().is_object);
+        if (!std::exchange(_stack.back().is_empty, false)) {
+            _output += ',';
+        }
+        new_line();
+    }
+}
+
+void JSON_writer::finish_value()
+{
+    if (_stack.empty()) {
+        // End the document with a line-feed.
+        _output += '\n';
+    }
+
+    if (_file != nullptr && _output.size() >= flush_size) {
+        flush();
+    }
+}
+
+void JSON_writer::start_container(bool is_object, char c) noexcept
+{
+    start_value();
+    _output += c;
+    _stack.push_back({is_object, true});
+}
+
+void JSON_writer::end_container(char c)
+{
+    tt_axiom(!_stack.empty() && !_after_key);
+    ttlet is_empty = _stack.back().is_empty;
+    _stack.pop_back();
+    if (!is_empty) {
+        new_line();
+    }
+    _output += c;
+    finish_value();
+}
+
+void JSON_writer::start_object()
+{
+    start_container(true, '{');
+}
+
+void JSON_writer::end_object()
+{
+    tt_axiom(_stack.back().is_object);
+    end_container('}');
+}
+
+void JSON_writer::start_array()
+{
+    start_container(false, '[');
+}
+
+void JSON_writer::end_array()
+{
+    tt_axiom(!_stack.back().is_object);
+    end_container(']');
+}
+
+void JSON_writer::key(std::string_view key)
+{
+    tt_axiom(!_stack.empty() && _stack.back().is_object && !_after_key);
+
+    if (!std::exchange(_stack.back().is_empty, false)) {
+        _output += ',';
+    }
+    new_line();
+    write_string(key);
+    _output += ':';
+    if (_indent != 0) {
+        _output += ' ';
+    }
+    _after_key = true;
+}
+
+void JSON_writer::write_string(std::string_view str) noexcept
+{
+    _output += '"';
+
+    auto first = str.data();
+    ttlet last = first + str.size();
+    while (true) {
+        // Copy the characters that do not need to be escaped at once.
+        ttlet p = JSON_find_escape(first, last);
+        _output.append(first, p);
+        if (p == last) {
+            break;
+        }
+
+        ttlet c = *p;
+        switch (c) {
+        case '"': _output += "\\\""; break;
+        case '\\': _output += "\\\\"; break;
+        case '\b': _output += "\\b"; break;
+        case '\f': _output += "\\f"; break;
+        case '\n': _output += "\\n"; break;
+        case '\r': _output += "\\r"; break;
+        case '\t': _output += "\\t"; break;
+        default: {
+            constexpr char hex_digits[] = "0123456789abcdef";
+            _output += "\\u00";
+            _output += hex_digits[(c >> 4) & 0xf];
+            _output += hex_digits[c & 0xf];
+        }
+        }
+        first = p + 1;
+    }
+
+    _output += '"';
+}
+
+void JSON_writer::string(std::string_view value)
+{
+    start_value();
+    write_string(value);
+    finish_value();
+}
+
+void JSON_writer::integer(long long value)
+{
+    start_value();
+
+    auto buffer = std::array<char, 24>{};
+    ttlet[last, ec] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+    tt_axiom(ec == std::errc{});
+    _output.append(buffer.data(), last);
+
+    finish_value();
+}
+
+void JSON_writer::number(double value)
+{
+    start_value();
+
+    if (!std::isfinite(value)) {
+        // JSON has no representation for infinite and not-a-number.
+        _output += "null";
+
+    } else {
+        // std::to_chars() without a precision writes the shortest text that round-trips to the same value.
+        auto buffer = std::array<char, 32>{};
+        ttlet[last, ec] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+        tt_axiom(ec == std::errc{});
+        _output.append(buffer.data(), last);
+
+        if (std::find_if(buffer.data(), last, [](ttlet c) {
+                return c == '.' || c == 'e';
+            }) == last) {
+            // Keep the number a floating point number when it is read back.
+            _output += ".0";
+        }
+    }
+
+    finish_value();
+}
+
+void JSON_writer::boolean(bool value)
+{
+    start_value();
+    _output += value ? "true" : "false";
+    finish_value();
+}
+
+void JSON_writer::null()
+{
+    start_value();
+    _output += "null";
+    finish_value();
+}
+
+void JSON_writer::value(datum const &value)
+{
+    switch (value.type()) {
+    case datum_type_t::Null: null(); break;
+
+    case datum_type_t::Boolean: boolean(static_cast<bool>(value)); break;
+
+    case datum_type_t::Integer: integer(static_cast<long long>(value)); break;
+
+    case datum_type_t::Float: number(static_cast<double>(value)); break;
+
+    case datum_type_t::String:
+    case datum_type_t::URL: string(static_cast<std::string>(value)); break;
+
+    case datum_type_t::Vector:
+        start_array();
+        for (auto i = value.vector_begin(); i != value.vector_end(); ++i) {
+            this->value(*i);
+        }
+        end_array();
+        break;
+
+    case datum_type_t::Map:
+        start_object();
+        for (auto i = value.map_begin(); i != value.map_end(); ++i) {
+            key(static_cast<std::string>(i->first));
+            this->value(i->second);
+        }
+        end_object();
+        break;
+
+    default: tt_no_default();
+    }
+}
+
+} // namespace tt
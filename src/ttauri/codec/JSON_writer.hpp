@@ -0,0 +1,125 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "../required.hpp"
+#include "../datum.hpp"
+#include "../file.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+
+namespace tt {
+
+/** An event driven JSON writer.
+ *
+ * The writer is the counterpart of `JSON_reader`: a document is written by calling
+ * `start_object()`, `key()`, the value functions and `end_object()`, or at once from a `datum`.
+ * The text is appended to a buffer which is taken using `take()`, or which is written to a file
+ * each time it grows beyond `flush_size`; so that large documents can be streamed to a file.
+ *
+ * Floating point numbers are written with the least number of digits that parse back to
+ * the same value, and always with a decimal point or exponent so that they remain floating point.
+ *
+ * Each document ends with a line-feed; with an indent of zero a sequence of documents
+ * is written as one document per line.
+ *
+ * When writing to a file the functions that write a value may throw an `io_error`.
+ *
+ * Typical usage:
+ * ```
+ * auto file = tt::file(location, access_mode::truncate_or_create_for_write);
+ * auto writer = JSON_writer{file};
+ * writer.start_object();
+ * writer.key("name");
+ * writer.string(name);
+ * writer.end_object();
+ * writer.flush();
+ * ```
+ */
+class JSON_writer {
+public:
+    /** The size of the buffer after which the text is written to the file.
+     */
+    static constexpr size_t flush_size = 0x10000;
+
+    /** Write JSON into a buffer.
+     *
+     * @param indent The number of spaces to indent each level; zero writes the document on a single line.
+     */
+    explicit JSON_writer(int indent = 4) noexcept;
+
+    /** Write JSON into a file.
+     *
+     * @param output The file to write to, which must outlive the writer.
+     * @param indent The number of spaces to indent each level; zero writes the document on a single line.
+     */
+    explicit JSON_writer(file &output, int indent = 4) noexcept;
+
+    JSON_writer(JSON_writer const &) = delete;
+    JSON_writer(JSON_writer &&) noexcept = default;
+    JSON_writer &operator=(JSON_writer const &) = delete;
+    JSON_writer &operator=(JSON_writer &&) noexcept = default;
+
+    void start_object();
+    void end_object();
+    void start_array();
+    void end_array();
+
+    /** Write the key of a member of an object; the value of the member is written next.
+     */
+    void key(std::string_view key);
+
+    void string(std::string_view value);
+    void integer(long long value);
+    void number(double value);
+    void boolean(bool value);
+    void null();
+
+    /** Write a datum, including nested maps and vectors.
+     */
+    void value(datum const &value);
+
+    /** Take the text written so far.
+     */
+    [[nodiscard]] std::string take() noexcept
+    {
+        return std::exchange(_output, std::string{});
+    }
+
+    /** Write the text written so far to the file.
+     *
+     * @throw io_error
+     */
+    void flush();
+
+private:
+    struct frame_type {
+        bool is_object;
+        bool is_empty;
+    };
+
+    file *_file = nullptr;
+    int _indent;
+    std::string _output;
+
+    /** The objects and arrays the writer is in.
+     */
+    std::vector<frame_type> _stack;
+
+    /** A key was written; the next value is the value of the member.
+     */
+    bool _after_key = false;
+
+    void new_line() noexcept;
+    void start_value() noexcept;
+    void finish_value();
+    void start_container(bool is_object, char c) noexcept;
+    void end_container(char c);
+    void write_string(std::string_view str) noexcept;
+};
+
+} // namespace tt
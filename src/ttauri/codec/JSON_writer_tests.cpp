@@ -0,0 +1,93 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/codec/JSON_writer.hpp"
+#include "ttauri/codec/JSON.hpp"
+#include "ttauri/required.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <limits>
+
+using namespace std;
+using namespace tt;
+
+TEST(JSON_writer, Events)
+{
+    auto writer = JSON_writer{};
+    writer.start_object();
+    writer.key("foo");
+    writer.start_array();
+    writer.integer(42);
+    writer.string("bar");
+    writer.start_object();
+    writer.end_object();
+    writer.end_array();
+    writer.key("baz");
+    writer.null();
+    writer.end_object();
+
+    ASSERT_EQ(writer.take(), "{\n    \"foo\": [\n        42,\n        \"bar\",\n        {}\n    ],\n    \"baz\": null\n}\n");
+}
+
+TEST(JSON_writer, Compact)
+{
+    auto writer = JSON_writer{0};
+    writer.start_object();
+    writer.key("foo");
+    writer.start_array();
+    writer.boolean(true);
+    writer.boolean(false);
+    writer.end_array();
+    writer.key("bar");
+    writer.number(1.5);
+    writer.end_object();
+    writer.start_array();
+    writer.end_array();
+
+    ASSERT_EQ(writer.take(), "{\"foo\":[true,false],\"bar\":1.5}\n[]\n");
+}
+
+TEST(JSON_writer, EscapeString)
+{
+    auto writer = JSON_writer{0};
+    writer.string("a \"long\" string with \\ escapes,\tcontrol\x01 characters\nand UTF-8 \xe2\x82\xac.");
+
+    ASSERT_EQ(
+        writer.take(),
+        "\"a \\\"long\\\" string with \\\\ escapes,\\tcontrol\\u0001 characters\\nand UTF-8 \xe2\x82\xac.\"\n");
+}
+
+TEST(JSON_writer, Number)
+{
+    auto writer = JSON_writer{0};
+    writer.start_array();
+    writer.number(0.1);
+    writer.number(1.0);
+    writer.number(-2.5e-8);
+    writer.number(1e300);
+    writer.number(1.0 / 3.0);
+    writer.number(std::numeric_limits<double>::infinity());
+    writer.end_array();
+
+    ASSERT_EQ(writer.take(), "[0.1,1.0,-2.5e-08,1e+300,0.3333333333333333,null]\n");
+}
+
+TEST(JSON_writer, RoundTrip)
+{
+    auto expected = datum::map{};
+    expected["foo"] = datum::vector{42, 0.1, "bar", true, datum::null{}};
+    expected["a \"quoted\"\tkey"] = datum::map{};
+    expected["baz"] = 2.0;
+
+    ASSERT_EQ(parse_JSON(format_JSON(expected)), expected);
+}
+
+TEST(JSON_writer, RoundTripControlCharacters)
+{
+    for (auto c = 0; c != 0x20; ++c) {
+        auto expected = datum::map{};
+        expected["k"] = std::string{"a"} + static_cast<char>(c) + "b";
+        ASSERT_EQ(parse_JSON(format_JSON(expected)), expected) << "c=" << c;
+    }
+}
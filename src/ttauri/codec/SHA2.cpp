@@ -0,0 +1,361 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "SHA2.hpp"
+#if TT_PROCESSOR == TT_CPU_X64
+#include "../cpu_id.hpp"
+#endif
+#if TT_X86_64_V2
+#include <emmintrin.h> // SSE2
+#include <tmmintrin.h> // SSSE3
+#include <smmintrin.h> // SSE4.1
+#include <immintrin.h> // SHA, AVX2
+#endif
+#include <utility>
+#include <cstring>
+
+// The SHA extensions are not part of any x86-64 micro-architecture level, so they
+// are enabled for only the functions that use them.
+#if TT_X86_64_V2 && TT_COMPILER != TT_CC_MSVC
+#define TT_TARGET_SHA __attribute__((target("sha,sse4.1")))
+#else
+#define TT_TARGET_SHA
+#endif
+
+namespace tt {
+namespace detail {
+
+constexpr std::array<uint32_t, 64> SHA256_K = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+constexpr std::array<uint32_t, 8> SHA256_initial_state = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+#if TT_X86_64_V2
+/** Four rounds of SHA-256 using the SHA extensions.
+ *
+ * The message words of the next rounds are calculated in a ring of four registers;
+ * `msg[I % 4]` holds the words of these rounds.
+ */
+template<int I>
+TT_TARGET_SHA static void SHA256_shani_rounds(__m128i &abef, __m128i &cdgh, __m128i (&msg)[4]) noexcept
+{
+    ttlet K = _mm_loadu_si128(reinterpret_cast<__m128i const *>(SHA256_K.data() + I * 4));
+
+    auto wk = _mm_add_epi32(msg[I % 4], K);
+    cdgh = _mm_sha256rnds2_epu32(cdgh, abef, wk);
+    if constexpr (I >= 3 and I <= 14) {
+        ttlet tmp = _mm_alignr_epi8(msg[I % 4], msg[(I + 3) % 4], 4);
+        msg[(I + 1) % 4] = _mm_sha256msg2_epu32(_mm_add_epi32(msg[(I + 1) % 4], tmp), msg[I % 4]);
+    }
+    wk = _mm_shuffle_epi32(wk, 0x0e);
+    abef = _mm_sha256rnds2_epu32(abef, cdgh, wk);
+    if constexpr (I >= 1 and I <= 12) {
+        msg[(I + 3) % 4] = _mm_sha256msg1_epu32(msg[(I + 3) % 4], msg[I % 4]);
+    }
+}
+
+template<int... I>
+TT_TARGET_SHA static void
+SHA256_shani_block(__m128i &abef, __m128i &cdgh, __m128i (&msg)[4], std::integer_sequence<int, I...>) noexcept
+{
+    (SHA256_shani_rounds<I>(abef, cdgh, msg), ...);
+}
+
+TT_TARGET_SHA void SHA256_compress_shani(std::array<uint32_t, 8> &state, std::byte const *ptr, size_t nr_blocks) noexcept
+{
+    ttlet big_endian = _mm_set_epi64x(0x0c0d'0e0f'0809'0a0bULL, 0x0405'0607'0001'0203ULL);
+
+    // The SHA instructions use the state words in the order ABEF and CDGH.
+    ttlet dcba = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(state.data())), 0xb1);
+    ttlet efgh = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(state.data() + 4)), 0x1b);
+    auto abef = _mm_alignr_epi8(dcba, efgh, 8);
+    auto cdgh = _mm_blend_epi16(efgh, dcba, 0xf0);
+
+    for (; nr_blocks != 0; --nr_blocks, ptr += 64) {
+        ttlet abef_save = abef;
+        ttlet cdgh_save = cdgh;
+
+        __m128i msg[4];
+        for (int i = 0; i != 4; ++i) {
+            msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(ptr + i * 16)), big_endian);
+        }
+
+        SHA256_shani_block(abef, cdgh, msg, std::make_integer_sequence<int, 16>{});
+
+        abef = _mm_add_epi32(abef, abef_save);
+        cdgh = _mm_add_epi32(cdgh, cdgh_save);
+    }
+
+    ttlet feba = _mm_shuffle_epi32(abef, 0x1b);
+    ttlet dchg = _mm_shuffle_epi32(cdgh, 0xb1);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(state.data()), _mm_blend_epi16(feba, dchg, 0xf0));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(state.data() + 4), _mm_alignr_epi8(dchg, feba, 8));
+}
+#endif
+
+#if TT_X86_64_V2
+// The AVX2 functions are compiled for AVX2 independent of the x86-64 level of the build,
+// and are only called when the CPU supports AVX2.
+template<int N>
+[[nodiscard]] tt_target_avx2 static __m256i SHA256_rotr_avx2(__m256i x) noexcept
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, N), _mm256_slli_epi32(x, 32 - N));
+}
+
+/** Load eight message words from each of the eight blocks; the result holds a word of every block.
+ */
+tt_target_avx2 static void SHA256_load_avx2(__m256i *W, std::array<std::byte const *, 8> const &blocks, size_t offset) noexcept
+{
+    ttlet big_endian = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    __m256i r[8];
+    for (int i = 0; i != 8; ++i) {
+        r[i] = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(blocks[i] + offset));
+    }
+
+    // Transpose the 8x8 matrix of words.
+    __m256i t[8];
+    for (int i = 0; i != 8; i += 2) {
+        t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+        t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+    }
+    for (int i = 0; i != 8; i += 4) {
+        r[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+        r[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+        r[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+        r[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+    for (int i = 0; i != 4; ++i) {
+        W[i] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r[i], r[i + 4], 0x20), big_endian);
+        W[i + 4] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r[i], r[i + 4], 0x31), big_endian);
+    }
+}
+
+/** Compress one block of each of eight independent messages.
+ *
+ * @param state The state of the messages, `state[word][message]`.
+ * @param blocks A pointer to the 64 byte block of each message.
+ */
+tt_target_avx2 static void SHA256_compress_x8_avx2(
+    std::array<std::array<uint32_t, 8>, 8> &state,
+    std::array<std::byte const *, 8> const &blocks) noexcept
+{
+    __m256i W[16];
+    SHA256_load_avx2(W, blocks, 0);
+    SHA256_load_avx2(W + 8, blocks, 32);
+
+    __m256i s[8];
+    for (int i = 0; i != 8; ++i) {
+        s[i] = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(state[i].data()));
+    }
+
+    auto a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+    for (int i = 0; i != 64; ++i) {
+        if (i >= 16) {
+            ttlet w15 = W[(i - 15) % 16];
+            ttlet w2 = W[(i - 2) % 16];
+            ttlet s0 = _mm256_xor_si256(
+                _mm256_xor_si256(SHA256_rotr_avx2<7>(w15), SHA256_rotr_avx2<18>(w15)), _mm256_srli_epi32(w15, 3));
+            ttlet s1 = _mm256_xor_si256(
+                _mm256_xor_si256(SHA256_rotr_avx2<17>(w2), SHA256_rotr_avx2<19>(w2)), _mm256_srli_epi32(w2, 10));
+            W[i % 16] = _mm256_add_epi32(_mm256_add_epi32(W[i % 16], s0), _mm256_add_epi32(W[(i - 7) % 16], s1));
+        }
+
+        ttlet S1 =
+            _mm256_xor_si256(_mm256_xor_si256(SHA256_rotr_avx2<6>(e), SHA256_rotr_avx2<11>(e)), SHA256_rotr_avx2<25>(e));
+        ttlet ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        ttlet T1 = _mm256_add_epi32(
+            _mm256_add_epi32(_mm256_add_epi32(h, S1), _mm256_add_epi32(ch, W[i % 16])),
+            _mm256_set1_epi32(static_cast<int>(SHA256_K[i])));
+
+        ttlet S0 =
+            _mm256_xor_si256(_mm256_xor_si256(SHA256_rotr_avx2<2>(a), SHA256_rotr_avx2<13>(a)), SHA256_rotr_avx2<22>(a));
+        ttlet maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        ttlet T2 = _mm256_add_epi32(S0, maj);
+
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi32(d, T1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi32(T1, T2);
+    }
+
+    __m256i const r[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i != 8; ++i) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(state[i].data()), _mm256_add_epi32(s[i], r[i]));
+    }
+}
+
+/** A message being hashed in a lane of the multi-buffer SHA-256.
+ */
+struct SHA256_lane {
+    /** The index of the message, or -1 when the lane is idle.
+     */
+    ssize_t index = -1;
+
+    /** The next complete block of the message.
+     */
+    std::byte const *ptr = nullptr;
+
+    /** The number of complete blocks left in the message.
+     */
+    size_t nr_blocks = 0;
+
+    /** The padded tail of the message, one or two blocks.
+     */
+    std::array<std::byte, 128> tail = {};
+    size_t nr_tail_blocks = 0;
+    size_t tail_offset = 0;
+
+    void start(ssize_t message_index, std::span<std::byte const> message) noexcept
+    {
+        index = message_index;
+        ptr = message.data();
+        nr_blocks = message.size() / 64;
+
+        ttlet tail_size = message.size() % 64;
+        tail.fill(std::byte{0});
+        std::memcpy(tail.data(), message.data() + nr_blocks * 64, tail_size);
+        tail[tail_size] = std::byte{0x80};
+
+        nr_tail_blocks = tail_size + 9 > 64 ? 2 : 1;
+        tail_offset = 0;
+
+        ttlet nr_of_bits = static_cast<uint64_t>(message.size()) * 8;
+        ttlet length_ptr = tail.data() + nr_tail_blocks * 64 - 8;
+        for (int i = 0; i != 8; ++i) {
+            length_ptr[i] = static_cast<std::byte>(nr_of_bits >> (7 - i) * 8);
+        }
+    }
+
+    /** The block to hash next.
+     */
+    [[nodiscard]] std::byte const *block() const noexcept
+    {
+        return nr_blocks != 0 ? ptr : tail.data() + tail_offset;
+    }
+
+    /** Skip to the next block.
+     * @return true when the last block has been hashed.
+     */
+    [[nodiscard]] bool next() noexcept
+    {
+        if (nr_blocks != 0) {
+            --nr_blocks;
+            ptr += 64;
+            return false;
+        } else {
+            tail_offset += 64;
+            return --nr_tail_blocks == 0;
+        }
+    }
+};
+
+[[nodiscard]] tt_target_avx2 std::vector<bstring> SHA256_multi_avx2(std::span<std::span<std::byte const> const> messages)
+{
+    auto r = std::vector<bstring>(messages.size());
+    if (messages.empty()) {
+        return r;
+    }
+
+    alignas(32) auto state = std::array<std::array<uint32_t, 8>, 8>{};
+    auto lanes = std::array<SHA256_lane, 8>{};
+    auto idle = std::array<std::byte, 64>{};
+    ssize_t next_message = 0;
+    ssize_t nr_active = 0;
+
+    ttlet start = [&](size_t lane_nr) {
+        if (next_message == std::ssize(messages)) {
+            lanes[lane_nr].index = -1;
+            return;
+        }
+
+        for (int i = 0; i != 8; ++i) {
+            state[i][lane_nr] = SHA256_initial_state[i];
+        }
+        lanes[lane_nr].start(next_message, messages[next_message]);
+        ++next_message;
+        ++nr_active;
+    };
+
+    for (size_t lane_nr = 0; lane_nr != 8; ++lane_nr) {
+        start(lane_nr);
+    }
+
+    auto blocks = std::array<std::byte const *, 8>{};
+    while (nr_active != 0) {
+        for (size_t lane_nr = 0; lane_nr != 8; ++lane_nr) {
+            blocks[lane_nr] = lanes[lane_nr].index >= 0 ? lanes[lane_nr].block() : idle.data();
+        }
+
+        SHA256_compress_x8_avx2(state, blocks);
+
+        for (size_t lane_nr = 0; lane_nr != 8; ++lane_nr) {
+            auto &lane = lanes[lane_nr];
+            if (lane.index >= 0 and lane.next()) {
+                auto &hash = r[lane.index];
+                hash.reserve(32);
+                for (int i = 0; i != 8; ++i) {
+                    ttlet word = state[i][lane_nr];
+                    for (int j = 3; j >= 0; --j) {
+                        hash += static_cast<std::byte>(word >> j * 8);
+                    }
+                }
+
+                --nr_active;
+                start(lane_nr);
+            }
+        }
+    }
+    return r;
+}
+#endif
+
+[[nodiscard]] bool SHA256_compress(std::array<uint32_t, 8> &state, std::byte const *ptr, size_t nr_blocks) noexcept
+{
+#if TT_X86_64_V2
+    static ttlet has_sha = cpu_has_sha() and cpu_has_sse4_1();
+    if (has_sha) {
+        SHA256_compress_shani(state, ptr, nr_blocks);
+        return true;
+    }
+#endif
+    return false;
+}
+
+} // namespace detail
+
+[[nodiscard]] std::vector<bstring> SHA256_multi(std::span<std::span<std::byte const> const> messages)
+{
+#if TT_X86_64_V2
+    // A single stream using the SHA extensions is faster than eight streams in AVX2.
+    static ttlet use_avx2 = cpu_has_avx2() and not(cpu_has_sha() and cpu_has_sse4_1());
+    if (use_avx2) {
+        return detail::SHA256_multi_avx2(messages);
+    }
+#endif
+
+    auto r = std::vector<bstring>{};
+    r.reserve(messages.size());
+    for (ttlet message : messages) {
+        auto hash = SHA256{};
+        hash.add(message);
+        r.push_back(hash.get_bytes());
+    }
+    return r;
+}
+
+} // namespace tt
@@ -6,13 +6,48 @@
 
 #include "../byte_string.hpp"
 #include "../required.hpp"
+#include "../architecture.hpp"
 #include "../assert.hpp"
 #include <bit>
 #include <array>
 #include <cstdint>
 #include <span>
+#include <vector>
+#include <type_traits>
 
 namespace tt {
+namespace detail {
+
+#if TT_X86_64_V2
+/** Compress complete blocks into a SHA-256 state using the SHA extensions.
+ *
+ * @pre The CPU supports SHA and SSE4.1.
+ * @param state The state words a to h.
+ * @param ptr The first byte of the blocks.
+ * @param nr_blocks The number of 64 byte blocks.
+ */
+void SHA256_compress_shani(std::array<uint32_t, 8> &state, std::byte const *ptr, size_t nr_blocks) noexcept;
+#endif
+
+#if TT_X86_64_V2
+/** Calculate the SHA-256 of each message, hashing eight messages at a time in the lanes of AVX2 registers.
+ *
+ * @pre The CPU supports AVX2.
+ */
+[[nodiscard]] std::vector<bstring> SHA256_multi_avx2(std::span<std::span<std::byte const> const> messages);
+#endif
+
+/** Compress complete blocks into a SHA-256 state using the fastest method the CPU supports.
+ *
+ * @param state The state words a to h.
+ * @param ptr The first byte of the blocks.
+ * @param nr_blocks The number of 64 byte blocks.
+ * @return false when the CPU has no accelerated method, the state is not modified.
+ */
+[[nodiscard]] bool SHA256_compress(std::array<uint32_t, 8> &state, std::byte const *ptr, size_t nr_blocks) noexcept;
+
+} // namespace detail
+
 namespace detail::SHA2 {
 
 template<typename T>
@@ -252,6 +287,26 @@ class SHA2 {
         state += tmp;
     }
 
+    /** Add complete blocks.
+     * At run-time SHA-224 and SHA-256 use the SHA extensions of the CPU when available.
+     */
+    constexpr void add_blocks(cbyteptr ptr, size_t nr_blocks) noexcept
+    {
+        if constexpr (std::is_same_v<T, uint32_t>) {
+            if (not std::is_constant_evaluated()) {
+                auto words = std::array<uint32_t, 8>{state.a, state.b, state.c, state.d, state.e, state.f, state.g, state.h};
+                if (detail::SHA256_compress(words, ptr, nr_blocks)) {
+                    state = state_type{words[0], words[1], words[2], words[3], words[4], words[5], words[6], words[7]};
+                    return;
+                }
+            }
+        }
+
+        for (; nr_blocks != 0; --nr_blocks, ptr += block_type::size) {
+            add(block_type{ptr});
+        }
+    }
+
     constexpr void add_to_overflow(cbyteptr &ptr, std::byte const *last) noexcept {
         while (overflow_it != overflow.end() && ptr != last) {
             *(overflow_it++) = *(ptr++);
@@ -271,7 +326,7 @@ class SHA2 {
             while (overflow_it != overflow.end()) {
                 *(overflow_it++) = std::byte{0x00};
             }
-            add(block_type{overflow.data()});
+            add_blocks(overflow.data(), 1);
             overflow_it = overflow.begin();
         }
 
@@ -286,8 +341,7 @@ class SHA2 {
             *(overflow_it++) = i < sizeof(nr_of_bits) ? static_cast<std::byte>(nr_of_bits >> i * 8) : std::byte{0x00};
         }
 
-        auto b = block_type{overflow.data()};
-        add(b);
+        add_blocks(overflow.data(), 1);
     }
 
 public:
@@ -304,7 +358,7 @@ public:
             add_to_overflow(ptr, last);
 
             if (overflow_it == overflow.end()) {
-                add(block_type{overflow.data()});
+                add_blocks(overflow.data(), 1);
                 overflow_it = overflow.begin();
 
             } else {
@@ -315,10 +369,9 @@ public:
             }
         }
 
-        while (ptr + block_type::size <= last) {
-            add(block_type{ptr});
-            ptr += block_type::size;
-        }
+        ttlet nr_blocks = static_cast<size_t>(last - ptr) / block_type::size;
+        add_blocks(ptr, nr_blocks);
+        ptr += nr_blocks * block_type::size;
 
         add_to_overflow(ptr, last);
 
@@ -418,5 +471,15 @@ public:
         ) {}
 };
 
+/** Calculate the SHA-256 of many independent messages.
+ *
+ * This is faster than hashing the messages one after another with `SHA256` on CPUs
+ * with AVX2 but without the SHA extensions, where eight messages are hashed in parallel.
+ *
+ * @param messages The messages to hash.
+ * @return The 32 byte hash of each message.
+ */
+[[nodiscard]] std::vector<bstring> SHA256_multi(std::span<std::span<std::byte const> const> messages);
+
 }
 
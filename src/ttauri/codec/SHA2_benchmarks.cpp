@@ -0,0 +1,52 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/codec/SHA2.hpp"
+#include "ttauri/cast.hpp"
+#include "ttauri/required.hpp"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+using namespace tt;
+
+static void report_throughput(benchmark::State &state, int64_t nr_bytes)
+{
+    state.SetBytesProcessed(nr_bytes);
+    state.counters["GB"] = benchmark::Counter(static_cast<double>(nr_bytes) / 1e9, benchmark::Counter::kIsRate);
+}
+
+/** Hash a single message with the fastest compression function the CPU supports.
+ */
+template<typename T>
+static void SHA2_single(benchmark::State &state)
+{
+    ttlet message = bstring(narrow_cast<size_t>(state.range(0)), std::byte{0x5a});
+
+    for (auto _ : state) {
+        auto hash = T{};
+        hash.add(message);
+        benchmark::DoNotOptimize(hash.get_bytes());
+    }
+    report_throughput(state, state.iterations() * std::ssize(message));
+}
+
+/** Hash many messages, such as the files in a resource directory.
+ */
+static void SHA256_many(benchmark::State &state)
+{
+    ttlet messages = std::vector<bstring>(256, bstring(narrow_cast<size_t>(state.range(0)), std::byte{0x5a}));
+    auto spans = std::vector<std::span<std::byte const>>{};
+    for (ttlet &message : messages) {
+        spans.emplace_back(message);
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(SHA256_multi(spans));
+    }
+    report_throughput(state, state.iterations() * std::ssize(messages) * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(SHA2_single, SHA256)->Arg(64)->Arg(4096)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(SHA2_single, SHA512)->Arg(64)->Arg(4096)->Arg(1 << 20);
+BENCHMARK(SHA256_many)->Arg(64)->Arg(4096)->Arg(65536);
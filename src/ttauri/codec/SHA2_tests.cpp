@@ -6,8 +6,12 @@
 #include "ttauri/codec/base_n.hpp"
 #include "ttauri/required.hpp"
 #include "ttauri/strings.hpp"
+#if TT_PROCESSOR == TT_CPU_X64
+#include "ttauri/cpu_id.hpp"
+#endif
 #include <gtest/gtest.h>
 #include <iostream>
+#include <random>
 
 using namespace std;
 using namespace tt;
@@ -163,3 +167,89 @@ TEST(SHA2, NESSIE512Set1) {
         "DE0FF244877EA60A4CB0432CE577C31B"
         "EB009C5C2C49AA2E4EADB217AD8CC09B");
 }
+
+/** Messages of every length around the block and padding boundaries, and a few large ones.
+ */
+static std::vector<bstring> multi_messages()
+{
+    auto engine = std::mt19937{42};
+    auto dist = std::uniform_int_distribution<int>{0, 255};
+
+    auto r = std::vector<bstring>{};
+    for (ttlet size : {0, 1, 55, 56, 63, 64, 65, 119, 120, 128, 1000, 5000, 100'000}) {
+        auto message = bstring{};
+        for (int i = 0; i != size; ++i) {
+            message.push_back(static_cast<std::byte>(dist(engine)));
+        }
+        r.push_back(message);
+    }
+    for (int size = 0; size != 300; ++size) {
+        r.push_back(bstring(size, static_cast<std::byte>(size)));
+    }
+    return r;
+}
+
+template<typename Func>
+static void compare_SHA256_multi(Func const &func)
+{
+    ttlet messages = multi_messages();
+    auto spans = std::vector<std::span<std::byte const>>{};
+    for (ttlet &message : messages) {
+        spans.emplace_back(message);
+    }
+
+    ttlet hashes = func(spans);
+    ASSERT_EQ(hashes.size(), messages.size());
+    for (size_t i = 0; i != messages.size(); ++i) {
+        auto h = SHA256();
+        h.add(messages[i]);
+        ASSERT_EQ(hashes[i], h.get_bytes()) << "size=" << messages[i].size();
+    }
+
+    ASSERT_TRUE(func(std::span<std::span<std::byte const> const>{}).empty());
+}
+
+TEST(SHA2, SHA256Multi)
+{
+    compare_SHA256_multi(SHA256_multi);
+
+    ttlet abc = to_bstring("abc");
+    ttlet spans = std::vector<std::span<std::byte const>>{abc, abc};
+    ttlet hashes = SHA256_multi(spans);
+    ASSERT_CASEEQ(base16::encode(hashes[1]), "BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD");
+}
+
+#if TT_X86_64_V2
+TEST(SHA2, SHA256MultiAVX2)
+{
+    if (not cpu_has_avx2()) {
+        GTEST_SKIP() << "The CPU does not support AVX2.";
+    }
+    compare_SHA256_multi(detail::SHA256_multi_avx2);
+}
+#endif
+
+#if TT_X86_64_V2
+TEST(SHA2, SHA256SHANI)
+{
+    if (not(cpu_has_sha() and cpu_has_sse4_1())) {
+        GTEST_SKIP() << "The CPU does not support the SHA extensions.";
+    }
+
+    // The padded block of "abc", which is compared with the NESSIE test vector.
+    auto block = bstring(64, std::byte{0});
+    block[0] = std::byte{'a'};
+    block[1] = std::byte{'b'};
+    block[2] = std::byte{'c'};
+    block[3] = std::byte{0x80};
+    block[63] = std::byte{24};
+
+    auto state = std::array<uint32_t, 8>{
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    detail::SHA256_compress_shani(state, block.data(), 1);
+    ASSERT_EQ(
+        state,
+        (std::array<uint32_t, 8>{
+            0xba7816bf, 0x8f01cfea, 0x414140de, 0x5dae2223, 0xb00361a3, 0x96177a9c, 0xb410ff61, 0xf20015ad}));
+}
+#endif
@@ -0,0 +1,564 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "UTF.hpp"
+#include "../cast.hpp"
+#if TT_PROCESSOR == TT_CPU_X64
+#include "../cpu_id.hpp"
+#endif
+#if TT_X86_64_V1
+#include <emmintrin.h> // SSE2
+#endif
+#if TT_X86_64_V2
+#include <tmmintrin.h> // SSSE3
+#include <immintrin.h> // AVX2
+#endif
+#include <cstring>
+
+namespace tt {
+namespace detail {
+
+/** Check if the next 8 code units are all ASCII.
+ */
+[[nodiscard]] static bool is_ascii8(char8_t const *ptr) noexcept
+{
+    uint64_t chunk;
+    std::memcpy(&chunk, ptr, sizeof(chunk));
+    return (chunk & 0x8080'8080'8080'8080) == 0;
+}
+
+[[nodiscard]] size_t utf8_valid_size_scalar(char8_t const *str, size_t size) noexcept
+{
+    size_t i = 0;
+    while (i != size) {
+        if (size - i >= 8 and is_ascii8(str + i)) {
+            i += 8;
+            continue;
+        }
+
+        ttlet first_cu = str[i];
+        if (first_cu <= 0x7f) {
+            ++i;
+            continue;
+        }
+
+        size_t continuation_count = 0;
+        char32_t code_point_min = 0;
+        if (first_cu <= 0xbf) {
+            // Continuation code unit without a lead.
+            return i;
+        } else if (first_cu <= 0xdf) {
+            continuation_count = 1;
+            code_point_min = 0x80;
+        } else if (first_cu <= 0xef) {
+            continuation_count = 2;
+            code_point_min = 0x800;
+        } else if (first_cu <= 0xf7) {
+            continuation_count = 3;
+            code_point_min = 0x1'0000;
+        } else {
+            return i;
+        }
+
+        if (size - i <= continuation_count) {
+            // Incomplete code-point at the end of the string.
+            return i;
+        }
+
+        auto code_point = static_cast<char32_t>(first_cu & (0x7f >> (continuation_count + 1)));
+        for (size_t j = 1; j <= continuation_count; ++j) {
+            ttlet cu = str[i + j];
+            if ((cu & 0xc0) != 0x80) {
+                return i;
+            }
+            code_point <<= 6;
+            code_point |= cu & 0x3f;
+        }
+
+        if (code_point < code_point_min or code_point > 0x10ffff or (code_point >= 0xd800 and code_point <= 0xdfff)) {
+            return i;
+        }
+        i += continuation_count + 1;
+    }
+    return size;
+}
+
+/** Move an offset back to the start of the code-point which may continue at the offset.
+ *
+ * The SIMD validators report an error at the code unit where the error is detected, which
+ * may be after the start of the offending code-point. Everything before the returned offset
+ * was validated, so the scalar validator can continue from there.
+ */
+[[nodiscard]] static size_t utf8_code_point_start(char8_t const *str, size_t offset) noexcept
+{
+    ttlet first = offset >= 3 ? offset - 3 : 0;
+    while (offset != first and (str[offset - 1] & 0xc0) == 0x80) {
+        --offset;
+    }
+    if (offset != 0 and str[offset - 1] >= 0xc0) {
+        --offset;
+    }
+    return offset;
+}
+
+// The error classes of the lookup based UTF-8 validator of John Keiser and Daniel Lemire.
+// Each class is detected by combining lookups on the high and low nibble of the previous
+// code unit and the high nibble of the current code unit.
+constexpr uint8_t utf8_too_short = 1 << 0; // 11______ 0_______ or 11______ 11______
+constexpr uint8_t utf8_too_long = 1 << 1; // 0_______ 10______
+constexpr uint8_t utf8_overlong_3 = 1 << 2; // 11100000 100_____
+constexpr uint8_t utf8_too_large = 1 << 3; // 11110100 1001____ or 11110100 101_____ or 11110101+ 10______
+constexpr uint8_t utf8_surrogate = 1 << 4; // 11101101 101_____
+constexpr uint8_t utf8_overlong_2 = 1 << 5; // 1100000_ 10______
+constexpr uint8_t utf8_too_large_1000 = 1 << 6; // 11110101+ 1000____
+constexpr uint8_t utf8_overlong_4 = 1 << 6; // 11110000 1000____
+constexpr uint8_t utf8_two_conts = 1 << 7; // 10______ 10______
+constexpr uint8_t utf8_carry = utf8_too_short | utf8_too_long | utf8_two_conts;
+
+// clang-format off
+constexpr uint8_t utf8_byte_1_high[16] = {
+    // 0_______ ________
+    utf8_too_long, utf8_too_long, utf8_too_long, utf8_too_long,
+    utf8_too_long, utf8_too_long, utf8_too_long, utf8_too_long,
+    // 10______ ________
+    utf8_two_conts, utf8_two_conts, utf8_two_conts, utf8_two_conts,
+    // 1100____ ________
+    utf8_too_short | utf8_overlong_2,
+    // 1101____ ________
+    utf8_too_short,
+    // 1110____ ________
+    utf8_too_short | utf8_overlong_3 | utf8_surrogate,
+    // 1111____ ________
+    utf8_too_short | utf8_too_large | utf8_too_large_1000 | utf8_overlong_4
+};
+
+constexpr uint8_t utf8_byte_1_low[16] = {
+    // ____0000 ________
+    utf8_carry | utf8_overlong_3 | utf8_overlong_2 | utf8_overlong_4,
+    // ____0001 ________
+    utf8_carry | utf8_overlong_2,
+    // ____001_ ________
+    utf8_carry,
+    utf8_carry,
+    // ____0100 ________
+    utf8_carry | utf8_too_large,
+    // ____0101 ________
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    // ____011_ ________
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    // ____1___ ________
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    // ____1101 ________
+    utf8_carry | utf8_too_large | utf8_too_large_1000 | utf8_surrogate,
+    utf8_carry | utf8_too_large | utf8_too_large_1000,
+    utf8_carry | utf8_too_large | utf8_too_large_1000
+};
+
+constexpr uint8_t utf8_byte_2_high[16] = {
+    // ________ 0_______
+    utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short,
+    utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short,
+    // ________ 1000____
+    utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_overlong_3 | utf8_too_large_1000 | utf8_overlong_4,
+    // ________ 1001____
+    utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_overlong_3 | utf8_too_large,
+    // ________ 101_____
+    utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_surrogate | utf8_too_large,
+    utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_surrogate | utf8_too_large,
+    // ________ 11______
+    utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short
+};
+
+/** A code unit at the end of a block which requires more code units in the next block.
+ * The subtraction saturates to zero for any code unit that completes a code-point.
+ */
+constexpr uint8_t utf8_incomplete_max[16] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xef, 0xdf, 0xbf
+};
+// clang-format on
+
+#if TT_X86_64_V2
+/** Find the errors in a block of UTF-8, given the previous block.
+ */
+[[nodiscard]] static __m128i utf8_errors_ssse3(__m128i input, __m128i prev_input) noexcept
+{
+    ttlet nibble_mask = _mm_set1_epi8(0x0f);
+    ttlet byte_1_high_table = _mm_loadu_si128(reinterpret_cast<__m128i const *>(utf8_byte_1_high));
+    ttlet byte_1_low_table = _mm_loadu_si128(reinterpret_cast<__m128i const *>(utf8_byte_1_low));
+    ttlet byte_2_high_table = _mm_loadu_si128(reinterpret_cast<__m128i const *>(utf8_byte_2_high));
+
+    ttlet prev1 = _mm_alignr_epi8(input, prev_input, 15);
+    ttlet byte_1_high = _mm_shuffle_epi8(byte_1_high_table, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble_mask));
+    ttlet byte_1_low = _mm_shuffle_epi8(byte_1_low_table, _mm_and_si128(prev1, nibble_mask));
+    ttlet byte_2_high = _mm_shuffle_epi8(byte_2_high_table, _mm_and_si128(_mm_srli_epi16(input, 4), nibble_mask));
+    ttlet special_cases = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+    // The third and fourth code unit of a code-point are found from the lead two or three code units back.
+    ttlet prev2 = _mm_alignr_epi8(input, prev_input, 14);
+    ttlet prev3 = _mm_alignr_epi8(input, prev_input, 13);
+    ttlet is_third_byte = _mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xe0 - 0x80)));
+    ttlet is_fourth_byte = _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xf0 - 0x80)));
+    ttlet must_be_continuation =
+        _mm_and_si128(_mm_or_si128(is_third_byte, is_fourth_byte), _mm_set1_epi8(static_cast<char>(0x80)));
+    return _mm_xor_si128(must_be_continuation, special_cases);
+}
+
+[[nodiscard]] size_t utf8_valid_size_ssse3(char8_t const *str, size_t size) noexcept
+{
+    ttlet incomplete_max = _mm_loadu_si128(reinterpret_cast<__m128i const *>(utf8_incomplete_max));
+
+    auto prev_input = _mm_setzero_si128();
+    auto prev_incomplete = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        ttlet input = _mm_loadu_si128(reinterpret_cast<__m128i const *>(str + i));
+
+        auto errors = prev_incomplete;
+        if (_mm_movemask_epi8(input) != 0) {
+            errors = utf8_errors_ssse3(input, prev_input);
+            prev_incomplete = _mm_subs_epu8(input, incomplete_max);
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(errors, _mm_setzero_si128())) != 0xffff) {
+            break;
+        }
+        prev_input = input;
+    }
+    return utf8_code_point_start(str, i);
+}
+#endif
+
+#if TT_X86_64_V2
+// The AVX2 functions are compiled for AVX2 independent of the x86-64 level of the build,
+// and are only called when the CPU supports AVX2.
+
+/** Find the errors in a block of UTF-8, given the previous block.
+ */
+[[nodiscard]] tt_target_avx2 static __m256i utf8_errors_avx2(__m256i input, __m256i prev_input) noexcept
+{
+    ttlet nibble_mask = _mm256_set1_epi8(0x0f);
+    ttlet byte_1_high_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const *>(utf8_byte_1_high)));
+    ttlet byte_1_low_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const *>(utf8_byte_1_low)));
+    ttlet byte_2_high_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const *>(utf8_byte_2_high)));
+
+    // The high lane of the previous block and the low lane of this block, so that alignr crosses lanes.
+    ttlet prev_lanes = _mm256_permute2x128_si256(prev_input, input, 0x21);
+
+    ttlet prev1 = _mm256_alignr_epi8(input, prev_lanes, 15);
+    ttlet byte_1_high = _mm256_shuffle_epi8(byte_1_high_table, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble_mask));
+    ttlet byte_1_low = _mm256_shuffle_epi8(byte_1_low_table, _mm256_and_si256(prev1, nibble_mask));
+    ttlet byte_2_high = _mm256_shuffle_epi8(byte_2_high_table, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble_mask));
+    ttlet special_cases = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    ttlet prev2 = _mm256_alignr_epi8(input, prev_lanes, 14);
+    ttlet prev3 = _mm256_alignr_epi8(input, prev_lanes, 13);
+    ttlet is_third_byte = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xe0 - 0x80)));
+    ttlet is_fourth_byte = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xf0 - 0x80)));
+    ttlet must_be_continuation =
+        _mm256_and_si256(_mm256_or_si256(is_third_byte, is_fourth_byte), _mm256_set1_epi8(static_cast<char>(0x80)));
+    return _mm256_xor_si256(must_be_continuation, special_cases);
+}
+
+[[nodiscard]] tt_target_avx2 size_t utf8_valid_size_avx2(char8_t const *str, size_t size) noexcept
+{
+    ttlet incomplete_max = _mm256_inserti128_si256(
+        _mm256_set1_epi8(static_cast<char>(0xff)), _mm_loadu_si128(reinterpret_cast<__m128i const *>(utf8_incomplete_max)), 1);
+
+    auto prev_input = _mm256_setzero_si256();
+    auto prev_incomplete = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        ttlet input = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(str + i));
+
+        auto errors = prev_incomplete;
+        if (_mm256_movemask_epi8(input) != 0) {
+            errors = utf8_errors_avx2(input, prev_input);
+            prev_incomplete = _mm256_subs_epu8(input, incomplete_max);
+        }
+        if (not _mm256_testz_si256(errors, errors)) {
+            break;
+        }
+        prev_input = input;
+    }
+    return utf8_code_point_start(str, i);
+}
+#endif
+
+[[nodiscard]] size_t utf8_valid_size(char8_t const *str, size_t size) noexcept
+{
+    size_t nr_valid = 0;
+#if TT_X86_64_V2
+    static ttlet has_avx2 = cpu_has_avx2();
+    if (has_avx2) {
+        nr_valid = utf8_valid_size_avx2(str, size);
+    } else {
+        nr_valid = utf8_valid_size_ssse3(str, size);
+    }
+#endif
+    return nr_valid + utf8_valid_size_scalar(str + nr_valid, size - nr_valid);
+}
+
+/** Read a code-point from valid UTF-8.
+ */
+[[nodiscard]] static tt_force_inline char32_t get_utf8(char8_t const *&str) noexcept
+{
+    ttlet cu = *(str++);
+    if (cu <= 0x7f) {
+        return cu;
+    } else if (cu <= 0xdf) {
+        ttlet cp = static_cast<char32_t>(cu & 0x1f) << 6 | static_cast<char32_t>(str[0] & 0x3f);
+        str += 1;
+        return cp;
+    } else if (cu <= 0xef) {
+        ttlet cp = static_cast<char32_t>(cu & 0x0f) << 12 | static_cast<char32_t>(str[0] & 0x3f) << 6 |
+            static_cast<char32_t>(str[1] & 0x3f);
+        str += 2;
+        return cp;
+    } else {
+        ttlet cp = static_cast<char32_t>(cu & 0x07) << 18 | static_cast<char32_t>(str[0] & 0x3f) << 12 |
+            static_cast<char32_t>(str[1] & 0x3f) << 6 | static_cast<char32_t>(str[2] & 0x3f);
+        str += 3;
+        return cp;
+    }
+}
+
+/** Write a code-point as UTF-8.
+ */
+static tt_force_inline void put_utf8(char8_t *&output, char32_t code_point) noexcept
+{
+    if (code_point <= 0x7f) {
+        *(output++) = static_cast<char8_t>(code_point);
+
+    } else if (code_point <= 0x07ff) {
+        *(output++) = static_cast<char8_t>((code_point >> 6) | 0xc0);
+        *(output++) = static_cast<char8_t>((code_point & 0x3f) | 0x80);
+
+    } else if (code_point <= 0xffff) {
+        tt_axiom(!(code_point >= 0xd800 && code_point <= 0xdfff), "Code Point must not be a surrogate");
+        *(output++) = static_cast<char8_t>((code_point >> 12) | 0xe0);
+        *(output++) = static_cast<char8_t>(((code_point >> 6) & 0x3f) | 0x80);
+        *(output++) = static_cast<char8_t>((code_point & 0x3f) | 0x80);
+
+    } else {
+        tt_axiom(code_point <= 0x10ffff, "Code Point must be in range of the 17 planes");
+        *(output++) = static_cast<char8_t>((code_point >> 18) | 0xf0);
+        *(output++) = static_cast<char8_t>(((code_point >> 12) & 0x3f) | 0x80);
+        *(output++) = static_cast<char8_t>(((code_point >> 6) & 0x3f) | 0x80);
+        *(output++) = static_cast<char8_t>((code_point & 0x3f) | 0x80);
+    }
+}
+
+/** Write a code-point as UTF-16.
+ */
+static tt_force_inline void put_utf16(char16_t *&output, char32_t code_point) noexcept
+{
+    if (code_point <= 0xffff) {
+        tt_axiom(!(code_point >= 0xd800 && code_point <= 0xdfff), "Code Point must not be a surrogate-code");
+        *(output++) = static_cast<char16_t>(code_point);
+
+    } else {
+        tt_axiom(code_point <= 0x10ffff, "Code Point must be in range of the 17 planes");
+        code_point -= 0x1'0000;
+        *(output++) = static_cast<char16_t>((code_point >> 10) | 0xd800);
+        *(output++) = static_cast<char16_t>((code_point & 0x03ff) | 0xdc00);
+    }
+}
+
+#if TT_X86_64_V1
+/** Find the number of leading code units in a chunk that are selected by the mask.
+ *
+ * @param mask The result of `_mm_movemask_epi8()` with bits set for the code units that are not selected.
+ * @param code_unit_size The number of bytes in a code unit.
+ */
+[[nodiscard]] static size_t chunk_prefix_size(int mask, size_t code_unit_size) noexcept
+{
+    return narrow_cast<size_t>(std::countr_zero(static_cast<unsigned int>(mask) | 0x1'0000U)) / code_unit_size;
+}
+#endif
+
+// The bulk converters below have an ASCII fast path: when the next code unit is ASCII, a whole
+// chunk is converted with SIMD and the output is advanced over the leading ASCII code units of
+// the chunk. Writing the full chunk is safe, because each code unit needs at least as much room
+// in the output as it does in the input.
+
+[[nodiscard]] size_t utf8_to_utf16_bulk(char16_t *output, char8_t const *str, size_t size) noexcept
+{
+    ttlet output_first = output;
+    ttlet last = str + size;
+    while (str != last) {
+#if TT_X86_64_V1
+        if (*str <= 0x7f and last - str >= 16) {
+            ttlet chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(str));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output), _mm_unpacklo_epi8(chunk, _mm_setzero_si128()));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output + 8), _mm_unpackhi_epi8(chunk, _mm_setzero_si128()));
+
+            ttlet n = chunk_prefix_size(_mm_movemask_epi8(chunk), 1);
+            str += n;
+            output += n;
+            continue;
+        }
+#endif
+        put_utf16(output, get_utf8(str));
+    }
+    return narrow_cast<size_t>(output - output_first);
+}
+
+[[nodiscard]] size_t utf8_to_utf32_bulk(char32_t *output, char8_t const *str, size_t size) noexcept
+{
+    ttlet output_first = output;
+    ttlet last = str + size;
+    while (str != last) {
+#if TT_X86_64_V1
+        if (*str <= 0x7f and last - str >= 16) {
+            ttlet chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(str));
+            ttlet lo = _mm_unpacklo_epi8(chunk, _mm_setzero_si128());
+            ttlet hi = _mm_unpackhi_epi8(chunk, _mm_setzero_si128());
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output), _mm_unpacklo_epi16(lo, _mm_setzero_si128()));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output + 4), _mm_unpackhi_epi16(lo, _mm_setzero_si128()));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output + 8), _mm_unpacklo_epi16(hi, _mm_setzero_si128()));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output + 12), _mm_unpackhi_epi16(hi, _mm_setzero_si128()));
+
+            ttlet n = chunk_prefix_size(_mm_movemask_epi8(chunk), 1);
+            str += n;
+            output += n;
+            continue;
+        }
+#endif
+        *(output++) = get_utf8(str);
+    }
+    return narrow_cast<size_t>(output - output_first);
+}
+
+[[nodiscard]] size_t utf16_to_utf8_bulk(char8_t *output, char16_t const *str, size_t size) noexcept
+{
+    ttlet output_first = output;
+    ttlet last = str + size;
+    while (str != last) {
+#if TT_X86_64_V1
+        if (*str <= 0x7f and last - str >= 8) {
+            ttlet chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(str));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(output), _mm_packus_epi16(chunk, chunk));
+
+            ttlet high_bits = _mm_and_si128(chunk, _mm_set1_epi16(static_cast<short>(0xff80)));
+            ttlet non_ascii = _mm_xor_si128(_mm_cmpeq_epi16(high_bits, _mm_setzero_si128()), _mm_set1_epi8(-1));
+            ttlet n = chunk_prefix_size(_mm_movemask_epi8(non_ascii), 2);
+            str += n;
+            output += n;
+            continue;
+        }
+#endif
+        put_utf8(output, utf16_to_utf32(str));
+    }
+    return narrow_cast<size_t>(output - output_first);
+}
+
+[[nodiscard]] size_t utf16_to_utf32_bulk(char32_t *output, char16_t const *str, size_t size) noexcept
+{
+    ttlet output_first = output;
+    ttlet last = str + size;
+    while (str != last) {
+#if TT_X86_64_V1
+        if ((*str < 0xd800 or *str > 0xdfff) and last - str >= 8) {
+            ttlet chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(str));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output), _mm_unpacklo_epi16(chunk, _mm_setzero_si128()));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output + 4), _mm_unpackhi_epi16(chunk, _mm_setzero_si128()));
+
+            ttlet surrogates = _mm_cmpeq_epi16(
+                _mm_and_si128(chunk, _mm_set1_epi16(static_cast<short>(0xf800))), _mm_set1_epi16(static_cast<short>(0xd800)));
+            ttlet n = chunk_prefix_size(_mm_movemask_epi8(surrogates), 2);
+            str += n;
+            output += n;
+            continue;
+        }
+#endif
+        *(output++) = utf16_to_utf32(str);
+    }
+    return narrow_cast<size_t>(output - output_first);
+}
+
+[[nodiscard]] size_t utf32_to_utf8_bulk(char8_t *output, char32_t const *str, size_t size) noexcept
+{
+    ttlet output_first = output;
+    ttlet last = str + size;
+    while (str != last) {
+#if TT_X86_64_V1
+        if (*str <= 0x7f and last - str >= 4) {
+            ttlet chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(str));
+            ttlet words = _mm_packs_epi32(chunk, chunk);
+            ttlet bytes = _mm_packus_epi16(words, words);
+            ttlet value = _mm_cvtsi128_si32(bytes);
+            std::memcpy(output, &value, sizeof(value));
+
+            ttlet high_bits = _mm_and_si128(chunk, _mm_set1_epi32(static_cast<int>(0xffff'ff80)));
+            ttlet non_ascii = _mm_xor_si128(_mm_cmpeq_epi32(high_bits, _mm_setzero_si128()), _mm_set1_epi8(-1));
+            ttlet n = chunk_prefix_size(_mm_movemask_epi8(non_ascii), 4);
+            str += n;
+            output += n;
+            continue;
+        }
+#endif
+        put_utf8(output, *(str++));
+    }
+    return narrow_cast<size_t>(output - output_first);
+}
+
+[[nodiscard]] size_t utf32_to_utf16_bulk(char16_t *output, char32_t const *str, size_t size) noexcept
+{
+    ttlet output_first = output;
+    ttlet last = str + size;
+    while (str != last) {
+#if TT_X86_64_V1
+        if (*str <= 0xffff and last - str >= 8) {
+            ttlet lo = _mm_loadu_si128(reinterpret_cast<__m128i const *>(str));
+            ttlet hi = _mm_loadu_si128(reinterpret_cast<__m128i const *>(str + 4));
+
+            // SSE2 only has a signed saturating pack; bias the code units into the signed range.
+            ttlet bias = _mm_set1_epi32(0x8000);
+            ttlet words = _mm_packs_epi32(_mm_sub_epi32(lo, bias), _mm_sub_epi32(hi, bias));
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i *>(output), _mm_xor_si128(words, _mm_set1_epi16(static_cast<short>(0x8000))));
+
+            ttlet high_bits = _mm_packs_epi32(_mm_srli_epi32(lo, 16), _mm_srli_epi32(hi, 16));
+            ttlet non_bmp = _mm_xor_si128(_mm_cmpeq_epi16(high_bits, _mm_setzero_si128()), _mm_set1_epi8(-1));
+            ttlet n = chunk_prefix_size(_mm_movemask_epi8(non_bmp), 2);
+            str += n;
+            output += n;
+            continue;
+        }
+#endif
+        put_utf16(output, *(str++));
+    }
+    return narrow_cast<size_t>(output - output_first);
+}
+
+[[nodiscard]] std::u8string sanitize_u8string(std::u8string_view str, size_t valid_size) noexcept
+{
+    auto r = std::u8string{};
+    r.reserve(str.size() + str.size() / 2);
+    r.append(str.substr(0, valid_size));
+
+    auto r_it = std::back_inserter(r);
+    auto it = str.begin() + valid_size;
+    ttlet last = str.end();
+    while (it != last) {
+        // Re-encode the invalid code-point using the CP-1252 fallback.
+        auto code_point = char32_t{};
+        (void)utf8_to_utf32(it, last, code_point);
+        utf32_to_utf8(code_point, r_it);
+
+        // Copy the valid run that follows in one go.
+        ttlet offset = narrow_cast<size_t>(it - str.begin());
+        ttlet run_size = utf8_valid_size(str.data() + offset, str.size() - offset);
+        r.append(str.substr(offset, run_size));
+        it += run_size;
+    }
+    return r;
+}
+
+} // namespace detail
+} // namespace tt
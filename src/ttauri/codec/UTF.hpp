@@ -5,11 +5,14 @@
 #pragma once
 
 #include "../required.hpp"
+#include "../architecture.hpp"
 #include "../endian.hpp"
 #include "../CP1252.hpp"
 #include <type_traits>
 #include <iterator>
 #include <bit>
+#include <string>
+#include <string_view>
 
 namespace tt {
 
@@ -91,7 +94,7 @@ template<typename Iterator>
         cp |= static_cast<char32_t>(*(it++) & 0x3f);
         cp <<= 6;
         cp |= static_cast<char32_t>(*(it++) & 0x3f);
-        tt_axiom(cp >= 0x100000 && cp <= 0x10ffff, "UTF-8 Overlong encoding");
+        tt_axiom(cp >= 0x10000 && cp <= 0x10ffff, "UTF-8 Overlong encoding");
         return cp;
     }
 }
@@ -153,13 +156,14 @@ constexpr bool utf8_to_utf32(Iterator &it, Iterator last, char32_t &code_point)
         }
 
         code_point <<= 6;
-        code_point = *(it++) & 0x3f;
+        code_point |= *(it++) & 0x3f;
     }
 
     if ((code_point >= 0xd800 && code_point <= 0xdfff) || // Surrogate pair
         (continuation_count == 1 && code_point < 0x0080) || // Overlong
         (continuation_count == 2 && code_point < 0x0800) || // Overlong
-        (continuation_count == 3 && code_point < 0x10000) // Overlong
+        (continuation_count == 3 && code_point < 0x10000) || // Overlong
+        code_point > 0x10ffff // Beyond the 17 planes
     ) {
         // Surrogate pair
         code_point = CP1252_to_UTF32(static_cast<char>(first_cu));
@@ -233,6 +237,89 @@ constexpr void utf32_to_utf8(char32_t code_point, BackInsertIterator &it) noexce
     }
 }
 
+namespace detail {
+
+/** Find the length of the valid UTF-8 prefix of a string.
+ *
+ * @param str The UTF-8 encoded string, which may be invalid.
+ * @param size The number of code units in the string.
+ * @return The number of code units before the first invalid code-point; `size` when the string is valid.
+ */
+[[nodiscard]] size_t utf8_valid_size_scalar(char8_t const *str, size_t size) noexcept;
+
+#if TT_X86_64_V2
+/** Validate UTF-8, 16 code units at a time.
+ * @see utf8_valid_size_scalar()
+ * @return The number of code units that were validated, ending on a code-point boundary;
+ *         the caller validates the rest.
+ */
+[[nodiscard]] size_t utf8_valid_size_ssse3(char8_t const *str, size_t size) noexcept;
+
+/** Validate UTF-8, 32 code units at a time.
+ * @pre The CPU supports AVX2.
+ * @see utf8_valid_size_scalar()
+ * @return The number of code units that were validated, ending on a code-point boundary;
+ *         the caller validates the rest.
+ */
+[[nodiscard]] size_t utf8_valid_size_avx2(char8_t const *str, size_t size) noexcept;
+#endif
+
+/** Find the length of the valid UTF-8 prefix of a string, using the fastest method of the CPU.
+ * @see utf8_valid_size_scalar()
+ */
+[[nodiscard]] size_t utf8_valid_size(char8_t const *str, size_t size) noexcept;
+
+/** Convert a valid UTF-8 string to UTF-16.
+ *
+ * Runs of ASCII characters are converted 16 code units at a time.
+ *
+ * @param output The output buffer, with room for `size` code units.
+ * @param str The valid UTF-8 encoded string.
+ * @param size The number of code units in the string.
+ * @return The number of code units written to the output.
+ */
+[[nodiscard]] size_t utf8_to_utf16_bulk(char16_t *output, char8_t const *str, size_t size) noexcept;
+
+/** Convert a valid UTF-8 string to UTF-32.
+ * @see utf8_to_utf16_bulk()
+ * @param output The output buffer, with room for `size` code units.
+ */
+[[nodiscard]] size_t utf8_to_utf32_bulk(char32_t *output, char8_t const *str, size_t size) noexcept;
+
+/** Convert a valid UTF-16 string to UTF-8.
+ * @see utf8_to_utf16_bulk()
+ * @param output The output buffer, with room for `size * 3` code units.
+ */
+[[nodiscard]] size_t utf16_to_utf8_bulk(char8_t *output, char16_t const *str, size_t size) noexcept;
+
+/** Convert a valid UTF-16 string to UTF-32.
+ * @see utf8_to_utf16_bulk()
+ * @param output The output buffer, with room for `size` code units.
+ */
+[[nodiscard]] size_t utf16_to_utf32_bulk(char32_t *output, char16_t const *str, size_t size) noexcept;
+
+/** Convert a valid UTF-32 string to UTF-8.
+ * @see utf8_to_utf16_bulk()
+ * @param output The output buffer, with room for `size * 4` code units.
+ */
+[[nodiscard]] size_t utf32_to_utf8_bulk(char8_t *output, char32_t const *str, size_t size) noexcept;
+
+/** Convert a valid UTF-32 string to UTF-16.
+ * @see utf8_to_utf16_bulk()
+ * @param output The output buffer, with room for `size * 2` code units.
+ */
+[[nodiscard]] size_t utf32_to_utf16_bulk(char16_t *output, char32_t const *str, size_t size) noexcept;
+
+/** Re-encode the invalid code units of a UTF-8 string.
+ *
+ * @param str A UTF-8 string with invalid code units.
+ * @param valid_size The number of code units of the valid prefix of the string.
+ * @return A valid UTF-8 string.
+ */
+[[nodiscard]] std::u8string sanitize_u8string(std::u8string_view str, size_t valid_size) noexcept;
+
+} // namespace detail
+
 /** Sanitize a UTF-32 string so it contains only valid encoded Unicode code points.
  *
  * This function will replace invalid code units with the unicode-replacement-character 0xfffd.
@@ -379,40 +466,12 @@ template<typename Container>
  */
 [[nodiscard]] inline std::u8string sanitize_u8string(std::u8string &&rhs) noexcept
 {
-    auto r = std::move(rhs);
-
-    ttlet first = begin(rhs);
-    ttlet last = end(rhs);
-
-    auto code_point = char32_t{};
-    auto valid = true;
-    auto old_it = first;
-    for (auto it = first; valid && it != last;) {
-        old_it = it;
-        valid &= utf8_to_utf32(it, last, code_point);
-    }
-
-    if (valid) {
-        return r;
-    }
-
-    // Copy the valid UTF-8 code units and prepare for
-    // re-encoding the rest of the string.
-    auto tmp = std::u8string{begin(r), old_it};
-    tmp.reserve(size(r));
-
-    // Add the last decoded code point.
-    auto tmp_i = std::back_inserter(tmp);
-    utf32_to_utf8(code_point, tmp_i);
-
-    // Re-encode the rest of the string.
-    for (auto it = old_it + 1; it != last;) {
-        utf8_to_utf32(it, last, code_point);
-        utf32_to_utf8(code_point, tmp_i);
+    ttlet valid_size = detail::utf8_valid_size(rhs.data(), rhs.size());
+    if (valid_size == rhs.size()) {
+        return std::move(rhs);
+    } else {
+        return detail::sanitize_u8string(rhs, valid_size);
     }
-
-    std::swap(r, tmp);
-    return r;
 }
 
 namespace detail {
@@ -420,27 +479,16 @@ namespace detail {
 template<typename StringT>
 [[nodiscard]] inline StringT to_u8string(std::u16string_view const &rhs) noexcept
 {
-    auto r = StringT{};
-    r.reserve(rhs.size());
-    auto r_it = std::back_inserter(r);
-
-    for (auto it = std::begin(rhs); it != std::end(rhs);) {
-        ttlet c32 = utf16_to_utf32(it);
-        utf32_to_utf8(c32, r_it);
-    }
+    auto r = StringT(rhs.size() * 3, typename StringT::value_type{});
+    r.resize(utf16_to_utf8_bulk(reinterpret_cast<char8_t *>(r.data()), rhs.data(), rhs.size()));
     return r;
 }
 
 template<typename StringT>
 [[nodiscard]] inline StringT to_u8string(std::u32string_view const &rhs) noexcept
 {
-    auto r = StringT{};
-    r.reserve(rhs.size());
-    auto r_it = std::back_inserter(r);
-
-    for (auto c32 : rhs) {
-        utf32_to_utf8(c32, r_it);
-    }
+    auto r = StringT(rhs.size() * 4, typename StringT::value_type{});
+    r.resize(utf32_to_utf8_bulk(reinterpret_cast<char8_t *>(r.data()), rhs.data(), rhs.size()));
     return r;
 }
 
@@ -521,14 +569,8 @@ template<typename StringT>
  */
 [[nodiscard]] inline std::u16string to_u16string(std::u8string_view const &rhs) noexcept
 {
-    auto r = std::u16string{};
-    r.reserve(rhs.size());
-    auto r_it = std::back_inserter(r);
-
-    for (auto it = std::begin(rhs); it != std::end(rhs);) {
-        ttlet c32 = utf8_to_utf32(it);
-        utf32_to_utf16(c32, r_it);
-    }
+    auto r = std::u16string(rhs.size(), char16_t{});
+    r.resize(detail::utf8_to_utf16_bulk(r.data(), rhs.data(), rhs.size()));
     return r;
 }
 
@@ -540,13 +582,8 @@ template<typename StringT>
  */
 [[nodiscard]] inline std::u16string to_u16string(std::u32string_view const &rhs) noexcept
 {
-    auto r = std::u16string{};
-    r.reserve(rhs.size());
-    auto r_it = std::back_inserter(r);
-
-    for (auto c32 : rhs) {
-        utf32_to_utf16(c32, r_it);
-    }
+    auto r = std::u16string(rhs.size() * 2, char16_t{});
+    r.resize(detail::utf32_to_utf16_bulk(r.data(), rhs.data(), rhs.size()));
     return r;
 }
 
@@ -558,12 +595,8 @@ template<typename StringT>
  */
 [[nodiscard]] inline std::u32string to_u32string(std::u8string_view const &rhs) noexcept
 {
-    auto r = std::u32string{};
-    r.reserve(rhs.size());
-
-    for (auto it = std::begin(rhs); it != std::end(rhs);) {
-        r += utf8_to_utf32(it);
-    }
+    auto r = std::u32string(rhs.size(), char32_t{});
+    r.resize(detail::utf8_to_utf32_bulk(r.data(), rhs.data(), rhs.size()));
     return r;
 }
 
@@ -575,12 +608,8 @@ template<typename StringT>
  */
 [[nodiscard]] inline std::u32string to_u32string(std::u16string_view const &rhs) noexcept
 {
-    auto r = std::u32string{};
-    r.reserve(rhs.size());
-
-    for (auto it = std::begin(rhs); it != std::end(rhs);) {
-        r += utf16_to_utf32(it);
-    }
+    auto r = std::u32string(rhs.size(), char32_t{});
+    r.resize(detail::utf16_to_utf32_bulk(r.data(), rhs.data(), rhs.size()));
     return r;
 }
 
@@ -603,7 +632,13 @@ template<typename StringT>
  */
 [[nodiscard]] inline std::u16string to_u16string(std::string_view const &rhs) noexcept
 {
-    return to_u16string(sanitize_u8string(std::u8string{reinterpret_cast<char8_t const *>(rhs.data()), rhs.size()}));
+    ttlet str = std::u8string_view{reinterpret_cast<char8_t const *>(rhs.data()), rhs.size()};
+    ttlet valid_size = detail::utf8_valid_size(str.data(), str.size());
+    if (valid_size == str.size()) {
+        return to_u16string(str);
+    } else {
+        return to_u16string(detail::sanitize_u8string(str, valid_size));
+    }
 }
 
 /** Convert a string to a UTF-32 encoded string.
@@ -614,7 +649,13 @@ template<typename StringT>
  */
 [[nodiscard]] inline std::u32string to_u32string(std::string_view const &rhs) noexcept
 {
-    return to_u32string(sanitize_u8string(std::u8string{reinterpret_cast<char8_t const *>(rhs.data()), rhs.size()}));
+    ttlet str = std::u8string_view{reinterpret_cast<char8_t const *>(rhs.data()), rhs.size()};
+    ttlet valid_size = detail::utf8_valid_size(str.data(), str.size());
+    if (valid_size == str.size()) {
+        return to_u32string(str);
+    } else {
+        return to_u32string(detail::sanitize_u8string(str, valid_size));
+    }
 }
 
 /** Convert a wide-string to a UTF-8 encoded string.
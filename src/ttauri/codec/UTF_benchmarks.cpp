@@ -0,0 +1,97 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/codec/UTF.hpp"
+#include "ttauri/cast.hpp"
+#include "ttauri/required.hpp"
+#include <benchmark/benchmark.h>
+#include <string>
+#include <string_view>
+
+using namespace tt;
+
+/** Pangrams, each with a different mix of code-point lengths.
+ */
+static char8_t const *corpora[] = {
+    u8"The quick brown fox jumps over the lazy dog. ",
+    u8"Voix ambiguë d'un cœur qui, au zéphyr, préfère les jattes de kiwis. ",
+    u8"Съешь же ещё этих мягких французских булок, да выпей чаю. ",
+    u8"いろはにほへと ちりぬるを わかよたれそ つねならむ うゐのおくやま けふこえて あさきゆめみし ゑひもせす。",
+    u8"天地玄黄 宇宙洪荒 日月盈昃 辰宿列张 寒来暑往 秋收冬藏 ",
+    u8"😀 😃 😄 😁 😆 😅 🤣 😂 🙂 🙃 😉 😊 😇 🥰 😍 🤩 "};
+
+/** Repeat the pangram of a corpus to make a 64 KiB string.
+ */
+[[nodiscard]] static std::u8string make_corpus(benchmark::State &state)
+{
+    auto r = std::u8string{};
+    while (r.size() < 0x1'0000) {
+        r += corpora[state.range(0)];
+    }
+    return r;
+}
+
+static void report_throughput(benchmark::State &state, size_t nr_code_units)
+{
+    state.SetBytesProcessed(narrow_cast<int64_t>(state.iterations() * nr_code_units));
+}
+
+static void UTF_sanitize_u8string(benchmark::State &state)
+{
+    ttlet str = make_corpus(state);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sanitize_u8string(std::u8string{str}));
+    }
+    report_throughput(state, str.size());
+}
+
+static void UTF_to_u32string(benchmark::State &state)
+{
+    ttlet str = make_corpus(state);
+    ttlet str_view = std::string_view{reinterpret_cast<char const *>(str.data()), str.size()};
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(to_u32string(str_view));
+    }
+    report_throughput(state, str.size());
+}
+
+static void UTF_to_u16string(benchmark::State &state)
+{
+    ttlet str = make_corpus(state);
+    ttlet str_view = std::string_view{reinterpret_cast<char const *>(str.data()), str.size()};
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(to_u16string(str_view));
+    }
+    report_throughput(state, str.size());
+}
+
+static void UTF_u16_to_string(benchmark::State &state)
+{
+    ttlet str = to_u16string(make_corpus(state));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(to_string(str));
+    }
+    report_throughput(state, str.size());
+}
+
+static void UTF_u32_to_string(benchmark::State &state)
+{
+    ttlet str = to_u32string(make_corpus(state));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(to_string(str));
+    }
+    report_throughput(state, str.size());
+}
+
+// The argument selects the corpus: English, French, Russian, Japanese, Chinese, Emoji.
+BENCHMARK(UTF_sanitize_u8string)->DenseRange(0, 5);
+BENCHMARK(UTF_to_u32string)->DenseRange(0, 5);
+BENCHMARK(UTF_to_u16string)->DenseRange(0, 5);
+BENCHMARK(UTF_u16_to_string)->DenseRange(0, 5);
+BENCHMARK(UTF_u32_to_string)->DenseRange(0, 5);
@@ -0,0 +1,188 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/codec/UTF.hpp"
+#include "ttauri/required.hpp"
+#if TT_PROCESSOR == TT_CPU_X64
+#include "ttauri/cpu_id.hpp"
+#endif
+#include <gtest/gtest.h>
+#include <iostream>
+#include <random>
+
+using namespace std;
+using namespace tt;
+
+/** Make a valid UTF-8 string with a mix of 1, 2, 3 and 4 code unit code-points.
+ */
+static std::u8string random_utf8(std::mt19937 &engine, size_t size)
+{
+    auto kind_dist = std::uniform_int_distribution<int>{0, 4};
+
+    auto r = std::u8string{};
+    auto r_it = std::back_inserter(r);
+    while (r.size() < size) {
+        auto code_point = char32_t{};
+        switch (kind_dist(engine)) {
+        case 0:
+        case 1: code_point = engine() % 0x80; break;
+        case 2: code_point = 0x80 + engine() % (0x800 - 0x80); break;
+        case 3:
+            do {
+                code_point = 0x800 + engine() % (0x1'0000 - 0x800);
+            } while (code_point >= 0xd800 and code_point <= 0xdfff);
+            break;
+        default: code_point = 0x1'0000 + engine() % 0x10'0000;
+        }
+        utf32_to_utf8(code_point, r_it);
+    }
+    return r;
+}
+
+/** Sanitize by decoding each code-point with the CP-1252 fallback.
+ */
+static std::u8string sanitize_reference(std::u8string const &str)
+{
+    auto r = std::u8string{};
+    auto r_it = std::back_inserter(r);
+    for (auto it = str.begin(); it != str.end();) {
+        auto code_point = char32_t{};
+        (void)utf8_to_utf32(it, str.end(), code_point);
+        utf32_to_utf8(code_point, r_it);
+    }
+    return r;
+}
+
+/** Compare a vectorized UTF-8 validator with the scalar validator on damaged strings.
+ */
+template<typename Validate>
+static void compare_utf8_valid_size(Validate const &validate, size_t block_size)
+{
+    auto engine = std::mt19937{42};
+
+    for (int i = 0; i != 20000; ++i) {
+        auto str = random_utf8(engine, engine() % 200);
+        ttlet nr_damages = engine() % 3;
+        for (size_t j = 0; j != nr_damages and not str.empty(); ++j) {
+            str[engine() % str.size()] = static_cast<char8_t>(engine());
+        }
+
+        ttlet expected = detail::utf8_valid_size_scalar(str.data(), str.size());
+        ttlet result = validate(str.data(), str.size());
+        ASSERT_LE(result, expected);
+        ASSERT_EQ(detail::utf8_valid_size_scalar(str.data(), result), result);
+        if (expected == str.size()) {
+            // Only the last incomplete block, and the code-point that crosses into it, are left to the caller.
+            ASSERT_LT(str.size() - result, block_size + 4);
+        }
+    }
+}
+
+TEST(UTF, utf8_valid_size_scalar)
+{
+    ttlet valid = std::u8string{u8"abc é€\U0001f600"};
+    ASSERT_EQ(detail::utf8_valid_size_scalar(valid.data(), valid.size()), valid.size());
+
+    auto invalid = [](std::initializer_list<uint8_t> code_units) {
+        auto str = std::u8string{u8"ab"};
+        for (ttlet cu : code_units) {
+            str += static_cast<char8_t>(cu);
+        }
+        str += u8"cd";
+        return detail::utf8_valid_size_scalar(str.data(), str.size());
+    };
+
+    ASSERT_EQ(invalid({0x80}), 2); // Continuation without lead.
+    ASSERT_EQ(invalid({0xc3}), 2); // Missing continuation.
+    ASSERT_EQ(invalid({0xc0, 0x80}), 2); // Overlong 2.
+    ASSERT_EQ(invalid({0xe0, 0x80, 0x80}), 2); // Overlong 3.
+    ASSERT_EQ(invalid({0xf0, 0x80, 0x80, 0x80}), 2); // Overlong 4.
+    ASSERT_EQ(invalid({0xed, 0xa0, 0x80}), 2); // Surrogate.
+    ASSERT_EQ(invalid({0xf4, 0x90, 0x80, 0x80}), 2); // Beyond U+10FFFF.
+    ASSERT_EQ(invalid({0xf8}), 2); // Invalid code unit.
+    ASSERT_EQ(invalid({0xef, 0xbf, 0xbf}), 7); // U+FFFF is valid.
+    ASSERT_EQ(invalid({0xf4, 0x8f, 0xbf, 0xbf}), 8); // U+10FFFF is valid.
+
+    compare_utf8_valid_size(detail::utf8_valid_size, 0);
+}
+
+#if TT_X86_64_V2
+TEST(UTF, utf8_valid_size_SSSE3)
+{
+    compare_utf8_valid_size(detail::utf8_valid_size_ssse3, 16);
+}
+#endif
+
+#if TT_X86_64_V2
+TEST(UTF, utf8_valid_size_AVX2)
+{
+    if (not cpu_has_avx2()) {
+        GTEST_SKIP() << "The CPU does not support AVX2.";
+    }
+    compare_utf8_valid_size(detail::utf8_valid_size_avx2, 32);
+}
+#endif
+
+TEST(UTF, sanitize_u8string)
+{
+    ASSERT_EQ(sanitize_u8string(u8"Hello é€\U0001f600"), u8"Hello é€\U0001f600");
+
+    // Invalid code units are decoded as CP-1252.
+    ASSERT_EQ(sanitize_u8string(std::u8string{u8"a\x80z"}), u8"a€z");
+    ASSERT_EQ(sanitize_u8string(std::u8string{u8"a\xe9z"}), u8"aéz");
+    ASSERT_EQ(sanitize_u8string(std::u8string{u8"a\xc3"}), u8"aÃ");
+    ASSERT_EQ(sanitize_u8string(std::u8string{u8"\xed\xa0\x80"}), u8"\u00ed\u00a0\u20ac");
+
+    auto engine = std::mt19937{42};
+    for (int i = 0; i != 2000; ++i) {
+        auto str = random_utf8(engine, engine() % 500);
+        ttlet nr_damages = engine() % 4;
+        for (size_t j = 0; j != nr_damages and not str.empty(); ++j) {
+            str[engine() % str.size()] = static_cast<char8_t>(engine());
+        }
+
+        ttlet expected = sanitize_reference(str);
+        ASSERT_EQ(sanitize_u8string(std::u8string{str}), expected);
+
+        ttlet str_view = std::string_view{reinterpret_cast<char const *>(str.data()), str.size()};
+        ASSERT_EQ(to_u32string(str_view), to_u32string(expected));
+        ASSERT_EQ(to_u16string(str_view), to_u16string(expected));
+    }
+}
+
+TEST(UTF, transcode)
+{
+    ASSERT_EQ(to_u16string(u8"Hello é€\U0001f600"), u"Hello é€\U0001f600");
+    ASSERT_EQ(to_u32string(u8"Hello é€\U0001f600"), U"Hello é€\U0001f600");
+    ASSERT_EQ(to_u8string(u"Hello é€\U0001f600"), u8"Hello é€\U0001f600");
+    ASSERT_EQ(to_u8string(U"Hello é€\U0001f600"), u8"Hello é€\U0001f600");
+    ASSERT_EQ(to_u16string(U"Hello é€\U0001f600"), u"Hello é€\U0001f600");
+    ASSERT_EQ(to_u32string(u"Hello é€\U0001f600"), U"Hello é€\U0001f600");
+
+    // Compare with converting one code-point at a time; long ASCII runs exercise the fast path.
+    auto engine = std::mt19937{42};
+    for (int i = 0; i != 2000; ++i) {
+        ttlet str8 =
+            random_utf8(engine, engine() % 250) + std::u8string(engine() % 40, u8'x') + random_utf8(engine, engine() % 250);
+
+        auto str32 = std::u32string{};
+        for (auto it = str8.begin(); it != str8.end();) {
+            str32 += utf8_to_utf32(it);
+        }
+
+        auto str16 = std::u16string{};
+        auto str16_it = std::back_inserter(str16);
+        for (ttlet c : str32) {
+            utf32_to_utf16(c, str16_it);
+        }
+
+        ASSERT_EQ(to_u16string(std::u8string_view{str8}), str16);
+        ASSERT_EQ(to_u32string(std::u8string_view{str8}), str32);
+        ASSERT_EQ(to_u8string(std::u16string_view{str16}), str8);
+        ASSERT_EQ(to_u32string(std::u16string_view{str16}), str32);
+        ASSERT_EQ(to_u8string(std::u32string_view{str32}), str8);
+        ASSERT_EQ(to_u16string(std::u32string_view{str32}), str16);
+        ASSERT_EQ(to_string(std::u32string_view{str32}), std::string(str8.begin(), str8.end()));
+    }
+}
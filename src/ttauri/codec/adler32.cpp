@@ -0,0 +1,171 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "adler32.hpp"
+#if TT_PROCESSOR == TT_CPU_X64
+#include "../cpu_id.hpp"
+#endif
+#if TT_X86_64_V2
+#include <emmintrin.h> // SSE2
+#include <tmmintrin.h> // SSSE3
+#include <immintrin.h> // AVX2
+#endif
+#include <algorithm>
+
+namespace tt {
+namespace detail {
+
+/** The modulo of the Adler-32 sums.
+ */
+constexpr uint32_t adler32_base = 65521;
+
+/** The maximum number of bytes that can be summed before s2 may overflow 32 bits.
+ */
+constexpr ssize_t adler32_nmax = 5552;
+
+[[nodiscard]] uint32_t adler32_scalar(std::span<std::byte const> bytes, uint32_t adler) noexcept
+{
+    auto s1 = adler & 0xffff;
+    auto s2 = adler >> 16;
+
+    auto p = bytes.data();
+    auto size = std::ssize(bytes);
+    while (size != 0) {
+        ttlet n = std::min(size, adler32_nmax);
+        for (ttlet end = p + n; p != end; ++p) {
+            s1 += static_cast<uint8_t>(*p);
+            s2 += s1;
+        }
+        s1 %= adler32_base;
+        s2 %= adler32_base;
+        size -= n;
+    }
+
+    return (s2 << 16) | s1;
+}
+
+#if TT_X86_64_V2
+/* For a block of 32 bytes:
+ *  - s1 is incremented by the sum of the bytes.
+ *  - s2 is incremented by 32 times the previous s1, plus the bytes multiplied by 32, 31, ..., 1.
+ */
+[[nodiscard]] uint32_t adler32_ssse3(std::span<std::byte const> bytes, uint32_t adler) noexcept
+{
+    auto s1 = adler & 0xffff;
+    auto s2 = adler >> 16;
+
+    auto p = bytes.data();
+    auto nr_blocks = std::ssize(bytes) / 32;
+
+    ttlet tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+    ttlet tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    ttlet zero = _mm_setzero_si128();
+    ttlet ones = _mm_set1_epi16(1);
+
+    while (nr_blocks != 0) {
+        auto n = std::min(nr_blocks, adler32_nmax / 32);
+        nr_blocks -= n;
+
+        // The sum of s1 at the start of each block.
+        auto v_ps = _mm_cvtsi32_si128(static_cast<int>(s1 * n));
+        auto v_s1 = zero;
+        auto v_s2 = _mm_cvtsi32_si128(static_cast<int>(s2));
+
+        do {
+            ttlet bytes1 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+            ttlet bytes2 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + 16));
+
+            v_ps = _mm_add_epi32(v_ps, v_s1);
+
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+            v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+            v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+
+            p += 32;
+        } while (--n);
+
+        v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+
+        // Horizontal sums; v_s1 holds two 64 bit sums, v_s2 holds four 32 bit sums.
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(1, 0, 3, 2)));
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(1, 0, 3, 2)));
+
+        s1 = (s1 + static_cast<uint32_t>(_mm_cvtsi128_si32(v_s1))) % adler32_base;
+        s2 = static_cast<uint32_t>(_mm_cvtsi128_si32(v_s2)) % adler32_base;
+    }
+
+    ttlet tail = bytes.subspan(static_cast<size_t>(p - bytes.data()));
+    return adler32_scalar(tail, (s2 << 16) | s1);
+}
+#endif
+
+#if TT_X86_64_V2
+// The AVX2 function is compiled for AVX2 independent of the x86-64 level of the build,
+// and is only called when the CPU supports AVX2.
+[[nodiscard]] tt_target_avx2 uint32_t adler32_avx2(std::span<std::byte const> bytes, uint32_t adler) noexcept
+{
+    auto s1 = adler & 0xffff;
+    auto s2 = adler >> 16;
+
+    auto p = bytes.data();
+    auto nr_blocks = std::ssize(bytes) / 32;
+
+    ttlet tap = _mm256_setr_epi8(
+        32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    ttlet zero = _mm256_setzero_si256();
+    ttlet ones = _mm256_set1_epi16(1);
+
+    while (nr_blocks != 0) {
+        auto n = std::min(nr_blocks, adler32_nmax / 32);
+        nr_blocks -= n;
+
+        auto v_ps = _mm256_setr_epi32(static_cast<int>(s1 * n), 0, 0, 0, 0, 0, 0, 0);
+        auto v_s1 = zero;
+        auto v_s2 = _mm256_setr_epi32(static_cast<int>(s2), 0, 0, 0, 0, 0, 0, 0);
+
+        do {
+            ttlet block = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p));
+
+            v_ps = _mm256_add_epi32(v_ps, v_s1);
+            v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(block, zero));
+            v_s2 = _mm256_add_epi32(v_s2, _mm256_madd_epi16(_mm256_maddubs_epi16(block, tap), ones));
+
+            p += 32;
+        } while (--n);
+
+        v_s2 = _mm256_add_epi32(v_s2, _mm256_slli_epi32(v_ps, 5));
+
+        auto v_s1_ = _mm_add_epi32(_mm256_castsi256_si128(v_s1), _mm256_extracti128_si256(v_s1, 1));
+        auto v_s2_ = _mm_add_epi32(_mm256_castsi256_si128(v_s2), _mm256_extracti128_si256(v_s2, 1));
+        v_s1_ = _mm_add_epi32(v_s1_, _mm_shuffle_epi32(v_s1_, _MM_SHUFFLE(1, 0, 3, 2)));
+        v_s2_ = _mm_add_epi32(v_s2_, _mm_shuffle_epi32(v_s2_, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s2_ = _mm_add_epi32(v_s2_, _mm_shuffle_epi32(v_s2_, _MM_SHUFFLE(1, 0, 3, 2)));
+
+        s1 = (s1 + static_cast<uint32_t>(_mm_cvtsi128_si32(v_s1_))) % adler32_base;
+        s2 = static_cast<uint32_t>(_mm_cvtsi128_si32(v_s2_)) % adler32_base;
+    }
+
+    ttlet tail = bytes.subspan(static_cast<size_t>(p - bytes.data()));
+    return adler32_scalar(tail, (s2 << 16) | s1);
+}
+#endif
+
+} // namespace detail
+
+[[nodiscard]] uint32_t adler32(std::span<std::byte const> bytes, uint32_t adler) noexcept
+{
+#if TT_X86_64_V2
+    static ttlet has_avx2 = cpu_has_avx2();
+    if (has_avx2) {
+        return detail::adler32_avx2(bytes, adler);
+    }
+    return detail::adler32_ssse3(bytes, adler);
+#else
+    return detail::adler32_scalar(bytes, adler);
+#endif
+}
+
+} // namespace tt
@@ -0,0 +1,45 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "../required.hpp"
+#include "../architecture.hpp"
+#include <span>
+#include <cstddef>
+#include <cstdint>
+
+namespace tt {
+namespace detail {
+
+/** Calculate the Adler-32 one byte at a time.
+ */
+[[nodiscard]] uint32_t adler32_scalar(std::span<std::byte const> bytes, uint32_t adler) noexcept;
+
+#if TT_X86_64_V2
+/** Calculate the Adler-32 32 bytes at a time using SSSE3.
+ */
+[[nodiscard]] uint32_t adler32_ssse3(std::span<std::byte const> bytes, uint32_t adler) noexcept;
+
+/** Calculate the Adler-32 32 bytes at a time using AVX2.
+ *
+ * @pre The CPU supports AVX2.
+ */
+[[nodiscard]] uint32_t adler32_avx2(std::span<std::byte const> bytes, uint32_t adler) noexcept;
+#endif
+
+} // namespace detail
+
+/** Calculate the Adler-32 of data.
+ *
+ * This is the checksum in the trailer of the zlib format.
+ * An Adler-32 may be calculated incrementally by passing the result of the previous chunk of data.
+ *
+ * @param bytes The data.
+ * @param adler The Adler-32 of the preceding data.
+ * @return The Adler-32 of the preceding data combined with `bytes`.
+ */
+[[nodiscard]] uint32_t adler32(std::span<std::byte const> bytes, uint32_t adler = 1) noexcept;
+
+} // namespace tt
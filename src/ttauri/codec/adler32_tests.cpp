@@ -0,0 +1,73 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/codec/adler32.hpp"
+#include "ttauri/byte_string.hpp"
+#include "ttauri/required.hpp"
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace std;
+using namespace tt;
+
+TEST(Adler32, Check)
+{
+    ttlet check = to_bstring("Wikipedia");
+    ASSERT_EQ(adler32(check), 0x11e6'0398);
+    ASSERT_EQ(detail::adler32_scalar(check, 1), 0x11e6'0398);
+    ASSERT_EQ(adler32({}), 1);
+}
+
+TEST(Adler32, Incremental)
+{
+    ttlet check = to_bstring("Wikipedia");
+    ttlet bytes = std::span<std::byte const>(check);
+    ASSERT_EQ(adler32(bytes.subspan(4), adler32(bytes.first(4))), 0x11e6'0398);
+}
+
+static bstring random_bytes(ssize_t size, int max_value)
+{
+    auto engine = std::mt19937{42};
+    auto dist = std::uniform_int_distribution<int>{0, max_value};
+
+    auto r = bstring{};
+    for (ssize_t i = 0; i != size; ++i) {
+        r.push_back(static_cast<std::byte>(dist(engine)));
+    }
+    return r;
+}
+
+/** Compare a vectorized implementation with the scalar implementation.
+ * All 0xff bytes are used to check for overflow of the sums between reductions.
+ */
+template<typename Func>
+static void compare_adler32(Func const &func)
+{
+    for (ttlet max_value : {255, 0}) {
+        ttlet data = max_value == 0 ? bstring(20000, std::byte{0xff}) : random_bytes(20000, max_value);
+        ttlet bytes = std::span<std::byte const>(data);
+
+        for (ttlet offset : {0, 1, 7}) {
+            for (ssize_t size = 0; size <= 19000; size += (size < 300 ? 1 : 997)) {
+                ttlet chunk = bytes.subspan(offset, size);
+                ASSERT_EQ(func(chunk, 0xfff0'fff0), detail::adler32_scalar(chunk, 0xfff0'fff0))
+                    << "offset=" << offset << " size=" << size;
+            }
+        }
+    }
+}
+
+#if TT_X86_64_V2
+TEST(Adler32, SSSE3)
+{
+    compare_adler32(detail::adler32_ssse3);
+}
+#endif
+
+#if TT_X86_64_V2
+TEST(Adler32, AVX2)
+{
+    compare_adler32(detail::adler32_avx2);
+}
+#endif
@@ -0,0 +1,287 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "base_n.hpp"
+#if TT_PROCESSOR == TT_CPU_X64
+#include "../cpu_id.hpp"
+#endif
+#if TT_X86_64_V2
+#include <emmintrin.h> // SSE2
+#include <tmmintrin.h> // SSSE3
+#include <immintrin.h> // AVX2
+#endif
+#include <cstring>
+
+namespace tt {
+namespace detail {
+
+[[nodiscard]] constexpr base_n_alphabet const &base64_alphabet(bool url) noexcept
+{
+    return url ? base64url_rfc4648_alphabet : base64_rfc4648_alphabet;
+}
+
+[[nodiscard]] size_t base64_encode_scalar(char *output, std::span<std::byte const> bytes, bool url) noexcept
+{
+    ttlet &alphabet = base64_alphabet(url);
+
+    ttlet nr_blocks = bytes.size() / 3;
+    auto ptr = bytes.data();
+    for (size_t i = 0; i != nr_blocks; ++i, ptr += 3) {
+        ttlet block = static_cast<uint32_t>(ptr[0]) << 16 | static_cast<uint32_t>(ptr[1]) << 8 | static_cast<uint32_t>(ptr[2]);
+        *(output++) = alphabet.char_from_int_table[block >> 18];
+        *(output++) = alphabet.char_from_int_table[(block >> 12) & 0x3f];
+        *(output++) = alphabet.char_from_int_table[(block >> 6) & 0x3f];
+        *(output++) = alphabet.char_from_int_table[block & 0x3f];
+    }
+    return nr_blocks * 3;
+}
+
+[[nodiscard]] size_t base64_decode_scalar(std::byte *output, std::string_view str, bool url) noexcept
+{
+    ttlet &alphabet = base64_alphabet(url);
+
+    ttlet nr_blocks = str.size() / 4;
+    auto ptr = str.data();
+    for (size_t i = 0; i != nr_blocks; ++i, ptr += 4) {
+        ttlet a = alphabet.int_from_char(ptr[0]);
+        ttlet b = alphabet.int_from_char(ptr[1]);
+        ttlet c = alphabet.int_from_char(ptr[2]);
+        ttlet d = alphabet.int_from_char(ptr[3]);
+        if ((a | b | c | d) < 0) {
+            return i * 4;
+        }
+
+        ttlet block = static_cast<uint32_t>(a) << 18 | static_cast<uint32_t>(b) << 12 | static_cast<uint32_t>(c) << 6 |
+            static_cast<uint32_t>(d);
+        *(output++) = static_cast<std::byte>(block >> 16);
+        *(output++) = static_cast<std::byte>(block >> 8);
+        *(output++) = static_cast<std::byte>(block);
+    }
+    return nr_blocks * 4;
+}
+
+#if TT_X86_64_V2
+/** Convert 6-bit values to base64 characters.
+ *
+ * The values are classified by a saturating subtract and a compare into: 0 for 'a'-'z',
+ * 1-10 for '0'-'9', 11 for character 62, 12 for character 63 and 13 for 'A'-'Z';
+ * the class selects the offset to add to the value.
+ */
+[[nodiscard]] static __m128i base64_char_from_int_ssse3(__m128i values, __m128i offsets) noexcept
+{
+    auto classes = _mm_subs_epu8(values, _mm_set1_epi8(51));
+    classes = _mm_or_si128(classes, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), values), _mm_set1_epi8(13)));
+    return _mm_add_epi8(values, _mm_shuffle_epi8(offsets, classes));
+}
+
+/** The offsets to add to a value in each class; see base64_char_from_int_ssse3().
+ */
+[[nodiscard]] static __m128i base64_offsets_ssse3(bool url) noexcept
+{
+    ttlet &alphabet = base64_alphabet(url);
+    ttlet offset62 = static_cast<char>(alphabet.char_from_int_table[62] - 62);
+    ttlet offset63 = static_cast<char>(alphabet.char_from_int_table[63] - 63);
+    return _mm_setr_epi8(71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, offset62, offset63, 65, 0, 0);
+}
+
+/** Split 12 bytes into 16 values of 6 bits.
+ *
+ * @param bytes The bytes in the lower 12 bytes of the register.
+ */
+[[nodiscard]] static __m128i base64_split_ssse3(__m128i bytes) noexcept
+{
+    // Put the three bytes of each block in a 32-bit word as: b1 b0 b2 b1.
+    bytes = _mm_shuffle_epi8(bytes, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+
+    // Shift each 6-bit field into its own byte.
+    ttlet ac = _mm_mulhi_epu16(_mm_and_si128(bytes, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+    ttlet bd = _mm_mullo_epi16(_mm_and_si128(bytes, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(ac, bd);
+}
+
+/** Convert base64 characters to 6-bit values.
+ *
+ * @param chars The characters.
+ * @param char62 The character that encodes the value 62.
+ * @param char63 The character that encodes the value 63.
+ * @param[out] valid Set to all ones for each character that is part of the alphabet.
+ * @return The 6-bit values.
+ */
+[[nodiscard]] static __m128i base64_int_from_char_ssse3(__m128i chars, __m128i char62, __m128i char63, __m128i &valid) noexcept
+{
+    // Characters with the high bit set are negative, so they are not in any of the ranges.
+    ttlet upper = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('Z' + 1)));
+    ttlet lower = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('z' + 1)));
+    ttlet digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+    ttlet is62 = _mm_cmpeq_epi8(chars, char62);
+    ttlet is63 = _mm_cmpeq_epi8(chars, char63);
+    valid = _mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), digit), _mm_or_si128(is62, is63));
+
+    auto offset = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+    offset = _mm_or_si128(offset, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+    offset = _mm_or_si128(offset, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+    offset = _mm_or_si128(offset, _mm_and_si128(is62, _mm_sub_epi8(_mm_set1_epi8(62), char62)));
+    offset = _mm_or_si128(offset, _mm_and_si128(is63, _mm_sub_epi8(_mm_set1_epi8(63), char63)));
+    return _mm_add_epi8(chars, offset);
+}
+
+/** Merge 16 values of 6 bits into 12 bytes, in the lower 12 bytes of the result.
+ */
+[[nodiscard]] static __m128i base64_merge_ssse3(__m128i values) noexcept
+{
+    // Merge pairs of values into 12 bits, then pairs of 12 bits into 24 bits.
+    ttlet pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    ttlet blocks = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+
+    // Pack the 24 bits of each 32-bit word in big-endian order.
+    return _mm_shuffle_epi8(blocks, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+[[nodiscard]] size_t base64_encode_ssse3(char *output, std::span<std::byte const> bytes, bool url) noexcept
+{
+    ttlet offsets = base64_offsets_ssse3(url);
+
+    auto ptr = bytes.data();
+    // 16 bytes are loaded of which 12 are encoded.
+    ttlet last = ptr + (bytes.size() >= 16 ? (bytes.size() - 4) / 12 * 12 : 0);
+    for (; ptr != last; ptr += 12, output += 16) {
+        ttlet values = base64_split_ssse3(_mm_loadu_si128(reinterpret_cast<__m128i const *>(ptr)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output), base64_char_from_int_ssse3(values, offsets));
+    }
+    return narrow_cast<size_t>(ptr - bytes.data());
+}
+
+[[nodiscard]] size_t base64_decode_ssse3(std::byte *output, std::string_view str, bool url) noexcept
+{
+    ttlet &alphabet = base64_alphabet(url);
+    ttlet char62 = _mm_set1_epi8(alphabet.char_from_int_table[62]);
+    ttlet char63 = _mm_set1_epi8(alphabet.char_from_int_table[63]);
+
+    auto ptr = str.data();
+    ttlet last = ptr + str.size() / 16 * 16;
+    for (; ptr != last; ptr += 16, output += 12) {
+        __m128i valid;
+        ttlet values =
+            base64_int_from_char_ssse3(_mm_loadu_si128(reinterpret_cast<__m128i const *>(ptr)), char62, char63, valid);
+        if (_mm_movemask_epi8(valid) != 0xffff) {
+            break;
+        }
+
+        ttlet block = base64_merge_ssse3(values);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(output), block);
+        ttlet tail = _mm_cvtsi128_si32(_mm_srli_si128(block, 8));
+        std::memcpy(output + 8, &tail, 4);
+    }
+    return narrow_cast<size_t>(ptr - str.data());
+}
+#endif
+
+#if TT_X86_64_V2
+// The AVX2 functions are compiled for AVX2 independent of the x86-64 level of the build,
+// and are only called when the CPU supports AVX2.
+[[nodiscard]] tt_target_avx2 size_t base64_encode_avx2(char *output, std::span<std::byte const> bytes, bool url) noexcept
+{
+    ttlet offsets = _mm256_broadcastsi128_si256(base64_offsets_ssse3(url));
+    ttlet split = _mm256_setr_epi8(
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+
+    auto ptr = bytes.data();
+    // Each half of the register is loaded with 16 bytes of which 12 are encoded.
+    ttlet last = ptr + (bytes.size() >= 28 ? (bytes.size() - 4) / 24 * 24 : 0);
+    for (; ptr != last; ptr += 24, output += 32) {
+        ttlet lo = _mm_loadu_si128(reinterpret_cast<__m128i const *>(ptr));
+        ttlet hi = _mm_loadu_si128(reinterpret_cast<__m128i const *>(ptr + 12));
+        auto block = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), split);
+
+        ttlet ac = _mm256_mulhi_epu16(_mm256_and_si256(block, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+        ttlet bd = _mm256_mullo_epi16(_mm256_and_si256(block, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+        ttlet values = _mm256_or_si256(ac, bd);
+
+        auto classes = _mm256_subs_epu8(values, _mm256_set1_epi8(51));
+        classes = _mm256_or_si256(
+            classes, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), values), _mm256_set1_epi8(13)));
+        ttlet chars = _mm256_add_epi8(values, _mm256_shuffle_epi8(offsets, classes));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output), chars);
+    }
+    return narrow_cast<size_t>(ptr - bytes.data());
+}
+
+[[nodiscard]] tt_target_avx2 size_t base64_decode_avx2(std::byte *output, std::string_view str, bool url) noexcept
+{
+    ttlet &alphabet = base64_alphabet(url);
+    ttlet char62 = _mm256_set1_epi8(alphabet.char_from_int_table[62]);
+    ttlet char63 = _mm256_set1_epi8(alphabet.char_from_int_table[63]);
+
+    auto ptr = str.data();
+    ttlet last = ptr + str.size() / 32 * 32;
+    for (; ptr != last; ptr += 32, output += 24) {
+        ttlet chars = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(ptr));
+
+        // Characters with the high bit set are negative, so they are not in any of the ranges.
+        ttlet upper =
+            _mm256_andnot_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('Z')), _mm256_cmpgt_epi8(chars, _mm256_set1_epi8('A' - 1)));
+        ttlet lower =
+            _mm256_andnot_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('z')), _mm256_cmpgt_epi8(chars, _mm256_set1_epi8('a' - 1)));
+        ttlet digit =
+            _mm256_andnot_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('9')), _mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)));
+        ttlet is62 = _mm256_cmpeq_epi8(chars, char62);
+        ttlet is63 = _mm256_cmpeq_epi8(chars, char63);
+        ttlet valid = _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(upper, lower), digit), _mm256_or_si256(is62, is63));
+        if (_mm256_movemask_epi8(valid) != -1) {
+            break;
+        }
+
+        auto offset = _mm256_and_si256(upper, _mm256_set1_epi8(-'A'));
+        offset = _mm256_or_si256(offset, _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a')));
+        offset = _mm256_or_si256(offset, _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')));
+        offset = _mm256_or_si256(offset, _mm256_and_si256(is62, _mm256_sub_epi8(_mm256_set1_epi8(62), char62)));
+        offset = _mm256_or_si256(offset, _mm256_and_si256(is63, _mm256_sub_epi8(_mm256_set1_epi8(63), char63)));
+        ttlet values = _mm256_add_epi8(chars, offset);
+
+        ttlet pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        auto blocks = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+        blocks = _mm256_shuffle_epi8(
+            blocks,
+            _mm256_setr_epi8(
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+        // Move the 12 bytes of the upper half next to the 12 bytes of the lower half.
+        blocks = _mm256_permutevar8x32_epi32(blocks, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output), _mm256_castsi256_si128(blocks));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(output + 16), _mm256_extracti128_si256(blocks, 1));
+    }
+    return narrow_cast<size_t>(ptr - str.data());
+}
+#endif
+
+[[nodiscard]] size_t base64_encode(char *output, std::span<std::byte const> bytes, bool url) noexcept
+{
+    size_t nr_bytes = 0;
+#if TT_X86_64_V2
+    static ttlet has_avx2 = cpu_has_avx2();
+    if (has_avx2) {
+        nr_bytes = base64_encode_avx2(output, bytes, url);
+    } else {
+        nr_bytes = base64_encode_ssse3(output, bytes, url);
+    }
+#endif
+    return nr_bytes + base64_encode_scalar(output + nr_bytes / 3 * 4, bytes.subspan(nr_bytes), url);
+}
+
+[[nodiscard]] size_t base64_decode(std::byte *output, std::string_view str, bool url) noexcept
+{
+    size_t nr_chars = 0;
+#if TT_X86_64_V2
+    static ttlet has_avx2 = cpu_has_avx2();
+    if (has_avx2) {
+        nr_chars = base64_decode_avx2(output, str, url);
+    } else {
+        nr_chars = base64_decode_ssse3(output, str, url);
+    }
+#endif
+    return nr_chars + base64_decode_scalar(output + nr_chars / 4 * 3, str.substr(nr_chars), url);
+}
+
+} // namespace detail
+} // namespace tt
@@ -6,6 +6,7 @@
 
 #include "../byte_string.hpp"
 #include "../required.hpp"
+#include "../architecture.hpp"
 #include "../assert.hpp"
 #include "../cast.hpp"
 #include "../check.hpp"
@@ -15,8 +16,7 @@
 #include <array>
 #include <string>
 #include <string_view>
-
-#pragma once
+#include <type_traits>
 
 namespace tt {
 namespace detail {
@@ -85,7 +85,7 @@ struct base_n_alphabet {
 
     constexpr int8_t int_from_char(char c) const noexcept
     {
-        return int_from_char_table[narrow_cast<size_t>(c)];
+        return int_from_char_table[static_cast<uint8_t>(c)];
     }
 };
 
@@ -113,6 +113,66 @@ constexpr auto base85_rfc1924_alphabet =
 constexpr auto base85_btoa_alphabet =
     base_n_alphabet{"!\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstu"};
 
+/** Encode the complete 3 byte blocks of the data as base64, without using the generic base_n algorithm.
+ *
+ * @param output The output buffer, with room for `bytes.size() / 3 * 4` characters.
+ * @param bytes The data to encode.
+ * @param url Use the base64url alphabet instead of the base64 alphabet.
+ * @return The number of bytes that were encoded, a multiple of 3.
+ */
+[[nodiscard]] size_t base64_encode_scalar(char *output, std::span<std::byte const> bytes, bool url) noexcept;
+
+/** Decode complete 4 character blocks of base64, without using the generic base_n algorithm.
+ *
+ * Decoding stops at the first block which contains a character that is not part of the alphabet,
+ * such as white-space, padding or an invalid character. The rest of the string should be decoded
+ * with the generic algorithm, which handles these characters.
+ *
+ * @param output The output buffer, with room for `str.size() / 4 * 3` bytes.
+ * @param str The base64 encoded string.
+ * @param url Use the base64url alphabet instead of the base64 alphabet.
+ * @return The number of characters that were decoded, a multiple of 4.
+ */
+[[nodiscard]] size_t base64_decode_scalar(std::byte *output, std::string_view str, bool url) noexcept;
+
+#if TT_X86_64_V2
+/** Encode 12 bytes at a time as base64.
+ * @see base64_encode_scalar()
+ * @return The number of bytes that were encoded; the caller encodes the rest.
+ */
+[[nodiscard]] size_t base64_encode_ssse3(char *output, std::span<std::byte const> bytes, bool url) noexcept;
+
+/** Decode 16 characters at a time of base64.
+ * @see base64_decode_scalar()
+ * @return The number of characters that were decoded; the caller decodes the rest.
+ */
+[[nodiscard]] size_t base64_decode_ssse3(std::byte *output, std::string_view str, bool url) noexcept;
+
+/** Encode 24 bytes at a time as base64.
+ * @pre The CPU supports AVX2.
+ * @see base64_encode_scalar()
+ * @return The number of bytes that were encoded; the caller encodes the rest.
+ */
+[[nodiscard]] size_t base64_encode_avx2(char *output, std::span<std::byte const> bytes, bool url) noexcept;
+
+/** Decode 32 characters at a time of base64.
+ * @pre The CPU supports AVX2.
+ * @see base64_decode_scalar()
+ * @return The number of characters that were decoded; the caller decodes the rest.
+ */
+[[nodiscard]] size_t base64_decode_avx2(std::byte *output, std::string_view str, bool url) noexcept;
+#endif
+
+/** Encode the complete 3 byte blocks of the data as base64, using the fastest method of the CPU.
+ * @see base64_encode_scalar()
+ */
+[[nodiscard]] size_t base64_encode(char *output, std::span<std::byte const> bytes, bool url) noexcept;
+
+/** Decode complete 4 character blocks of base64, using the fastest method of the CPU.
+ * @see base64_decode_scalar()
+ */
+[[nodiscard]] size_t base64_decode(std::byte *output, std::string_view str, bool url) noexcept;
+
 } // namespace detail
 
 template<detail::base_n_alphabet Alphabet, int CharsPerBlock, int BytesPerBlock>
@@ -126,6 +186,13 @@ public:
     static_assert(bytes_per_block != 0, "radix must be 16, 32, 64 or 85");
     static_assert(chars_per_block != 0, "radix must be 16, 32, 64 or 85");
 
+    /** The base64 and base64url encodings are accelerated by SIMD kernels.
+     */
+    static constexpr bool is_base64 =
+        radix == 64 and alphabet.char_from_int_table == detail::base64_rfc4648_alphabet.char_from_int_table;
+    static constexpr bool is_base64url =
+        radix == 64 and alphabet.char_from_int_table == detail::base64url_rfc4648_alphabet.char_from_int_table;
+
     template<typename T>
     static constexpr T int_from_char(char c) noexcept
     {
@@ -188,7 +255,18 @@ public:
      */
     static constexpr std::string encode(std::span<std::byte const> bytes) noexcept
     {
-        return encode(begin(bytes), end(bytes));
+        auto r = std::string{};
+        if constexpr (is_base64 or is_base64url) {
+            if (not std::is_constant_evaluated()) {
+                r.resize(bytes.size() / 3 * 4);
+                ttlet nr_bytes = detail::base64_encode(r.data(), bytes, is_base64url);
+                r.resize(nr_bytes / 3 * 4);
+                bytes = bytes.subspan(nr_bytes);
+            }
+        }
+
+        encode(begin(bytes), end(bytes), std::back_inserter(r));
+        return r;
     }
 
     /** Decodes a UTF-8 string into bytes.
@@ -239,6 +317,27 @@ public:
     static bstring decode(std::string_view str)
     {
         auto r = bstring{};
+        if constexpr (is_base64 or is_base64url) {
+            r.resize(str.size() / 4 * 3);
+            auto output = r.data();
+            while (true) {
+                ttlet nr_chars = detail::base64_decode(output, str, is_base64url);
+                output += nr_chars / 4 * 3;
+                str = str.substr(nr_chars);
+
+                // Skip white-space between blocks, such as line-breaks, and continue with the next blocks.
+                auto i = 0_uz;
+                while (i != str.size() and int_from_char<int>(str[i]) == -1) {
+                    ++i;
+                }
+                if (i == 0) {
+                    break;
+                }
+                str = str.substr(i);
+            }
+            r.resize(static_cast<size_t>(output - r.data()));
+        }
+
         auto i = decode(begin(str), end(str), std::back_inserter(r));
         tt_parse_check(i == end(str));
         return r;
@@ -257,7 +356,7 @@ private:
             block /= radix;
 
             if (i < padding) {
-                tt_assume(v != 0);
+                tt_axiom(v == 0);
                 if (padding_char != 0) {
                     char_block += padding_char;
                 }
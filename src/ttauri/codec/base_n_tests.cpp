@@ -6,8 +6,12 @@
 #include "ttauri/byte_string.hpp"
 #include "ttauri/required.hpp"
 #include "ttauri/exception.hpp"
+#if TT_PROCESSOR == TT_CPU_X64
+#include "ttauri/cpu_id.hpp"
+#endif
 #include <gtest/gtest.h>
 #include <iostream>
+#include <random>
 
 using namespace std;
 using namespace tt;
@@ -57,3 +61,99 @@ TEST(base_n, base64_decode) {
     ASSERT_EQ(base64::decode("SGVsb G8g\nV29ybGQK"), to_bstring("Hello World\n"));
     ASSERT_THROW(base64::decode("SGVsbG8g,V29ybGQK"), parse_error);
 }
+
+static bstring random_bytes(size_t size)
+{
+    auto engine = std::mt19937{42};
+    auto dist = std::uniform_int_distribution<int>{0, 255};
+
+    auto r = bstring{};
+    for (size_t i = 0; i != size; ++i) {
+        r.push_back(static_cast<std::byte>(dist(engine)));
+    }
+    return r;
+}
+
+/** Compare a vectorized base64 kernel with the scalar kernel.
+ */
+template<typename Encode, typename Decode>
+static void compare_base64(Encode const &encode, Decode const &decode)
+{
+    ttlet data = random_bytes(1000);
+
+    for (ttlet url : {false, true}) {
+        for (size_t size = 0; size < 1000; size += (size < 200 ? 1 : 97)) {
+            ttlet bytes = std::span<std::byte const>(data).first(size);
+
+            auto expected = std::string(size / 3 * 4, '\0');
+            ASSERT_EQ(detail::base64_encode_scalar(expected.data(), bytes, url), size / 3 * 3);
+
+            auto chars = std::string(size / 3 * 4, '\0');
+            ttlet nr_bytes = encode(chars.data(), bytes, url);
+            ASSERT_EQ(nr_bytes % 3, 0);
+            ASSERT_EQ(chars.substr(0, nr_bytes / 3 * 4), expected.substr(0, nr_bytes / 3 * 4)) << "size=" << size;
+
+            auto decoded = bstring(expected.size() / 4 * 3, std::byte{0});
+            ttlet nr_chars = decode(decoded.data(), expected, url);
+            ASSERT_EQ(nr_chars % 4, 0);
+            ASSERT_TRUE(std::equal(decoded.begin(), decoded.begin() + nr_chars / 4 * 3, data.begin())) << "size=" << size;
+        }
+
+        // The decoder stops before the block with a character that is not part of the alphabet.
+        auto message = std::string(256, '\0');
+        (void)detail::base64_encode_scalar(message.data(), std::span<std::byte const>(data).first(192), url);
+        for (ttlet c : {'\0', ' ', '=', '\x80', '\xff', url ? '+' : '-', url ? '/' : '_', '@', '[', '`', '{'}) {
+            for (size_t i = 0; i != message.size(); ++i) {
+                auto bad_message = message;
+                bad_message[i] = c;
+
+                auto decoded = bstring(192, std::byte{0});
+                ASSERT_LE(decode(decoded.data(), bad_message, url), i / 4 * 4) << "i=" << i << " c=" << int(c);
+            }
+        }
+    }
+}
+
+TEST(base_n, base64_scalar)
+{
+    compare_base64(detail::base64_encode_scalar, detail::base64_decode_scalar);
+    compare_base64(detail::base64_encode, detail::base64_decode);
+}
+
+#if TT_X86_64_V2
+TEST(base_n, base64_SSSE3)
+{
+    compare_base64(detail::base64_encode_ssse3, detail::base64_decode_ssse3);
+}
+#endif
+
+#if TT_X86_64_V2
+TEST(base_n, base64_AVX2)
+{
+    if (not cpu_has_avx2()) {
+        GTEST_SKIP() << "The CPU does not support AVX2.";
+    }
+    compare_base64(detail::base64_encode_avx2, detail::base64_decode_avx2);
+}
+#endif
+
+TEST(base_n, base64_large)
+{
+    ttlet data = random_bytes(10000);
+    ttlet message = base64::encode(data);
+    ASSERT_EQ(message.size(), 13336);
+    ASSERT_EQ(base64::decode(message), data);
+    ASSERT_EQ(base64url::decode(base64url::encode(data)), data);
+
+    // Lines of 76 characters, as in MIME.
+    auto lines = std::string{};
+    for (size_t i = 0; i < message.size(); i += 76) {
+        lines += message.substr(i, 76);
+        lines += "\r\n";
+    }
+    ASSERT_EQ(base64::decode(lines), data);
+
+    auto bad_message = message;
+    bad_message[5000] = '-';
+    ASSERT_THROW(base64::decode(bad_message), parse_error);
+}
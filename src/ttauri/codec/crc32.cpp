@@ -0,0 +1,152 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "crc32.hpp"
+#include "../endian.hpp"
+#if TT_PROCESSOR == TT_CPU_X64
+#include "../cpu_id.hpp"
+#endif
+#if TT_X86_64_V2
+#include <emmintrin.h> // SSE2
+#include <smmintrin.h> // SSE4.1
+#include <wmmintrin.h> // PCLMULQDQ
+#endif
+#include <array>
+
+namespace tt {
+namespace detail {
+
+[[nodiscard]] constexpr std::array<std::array<uint32_t, 256>, 8> crc32_make_tables() noexcept
+{
+    auto r = std::array<std::array<uint32_t, 256>, 8>{};
+
+    for (uint32_t i = 0; i != 256; ++i) {
+        auto c = i;
+        for (int k = 0; k != 8; ++k) {
+            c = (c & 1) ? (c >> 1) ^ 0xedb8'8320 : c >> 1;
+        }
+        r[0][i] = c;
+    }
+
+    // Table t gives the CRC of a byte followed by t zero bytes.
+    for (int t = 1; t != 8; ++t) {
+        for (int i = 0; i != 256; ++i) {
+            r[t][i] = (r[t - 1][i] >> 8) ^ r[0][r[t - 1][i] & 0xff];
+        }
+    }
+    return r;
+}
+
+constexpr auto crc32_tables = crc32_make_tables();
+
+[[nodiscard]] uint32_t crc32_scalar(std::span<std::byte const> bytes, uint32_t crc) noexcept
+{
+    ttlet &t = crc32_tables;
+
+    auto p = bytes.data();
+    auto size = std::ssize(bytes);
+
+    crc = ~crc;
+    for (; size >= 8; p += 8, size -= 8) {
+        ttlet lo = reinterpret_cast<little_uint32_buf_t const *>(p)->value() ^ crc;
+        ttlet hi = reinterpret_cast<little_uint32_buf_t const *>(p + 4)->value();
+
+        crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^ t[3][hi & 0xff] ^
+            t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+    }
+
+    for (; size != 0; ++p, --size) {
+        crc = t[0][(crc ^ static_cast<uint8_t>(*p)) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+#if TT_X86_64_V2
+/** Fold a 128 bit remainder over the next 128 bits of data.
+ *
+ * @param x The remainder.
+ * @param k The folding constants for the distance between the remainder and the data.
+ * @param data The next 128 bits of data.
+ */
+[[nodiscard]] static __m128i crc32_fold(__m128i x, __m128i k, __m128i data) noexcept
+{
+    ttlet lo = _mm_clmulepi64_si128(x, k, 0x00);
+    ttlet hi = _mm_clmulepi64_si128(x, k, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(lo, hi), data);
+}
+
+/* The algorithm and constants are from:
+ * "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction",
+ * V. Gopal, E. Ozturk, et al., 2009, for the bit-reflected polynomial 0x1db710641.
+ */
+[[nodiscard]] uint32_t crc32_pclmul(std::span<std::byte const> bytes, uint32_t crc) noexcept
+{
+    if (std::ssize(bytes) < 64) {
+        return crc32_scalar(bytes, crc);
+    }
+
+    auto p = bytes.data();
+    auto size = std::ssize(bytes);
+
+    ttlet load = [](std::byte const *ptr) {
+        return _mm_loadu_si128(reinterpret_cast<__m128i const *>(ptr));
+    };
+
+    // Fold 4 x 128 bits in parallel, 512 bits at a time.
+    auto x1 = _mm_xor_si128(load(p), _mm_cvtsi32_si128(static_cast<int>(~crc)));
+    auto x2 = load(p + 16);
+    auto x3 = load(p + 32);
+    auto x4 = load(p + 48);
+    p += 64;
+    size -= 64;
+
+    ttlet k1k2 = _mm_set_epi64x(0x01'c6e4'1596, 0x01'5444'2bd4);
+    for (; size >= 64; p += 64, size -= 64) {
+        x1 = crc32_fold(x1, k1k2, load(p));
+        x2 = crc32_fold(x2, k1k2, load(p + 16));
+        x3 = crc32_fold(x3, k1k2, load(p + 32));
+        x4 = crc32_fold(x4, k1k2, load(p + 48));
+    }
+
+    // Fold the four remainders into one, then fold in the rest of the data 128 bits at a time.
+    ttlet k3k4 = _mm_set_epi64x(0x00'ccaa'009e, 0x01'7519'97d0);
+    x1 = crc32_fold(x1, k3k4, x2);
+    x1 = crc32_fold(x1, k3k4, x3);
+    x1 = crc32_fold(x1, k3k4, x4);
+    for (; size >= 16; p += 16, size -= 16) {
+        x1 = crc32_fold(x1, k3k4, load(p));
+    }
+
+    // Fold 128 bits to 64 bits.
+    ttlet mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x10), _mm_srli_si128(x1, 8));
+
+    ttlet k5 = _mm_set_epi64x(0, 0x01'63cd'6124);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k5, 0x00), _mm_srli_si128(x1, 4));
+
+    // Barrett reduction to 32 bits.
+    ttlet poly = _mm_set_epi64x(0x01'f701'1641, 0x01'db71'0641);
+    auto x2_ = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), poly, 0x10);
+    x2_ = _mm_clmulepi64_si128(_mm_and_si128(x2_, mask32), poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2_);
+
+    crc = ~static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+    return crc32_scalar({p, static_cast<size_t>(size)}, crc);
+}
+#endif
+
+} // namespace detail
+
+[[nodiscard]] uint32_t crc32(std::span<std::byte const> bytes, uint32_t crc) noexcept
+{
+#if TT_X86_64_V2
+    static ttlet has_pclmul = cpu_has_pclmulqdq();
+    if (has_pclmul) {
+        return detail::crc32_pclmul(bytes, crc);
+    }
+#endif
+    return detail::crc32_scalar(bytes, crc);
+}
+
+} // namespace tt
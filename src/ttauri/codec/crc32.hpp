@@ -0,0 +1,41 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "../required.hpp"
+#include "../architecture.hpp"
+#include <span>
+#include <cstddef>
+#include <cstdint>
+
+namespace tt {
+namespace detail {
+
+/** Calculate the CRC-32 one byte at a time using slicing-by-8 tables.
+ */
+[[nodiscard]] uint32_t crc32_scalar(std::span<std::byte const> bytes, uint32_t crc) noexcept;
+
+#if TT_X86_64_V2
+/** Calculate the CRC-32 by folding 64 bytes at a time using carry-less multiplication.
+ *
+ * @pre The CPU supports PCLMULQDQ.
+ */
+[[nodiscard]] uint32_t crc32_pclmul(std::span<std::byte const> bytes, uint32_t crc) noexcept;
+#endif
+
+} // namespace detail
+
+/** Calculate the CRC-32 of data.
+ *
+ * This is the CRC-32 used by png, gzip and zip; with the reflected polynomial 0xedb88320.
+ * A CRC-32 may be calculated incrementally by passing the result of the previous chunk of data.
+ *
+ * @param bytes The data.
+ * @param crc The CRC-32 of the preceding data.
+ * @return The CRC-32 of the preceding data combined with `bytes`.
+ */
+[[nodiscard]] uint32_t crc32(std::span<std::byte const> bytes, uint32_t crc = 0) noexcept;
+
+} // namespace tt
@@ -0,0 +1,49 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/codec/crc32.hpp"
+#include "ttauri/byte_string.hpp"
+#include "ttauri/required.hpp"
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace std;
+using namespace tt;
+
+TEST(CRC32, Check)
+{
+    ttlet check = to_bstring("123456789");
+    ASSERT_EQ(crc32(check), 0xcbf4'3926);
+    ASSERT_EQ(detail::crc32_scalar(check, 0), 0xcbf4'3926);
+    ASSERT_EQ(crc32({}), 0);
+}
+
+TEST(CRC32, Incremental)
+{
+    ttlet check = to_bstring("123456789");
+    ttlet bytes = std::span<std::byte const>(check);
+    ASSERT_EQ(crc32(bytes.subspan(4), crc32(bytes.first(4))), 0xcbf4'3926);
+}
+
+#if TT_X86_64_V2
+TEST(CRC32, PCLMUL)
+{
+    auto engine = std::mt19937{42};
+    auto dist = std::uniform_int_distribution<int>{0, 255};
+
+    auto data = bstring{};
+    for (int i = 0; i != 1100; ++i) {
+        data.push_back(static_cast<std::byte>(dist(engine)));
+    }
+    ttlet bytes = std::span<std::byte const>(data);
+
+    for (ttlet offset : {0, 1, 3, 8, 15}) {
+        for (ssize_t size = 0; size <= 1024; size += (size < 200 ? 1 : 37)) {
+            ttlet chunk = bytes.subspan(offset, size);
+            ASSERT_EQ(detail::crc32_pclmul(chunk, 0x1234'5678), detail::crc32_scalar(chunk, 0x1234'5678))
+                << "offset=" << offset << " size=" << size;
+        }
+    }
+}
+#endif
@@ -0,0 +1,881 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "deflate.hpp"
+#include "inflate.hpp"
+#include "../cast.hpp"
+#if TT_X86_64_V2
+#include <emmintrin.h> // SSE2
+#endif
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <tuple>
+#include <utility>
+#include <bit>
+#include <cstring>
+
+namespace tt {
+
+/** Parameters of the match finder for a compression level.
+ */
+struct deflate_config {
+    /** When the previous match is at least this long, the hash-chain search is reduced to a quarter.
+     */
+    int good_length;
+
+    /** Greedy: only insert the positions covered by a match of at most this length in the hash table.
+     * Lazy: do not search for a better match after a match of at least this length.
+     */
+    int max_lazy;
+
+    /** Stop searching when a match of at least this length is found.
+     */
+    int nice_length;
+
+    /** The maximum number of positions on the hash-chain to check.
+     */
+    int max_chain;
+
+    bool lazy;
+};
+
+constexpr auto deflate_configs = std::array<deflate_config, 10>{{
+    {0, 0, 0, 0, false},
+    {4, 4, 8, 1, false},
+    {4, 5, 16, 8, false},
+    {4, 6, 32, 32, false},
+    {4, 4, 16, 16, true},
+    {8, 16, 32, 32, true},
+    {8, 16, 128, 128, true},
+    {8, 32, 128, 256, true},
+    {32, 128, 258, 1024, true},
+    {32, 258, 258, 4096, true},
+}};
+
+/** Matches of the minimum length that are further away than this are not worth encoding.
+ */
+constexpr int deflate_too_far = 4096;
+
+/** The maximum number of symbols in a block.
+ */
+constexpr ssize_t deflate_max_block_symbols = 0x4000;
+
+/** Level 0: the number of bytes after which a block of stored data is written.
+ */
+constexpr ssize_t deflate_max_stored_block = 0x4'0000;
+
+/** The number of bytes at the end of the input that are only compressed when more data is available.
+ */
+constexpr ssize_t deflate_lookahead = deflate_max_match + deflate_min_match + 1;
+
+/** The minimum number of bytes to discard from the front of the buffer.
+ */
+constexpr ssize_t deflate_discard_size = 0x1'0000;
+
+/** The length symbol minus 257, for each match length.
+ */
+constexpr auto deflate_length_code = []() {
+    auto r = std::array<uint8_t, deflate_max_match + 1>{};
+    for (int code = 0; code != std::ssize(inflate_length_base); ++code) {
+        ttlet first = inflate_length_base[code];
+        ttlet last = std::min(first + (1 << inflate_length_extra[code]) - 1, deflate_max_match);
+        for (int length = first; length <= last; ++length) {
+            r[length] = static_cast<uint8_t>(code);
+        }
+    }
+    return r;
+}();
+
+[[nodiscard]] constexpr int deflate_distance_code(int distance) noexcept
+{
+    tt_axiom(distance >= 1 && distance <= deflate_window_size);
+    if (distance <= 4) {
+        return distance - 1;
+    }
+
+    // Each power of two is split in two codes.
+    ttlet d = static_cast<unsigned int>(distance - 1);
+    ttlet width = std::bit_width(d);
+    return (width - 1) * 2 + static_cast<int>((d >> (width - 2)) & 1);
+}
+
+/** Calculate the code lengths of a length-limited huffman code.
+ *
+ * @param frequencies The number of times each symbol is used.
+ * @param max_length The maximum length of a code.
+ * @return The length of the code of each symbol; zero for unused symbols.
+ */
+[[nodiscard]] static std::vector<int> deflate_code_lengths(std::span<uint32_t const> frequencies, int max_length) noexcept
+{
+    auto r = std::vector<int>(frequencies.size(), 0);
+
+    auto symbols = std::vector<int>{};
+    for (int symbol = 0; symbol != std::ssize(frequencies); ++symbol) {
+        if (frequencies[symbol] != 0) {
+            symbols.push_back(symbol);
+        }
+    }
+
+    // A code needs at least two symbols to be complete.
+    for (int symbol = 0; std::ssize(symbols) < 2; ++symbol) {
+        if (frequencies[symbol] == 0) {
+            symbols.push_back(symbol);
+        }
+    }
+
+    std::stable_sort(symbols.begin(), symbols.end(), [&frequencies](ttlet a, ttlet b) {
+        return frequencies[a] < frequencies[b];
+    });
+
+    // Build the huffman tree by merging the two lightest nodes, using a queue of leaves
+    // sorted by weight, and a queue of internal nodes which are created in order of weight.
+    // Nodes [0, n) are the leaves, nodes [n, 2n - 1) the internal nodes.
+    ttlet nr_leaves = std::ssize(symbols);
+    auto weights = std::vector<uint64_t>(nr_leaves * 2 - 1);
+    auto parents = std::vector<ssize_t>(nr_leaves * 2 - 1, 0);
+    for (ssize_t i = 0; i != nr_leaves; ++i) {
+        weights[i] = frequencies[symbols[i]];
+    }
+
+    ssize_t next_leaf = 0;
+    ssize_t next_node = nr_leaves;
+    auto take_lightest = [&](ssize_t end_node) {
+        if (next_leaf != nr_leaves && (next_node == end_node || weights[next_leaf] <= weights[next_node])) {
+            return next_leaf++;
+        } else {
+            return next_node++;
+        }
+    };
+
+    for (ssize_t node = nr_leaves; node != std::ssize(weights); ++node) {
+        ttlet a = take_lightest(node);
+        ttlet b = take_lightest(node);
+        weights[node] = weights[a] + weights[b];
+        parents[a] = node;
+        parents[b] = node;
+    }
+
+    // The depth of each node; the root is the last node.
+    auto depths = std::vector<int>(weights.size(), 0);
+    for (auto node = std::ssize(weights) - 2; node >= 0; --node) {
+        depths[node] = depths[parents[node]] + 1;
+    }
+
+    // Count the number of codes of each length, and shorten the codes that are too long.
+    auto counts = std::vector<int>(max_length + 1, 0);
+    for (ssize_t i = 0; i != nr_leaves; ++i) {
+        ++counts[std::min(depths[i], max_length)];
+    }
+
+    // Shortening codes oversubscribes the code-space. Make room by lengthening the
+    // codes just below the maximum length.
+    auto kraft = uint64_t{0};
+    for (int length = 1; length <= max_length; ++length) {
+        kraft += static_cast<uint64_t>(counts[length]) << (max_length - length);
+    }
+    while (kraft > (uint64_t{1} << max_length)) {
+        --counts[max_length];
+        for (int length = max_length - 1; length > 0; --length) {
+            if (counts[length] != 0) {
+                --counts[length];
+                counts[length + 1] += 2;
+                break;
+            }
+        }
+        --kraft;
+    }
+
+    // Give the longest codes to the least frequent symbols.
+    auto i = 0;
+    for (int length = max_length; length > 0; --length) {
+        for (int j = 0; j != counts[length]; ++j) {
+            r[symbols[i++]] = length;
+        }
+    }
+    return r;
+}
+
+/** Calculate the canonical huffman codes from the code lengths.
+ *
+ * @return The codes, with the bits reversed so that they can be written least significant bit first.
+ */
+[[nodiscard]] static std::vector<uint16_t> deflate_codes(std::vector<int> const &lengths) noexcept
+{
+    auto counts = std::array<int, 16>{};
+    for (ttlet length : lengths) {
+        ++counts[length];
+    }
+    counts[0] = 0;
+
+    auto next_code = std::array<int, 16>{};
+    auto code = 0;
+    for (int length = 1; length != 16; ++length) {
+        code = (code + counts[length - 1]) << 1;
+        next_code[length] = code;
+    }
+
+    auto r = std::vector<uint16_t>(lengths.size(), 0);
+    for (ssize_t symbol = 0; symbol != std::ssize(lengths); ++symbol) {
+        ttlet length = lengths[symbol];
+        if (length != 0) {
+            auto c = next_code[length]++;
+            auto reversed = 0;
+            for (int i = 0; i != length; ++i) {
+                reversed = (reversed << 1) | (c & 1);
+                c >>= 1;
+            }
+            r[symbol] = narrow_cast<uint16_t>(reversed);
+        }
+    }
+    return r;
+}
+
+/** A huffman code for writing symbols.
+ */
+struct deflate_huffman_code {
+    std::vector<int> lengths;
+    std::vector<uint16_t> codes;
+
+    deflate_huffman_code(std::vector<int> lengths) noexcept : lengths(std::move(lengths)), codes(deflate_codes(this->lengths)) {}
+
+    void write(deflate_bit_writer &writer, int symbol) const noexcept
+    {
+        tt_axiom(lengths[symbol] != 0);
+        writer.write(codes[symbol], lengths[symbol]);
+    }
+
+    /** The number of bits needed to write symbols with the given frequencies.
+     */
+    [[nodiscard]] size_t cost(std::span<uint32_t const> frequencies) const noexcept
+    {
+        auto r = size_t{0};
+        for (ssize_t symbol = 0; symbol != std::ssize(frequencies); ++symbol) {
+            r += static_cast<size_t>(frequencies[symbol]) * lengths[symbol];
+        }
+        return r;
+    }
+};
+
+static deflate_huffman_code const deflate_fixed_literal_code = []() {
+    auto lengths = std::vector<int>(288, 0);
+    std::fill(lengths.begin(), lengths.begin() + 144, 8);
+    std::fill(lengths.begin() + 144, lengths.begin() + 256, 9);
+    std::fill(lengths.begin() + 256, lengths.begin() + 280, 7);
+    std::fill(lengths.begin() + 280, lengths.end(), 8);
+    return deflate_huffman_code{std::move(lengths)};
+}();
+
+static deflate_huffman_code const deflate_fixed_distance_code = deflate_huffman_code{std::vector<int>(30, 5)};
+
+/** Write stored blocks.
+ * The data is split into multiple blocks if it does not fit in a single stored block.
+ */
+static void deflate_write_stored(deflate_bit_writer &writer, std::span<std::byte const> bytes, bool final) noexcept
+{
+    do {
+        ttlet size = std::min(std::ssize(bytes), ssize_t{0xffff});
+        ttlet last = size == std::ssize(bytes);
+
+        writer.write(final && last ? 1 : 0, 1);
+        writer.write(0, 2);
+        writer.align_to_byte();
+        writer.write(narrow_cast<uint32_t>(size), 16);
+        writer.write(narrow_cast<uint32_t>(~size & 0xffff), 16);
+        writer.write(bytes.first(size));
+
+        bytes = bytes.subspan(size);
+    } while (!bytes.empty());
+}
+
+deflate_encoder::deflate_encoder(int level, deflate_strategy strategy, int pixel_size) noexcept :
+    _config(&deflate_configs[level]), _strategy(strategy), _pixel_size(pixel_size)
+{
+    tt_axiom(level >= 0 && level <= 9);
+    tt_axiom(pixel_size >= 1 && pixel_size <= deflate_window_size);
+
+    if (_config->max_chain != 0 && _strategy == deflate_strategy::normal) {
+        _head.resize(size_t{1} << deflate_hash_bits, -1);
+        _prev.resize(deflate_window_size, -1);
+    }
+    _symbols.reserve(deflate_max_block_symbols);
+}
+
+void deflate_encoder::feed(std::span<std::byte const> bytes) noexcept
+{
+    tt_axiom(!_finished);
+
+    _buffer.append(bytes.data(), bytes.size());
+
+    // Leave enough data at the end, so that the matches are not cut short by the end of the chunk.
+    compress(buffer_end() - deflate_lookahead);
+    discard();
+}
+
+void deflate_encoder::finish() noexcept
+{
+    tt_axiom(!_finished);
+
+    compress(buffer_end());
+    if (_prev_pending) {
+        add_literal(get(_position - 1));
+        _prev_pending = false;
+    }
+    write_block(true);
+
+    _buffer.clear();
+    _buffer_offset = _position;
+    _finished = true;
+}
+
+/** Insert a position in the hash table.
+ *
+ * @return The previous position with the same hash, or -1 if there is none.
+ */
+ssize_t deflate_encoder::insert(ssize_t position) noexcept
+{
+    if (position + deflate_min_match > buffer_end()) {
+        return -1;
+    }
+
+    ttlet key = (uint32_t{get(position)} << 16) | (uint32_t{get(position + 1)} << 8) | uint32_t{get(position + 2)};
+    ttlet hash = (key * 0x9e37'79b1) >> (32 - deflate_hash_bits);
+
+    ttlet r = _head[hash];
+    _prev[position % deflate_window_size] = r;
+    _head[hash] = position;
+    return r;
+}
+
+/** The number of bytes that are equal at two positions.
+ */
+[[nodiscard]] int deflate_encoder::match_length(ssize_t a, ssize_t b, int max_length) const noexcept
+{
+    ttlet pa = _buffer.data() + (a - _buffer_offset);
+    ttlet pb = _buffer.data() + (b - _buffer_offset);
+    auto length = 0;
+#if TT_X86_64_V2
+    while (length + 16 <= max_length) {
+        ttlet x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(pa + length));
+        ttlet y = _mm_loadu_si128(reinterpret_cast<__m128i const *>(pb + length));
+        ttlet equal = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)));
+        if (equal != 0xffff) {
+            return length + std::countr_one(equal);
+        }
+        length += 16;
+    }
+#endif
+    while (length + 8 <= max_length) {
+        uint64_t x;
+        uint64_t y;
+        std::memcpy(&x, pa + length, 8);
+        std::memcpy(&y, pb + length, 8);
+        if (ttlet diff = x ^ y) {
+            if constexpr (std::endian::native == std::endian::little) {
+                return length + std::countr_zero(diff) / 8;
+            } else {
+                return length + std::countl_zero(diff) / 8;
+            }
+        }
+        length += 8;
+    }
+    while (length < max_length && pa[length] == pb[length]) {
+        ++length;
+    }
+    return length;
+}
+
+/** Find the longest match on the hash-chain.
+ *
+ * @param position The position to find a match for.
+ * @param candidate The first position on the hash-chain.
+ * @param prev_length The length of a match found earlier; only longer matches are returned.
+ * @return The length and distance of the match, or a length of zero if no longer match was found.
+ */
+[[nodiscard]] std::pair<int, int>
+deflate_encoder::longest_match(ssize_t position, ssize_t candidate, int prev_length) const noexcept
+{
+    ttlet max_length = narrow_cast<int>(std::min(ssize_t{deflate_max_match}, buffer_end() - position));
+    ttlet limit = position - deflate_window_size;
+
+    auto chain = _config->max_chain;
+    if (prev_length >= _config->good_length) {
+        chain = std::max(1, chain / 4);
+    }
+
+    auto best_length = std::max(prev_length, deflate_min_match - 1);
+    auto best_distance = 0;
+    for (; candidate >= 0 && candidate >= limit && chain != 0; candidate = _prev[candidate % deflate_window_size], --chain) {
+        // Quickly reject candidates that can not be longer than the best match so far.
+        if (best_length < max_length && get(candidate + best_length) != get(position + best_length)) {
+            continue;
+        }
+
+        ttlet length = match_length(candidate, position, max_length);
+        if (length > best_length) {
+            best_length = length;
+            best_distance = narrow_cast<int>(position - candidate);
+            if (length >= _config->nice_length || length == max_length) {
+                break;
+            }
+        }
+    }
+
+    if (best_distance == 0) {
+        return {0, 0};
+    } else {
+        return {best_length, best_distance};
+    }
+}
+
+void deflate_encoder::add_literal(uint8_t value) noexcept
+{
+    _symbols.push_back({value, 0});
+    ++_literal_frequencies[value];
+    ++_block_size;
+    if (std::ssize(_symbols) == deflate_max_block_symbols) {
+        write_block(false);
+    }
+}
+
+/** Add a sequence of literal bytes.
+ * Cheaper than adding the literals one at a time, the block is checked for being full once.
+ */
+void deflate_encoder::add_literals(uint8_t const *ptr, ssize_t count) noexcept
+{
+    while (count != 0) {
+        ttlet n = std::min(count, deflate_max_block_symbols - std::ssize(_symbols));
+        for (ssize_t i = 0; i != n; ++i) {
+            _symbols.push_back({ptr[i], 0});
+            ++_literal_frequencies[ptr[i]];
+        }
+        _block_size += n;
+        if (std::ssize(_symbols) == deflate_max_block_symbols) {
+            write_block(false);
+        }
+        ptr += n;
+        count -= n;
+    }
+}
+
+void deflate_encoder::add_match(int length, int distance) noexcept
+{
+    _symbols.push_back({narrow_cast<uint16_t>(length), narrow_cast<uint16_t>(distance)});
+    ++_literal_frequencies[257 + deflate_length_code[length]];
+    ++_distance_frequencies[deflate_distance_code(distance)];
+    _block_size += length;
+    if (std::ssize(_symbols) == deflate_max_block_symbols) {
+        write_block(false);
+    }
+}
+
+/** Compress the data up to the given position.
+ *
+ * A match that starts before `end` may extend beyond it.
+ */
+void deflate_encoder::compress(ssize_t end) noexcept
+{
+    if (_config->max_chain == 0) {
+        compress_stored(end);
+    } else if (_strategy == deflate_strategy::run_length) {
+        compress_run_length(end);
+    } else if (_config->lazy) {
+        compress_lazy(end);
+    } else {
+        compress_greedy(end);
+    }
+}
+
+void deflate_encoder::compress_stored(ssize_t end) noexcept
+{
+    if (_position < end) {
+        _block_size += end - _position;
+        _position = end;
+    }
+
+    if (_block_size >= deflate_max_stored_block) {
+        write_block(false);
+    }
+}
+
+void deflate_encoder::compress_greedy(ssize_t end) noexcept
+{
+    while (_position < end) {
+        ttlet candidate = insert(_position);
+
+        auto [length, distance] = candidate >= 0 ? longest_match(_position, candidate, 0) : std::pair{0, 0};
+        if (length == deflate_min_match && distance > deflate_too_far) {
+            length = 0;
+        }
+
+        if (length != 0) {
+            add_match(length, distance);
+
+            // Skip inserting the positions inside long matches for speed.
+            if (length <= _config->max_lazy) {
+                for (ssize_t i = 1; i != length; ++i) {
+                    insert(_position + i);
+                }
+            }
+            _position += length;
+
+        } else {
+            add_literal(get(_position));
+            ++_position;
+        }
+    }
+}
+
+void deflate_encoder::compress_lazy(ssize_t end) noexcept
+{
+    while (_position < end) {
+        ttlet candidate = insert(_position);
+
+        auto length = 0;
+        auto distance = 0;
+        if (candidate >= 0 && _prev_length < _config->max_lazy) {
+            std::tie(length, distance) = longest_match(_position, candidate, _prev_length);
+            if (length == deflate_min_match && distance > deflate_too_far) {
+                length = 0;
+            }
+        }
+
+        if (_prev_length != 0 && length == 0) {
+            // The match at the previous position is the best match.
+            tt_axiom(_prev_pending);
+            add_match(_prev_length, _prev_distance);
+
+            ttlet match_end = _position - 1 + _prev_length;
+            for (++_position; _position < match_end; ++_position) {
+                insert(_position);
+            }
+            _prev_length = 0;
+            _prev_pending = false;
+
+        } else {
+            if (_prev_pending) {
+                add_literal(get(_position - 1));
+            }
+            _prev_length = length;
+            _prev_distance = distance;
+            _prev_pending = true;
+            ++_position;
+        }
+    }
+}
+
+/** Load 8 bytes.
+ */
+[[nodiscard]] static uint64_t deflate_load64(uint8_t const *ptr) noexcept
+{
+    uint64_t r;
+    std::memcpy(&r, ptr, sizeof(r));
+    return r;
+}
+
+/** A mask with the high bit set of each byte that is zero.
+ */
+[[nodiscard]] constexpr uint64_t deflate_zero_bytes(uint64_t x) noexcept
+{
+    constexpr auto low_bits = uint64_t{0x7f7f'7f7f'7f7f'7f7f};
+    return ~(((x & low_bits) + low_bits) | x | low_bits);
+}
+
+/** The number of bytes before the first byte with its high bit set.
+ */
+[[nodiscard]] static int deflate_first_byte(uint64_t mask) noexcept
+{
+    if constexpr (std::endian::native == std::endian::little) {
+        return std::countr_zero(mask) / 8;
+    } else {
+        return std::countl_zero(mask) / 8;
+    }
+}
+
+void deflate_encoder::compress_run_length(ssize_t end) noexcept
+{
+    // The buffer is not modified while compressing, so the bytes can be accessed directly.
+    ttlet buffer = reinterpret_cast<uint8_t const *>(_buffer.data());
+    ttlet buffer_size = std::ssize(_buffer);
+    ttlet pixel_size = _pixel_size;
+
+    while (_position < end) {
+        ttlet i = _position - _buffer_offset;
+
+        // Skip over literals 8 positions at a time. A match can only start at a position where
+        // the next 3 bytes are equal to the 3 bytes at distance 1 or at the pixel size.
+        if (i >= pixel_size && end - _position >= 8 && buffer_size - i >= 16) {
+            ttlet p = buffer + i;
+            ttlet x = deflate_load64(p);
+            ttlet y = deflate_load64(p + 1);
+            ttlet z = deflate_load64(p + 2);
+            ttlet no_match1 = (x ^ deflate_load64(p - 1)) | (y ^ x) | (z ^ y);
+            ttlet q = p - pixel_size;
+            ttlet no_match_pixel = (x ^ deflate_load64(q)) | (y ^ deflate_load64(q + 1)) | (z ^ deflate_load64(q + 2));
+            ttlet match_starts = deflate_zero_bytes(no_match1) | deflate_zero_bytes(no_match_pixel);
+
+            ttlet nr_literals = match_starts == 0 ? 8 : deflate_first_byte(match_starts);
+            add_literals(p, nr_literals);
+            _position += nr_literals;
+            if (nr_literals == 8) {
+                continue;
+            }
+        }
+
+        ttlet j = _position - _buffer_offset;
+        ttlet max_length = narrow_cast<int>(std::min(ssize_t{deflate_max_match}, buffer_size - j));
+
+        auto length = 0;
+        auto distance = 0;
+        if (max_length >= deflate_min_match) {
+            for (ttlet candidate_distance : {1, pixel_size}) {
+                // Reject the candidate early when the first bytes of a minimum length match differ.
+                if (candidate_distance > _position || candidate_distance == distance ||
+                    buffer[j - candidate_distance] != buffer[j] || buffer[j - candidate_distance + 1] != buffer[j + 1] ||
+                    buffer[j - candidate_distance + 2] != buffer[j + 2]) {
+                    continue;
+                }
+
+                ttlet candidate_length = match_length(_position - candidate_distance, _position, max_length);
+                if (candidate_length > length) {
+                    length = candidate_length;
+                    distance = candidate_distance;
+                    if (length == max_length) {
+                        // In a run of equal pixels both candidates match, don't compare the bytes twice.
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (length >= deflate_min_match) {
+            add_match(length, distance);
+            _position += length;
+        } else {
+            add_literal(buffer[j]);
+            ++_position;
+        }
+    }
+}
+
+/** Remove the data from the buffer that is no longer needed.
+ *
+ * The window before the current position is needed for matching, the data of the
+ * current block is needed in case the block is stored.
+ */
+void deflate_encoder::discard() noexcept
+{
+    ttlet keep = std::min(_block_start, _position - deflate_window_size);
+    ttlet size = keep - _buffer_offset;
+
+    // Moving the rest of the buffer to the front is amortized over a large amount of input.
+    if (size >= deflate_discard_size && size * 2 >= std::ssize(_buffer)) {
+        _buffer.erase(0, size);
+        _buffer_offset = keep;
+    }
+}
+
+/** Run-length encode the code lengths of a dynamic block.
+ *
+ * @return A list of code-length symbols, with the value of their extra bits.
+ */
+[[nodiscard]] static std::vector<std::pair<int, int>> deflate_run_length_encode(std::vector<int> const &lengths) noexcept
+{
+    auto r = std::vector<std::pair<int, int>>{};
+
+    ssize_t i = 0;
+    while (i != std::ssize(lengths)) {
+        ttlet length = lengths[i];
+        auto run = ssize_t{1};
+        while (i + run != std::ssize(lengths) && lengths[i + run] == length) {
+            ++run;
+        }
+        i += run;
+
+        if (length == 0) {
+            for (; run >= 11; run -= std::min(run, ssize_t{138})) {
+                r.emplace_back(18, narrow_cast<int>(std::min(run, ssize_t{138}) - 11));
+            }
+            if (run >= 3) {
+                r.emplace_back(17, narrow_cast<int>(run - 3));
+                run = 0;
+            }
+
+        } else {
+            r.emplace_back(length, 0);
+            --run;
+            for (; run >= 3; run -= std::min(run, ssize_t{6})) {
+                r.emplace_back(16, narrow_cast<int>(std::min(run, ssize_t{6}) - 3));
+            }
+        }
+
+        for (; run != 0; --run) {
+            r.emplace_back(length, 0);
+        }
+    }
+    return r;
+}
+
+void deflate_encoder::write_symbols(deflate_huffman_code const &literal_code, deflate_huffman_code const &distance_code) noexcept
+{
+    ttlet literal_codes = literal_code.codes.data();
+    ttlet literal_lengths = literal_code.lengths.data();
+    ttlet distance_codes = distance_code.codes.data();
+    ttlet distance_lengths = distance_code.lengths.data();
+
+    // The code of each match length combined with its extra bits, so that they are written at once.
+    auto length_bits = std::array<uint32_t, deflate_max_match + 1>{};
+    auto length_sizes = std::array<uint8_t, deflate_max_match + 1>{};
+    for (int length = deflate_min_match; length <= deflate_max_match; ++length) {
+        ttlet code = deflate_length_code[length];
+        ttlet symbol = 257 + code;
+        if (literal_lengths[symbol] != 0) {
+            length_bits[length] = literal_codes[symbol] | ((length - inflate_length_base[code]) << literal_lengths[symbol]);
+            length_sizes[length] = narrow_cast<uint8_t>(literal_lengths[symbol] + inflate_length_extra[code]);
+        }
+    }
+
+    // A symbol is at most 48 bits: a length code with its extra bits, and a distance code with its extra bits.
+    _writer.write_codes(std::ssize(_symbols) * 6, [&](ttlet &write) {
+        for (ttlet symbol : _symbols) {
+            if (symbol.distance == 0) {
+                tt_axiom(literal_lengths[symbol.value] != 0);
+                write(literal_codes[symbol.value], literal_lengths[symbol.value]);
+
+            } else {
+                ttlet code = deflate_distance_code(symbol.distance);
+                tt_axiom(length_sizes[symbol.value] != 0);
+                tt_axiom(distance_lengths[code] != 0);
+
+                ttlet extra = static_cast<uint64_t>(symbol.distance - inflate_distance_base[code]);
+                ttlet distance_bits = distance_codes[code] | (extra << distance_lengths[code]);
+                write(
+                    length_bits[symbol.value] | (distance_bits << length_sizes[symbol.value]),
+                    length_sizes[symbol.value] + distance_lengths[code] + inflate_distance_extra[code]);
+            }
+        }
+    });
+    literal_code.write(_writer, deflate_end_of_block);
+}
+
+/** The number of extra bits needed for the lengths and distances.
+ */
+[[nodiscard]] size_t deflate_encoder::extra_bits_cost() const noexcept
+{
+    auto r = size_t{0};
+    for (int code = 0; code != std::ssize(inflate_length_extra); ++code) {
+        r += static_cast<size_t>(_literal_frequencies[257 + code]) * inflate_length_extra[code];
+    }
+    for (int code = 0; code != std::ssize(inflate_distance_extra); ++code) {
+        r += static_cast<size_t>(_distance_frequencies[code]) * inflate_distance_extra[code];
+    }
+    return r;
+}
+
+/** Write the symbols collected so far as a block.
+ */
+void deflate_encoder::write_block(bool final) noexcept
+{
+    ttlet block_bytes =
+        std::span<std::byte const>{_buffer.data() + (_block_start - _buffer_offset), static_cast<size_t>(_block_size)};
+
+    if (_config->max_chain == 0) {
+        deflate_write_stored(_writer, block_bytes, final);
+        _block_start += _block_size;
+        _block_size = 0;
+        return;
+    }
+
+    _literal_frequencies[deflate_end_of_block] = 1;
+
+    // Dynamic huffman code.
+    ttlet literal_code = deflate_huffman_code{deflate_code_lengths(_literal_frequencies, 15)};
+    ttlet distance_code = deflate_huffman_code{deflate_code_lengths(_distance_frequencies, 15)};
+
+    auto nr_literals = deflate_nr_literals;
+    while (nr_literals > 257 && literal_code.lengths[nr_literals - 1] == 0) {
+        --nr_literals;
+    }
+    auto nr_distances = deflate_nr_distances;
+    while (nr_distances > 1 && distance_code.lengths[nr_distances - 1] == 0) {
+        --nr_distances;
+    }
+
+    auto lengths = std::vector<int>(literal_code.lengths.begin(), literal_code.lengths.begin() + nr_literals);
+    lengths.insert(lengths.end(), distance_code.lengths.begin(), distance_code.lengths.begin() + nr_distances);
+    ttlet run_lengths = deflate_run_length_encode(lengths);
+
+    auto code_length_frequencies = std::array<uint32_t, 19>{};
+    for (ttlet [symbol, extra] : run_lengths) {
+        ++code_length_frequencies[symbol];
+    }
+    ttlet code_length_code = deflate_huffman_code{deflate_code_lengths(code_length_frequencies, 7)};
+
+    auto nr_code_lengths = 19;
+    while (nr_code_lengths > 4 && code_length_code.lengths[inflate_code_length_order[nr_code_lengths - 1]] == 0) {
+        --nr_code_lengths;
+    }
+
+    ttlet extra_bits = extra_bits_cost();
+    ttlet dynamic_cost = 3 + 5 + 5 + 4 + 3 * nr_code_lengths + code_length_code.cost(code_length_frequencies) +
+        2 * code_length_frequencies[16] + 3 * code_length_frequencies[17] + 7 * code_length_frequencies[18] +
+        literal_code.cost(_literal_frequencies) + distance_code.cost(_distance_frequencies) + extra_bits;
+
+    ttlet fixed_cost = 3 + deflate_fixed_literal_code.cost(_literal_frequencies) +
+        deflate_fixed_distance_code.cost(_distance_frequencies) + extra_bits;
+
+    // The stored cost includes the worst case alignment of 7 bits.
+    ttlet nr_stored_blocks = std::max(ssize_t{1}, (_block_size + 0xfffe) / 0xffff);
+    ttlet stored_cost = static_cast<size_t>(_block_size * 8 + nr_stored_blocks * (3 + 7 + 32));
+
+    if (stored_cost <= fixed_cost && stored_cost <= dynamic_cost) {
+        deflate_write_stored(_writer, block_bytes, final);
+
+    } else if (fixed_cost <= dynamic_cost) {
+        _writer.write(final ? 1 : 0, 1);
+        _writer.write(1, 2);
+        write_symbols(deflate_fixed_literal_code, deflate_fixed_distance_code);
+
+    } else {
+        _writer.write(final ? 1 : 0, 1);
+        _writer.write(2, 2);
+        _writer.write(nr_literals - 257, 5);
+        _writer.write(nr_distances - 1, 5);
+        _writer.write(nr_code_lengths - 4, 4);
+        for (int i = 0; i != nr_code_lengths; ++i) {
+            _writer.write(code_length_code.lengths[inflate_code_length_order[i]], 3);
+        }
+        for (ttlet [symbol, extra] : run_lengths) {
+            code_length_code.write(_writer, symbol);
+            if (symbol == 16) {
+                _writer.write(extra, 2);
+            } else if (symbol == 17) {
+                _writer.write(extra, 3);
+            } else if (symbol == 18) {
+                _writer.write(extra, 7);
+            }
+        }
+        write_symbols(literal_code, distance_code);
+    }
+
+    if (final) {
+        _writer.align_to_byte();
+    }
+
+    _symbols.clear();
+    _literal_frequencies = {};
+    _distance_frequencies = {};
+    _block_start += _block_size;
+    _block_size = 0;
+}
+
+[[nodiscard]] bstring deflate(std::span<std::byte const> bytes, int level)
+{
+    auto encoder = deflate_encoder{level};
+    encoder.feed(bytes);
+    encoder.finish();
+    return encoder.take();
+}
+
+} // namespace tt
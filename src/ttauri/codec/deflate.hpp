@@ -0,0 +1,336 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "../required.hpp"
+#include "../byte_string.hpp"
+#include "../assert.hpp"
+#include <span>
+#include <array>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstring>
+#include <bit>
+
+namespace tt {
+
+/** The compression level used when no level is given.
+ */
+constexpr int deflate_default_level = 6;
+
+constexpr int deflate_min_match = 3;
+constexpr int deflate_max_match = 258;
+constexpr ssize_t deflate_window_size = 0x8000;
+constexpr int deflate_hash_bits = 15;
+constexpr int deflate_nr_literals = 286;
+constexpr int deflate_nr_distances = 30;
+constexpr int deflate_end_of_block = 256;
+
+struct deflate_config;
+struct deflate_huffman_code;
+
+/** Writes bits to a byte string, least significant bit first.
+ */
+class deflate_bit_writer {
+public:
+    void write(uint32_t value, int nr_bits) noexcept
+    {
+        tt_axiom(nr_bits >= 0 && nr_bits <= 32);
+        tt_axiom(nr_bits == 32 || (value >> nr_bits) == 0);
+
+        _hold |= static_cast<uint64_t>(value) << _hold_size;
+        _hold_size += nr_bits;
+        if (_hold_size >= 32) {
+            append_bytes(4);
+        }
+    }
+
+    /** Write many codes, faster than calling `write()` for each of them.
+     *
+     * While writing the codes the state of the writer is kept in local variables, so that
+     * it stays in registers; and the whole bytes are written without checking the size of the output.
+     *
+     * @param max_nr_bytes The maximum number of bytes that are written by `func`.
+     * @param func A function which is called with a function `write(uint64_t value, int nr_bits)`,
+     *             which writes a code of at most 56 bits.
+     */
+    template<typename Func>
+    void write_codes(ssize_t max_nr_bytes, Func const &func) noexcept
+    {
+        reserve(max_nr_bytes + 4);
+
+        auto ptr = _output.data() + _output_size;
+        auto hold = _hold;
+        auto hold_size = _hold_size;
+
+        ttlet write = [&](uint64_t value, int nr_bits) {
+            tt_axiom(nr_bits >= 0 && nr_bits <= 56);
+            tt_axiom(nr_bits == 56 || (value >> nr_bits) == 0);
+
+            hold |= value << hold_size;
+            hold_size += nr_bits;
+
+            // Write all the bits, but only move forward by the whole bytes.
+            store(ptr, hold);
+            ptr += hold_size / 8;
+            hold >>= hold_size & ~7;
+            hold_size &= 7;
+        };
+
+        write(0, 0);
+        func(write);
+
+        _output_size = ptr - _output.data();
+        _hold = hold;
+        _hold_size = hold_size;
+    }
+
+    /** Write zero bits until the output is at a byte boundary.
+     */
+    void align_to_byte() noexcept
+    {
+        _hold_size = (_hold_size + 7) & ~7;
+        append_bytes(_hold_size / 8);
+    }
+
+    /** Write bytes directly to the output.
+     * @pre The output must be aligned to a byte boundary.
+     */
+    void write(std::span<std::byte const> bytes) noexcept
+    {
+        tt_axiom(_hold_size == 0);
+        _output.resize(_output_size);
+        _output.append(bytes.data(), bytes.size());
+        _output_size = std::ssize(_output);
+    }
+
+    /** Take the whole bytes written so far.
+     * Bits that do not yet form a whole byte remain in the writer.
+     */
+    [[nodiscard]] bstring take() noexcept
+    {
+        _output.resize(_output_size);
+        _output_size = 0;
+        return std::exchange(_output, bstring{});
+    }
+
+private:
+    /** The output, followed by unused bytes; so that whole words can be written without checking the size.
+     */
+    bstring _output;
+    ssize_t _output_size = 0;
+
+    uint64_t _hold = 0;
+    int _hold_size = 0;
+
+    /** Make sure that the given number of bytes, and a whole word after them, can be written to the output.
+     */
+    void reserve(ssize_t nr_bytes) noexcept
+    {
+        ttlet size = _output_size + nr_bytes + 8;
+        if (size > std::ssize(_output)) {
+            _output.resize(std::max(size, std::ssize(_output) * 2));
+        }
+    }
+
+    /** Write a word to the output, least significant byte first.
+     */
+    static void store(std::byte *ptr, uint64_t value) noexcept
+    {
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(ptr, &value, sizeof(value));
+        } else {
+            for (int i = 0; i != 8; ++i) {
+                ptr[i] = static_cast<std::byte>((value >> (i * 8)) & 0xff);
+            }
+        }
+    }
+
+    void append_bytes(int nr_bytes) noexcept
+    {
+        tt_axiom(nr_bytes >= 0 && nr_bytes <= 4);
+
+        reserve(nr_bytes);
+        store(_output.data() + _output_size, _hold);
+        _output_size += nr_bytes;
+        _hold >>= nr_bytes * 8;
+        _hold_size -= nr_bytes * 8;
+    }
+};
+
+/** A literal byte, or a length/distance pair.
+ */
+struct deflate_symbol {
+    /** The literal byte, or the length of the match.
+     */
+    uint16_t value;
+
+    /** The distance of the match; zero for a literal.
+     */
+    uint16_t distance;
+};
+
+/** The way the deflate encoder searches for matches.
+ */
+enum class deflate_strategy {
+    /** Search for matches in the whole window using hash-chains.
+     */
+    normal,
+
+    /** Only search for repeats of the previous byte and of the previous pixel.
+     *
+     * This is much faster than searching hash-chains, and works well for filtered
+     * image data which consists mostly of runs of zeros and of repeating pixels.
+     */
+    run_length
+};
+
+/** Incremental encoder for the deflate algorithm.
+ *
+ * Data is passed to the encoder in chunks using `feed()`, and the compressed
+ * data produced so far is taken from the encoder using `take()`. The encoder
+ * copies the input, keeping the 32 KiB window and the data of the current
+ * block; so that memory use is bounded independent of the size of the data.
+ *
+ * With the normal strategy matches are found using hash-chains.
+ * - Level 0 stores the data without compression.
+ * - Levels 1 to 3 emit the first match found (greedy), with level 1 checking only
+ *   a single earlier position for a match.
+ * - Levels 4 to 9 use lazy matching: a match is deferred by one byte when a longer
+ *   match starts at the next position. Higher levels search longer hash-chains.
+ *
+ * Each block is emitted as either a stored, fixed-huffman or dynamic-huffman block,
+ * whichever is smallest.
+ *
+ * Typical usage:
+ * ```
+ * auto encoder = deflate_encoder{level};
+ * while (has_data()) {
+ *     encoder.feed(next_chunk());
+ *     write(encoder.take());
+ * }
+ * encoder.finish();
+ * write(encoder.take());
+ * ```
+ */
+class deflate_encoder {
+public:
+    /**
+     * @param level The compression level between 0 (no compression) and 9 (best compression).
+     * @param strategy The way to search for matches.
+     * @param pixel_size The number of bytes in a pixel, for the `deflate_strategy::run_length` strategy.
+     */
+    explicit deflate_encoder(
+        int level = deflate_default_level,
+        deflate_strategy strategy = deflate_strategy::normal,
+        int pixel_size = 1) noexcept;
+    deflate_encoder(deflate_encoder const &) = delete;
+    deflate_encoder(deflate_encoder &&) noexcept = default;
+    deflate_encoder &operator=(deflate_encoder const &) = delete;
+    deflate_encoder &operator=(deflate_encoder &&) noexcept = default;
+
+    /** Pass the next chunk of data to the encoder.
+     *
+     * The last few hundred bytes are only compressed when more data is passed,
+     * or when `finish()` is called; so that matches may extend into the next chunk.
+     *
+     * @pre `finish()` has not been called.
+     * @param bytes The next chunk of data, it is copied by the encoder.
+     */
+    void feed(std::span<std::byte const> bytes) noexcept;
+
+    /** Compress the rest of the data and end the deflate stream.
+     */
+    void finish() noexcept;
+
+    /** Take the compressed data produced so far.
+     */
+    [[nodiscard]] bstring take() noexcept
+    {
+        return _writer.take();
+    }
+
+private:
+    deflate_config const *_config;
+    deflate_strategy _strategy;
+    int _pixel_size;
+    deflate_bit_writer _writer;
+    bool _finished = false;
+
+    /** The input which is still needed, starting at position `_buffer_offset`.
+     * Positions are counted from the start of the data.
+     */
+    bstring _buffer;
+    ssize_t _buffer_offset = 0;
+
+    /** The next position to compress.
+     */
+    ssize_t _position = 0;
+
+    /** The last position with a certain hash.
+     */
+    std::vector<ssize_t> _head;
+
+    /** The previous position with the same hash, indexed by position modulo the window size.
+     */
+    std::vector<ssize_t> _prev;
+
+    /** Lazy matching: the match found at the previous position; which is emitted if
+     * there is no better match at the current position.
+     */
+    int _prev_length = 0;
+    int _prev_distance = 0;
+
+    /** Lazy matching: the byte at the previous position has not been emitted yet.
+     */
+    bool _prev_pending = false;
+
+    std::vector<deflate_symbol> _symbols;
+    std::array<uint32_t, deflate_nr_literals> _literal_frequencies = {};
+    std::array<uint32_t, deflate_nr_distances> _distance_frequencies = {};
+
+    /** The position where the current block starts, and the number of bytes in the block.
+     */
+    ssize_t _block_start = 0;
+    ssize_t _block_size = 0;
+
+    [[nodiscard]] ssize_t buffer_end() const noexcept
+    {
+        return _buffer_offset + std::ssize(_buffer);
+    }
+
+    [[nodiscard]] uint8_t get(ssize_t position) const noexcept
+    {
+        return static_cast<uint8_t>(_buffer[position - _buffer_offset]);
+    }
+
+    ssize_t insert(ssize_t position) noexcept;
+    [[nodiscard]] int match_length(ssize_t a, ssize_t b, int max_length) const noexcept;
+    [[nodiscard]] std::pair<int, int> longest_match(ssize_t position, ssize_t candidate, int prev_length) const noexcept;
+    void add_literal(uint8_t value) noexcept;
+    void add_literals(uint8_t const *ptr, ssize_t count) noexcept;
+    void add_match(int length, int distance) noexcept;
+    void compress(ssize_t end) noexcept;
+    void compress_stored(ssize_t end) noexcept;
+    void compress_greedy(ssize_t end) noexcept;
+    void compress_lazy(ssize_t end) noexcept;
+    void compress_run_length(ssize_t end) noexcept;
+    void discard() noexcept;
+    void write_symbols(deflate_huffman_code const &literal_code, deflate_huffman_code const &distance_code) noexcept;
+    [[nodiscard]] size_t extra_bits_cost() const noexcept;
+    void write_block(bool final) noexcept;
+};
+
+/** Compress data using the deflate algorithm.
+ *
+ * @see deflate_encoder for a description of the compression levels.
+ * @param bytes The data to compress.
+ * @param level The compression level between 0 (no compression) and 9 (best compression).
+ * @return The compressed data.
+ */
+[[nodiscard]] bstring deflate(std::span<std::byte const> bytes, int level = deflate_default_level);
+
+} // namespace tt
@@ -0,0 +1,178 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/codec/deflate.hpp"
+#include "ttauri/codec/inflate.hpp"
+#include "ttauri/codec/zlib.hpp"
+#include "ttauri/codec/gzip.hpp"
+#include "ttauri/file_view.hpp"
+#include "ttauri/required.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <format>
+
+using namespace std;
+using namespace tt;
+
+static bstring random_bytes(ssize_t size, int max_value)
+{
+    auto engine = std::mt19937{42};
+    auto dist = std::uniform_int_distribution<int>{0, max_value};
+
+    auto r = bstring{};
+    for (ssize_t i = 0; i != size; ++i) {
+        r.push_back(static_cast<std::byte>(dist(engine)));
+    }
+    return r;
+}
+
+/** Data with many repeats at short and long distances.
+ */
+static bstring repetitive_bytes(ssize_t size)
+{
+    auto engine = std::mt19937{42};
+    auto word_dist = std::uniform_int_distribution<int>{0, 99};
+
+    auto r = bstring{};
+    while (std::ssize(r) < size) {
+        ttlet word = to_bstring(std::format("word{} ", word_dist(engine)));
+        r.append(word);
+    }
+    r.resize(size);
+    return r;
+}
+
+static void round_trip(bstring const &original)
+{
+    for (int level = 0; level <= 9; ++level) {
+        ttlet compressed = deflate(original, level);
+
+        ssize_t offset = 0;
+        ttlet decompressed = inflate(compressed, offset, 0x0400'0000);
+        ASSERT_EQ(offset, std::ssize(compressed)) << "level=" << level << " size=" << original.size();
+        ASSERT_TRUE(decompressed == original) << "level=" << level << " size=" << original.size();
+    }
+}
+
+TEST(Deflate, RoundTripEmpty)
+{
+    round_trip(bstring{});
+}
+
+TEST(Deflate, RoundTripSmall)
+{
+    for (ssize_t size = 1; size != 40; ++size) {
+        round_trip(repetitive_bytes(size));
+        round_trip(random_bytes(size, 255));
+    }
+}
+
+TEST(Deflate, RoundTripRandom)
+{
+    // Incompressible data is stored, and needs multiple stored blocks.
+    round_trip(random_bytes(200'000, 255));
+    round_trip(random_bytes(200'000, 3));
+}
+
+TEST(Deflate, RoundTripRepetitive)
+{
+    round_trip(repetitive_bytes(300'000));
+    round_trip(bstring(100'000, std::byte{'a'}));
+}
+
+TEST(Deflate, RoundTripFiles)
+{
+    for (auto i = 1; i <= 8; ++i) {
+        ttlet view = file_view(URL(std::format("file:gzip_test{}.bin", i)));
+        round_trip(bstring{view.bytes().begin(), view.bytes().end()});
+    }
+}
+
+TEST(Deflate, Streaming)
+{
+    auto original = repetitive_bytes(200'000);
+    original.append(random_bytes(100'000, 255));
+    original.append(repetitive_bytes(100'000));
+
+    for (ttlet level : {0, 1, 4, 9}) {
+        for (ttlet chunk_size : {1, 7, 1000, 70'000}) {
+            // Use only part of the data for single byte chunks, to keep the test fast.
+            ttlet size = chunk_size == 1 ? ssize_t{20'000} : std::ssize(original);
+
+            auto encoder = deflate_encoder{level};
+            auto compressed = bstring{};
+            for (ssize_t offset = 0; offset < size; offset += chunk_size) {
+                encoder.feed(std::span(original).subspan(offset, std::min(ssize_t{chunk_size}, size - offset)));
+                compressed.append(encoder.take());
+            }
+            encoder.finish();
+            compressed.append(encoder.take());
+
+            ssize_t offset = 0;
+            ttlet decompressed = inflate(compressed, offset, 0x0400'0000);
+            ASSERT_EQ(offset, std::ssize(compressed)) << "level=" << level << " chunk_size=" << chunk_size;
+            ASSERT_TRUE(decompressed == original.substr(0, size)) << "level=" << level << " chunk_size=" << chunk_size;
+        }
+    }
+}
+
+TEST(Deflate, RunLength)
+{
+    // Filtered image-like data: runs of zeros, repeating pixels and noise.
+    auto original = bstring(1000, std::byte{0});
+    original.append(random_bytes(1000, 255));
+    for (int i = 0; i != 2000; ++i) {
+        original.append(to_bstring(std::format("{:c}{:c}{:c}", i % 3, 'a', 'b')));
+    }
+    original.append(random_bytes(1000, 3));
+    original.append(bstring(100'000, std::byte{7}));
+    original.append(random_bytes(100'000, 1));
+
+    for (ttlet pixel_size : {1, 3, 4, 8}) {
+        for (ttlet chunk_size : {7, 1000, 70'000}) {
+            auto encoder = deflate_encoder{1, deflate_strategy::run_length, pixel_size};
+            auto compressed = bstring{};
+            for (ssize_t offset = 0; offset < std::ssize(original); offset += chunk_size) {
+                encoder.feed(std::span(original).subspan(offset, std::min(ssize_t{chunk_size}, std::ssize(original) - offset)));
+                compressed.append(encoder.take());
+            }
+            encoder.finish();
+            compressed.append(encoder.take());
+
+            ssize_t offset = 0;
+            ttlet decompressed = inflate(compressed, offset, 0x0400'0000);
+            ASSERT_EQ(offset, std::ssize(compressed)) << "pixel_size=" << pixel_size << " chunk_size=" << chunk_size;
+            ASSERT_TRUE(decompressed == original) << "pixel_size=" << pixel_size << " chunk_size=" << chunk_size;
+        }
+    }
+}
+
+TEST(Deflate, Levels)
+{
+    ttlet original = repetitive_bytes(300'000);
+
+    ttlet stored_size = std::ssize(deflate(original, 0));
+    ttlet fast_size = std::ssize(deflate(original, 1));
+    ttlet best_size = std::ssize(deflate(original, 9));
+
+    ASSERT_GT(stored_size, std::ssize(original));
+    ASSERT_LT(fast_size, stored_size / 2);
+    ASSERT_LE(best_size, fast_size);
+}
+
+TEST(Deflate, ZLib)
+{
+    ttlet original = repetitive_bytes(100'000);
+    for (ttlet level : {0, 1, 6, 9}) {
+        ASSERT_TRUE(zlib_decompress(zlib_compress(original, level), 0x0100'0000, true) == original);
+    }
+}
+
+TEST(Deflate, GZip)
+{
+    ttlet original = repetitive_bytes(100'000);
+    for (ttlet level : {0, 1, 6, 9}) {
+        ASSERT_TRUE(gzip_decompress(gzip_compress(original, level), 0x0100'0000, true) == original);
+    }
+}
@@ -4,8 +4,10 @@
 
 #include "gzip.hpp"
 #include "inflate.hpp"
+#include "crc32.hpp"
 #include "../endian.hpp"
 #include "../placement.hpp"
+#include <algorithm>
 
 namespace tt {
 
@@ -19,8 +21,18 @@ struct GZIPMemberHeader {
     uint8_t OS;
 };
 
-static bstring gzip_decompress_member(std::span<std::byte const> bytes, ssize_t &offset, ssize_t max_size)
+/** Get the size of a gzip member header.
+ *
+ * @param bytes The bytes starting at the gzip member header.
+ * @return The size of the header, or zero if `bytes` does not contain the complete header.
+ * @throw parse_error When the header is invalid.
+ */
+[[nodiscard]] static ssize_t gzip_member_header_size(std::span<std::byte const> bytes)
 {
+    ssize_t offset = 0;
+    if (!check_placement_ptr<GZIPMemberHeader>(bytes, offset)) {
+        return 0;
+    }
     ttlet header = make_placement_ptr<GZIPMemberHeader>(bytes, offset);
 
     tt_parse_check(header->ID1 == 31, "GZIP Member header ID1 must be 31");
@@ -35,6 +47,9 @@ static bstring gzip_decompress_member(std::span<std::byte const> bytes, ssize_t
     ttlet FCOMMENT = static_cast<bool>(header->FLG & 16);
 
     if (FEXTRA) {
+        if (!check_placement_ptr<little_uint16_buf_t>(bytes, offset)) {
+            return 0;
+        }
         ttlet XLEN = make_placement_ptr<little_uint16_buf_t>(bytes, offset);
         offset += XLEN->value();
     }
@@ -42,7 +57,9 @@ static bstring gzip_decompress_member(std::span<std::byte const> bytes, ssize_t
     if (FNAME) {
         std::byte c;
         do {
-            tt_parse_check(offset < std::ssize(bytes), "GZIP Member header FNAME reading beyond end of buffer");
+            if (offset >= std::ssize(bytes)) {
+                return 0;
+            }
             c = bytes[offset++];
         } while (c != std::byte{0});
     }
@@ -50,33 +67,47 @@ static bstring gzip_decompress_member(std::span<std::byte const> bytes, ssize_t
     if (FCOMMENT) {
         std::byte c;
         do {
-            tt_parse_check(offset < std::ssize(bytes), "GZIP Member header FCOMMENT reading beyond end of buffer");
+            if (offset >= std::ssize(bytes)) {
+                return 0;
+            }
             c = bytes[offset++];
         } while (c != std::byte{0});
     }
 
     if (FHCRC) {
-        [[maybe_unused]] ttlet CRC16 = make_placement_ptr<little_uint16_buf_t>(bytes, offset);
+        offset += ssizeof(little_uint16_buf_t);
     }
 
+    return offset <= std::ssize(bytes) ? offset : 0;
+}
+
+static bstring gzip_decompress_member(std::span<std::byte const> bytes, ssize_t &offset, ssize_t max_size, bool verify_checksum)
+{
+    ttlet header_size = gzip_member_header_size(bytes.subspan(offset));
+    tt_parse_check(header_size != 0, "GZIP Member header reading beyond end of buffer");
+    offset += header_size;
+
     auto r = inflate(bytes, offset, max_size);
 
-    [[maybe_unused]] auto CRC32 = make_placement_ptr<little_uint32_buf_t>(bytes, offset);
-    [[maybe_unused]] auto ISIZE = make_placement_ptr<little_uint32_buf_t>(bytes, offset);
+    ttlet CRC32 = make_placement_ptr<little_uint32_buf_t>(bytes, offset);
+    ttlet ISIZE = make_placement_ptr<little_uint32_buf_t>(bytes, offset);
 
     tt_parse_check(
         ISIZE->value() == (size(r) & 0xffffffff),
         "GZIP Member header ISIZE must be same as the lower 32 bits of the inflated size.");
+    if (verify_checksum) {
+        tt_parse_check(CRC32->value() == crc32(r), "GZIP Member CRC-32 checksum mismatch.");
+    }
     return r;
 }
 
-bstring gzip_decompress(std::span<std::byte const> bytes, ssize_t max_size)
+bstring gzip_decompress(std::span<std::byte const> bytes, ssize_t max_size, bool verify_checksum)
 {
     auto r = bstring{};
 
     ssize_t offset = 0;
     while (offset < std::ssize(bytes)) {
-        auto member = gzip_decompress_member(bytes, offset, max_size);
+        auto member = gzip_decompress_member(bytes, offset, max_size, verify_checksum);
         max_size -= std::ssize(member);
         r.append(member);
     }
@@ -84,4 +115,125 @@ bstring gzip_decompress(std::span<std::byte const> bytes, ssize_t max_size)
     return r;
 }
 
-} // namespace tt
\ No newline at end of file
+[[nodiscard]] bstring gzip_compress(std::span<std::byte const> bytes, int level)
+{
+    auto header = GZIPMemberHeader{};
+    header.ID1 = 31;
+    header.ID2 = 139;
+    header.CM = 8;
+    header.FLG = 0;
+    header.MTIME = 0;
+    // 2 = maximum compression, 4 = fastest algorithm.
+    header.XFL = level <= 1 ? 4 : 2;
+    // Unknown operating system.
+    header.OS = 255;
+
+    auto r = bstring{};
+    r.append(reinterpret_cast<std::byte const *>(&header), sizeof(header));
+    r.append(deflate(bytes, level));
+
+    auto trailer = std::array<little_uint32_buf_t, 2>{};
+    trailer[0] = crc32(bytes);
+    trailer[1] = narrow_cast<uint32_t>(bytes.size() & 0xffffffff);
+    r.append(reinterpret_cast<std::byte const *>(trailer.data()), sizeof(trailer));
+    return r;
+}
+
+void gzip_decoder::feed(std::span<std::byte const> bytes) noexcept
+{
+    tt_axiom(_input.empty());
+    _input = bytes;
+    _need_input = false;
+}
+
+[[nodiscard]] ssize_t gzip_decoder::read(std::span<std::byte> buffer)
+{
+    ssize_t offset = 0;
+
+    while (true) {
+        switch (_state) {
+        case state_type::header: {
+            // Copy the fixed part of the header at once, then one byte at a time
+            // until the variable length fields are complete.
+            auto header_size = gzip_member_header_size(_header);
+            while (header_size == 0) {
+                if (_input.empty()) {
+                    _need_input = true;
+                    return offset;
+                }
+
+                ttlet todo = std::max(ssizeof(GZIPMemberHeader) - std::ssize(_header), ssize_t{1});
+                ttlet size = std::min(todo, std::ssize(_input));
+                _header.append(_input.data(), size);
+                _input = _input.subspan(size);
+                header_size = gzip_member_header_size(_header);
+            }
+
+            _header.clear();
+            _inflate = inflate_decoder{};
+            _crc = 0;
+            _state = state_type::body;
+        } break;
+
+        case state_type::body:
+            if (_inflate.need_input()) {
+                if (_input.empty()) {
+                    _need_input = true;
+                    return offset;
+                }
+                _inflate.feed(_input);
+                _input = {};
+            }
+
+            {
+                ttlet size = _inflate.read(buffer.subspan(offset));
+                if (_verify_checksum) {
+                    _crc = crc32(buffer.subspan(offset, size), _crc);
+                }
+                offset += size;
+            }
+
+            if (_inflate.done()) {
+                _input = _inflate.remaining();
+                _trailer_size = 0;
+                _state = state_type::trailer;
+            } else if (!_inflate.need_input()) {
+                // The output buffer is full.
+                return offset;
+            }
+            break;
+
+        case state_type::trailer: {
+            ttlet size = std::min(std::ssize(_trailer) - _trailer_size, std::ssize(_input));
+            std::copy_n(_input.begin(), size, _trailer.begin() + _trailer_size);
+            _input = _input.subspan(size);
+            _trailer_size += size;
+
+            if (_trailer_size != std::ssize(_trailer)) {
+                _need_input = true;
+                return offset;
+            }
+
+            ttlet CRC32 = reinterpret_cast<little_uint32_buf_t const *>(_trailer.data())->value();
+            ttlet ISIZE = reinterpret_cast<little_uint32_buf_t const *>(_trailer.data() + 4)->value();
+            tt_parse_check(
+                ISIZE == (_inflate.total_out() & 0xffffffff),
+                "GZIP Member header ISIZE must be same as the lower 32 bits of the inflated size.");
+            if (_verify_checksum) {
+                tt_parse_check(CRC32 == _crc, "GZIP Member CRC-32 checksum mismatch.");
+            }
+            _state = state_type::member_end;
+        } break;
+
+        case state_type::member_end:
+            if (_input.empty()) {
+                _need_input = true;
+                return offset;
+            }
+            _state = state_type::header;
+            break;
+        }
+    }
+}
+
+} // namespace tt
@@ -7,14 +7,110 @@
 #include "../URL.hpp"
 #include "../byte_string.hpp"
 #include "../resource_view.hpp"
+#include "inflate.hpp"
+#include "deflate.hpp"
 #include <cstddef>
+#include <array>
 
 namespace tt {
 
-bstring gzip_decompress(std::span<std::byte const> bytes, ssize_t max_size=0x01000000);
+/** Decompress data in the gzip format.
+ *
+ * @param bytes The gzip data.
+ * @param max_size The maximum size of the decompressed data.
+ * @param verify_checksum Check the CRC-32 of each decompressed member against its trailer.
+ * @return The decompressed data.
+ * @throw parse_error When the gzip data is invalid.
+ */
+bstring gzip_decompress(std::span<std::byte const> bytes, ssize_t max_size=0x01000000, bool verify_checksum=false);
 
-inline bstring gzip_decompress(URL const &url, ssize_t max_size=0x01000000) {
-    return gzip_decompress(*url.loadView(), max_size);
+inline bstring gzip_decompress(URL const &url, ssize_t max_size=0x01000000, bool verify_checksum=false) {
+    return gzip_decompress(*url.loadView(), max_size, verify_checksum);
 }
 
+/** Compress data into the gzip format.
+ *
+ * The data is stored as a single gzip member, without a file name or modification time.
+ *
+ * @param bytes The data to compress.
+ * @param level The compression level between 0 (no compression) and 9 (best compression).
+ * @return The gzip data.
+ */
+[[nodiscard]] bstring gzip_compress(std::span<std::byte const> bytes, int level = deflate_default_level);
+
+/** Incremental decoder for the gzip format.
+ *
+ * A gzip stream may consist of multiple members, which are decompressed
+ * as a single continuous stream of data. `done()` returns true at the end of
+ * a member when all input has been consumed; when more input is available
+ * it should be fed to the decoder to continue with the next member.
+ *
+ * @see inflate_decoder for the usage of `feed()` and `read()`.
+ */
+class gzip_decoder {
+public:
+    gzip_decoder() = default;
+
+    /**
+     * @param verify_checksum Check the CRC-32 of each decompressed member against its trailer.
+     */
+    explicit gzip_decoder(bool verify_checksum) noexcept : _verify_checksum(verify_checksum) {}
+
+    gzip_decoder(gzip_decoder const &) = delete;
+    gzip_decoder(gzip_decoder &&) noexcept = default;
+    gzip_decoder &operator=(gzip_decoder const &) = delete;
+    gzip_decoder &operator=(gzip_decoder &&) noexcept = default;
+
+    /** Pass the next chunk of gzip data to the decoder.
+     *
+     * @pre All previous input must have been consumed.
+     * @param bytes The next chunk of gzip data, must remain valid until consumed.
+     */
+    void feed(std::span<std::byte const> bytes) noexcept;
+
+    /** Decompress data.
+     *
+     * @param buffer The buffer to write the decompressed data into.
+     * @return The number of bytes written into the buffer.
+     * @throw parse_error When the gzip data is invalid, or the checksum does not match.
+     */
+    [[nodiscard]] ssize_t read(std::span<std::byte> buffer);
+
+    /** Check if the decoder needs more input to continue.
+     */
+    [[nodiscard]] bool need_input() const noexcept
+    {
+        return _need_input;
+    }
+
+    /** Check if the end of a gzip member was reached, and all input was consumed.
+     */
+    [[nodiscard]] bool done() const noexcept
+    {
+        return _state == state_type::member_end && _input.empty();
+    }
+
+private:
+    enum class state_type { header, body, trailer, member_end };
+
+    state_type _state = state_type::header;
+    bool _need_input = true;
+    bool _verify_checksum = false;
+    std::span<std::byte const> _input;
+    inflate_decoder _inflate;
+
+    /** The CRC-32 of the decompressed data of the current member so far.
+     */
+    uint32_t _crc = 0;
+
+    /** The header of the current member, collected from chunks of input.
+     */
+    bstring _header;
+
+    /** The trailer of the current member, collected from chunks of input.
+     */
+    std::array<std::byte, 8> _trailer = {};
+    ssize_t _trailer_size = 0;
+};
+
 }
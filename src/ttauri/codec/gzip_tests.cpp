@@ -6,6 +6,8 @@
 #include "ttauri/required.hpp"
 #include <gtest/gtest.h>
 #include <iostream>
+#include <memory>
+#include <cstring>
 
 using namespace std;
 using namespace tt;
@@ -116,3 +118,92 @@ TEST(GZip, UnzipXargs1) {
         ASSERT_EQ(decompressed[i], original_bytes[i]);
     }
 }
+
+/** Decompress a gzip file by feeding it in chunks, and reading into a small buffer.
+ * Each chunk is copied into its own allocation, like data received from a socket,
+ * so that reading outside of the current chunk is detected.
+ *
+ * @param move_decoder Move the decoder into a new object after each read.
+ */
+static bstring gzip_decompress_streaming(
+    std::span<std::byte const> input,
+    ssize_t input_chunk_size,
+    ssize_t output_chunk_size,
+    bool move_decoder = false)
+{
+    auto decoder = std::make_unique<gzip_decoder>(true);
+    auto buffer = bstring(output_chunk_size, std::byte{0});
+    auto chunk = std::unique_ptr<std::byte[]>{};
+    auto r = bstring{};
+    auto nr_moves = 0;
+    while (!decoder->done() || !input.empty()) {
+        if (decoder->need_input()) {
+            ttlet size = std::min(input_chunk_size, std::ssize(input));
+            chunk = std::make_unique<std::byte[]>(size);
+            std::memcpy(chunk.get(), input.data(), size);
+            decoder->feed({chunk.get(), static_cast<size_t>(size)});
+            input = input.subspan(size);
+        }
+
+        ttlet size = decoder->read(buffer);
+        r.append(buffer.data(), size);
+
+        if (move_decoder) {
+            // Alternate between move-construction and move-assignment, the old decoder is destroyed.
+            if (++nr_moves % 2 == 0) {
+                decoder = std::make_unique<gzip_decoder>(std::move(*decoder));
+            } else {
+                auto tmp = std::make_unique<gzip_decoder>();
+                *tmp = std::move(*decoder);
+                decoder = std::move(tmp);
+            }
+        }
+    }
+    return r;
+}
+
+TEST(GZip, UnzipStreaming) {
+    for (auto i = 1; i <= 8; ++i) {
+        ttlet original = file_view(URL(std::format("file:gzip_test{}.bin", i)));
+        ttlet original_bytes = original.bytes();
+
+        ttlet chunk_sizes = std::vector<std::pair<ssize_t, ssize_t>>{{1, 1}, {7, 300}, {7, 50}, {31, 129}, {211, 100}, {4096, 100000}};
+        for (ttlet [input_chunk_size, output_chunk_size]: chunk_sizes) {
+            ttlet compressed = file_view(URL(std::format("file:gzip_test{}.bin.gz", i)));
+            ttlet decompressed = gzip_decompress_streaming(compressed.bytes(), input_chunk_size, output_chunk_size);
+
+            ASSERT_EQ(std::ssize(decompressed), std::ssize(original_bytes));
+            for (ssize_t j = 0; j != std::ssize(decompressed); ++j) {
+                ASSERT_EQ(decompressed[j], original_bytes[j]);
+            }
+        }
+    }
+}
+
+TEST(GZip, UnzipStreamingMoved) {
+    for (auto i = 1; i <= 8; ++i) {
+        ttlet original = file_view(URL(std::format("file:gzip_test{}.bin", i)));
+        ttlet original_bytes = original.bytes();
+
+        ttlet compressed = file_view(URL(std::format("file:gzip_test{}.bin.gz", i)));
+        ttlet decompressed = gzip_decompress_streaming(compressed.bytes(), 31, 129, true);
+
+        ASSERT_EQ(std::ssize(decompressed), std::ssize(original_bytes));
+        for (ssize_t j = 0; j != std::ssize(decompressed); ++j) {
+            ASSERT_EQ(decompressed[j], original_bytes[j]);
+        }
+    }
+}
+
+TEST(GZip, VerifyChecksum) {
+    ttlet view = file_view(URL("file:gzip_test3.bin.gz"));
+    auto compressed = bstring(view.bytes().begin(), view.bytes().end());
+
+    ASSERT_NO_THROW(gzip_decompress(compressed, 0x01000000, true));
+
+    // Corrupt the CRC-32 in the trailer.
+    compressed[compressed.size() - 8] ^= std::byte{1};
+    ASSERT_NO_THROW(gzip_decompress(compressed));
+    ASSERT_THROW(gzip_decompress(compressed, 0x01000000, true), parse_error);
+    ASSERT_THROW(gzip_decompress_streaming(compressed, 7, 300), parse_error);
+}
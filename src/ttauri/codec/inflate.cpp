@@ -3,159 +3,15 @@
 // (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
 
 #include "inflate.hpp"
+#include "../check.hpp"
 #include "../bits.hpp"
-#include "../placement.hpp"
-#include "../huffman.hpp"
 #include <array>
+#include <algorithm>
+#include <cstring>
 
 namespace tt {
 
-static void inflate_copy_block(std::span<std::byte const> bytes, ssize_t &bit_offset, ssize_t max_size, bstring &r)
-{
-    auto offset = (bit_offset + 7) / 8;
-
-    auto LEN = make_placement_ptr<little_uint16_buf_t>(bytes, offset);
-    [[maybe_unused]] auto NLEN = make_placement_ptr<little_uint16_buf_t>(bytes, offset);
-
-    tt_parse_check((offset + LEN->value()) <= std::ssize(bytes), "input buffer overrun");
-    tt_parse_check((std::ssize(r) + LEN->value()) <= max_size, "output buffer overrun");
-    r.append(&bytes[offset], LEN->value());
-
-    bit_offset = offset * 8;
-}
-
-[[nodiscard]] static int inflate_decode_length(
-    std::span<std::byte const> bytes,
-    ssize_t &bit_offset,
-    int symbol)
-{
-    switch (symbol) {
-    case 257: return 3;
-    case 258: return 4;
-    case 259: return 5;
-    case 260: return 6;
-    case 261: return 7;
-    case 262: return 8;
-    case 263: return 9;
-    case 264: return 10;
-    case 265: return get_bits(bytes, bit_offset, 1) + 11;
-    case 266: return get_bits(bytes, bit_offset, 1) + 13;
-    case 267: return get_bits(bytes, bit_offset, 1) + 15;
-    case 268: return get_bits(bytes, bit_offset, 1) + 17;
-    case 269: return get_bits(bytes, bit_offset, 2) + 19;
-    case 270: return get_bits(bytes, bit_offset, 2) + 23;
-    case 271: return get_bits(bytes, bit_offset, 2) + 27;
-    case 272: return get_bits(bytes, bit_offset, 2) + 31;
-    case 273: return get_bits(bytes, bit_offset, 3) + 35;
-    case 274: return get_bits(bytes, bit_offset, 3) + 43;
-    case 275: return get_bits(bytes, bit_offset, 3) + 51;
-    case 276: return get_bits(bytes, bit_offset, 3) + 59;
-    case 277: return get_bits(bytes, bit_offset, 4) + 67;
-    case 278: return get_bits(bytes, bit_offset, 4) + 83;
-    case 279: return get_bits(bytes, bit_offset, 4) + 99;
-    case 280: return get_bits(bytes, bit_offset, 4) + 115;
-    case 281: return get_bits(bytes, bit_offset, 5) + 131;
-    case 282: return get_bits(bytes, bit_offset, 5) + 163;
-    case 283: return get_bits(bytes, bit_offset, 5) + 195;
-    case 284: return get_bits(bytes, bit_offset, 5) + 227;
-    case 285: return 258;
-    default:
-        throw parse_error("Literal/Length symbol out of range {}", symbol);
-    }
-}
-
-[[nodiscard]] static int inflate_decode_distance(
-    std::span<std::byte const> bytes,
-    ssize_t &bit_offset,
-    int symbol)
-{
-    switch (symbol) {
-    case 0: return 1;
-    case 1: return 2;
-    case 2: return 3;
-    case 3: return 4;
-    case 4: return get_bits(bytes, bit_offset, 1) + 5;
-    case 5: return get_bits(bytes, bit_offset, 1) + 7;
-    case 6: return get_bits(bytes, bit_offset, 2) + 9;
-    case 7: return get_bits(bytes, bit_offset, 2) + 13;
-    case 8: return get_bits(bytes, bit_offset, 3) + 17;
-    case 9: return get_bits(bytes, bit_offset, 3) + 25;
-    case 10: return get_bits(bytes, bit_offset, 4) + 33;
-    case 11: return get_bits(bytes, bit_offset, 4) + 49;
-    case 12: return get_bits(bytes, bit_offset, 5) + 65;
-    case 13: return get_bits(bytes, bit_offset, 5) + 97;
-    case 14: return get_bits(bytes, bit_offset, 6) + 129;
-    case 15: return get_bits(bytes, bit_offset, 6) + 193;
-    case 16: return get_bits(bytes, bit_offset, 7) + 257;
-    case 17: return get_bits(bytes, bit_offset, 7) + 385;
-    case 18: return get_bits(bytes, bit_offset, 8) + 513;
-    case 19: return get_bits(bytes, bit_offset, 8) + 769;
-    case 20: return get_bits(bytes, bit_offset, 9) + 1025;
-    case 21: return get_bits(bytes, bit_offset, 9) + 1537;
-    case 22: return get_bits(bytes, bit_offset, 10) + 2049;
-    case 23: return get_bits(bytes, bit_offset, 10) + 3073;
-    case 24: return get_bits(bytes, bit_offset, 11) + 4097;
-    case 25: return get_bits(bytes, bit_offset, 11) + 6145;
-    case 26: return get_bits(bytes, bit_offset, 12) + 8193;
-    case 27: return get_bits(bytes, bit_offset, 12) + 12289;
-    case 28: return get_bits(bytes, bit_offset, 13) + 16385;
-    case 29: return get_bits(bytes, bit_offset, 13) + 24577;
-    default:
-        throw parse_error("Distance symbol out of range {}", symbol);
-    }
-}
-
-static void inflate_block(
-    std::span<std::byte const> bytes,
-    ssize_t &bit_offset,
-    ssize_t max_size,
-    huffman_tree<int16_t> const &literal_tree,
-    huffman_tree<int16_t> const &distance_tree,
-    bstring &r)
-{
-    while (true) {
-        // Test only every get_symbol, the trailer is at least 32 bits (Checksum)
-        // - 15 bits maximum huffman code.
-        // -  5 bits extra length.
-        // -  7 bits rounding up to byte.
-        tt_parse_check(((bit_offset + 27) >> 3) <= std::ssize(bytes), "Input buffer overrun");
-
-        auto literal_symbol = literal_tree.get_symbol(bytes, bit_offset);
-
-        if (literal_symbol <= 255) {
-            tt_parse_check(std::ssize(r) < max_size, "Output buffer overrun");
-            r.push_back(static_cast<std::byte>(literal_symbol));
-
-        } else if (literal_symbol == 256) {
-            // End-of-block.
-            return;
-
-        } else {
-            auto length = inflate_decode_length(bytes, bit_offset, literal_symbol);
-            tt_parse_check(std::ssize(r) + length <= max_size, "Output buffer overrun");
-
-            // Test only every get_symbol, the trailer is at least 32 bits (Checksum)
-            // - 15 bits maximum huffman code.
-            // -  7 bits rounding up to byte.
-            tt_parse_check(((bit_offset + 22) >> 3) <= std::ssize(bytes), "Input buffer overrun");
-            auto distance_symbol = distance_tree.get_symbol(bytes, bit_offset);
-
-            // Test only every inflate_decode_distance, the trailer is at least 32 bits (Checksum)
-            // - 13 bits extra length.
-            // -  7 bits rounding up to byte.
-            tt_parse_check(((bit_offset + 20) >> 3) <= std::ssize(bytes), "Input buffer overrun");
-            auto distance = inflate_decode_distance(bytes, bit_offset, distance_symbol);
-
-            tt_parse_check(distance <= std::ssize(r), "Distance beyond start of decompressed data");
-            auto src_i = std::ssize(r) - distance;
-            for (auto i = 0; i != length; ++i) {
-                r.push_back(r[src_i++]);
-            }
-        }
-    }
-}
-
-huffman_tree<int16_t> deflate_fixed_literal_tree = []() {
+huffman_table<int16_t> deflate_fixed_literal_table = []() {
     std::vector<int> lengths;
 
     for (int i = 0; i <= 143; ++i) {
@@ -171,144 +27,499 @@ huffman_tree<int16_t> deflate_fixed_literal_tree = []() {
         lengths.push_back(8);
     }
 
-    return huffman_tree<int16_t>::from_lengths(lengths);
+    return huffman_table<int16_t>::from_lengths(lengths);
 }();
 
-huffman_tree<int16_t> deflate_fixed_distance_tree = []() {
+huffman_table<int16_t> deflate_fixed_distance_table = []() {
     std::vector<int> lengths;
 
     for (int i = 0; i <= 31; ++i) {
         lengths.push_back(5);
     }
 
-    return huffman_tree<int16_t>::from_lengths(lengths);
+    return huffman_table<int16_t>::from_lengths(lengths);
 }();
 
+inflate_decoder::inflate_decoder() : _window(window_size, std::byte{0}) {}
 
+[[nodiscard]] huffman_table<int16_t> const &inflate_decoder::literal_table() const noexcept
+{
+    return _fixed_tables ? deflate_fixed_literal_table : _dynamic_literal_table;
+}
 
-static void inflate_fixed_block(std::span<std::byte const> bytes, ssize_t &bit_offset, ssize_t max_size, bstring &r)
+[[nodiscard]] huffman_table<int16_t> const &inflate_decoder::distance_table() const noexcept
 {
-    inflate_block(bytes, bit_offset, max_size, deflate_fixed_literal_tree, deflate_fixed_distance_tree, r);
+    return _fixed_tables ? deflate_fixed_distance_table : _dynamic_distance_table;
 }
 
-[[nodiscard]] static huffman_tree<int16_t> inflate_code_lengths(std::span<std::byte const> bytes, ssize_t &bit_offset, int nr_symbols)
+void inflate_decoder::feed(std::span<std::byte const> bytes) noexcept
 {
-    // The symbols are in different order in the table.
-    constexpr auto symbols = std::array{
-        16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
-    };
+    tt_axiom(_input.empty());
+    _input = bytes;
+    _need_input = false;
+}
 
-    tt_parse_check(((bit_offset + (3 * static_cast<ssize_t>(nr_symbols)) + 7) >> 3) <= std::ssize(bytes), "Input buffer overrun");
+/** Make sure that a number of bits are loaded in the hold.
+ *
+ * Bytes are loaded one at a time, so that after consuming the bits of a
+ * field less than 8 bits remain in the hold which belong to the input
+ * that was already consumed.
+ *
+ * @return false when there is not enough input.
+ */
+[[nodiscard]] bool inflate_decoder::need_bits(int nr_bits) noexcept
+{
+    while (_hold_size < nr_bits) {
+        if (_input.empty()) {
+            _need_input = true;
+            return false;
+        }
 
-    auto lengths = std::vector<int>(std::ssize(symbols), 0);
-    for (int i = 0; i != nr_symbols; ++i) {
-        ttlet symbol = symbols[i];
-        lengths[symbol] = get_bits(bytes, bit_offset, 3);
+        _hold |= static_cast<uint64_t>(_input.front()) << _hold_size;
+        _hold_size += 8;
+        _input = _input.subspan(1);
     }
-    return huffman_tree<int16_t>::from_lengths(std::move(lengths));
+    return true;
 }
 
-std::vector<int> inflate_lengths(
-    std::span<std::byte const> bytes,
-    ssize_t &bit_offset,
-    int nr_symbols,
-    huffman_tree<int16_t> const &code_length_tree)
+[[nodiscard]] int inflate_decoder::get_bits(int nr_bits) noexcept
 {
-    auto r = std::vector<int>{};
-    r.reserve(nr_symbols);
-
-    auto prev_length = 0;
-    while (std::ssize(r) < nr_symbols) {
-        // Test only every get_symbol, the trailer is at least 32 bits (Checksum)
-        // -  7 bits maximum huffman code.
-        // -  7 bits extra length.
-        // -  7 bits rounding up to byte.
-        tt_parse_check(((bit_offset + 21) >> 3) <= std::ssize(bytes), "Input buffer overrun");
-        auto symbol = code_length_tree.get_symbol(bytes, bit_offset);
-
-        switch (symbol) {
-        case 16: {
-                auto copy_length = get_bits(bytes, bit_offset, 2) + 3;
-                while (copy_length--) {
-                    r.push_back(prev_length);
-                }
-            } break;
-        case 17: {
-                auto copy_length = get_bits(bytes, bit_offset, 3) + 3;
-                while (copy_length--) {
-                    r.push_back(0);
-                }
-            } break;
-        case 18: {
-                auto copy_length = get_bits(bytes, bit_offset, 7) + 11;
-                while (copy_length--) {
-                    r.push_back(0);
-                }
-            } break;
-        default:
-            r.push_back(prev_length = symbol);
+    tt_axiom(nr_bits <= _hold_size);
+    ttlet r = static_cast<int>(_hold & ((uint64_t{1} << nr_bits) - 1));
+    drop_bits(nr_bits);
+    return r;
+}
+
+void inflate_decoder::drop_bits(int nr_bits) noexcept
+{
+    tt_axiom(nr_bits <= _hold_size);
+    _hold >>= nr_bits;
+    _hold_size -= nr_bits;
+}
+
+/** Skip to the next byte boundary in the compressed stream.
+ * Whole bytes that remain in the hold are returned to the input.
+ */
+void inflate_decoder::align_to_byte() noexcept
+{
+    drop_bits(_hold_size % 8);
+
+    ttlet nr_bytes = _hold_size / 8;
+    _input = {_input.data() - nr_bytes, _input.size() + nr_bytes};
+    _hold = 0;
+    _hold_size = 0;
+}
+
+/** Find the next symbol in the compressed stream, without consuming it.
+ *
+ * @return The symbol and the length of its code, or a length of zero when more input is needed.
+ */
+[[nodiscard]] std::pair<int, int> inflate_decoder::peek_symbol(huffman_table<int16_t> const &table)
+{
+    while (true) {
+        auto [symbol, length] = table.lookup(static_cast<uint32_t>(_hold));
+        if (length != 0 && length <= _hold_size) {
+            return {symbol, length};
+        }
+
+        if (_hold_size >= table.max_length()) {
+            throw parse_error("Code not in huffman table.");
+        }
+
+        if (!need_bits(_hold_size + 8)) {
+            return {0, 0};
         }
     }
+}
 
-    return r;
+/** Copy a back-reference into the output buffer.
+ *
+ * The source of the copy is either earlier in the output buffer, or when
+ * the distance is larger than what was written during this `read()`, from
+ * the sliding window.
+ */
+void inflate_decoder::copy_match() noexcept
+{
+    while (_length != 0 && _output_offset != _output_size) {
+        auto todo = std::min(static_cast<ssize_t>(_length), _output_size - _output_offset);
+
+        if (_distance > _output_offset) {
+            // The start of the match is in the window.
+            ttlet window_distance = _distance - _output_offset;
+            ttlet window_index = (_window_offset - window_distance) & (window_size - 1);
+            todo = std::min({todo, window_distance, window_size - window_index});
+            std::memcpy(_output + _output_offset, _window.data() + window_index, todo);
+
+        } else {
+            // Overlapping copy with the source earlier in the output buffer.
+            auto src = _output + _output_offset - _distance;
+            auto dst = _output + _output_offset;
+            for (auto i = 0; i != todo; ++i) {
+                dst[i] = src[i];
+            }
+        }
+
+        _output_offset += todo;
+        _length -= narrow_cast<int>(todo);
+    }
+}
+
+/** Copy the decompressed data of this `read()` into the sliding window.
+ */
+void inflate_decoder::update_window() noexcept
+{
+    auto todo = std::min(_output_offset, window_size);
+    auto src = _output + _output_offset - todo;
+
+    _total_out += _output_offset;
+    _window_fill = std::min(_window_fill + todo, window_size);
+
+    while (todo != 0) {
+        ttlet size = std::min(todo, window_size - _window_offset);
+        std::memcpy(_window.data() + _window_offset, src, size);
+        _window_offset = (_window_offset + size) & (window_size - 1);
+        src += size;
+        todo -= size;
+    }
 }
 
-void inflate_dynamic_block(std::span<std::byte const> bytes, ssize_t &bit_offset, ssize_t max_size, bstring &r)
+/** Decode literals and length/distance pairs while there is plenty of input and output space.
+ *
+ * The bit reader is refilled once per literal/length symbol, which loads enough bits
+ * for the longest literal/length code, its extra bits, the longest distance code and
+ * its extra bits. Since a match is at most 258 bytes long, output space is also only
+ * checked once per symbol.
+ */
+void inflate_decoder::decode_fast()
 {
-    // Test all lengths, the trailer is at least 32 bits (Checksum)
-    // - 14 bits lengths
-    // -  7 bits rounding up to byte.
-    tt_parse_check(((bit_offset + 21) >> 3) <= std::ssize(bytes), "Input buffer overrun");
-    ttlet HLIT = get_bits(bytes, bit_offset, 5);
-    ttlet HDIST = get_bits(bytes, bit_offset, 5);
-    ttlet HCLEN = get_bits(bytes, bit_offset, 4);
+    constexpr ssize_t max_match_length = 258;
 
-    ttlet code_length_tree = inflate_code_lengths(bytes, bit_offset, HCLEN + 4);
+    // When the slow path ran out of input halfway through a code, the hold may contain
+    // whole bytes of the previous input span. Those can not be returned by `unread()`,
+    // so let the slow path consume them first.
+    if (_hold_size >= 8) {
+        return;
+    }
 
-    ttlet lengths = inflate_lengths(bytes, bit_offset, HLIT + HDIST + 258, code_length_tree);
-    tt_parse_check(lengths[256] != 0, "The end-of-block symbol must be in the table");
+    auto reader = bit_reader{_input, _hold, _hold_size};
+    ttlet &literal_table = this->literal_table();
+    ttlet &distance_table = this->distance_table();
+    ttlet output = _output;
+    ttlet output_last = _output_size - max_match_length;
+    auto output_offset = _output_offset;
 
-    ttlet lengths_ptr = lengths.data();
-    ttlet literal_tree = huffman_tree<int16_t>::from_lengths(lengths_ptr, HLIT + 257);
-    ttlet distance_tree = huffman_tree<int16_t>::from_lengths(&lengths_ptr[HLIT + 257], HDIST + 1);
+    while (output_offset <= output_last && reader.refill()) {
+        ttlet symbol = literal_table.get_symbol(reader);
+        if (symbol <= 255) {
+            output[output_offset++] = static_cast<std::byte>(symbol);
+            continue;
+
+        } else if (symbol == 256) {
+            // End-of-block.
+            _state = state_type::header;
+            break;
+        }
+
+        ttlet length_symbol = symbol - 257;
+        if (length_symbol >= std::ssize(inflate_length_base)) {
+            throw parse_error("Literal/Length symbol out of range {}", symbol);
+        }
+        ttlet length = inflate_length_base[length_symbol] + reader.get(inflate_length_extra[length_symbol]);
 
-    inflate_block(bytes, bit_offset, max_size, literal_tree, distance_tree, r);
+        ttlet distance_symbol = distance_table.get_symbol(reader);
+        if (distance_symbol >= std::ssize(inflate_distance_base)) {
+            throw parse_error("Distance symbol out of range {}", distance_symbol);
+        }
+        ttlet distance = inflate_distance_base[distance_symbol] + reader.get(inflate_distance_extra[distance_symbol]);
+        tt_parse_check(distance <= _window_fill + output_offset, "Distance beyond start of decompressed data");
+
+        if (distance <= output_offset) {
+            auto src = output + output_offset - distance;
+            auto dst = output + output_offset;
+            if (distance >= length) {
+                std::memcpy(dst, src, length);
+            } else {
+                for (auto i = 0; i != length; ++i) {
+                    dst[i] = src[i];
+                }
+            }
+            output_offset += length;
+
+        } else {
+            _output_offset = output_offset;
+            _length = length;
+            _distance = distance;
+            copy_match();
+            output_offset = _output_offset;
+        }
+    }
+
+    _output_offset = output_offset;
+
+    // Return the whole bytes in the bit reader, so that the input can be
+    // consumed one byte at a time by the slow path.
+    reader.unread();
+    _input = reader.remaining();
+    _hold = reader.peek();
+    _hold_size = reader.size();
 }
 
-bstring inflate(std::span<std::byte const> bytes, ssize_t &offset, ssize_t max_size)
+/** Decode the compressed stream into the output buffer.
+ *
+ * @return false when more input is needed, the output buffer is full or
+ *         the end of the stream was reached.
+ */
+[[nodiscard]] bool inflate_decoder::decode()
 {
-    ssize_t bit_offset = offset * 8;
+    while (true) {
+        switch (_state) {
+        case state_type::header:
+            if (_final) {
+                align_to_byte();
+                _state = state_type::done;
+                break;
+            }
 
-    auto r = bstring{};
+            if (!need_bits(3)) {
+                return false;
+            }
 
-    bool BFINAL;
-    do {
-        // Test all lengths, the trailer is at least 32 bits (Checksum)
-        // - 3 bits header
-        // - 7 bits rounding up to byte.
-        tt_parse_check(((bit_offset + 10) >> 3) <= std::ssize(bytes), "Input buffer overrun");
+            _final = static_cast<bool>(get_bits(1));
+            switch (get_bits(2)) {
+            case 0:
+                align_to_byte();
+                _state = state_type::stored_length;
+                break;
+            case 1:
+                _fixed_tables = true;
+                _state = state_type::literal;
+                break;
+            case 2: _state = state_type::dynamic_header; break;
+            default: throw parse_error("Reserved block type");
+            }
+            break;
 
-        BFINAL = get_bits(bytes, bit_offset, 1);
-        ttlet BTYPE = get_bits(bytes, bit_offset, 2);
+        case state_type::stored_length:
+            if (!need_bits(32)) {
+                return false;
+            }
 
-        switch (BTYPE) {
-        case 0:
-            inflate_copy_block(bytes, bit_offset, max_size - std::ssize(r), r);
+            _length = get_bits(16);
+            tt_parse_check(get_bits(16) == (~_length & 0xffff), "Stored block length does not match its complement");
+            _state = state_type::stored_copy;
             break;
-        case 1:
-            inflate_fixed_block(bytes, bit_offset, max_size - std::ssize(r), r);
+
+        case state_type::stored_copy: {
+            // The hold is empty after reading the length of a stored block.
+            tt_axiom(_hold_size == 0);
+
+            ttlet size = std::min({static_cast<ssize_t>(_length), std::ssize(_input), _output_size - _output_offset});
+            std::memcpy(_output + _output_offset, _input.data(), size);
+            _input = _input.subspan(size);
+            _output_offset += size;
+            _length -= narrow_cast<int>(size);
+
+            if (_length == 0) {
+                _state = state_type::header;
+            } else if (_input.empty()) {
+                _need_input = true;
+                return false;
+            } else {
+                return false;
+            }
+        } break;
+
+        case state_type::dynamic_header:
+            if (!need_bits(14)) {
+                return false;
+            }
+
+            _nr_literals = get_bits(5) + 257;
+            _nr_distances = get_bits(5) + 1;
+            _nr_code_length_lengths = get_bits(4) + 4;
+            tt_parse_check(_nr_literals <= 286, "Too many literal/length codes");
+            tt_parse_check(_nr_distances <= 30, "Too many distance codes");
+
+            _lengths = {};
+            _index = 0;
+            _state = state_type::code_length_lengths;
             break;
-        case 2:
-            inflate_dynamic_block(bytes, bit_offset, max_size - std::ssize(r), r);
+
+        case state_type::code_length_lengths:
+            while (_index != _nr_code_length_lengths) {
+                if (!need_bits(3)) {
+                    return false;
+                }
+                _lengths[inflate_code_length_order[_index++]] = get_bits(3);
+            }
+
+            _code_length_table = huffman_table<int16_t>::from_lengths(_lengths.data(), std::ssize(inflate_code_length_order));
+            _lengths = {};
+            _index = 0;
+            _state = state_type::code_lengths;
             break;
-        default:
-            throw parse_error("Reserved block type");
+
+        case state_type::code_lengths: {
+            ttlet nr_lengths = _nr_literals + _nr_distances;
+            while (_index != nr_lengths) {
+                auto [symbol, length] = peek_symbol(_code_length_table);
+                if (length == 0) {
+                    return false;
+                }
+
+                if (symbol < 16) {
+                    drop_bits(length);
+                    _lengths[_index++] = symbol;
+                    continue;
+                }
+
+                ttlet nr_extra_bits = symbol == 16 ? 2 : symbol == 17 ? 3 : 7;
+                if (!need_bits(length + nr_extra_bits)) {
+                    return false;
+                }
+                drop_bits(length);
+
+                auto repeat_length = 0;
+                auto repeat_count = get_bits(nr_extra_bits);
+                if (symbol == 16) {
+                    tt_parse_check(_index != 0, "Repeat of the previous code length at the start of the table");
+                    repeat_length = _lengths[_index - 1];
+                    repeat_count += 3;
+                } else if (symbol == 17) {
+                    repeat_count += 3;
+                } else {
+                    repeat_count += 11;
+                }
+
+                tt_parse_check(_index + repeat_count <= nr_lengths, "Code length repeat beyond the end of the table");
+                while (repeat_count--) {
+                    _lengths[_index++] = repeat_length;
+                }
+            }
+
+            tt_parse_check(_lengths[256] != 0, "The end-of-block symbol must be in the table");
+            _dynamic_literal_table = huffman_table<int16_t>::from_lengths(_lengths.data(), _nr_literals);
+            _dynamic_distance_table = huffman_table<int16_t>::from_lengths(_lengths.data() + _nr_literals, _nr_distances);
+            _fixed_tables = false;
+            _state = state_type::literal;
+        } break;
+
+        case state_type::literal:
+            decode_fast();
+            if (_state != state_type::literal) {
+                break;
+            }
+
+            while (true) {
+                if (_output_offset == _output_size) {
+                    return false;
+                }
+
+                auto [symbol, length] = peek_symbol(literal_table());
+                if (length == 0) {
+                    return false;
+                }
+                drop_bits(length);
+
+                if (symbol <= 255) {
+                    _output[_output_offset++] = static_cast<std::byte>(symbol);
+
+                } else if (symbol == 256) {
+                    // End-of-block.
+                    _state = state_type::header;
+                    break;
+
+                } else {
+                    _symbol = symbol - 257;
+                    if (_symbol >= std::ssize(inflate_length_base)) {
+                        throw parse_error("Literal/Length symbol out of range {}", symbol);
+                    }
+                    _state = state_type::length_extra;
+                    break;
+                }
+            }
+            break;
+
+        case state_type::length_extra: {
+            ttlet nr_extra_bits = inflate_length_extra[_symbol];
+            if (!need_bits(nr_extra_bits)) {
+                return false;
+            }
+            _length = inflate_length_base[_symbol] + get_bits(nr_extra_bits);
+            _state = state_type::distance;
+        } break;
+
+        case state_type::distance: {
+            auto [symbol, length] = peek_symbol(distance_table());
+            if (length == 0) {
+                return false;
+            }
+            drop_bits(length);
+
+            if (symbol >= std::ssize(inflate_distance_base)) {
+                throw parse_error("Distance symbol out of range {}", symbol);
+            }
+            _symbol = symbol;
+            _state = state_type::distance_extra;
+        } break;
+
+        case state_type::distance_extra: {
+            ttlet nr_extra_bits = inflate_distance_extra[_symbol];
+            if (!need_bits(nr_extra_bits)) {
+                return false;
+            }
+            _distance = inflate_distance_base[_symbol] + get_bits(nr_extra_bits);
+            tt_parse_check(_distance <= _window_fill + _output_offset, "Distance beyond start of decompressed data");
+            _state = state_type::copy;
+        } break;
+
+        case state_type::copy:
+            copy_match();
+            if (_length != 0) {
+                return false;
+            }
+            _state = state_type::literal;
+            break;
+
+        case state_type::done: return false;
         }
+    }
+}
+
+[[nodiscard]] ssize_t inflate_decoder::read(std::span<std::byte> buffer)
+{
+    _output = buffer.data();
+    _output_size = std::ssize(buffer);
+    _output_offset = 0;
 
-    } while (!BFINAL);
+    while (decode()) {}
 
-    offset = (bit_offset + 7) / 8;
+    update_window();
+    return _output_offset;
+}
+
+bstring inflate(std::span<std::byte const> bytes, ssize_t &offset, ssize_t max_size)
+{
+    constexpr ssize_t chunk_size = 0x10000;
+
+    auto decoder = inflate_decoder{};
+    decoder.feed(bytes.subspan(offset));
+
+    auto r = bstring{};
+    while (!decoder.done()) {
+        ttlet size = std::ssize(r);
+
+        // Read one byte more than allowed, to detect overrun.
+        r.resize(size + std::min(chunk_size, max_size - size + 1));
+        ttlet nr_read = decoder.read({r.data() + size, r.size() - size});
+        r.resize(size + nr_read);
+
+        tt_parse_check(std::ssize(r) <= max_size, "Output buffer overrun");
+        tt_parse_check(nr_read != 0 || !decoder.need_input(), "Input buffer overrun");
+    }
+
+    offset = std::ssize(bytes) - std::ssize(decoder.remaining());
     return r;
 }
 
-}
\ No newline at end of file
+}
@@ -7,21 +7,206 @@
 #include "../required.hpp"
 #include "../byte_string.hpp"
 #include "../endian.hpp"
+#include "../huffman.hpp"
 #include <span>
+#include <array>
 
 namespace tt {
 
+/** The base values of the length symbols 257 to 285.
+ */
+inline constexpr auto inflate_length_base = std::array<int, 29>{
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+
+/** The number of extra bits of the length symbols 257 to 285.
+ */
+inline constexpr auto inflate_length_extra = std::array<int, 29>{
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+/** The base values of the distance symbols.
+ */
+inline constexpr auto inflate_distance_base = std::array<int, 30>{
+    1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+    193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+
+/** The number of extra bits of the distance symbols.
+ */
+inline constexpr auto inflate_distance_extra = std::array<int, 30>{
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+/** The order in which the code lengths of the code-length alphabet are stored.
+ */
+inline constexpr auto inflate_code_length_order = std::array<int, 19>{16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+/** Incremental decoder for the deflate algorithm.
+ *
+ * Compressed data is passed to the decoder in chunks using `feed()`,
+ * and decompressed data is pulled from the decoder into a caller provided
+ * buffer using `read()`. The decoder keeps a 32 KiB sliding window of the
+ * decompressed data for resolving back-references, so that memory use
+ * is bounded independent of the size of the decompressed data.
+ *
+ * Typical usage:
+ * ```
+ * auto decoder = inflate_decoder{};
+ * while (!decoder.done()) {
+ *     if (decoder.need_input()) {
+ *         decoder.feed(next_chunk());
+ *     }
+ *     ttlet size = decoder.read(buffer);
+ *     consume(buffer.first(size));
+ * }
+ * ```
+ */
+class inflate_decoder {
+public:
+    /** The size of the sliding window.
+     */
+    constexpr static ssize_t window_size = 0x8000;
+
+    inflate_decoder();
+    inflate_decoder(inflate_decoder const &) = delete;
+    inflate_decoder(inflate_decoder &&) noexcept = default;
+    inflate_decoder &operator=(inflate_decoder const &) = delete;
+    inflate_decoder &operator=(inflate_decoder &&) noexcept = default;
+
+    /** Pass the next chunk of compressed data to the decoder.
+     *
+     * The bytes are not copied, they must remain valid until they
+     * are consumed by `read()`; which is when `need_input()` becomes true.
+     *
+     * @pre All previous input must have been consumed.
+     * @param bytes The next chunk of compressed data.
+     */
+    void feed(std::span<std::byte const> bytes) noexcept;
+
+    /** Decompress data.
+     *
+     * @param buffer The buffer to write the decompressed data into.
+     * @return The number of bytes written into the buffer; less than the size of
+     *         the buffer when more input is needed or the end of the stream is reached.
+     * @throw parse_error When the compressed data is invalid.
+     */
+    [[nodiscard]] ssize_t read(std::span<std::byte> buffer);
+
+    /** Check if the decoder needs more input to continue.
+     */
+    [[nodiscard]] bool need_input() const noexcept
+    {
+        return _need_input;
+    }
+
+    /** Check if the end of the compressed stream was reached.
+     */
+    [[nodiscard]] bool done() const noexcept
+    {
+        return _state == state_type::done;
+    }
+
+    /** The input that follows the end of the compressed stream.
+     *
+     * Only valid after `done()` returns true. This is used to read
+     * the trailer of zlib and gzip formats.
+     */
+    [[nodiscard]] std::span<std::byte const> remaining() const noexcept
+    {
+        return _input;
+    }
+
+    /** The total number of bytes decompressed so far.
+     */
+    [[nodiscard]] size_t total_out() const noexcept
+    {
+        return _total_out;
+    }
+
+private:
+    enum class state_type {
+        header,
+        stored_length,
+        stored_copy,
+        dynamic_header,
+        code_length_lengths,
+        code_lengths,
+        literal,
+        length_extra,
+        distance,
+        distance_extra,
+        copy,
+        done
+    };
+
+    state_type _state = state_type::header;
+    bool _final = false;
+    bool _need_input = true;
+
+    /** Compressed data that has not been consumed yet.
+     */
+    std::span<std::byte const> _input;
+
+    /** Bits of the compressed stream loaded from the input, but not consumed yet.
+     * Bits above `_hold_size` are always zero.
+     */
+    uint64_t _hold = 0;
+    int _hold_size = 0;
+
+    /** Buffer passed to `read()`.
+     */
+    std::byte *_output = nullptr;
+    ssize_t _output_size = 0;
+    ssize_t _output_offset = 0;
+
+    /** A ring-buffer with the last 32 KiB of decompressed data.
+     */
+    bstring _window;
+    ssize_t _window_offset = 0;
+    ssize_t _window_fill = 0;
+    size_t _total_out = 0;
+
+    /** State of a dynamic block header.
+     */
+    int _nr_literals = 0;
+    int _nr_distances = 0;
+    int _nr_code_length_lengths = 0;
+    int _index = 0;
+    std::array<int, 320> _lengths = {};
+    huffman_table<int16_t> _code_length_table;
+
+    huffman_table<int16_t> _dynamic_literal_table;
+    huffman_table<int16_t> _dynamic_distance_table;
+
+    /** The current block uses the fixed huffman tables, instead of the dynamic tables.
+     * A flag instead of pointers to the tables, so that the decoder remains valid after it is moved.
+     */
+    bool _fixed_tables = false;
+
+    /** State of a length/distance pair, or of a stored block.
+     */
+    int _symbol = 0;
+    int _length = 0;
+    int _distance = 0;
+
+    [[nodiscard]] bool decode();
+    void decode_fast();
+    [[nodiscard]] bool need_bits(int nr_bits) noexcept;
+    [[nodiscard]] int get_bits(int nr_bits) noexcept;
+    void drop_bits(int nr_bits) noexcept;
+    void align_to_byte() noexcept;
+    [[nodiscard]] std::pair<int, int> peek_symbol(huffman_table<int16_t> const &table);
+    void copy_match() noexcept;
+    void update_window() noexcept;
+    [[nodiscard]] huffman_table<int16_t> const &literal_table() const noexcept;
+    [[nodiscard]] huffman_table<int16_t> const &distance_table() const noexcept;
+};
+
 /** Inflate compressed data using the deflate algorithm
- * `bytes` should include at least 32 bit of trailer, for the overflow check which
- * will slightly overrun the actual compressed data for performance reasons.
  *
- * - gzip has a CRC32+ISIZE trailer.
- *   Since gzip has no end-of-segment indicator, we need to include the trailer
- *   in the byte array passed to inflate anyway.
- * - zlib has a 32 bit check value.
- *   Since zlib has no end-of-segment indicator, we need to include the trailer
- *   in the byte array passed to inflate anyway.
- * - png IDAT chunks include the full zlib-format, including the 32 bit check value.
+ * @param bytes The compressed data.
+ * @param[in,out] offset The offset of the deflate stream in `bytes`, advanced to the byte
+ *                       after the end of the deflate stream.
+ * @param max_size The maximum size of the decompressed data.
+ * @return The decompressed data.
+ * @throw parse_error When the compressed data is invalid, incomplete or too large.
  */
 bstring inflate(std::span<std::byte const> bytes, ssize_t &offset, ssize_t max_size=0x0100'0000);
 
@@ -4,11 +4,20 @@
 
 #include "png.hpp"
 #include "zlib.hpp"
+#include "png_unfilter.hpp"
+#include "crc32.hpp"
+#include "png_filter.hpp"
+#include "../file.hpp"
 #include "../endian.hpp"
 #include "../placement.hpp"
+#if TT_PROCESSOR == TT_CPU_X64
+#include "../cpu_id.hpp"
+#endif
 #include "../color/sRGB.hpp"
 #include "../color/Rec2100.hpp"
 #include "../color/color_space.hpp"
+#include <limits>
+#include <cstring>
 
 namespace tt {
 
@@ -71,7 +80,7 @@ void png::read_header(std::span<std::byte const> bytes, ssize_t &offset)
 void png::generate_sRGB_transfer_function() noexcept
 {
     ttlet value_range = _bit_depth == 8 ? 256 : 65536;
-    ttlet value_range_f = narrow_cast<float>(value_range);
+    ttlet value_range_f = narrow_cast<float>(value_range - 1);
     for (int i = 0; i != value_range; ++i) {
         auto u = narrow_cast<float>(i) / value_range_f;
         _transfer_function.push_back(sRGB_gamma_to_linear(u));
@@ -84,7 +93,7 @@ void png::generate_Rec2100_transfer_function() noexcept
     constexpr float hdr_multiplier = 10'000.0f / 80.0f;
 
     ttlet value_range = _bit_depth == 8 ? 256 : 65536;
-    ttlet value_range_f = narrow_cast<float>(value_range);
+    ttlet value_range_f = narrow_cast<float>(value_range - 1);
     for (int i = 0; i != value_range; ++i) {
         auto u = narrow_cast<float>(i) / value_range_f;
         _transfer_function.push_back(Rec2100_gamma_to_linear(u) * hdr_multiplier);
@@ -94,7 +103,7 @@ void png::generate_Rec2100_transfer_function() noexcept
 void png::generate_gamma_transfer_function(float gamma) noexcept
 {
     ttlet value_range = _bit_depth == 8 ? 256 : 65536;
-    ttlet value_range_f = narrow_cast<float>(value_range);
+    ttlet value_range_f = narrow_cast<float>(value_range - 1);
     for (int i = 0; i != value_range; ++i) {
         auto u = narrow_cast<float>(i) / value_range_f;
         _transfer_function.push_back(powf(u, gamma));
@@ -255,9 +264,15 @@ void png::read_chunks(std::span<std::byte const> bytes, ssize_t &offset)
         default:;
         }
 
+        // The crc32 is calculated over the chunk type and data.
+        ttlet crc_bytes = bytes.subspan(offset - 4, length + 4);
+
         // Skip over the data, and extract the crc32.
         offset += length;
-        [[maybe_unused]] ttlet crc = make_placement_ptr<big_uint32_buf_t>(bytes, offset);
+        ttlet crc = make_placement_ptr<big_uint32_buf_t>(bytes, offset);
+        if (_verify_checksum) {
+            tt_parse_check(crc->value() == crc32(crc_bytes), "Chunk CRC-32 checksum mismatch.");
+        }
     }
 
     tt_parse_check(!IHDR_bytes.empty(), "Missing IHDR chunk.");
@@ -281,8 +296,8 @@ void png::read_chunks(std::span<std::byte const> bytes, ssize_t &offset)
 
 }
 
-png::png(std::span<std::byte const> bytes) :
-    _view()
+png::png(std::span<std::byte const> bytes, bool verify_checksum) :
+    _verify_checksum(verify_checksum), _view()
 {
     ssize_t offset = 0;
 
@@ -290,8 +305,8 @@ png::png(std::span<std::byte const> bytes) :
     read_chunks(bytes, offset);
 }
 
-png::png(std::unique_ptr<resource_view> view) :
-    _view(std::move(view))
+png::png(std::unique_ptr<resource_view> view, bool verify_checksum) :
+    _verify_checksum(verify_checksum), _view(std::move(view))
 {
     ssize_t offset = 0;
 
@@ -300,112 +315,19 @@ png::png(std::unique_ptr<resource_view> view) :
     read_chunks(bytes, offset);
 }
 
-bstring png::decompress_IDATs(ssize_t image_data_size) const {
-    if (std::ssize(_idat_chunk_data) == 1) {
-        return zlib_decompress(_idat_chunk_data[0], image_data_size);
-    } else {
-        // Merge all idat chunks together.
-        ttlet compressed_data_size = std::accumulate(
-            _idat_chunk_data.cbegin(), _idat_chunk_data.cend(), ssize_t{0},
-            [](ttlet &a, ttlet &b) {
-            return a + std::ssize(b);
-        }
-        );
-
-        bstring compressed_data;
-        compressed_data.reserve(compressed_data_size);
-        for (ttlet &chunk_data : _idat_chunk_data) {
-            std::copy(chunk_data.begin(), chunk_data.end(), std::back_inserter(compressed_data));
-        }
-
-        return zlib_decompress(compressed_data, image_data_size);
-    }
-}
-
-void png::unfilter_line_sub(std::span<uint8_t> line, std::span<uint8_t const> prev_line) const noexcept
-{
-    for (int i = 0; i != _bytes_per_line; ++i) {
-        int j = i - _bytes_per_pixel;
-
-        uint8_t prev_raw = j >= 0 ? line[j] : 0;
-        line[i] += prev_raw;
-    }
-}
-
-void png::unfilter_line_up(std::span<uint8_t> line, std::span<uint8_t const> prev_line) const noexcept
-{
-    for (int i = 0; i != _bytes_per_line; ++i) {
-        line[i] += prev_line[i];
-    }
-}
-
-void png::unfilter_line_average(std::span<uint8_t> line, std::span<uint8_t const> prev_line) const noexcept
-{
-    for (int i = 0; i != _bytes_per_line; ++i) {
-        int j = i - _bytes_per_pixel;
-
-        uint8_t prev_raw = j >= 0 ? line[j] : 0;
-        line[i] += (prev_raw + prev_line[i]) / 2;
-    }
-}
-
-static uint8_t paeth_predictor(uint8_t _a, uint8_t _b, uint8_t _c) noexcept {
-    auto a = static_cast<int>(_a);
-    auto b = static_cast<int>(_b);
-    auto c = static_cast<int>(_c);
-
-    auto p = a + b - c;
-    auto pa = std::abs(p - a);
-    auto pb = std::abs(p - b);
-    auto pc = std::abs(p - c);
-
-    if (pa <= pb && pa <= pc) {
-        return static_cast<uint8_t>(a);
-    } else if (pb <= pc) {
-        return static_cast<uint8_t>(b);
-    } else {
-        return static_cast<uint8_t>(c);
-    }
-}
-
-void png::unfilter_line_paeth(std::span<uint8_t> line, std::span<uint8_t const> prev_line) const noexcept
-{
-    for (int i = 0; i != _bytes_per_line; ++i) {
-        int j = i - _bytes_per_pixel;
-
-        uint8_t up = prev_line[i];
-        uint8_t left = j >= 0 ? line[j] : 0;
-        uint8_t left_up = j >= 0 ? prev_line[j] : 0;
-        line[i] += paeth_predictor(left, up, left_up);
-    }
-}
-
 void png::unfilter_line(std::span<uint8_t> line, std::span<uint8_t const> prev_line) const
 {
     switch (line[0]) {
     case 0: return;
-    case 1: return unfilter_line_sub(line.subspan(1, _bytes_per_line), prev_line);
-    case 2: return unfilter_line_up(line.subspan(1, _bytes_per_line), prev_line);
-    case 3: return unfilter_line_average(line.subspan(1, _bytes_per_line), prev_line);
-    case 4: return unfilter_line_paeth(line.subspan(1, _bytes_per_line), prev_line);
+    case 1: return png_unfilter_line_sub(line.subspan(1, _bytes_per_line), _bytes_per_pixel);
+    case 2: return png_unfilter_line_up(line.subspan(1, _bytes_per_line), prev_line);
+    case 3: return png_unfilter_line_average(line.subspan(1, _bytes_per_line), prev_line, _bytes_per_pixel);
+    case 4: return png_unfilter_line_paeth(line.subspan(1, _bytes_per_line), prev_line, _bytes_per_pixel);
     default:
         throw parse_error("Unknown line-filter type");
     }
 }
 
-void png::unfilter_lines(bstring &image_data) const
-{
-    auto image_bytes = std::span(reinterpret_cast<uint8_t *>(image_data.data()), std::ssize(image_data));
-    auto zero_line = bstring(_bytes_per_line, std::byte{0});
-
-    auto prev_line = std::span(reinterpret_cast<uint8_t *>(zero_line.data()), std::ssize(zero_line));
-    for (int y = 0; y != _height; ++y) {
-        auto line = image_bytes.subspan(y * _stride, _stride);
-        unfilter_line(line, prev_line);
-        prev_line = line.subspan(1, _bytes_per_line);
-    }
-}
-
 static uint16_t get_sample(std::span<std::byte const> bytes, ssize_t &offset, bool two_bytes)
 {
     uint16_t value = static_cast<uint8_t>(bytes[offset++]);
@@ -443,10 +365,76 @@ u16x4 png::extract_pixel_from_line(std::span<std::byte const> bytes, int x) cons
     return {r, g, b, a};
 }
 
-void png::data_to_image_line(std::span<std::byte const> bytes, pixel_row<sfloat_rgba16> &line) const noexcept
+#if TT_X86_64_V2_5
+/** Store 8 pixels, converting the color components from float to half-float using F16C.
+ *
+ * The mantissa is truncated, the same as `f32x4_to_f16x8()`. Unlike `f32x4_to_f16x8()`,
+ * values that are denormal as half-float are not flushed to zero.
+ */
+static void store_f16c(sfloat_rgba16 *dst, f32x8 red, f32x8 green, f32x8 blue, f32x8 alpha) noexcept
+{
+    ttlet r = _mm256_cvtps_ph(red.reg(), _MM_FROUND_TO_ZERO);
+    ttlet g = _mm256_cvtps_ph(green.reg(), _MM_FROUND_TO_ZERO);
+    ttlet b = _mm256_cvtps_ph(blue.reg(), _MM_FROUND_TO_ZERO);
+    ttlet a = _mm256_cvtps_ph(alpha.reg(), _MM_FROUND_TO_ZERO);
+
+    // Transpose the components into pixels.
+    ttlet rg_lo = _mm_unpacklo_epi16(r, g);
+    ttlet rg_hi = _mm_unpackhi_epi16(r, g);
+    ttlet ba_lo = _mm_unpacklo_epi16(b, a);
+    ttlet ba_hi = _mm_unpackhi_epi16(b, a);
+
+    auto ptr = reinterpret_cast<__m128i *>(dst);
+    _mm_storeu_si128(ptr + 0, _mm_unpacklo_epi32(rg_lo, ba_lo));
+    _mm_storeu_si128(ptr + 1, _mm_unpackhi_epi32(rg_lo, ba_lo));
+    _mm_storeu_si128(ptr + 2, _mm_unpacklo_epi32(rg_hi, ba_hi));
+    _mm_storeu_si128(ptr + 3, _mm_unpackhi_epi32(rg_hi, ba_hi));
+}
+
+int png::data_to_image_line_f16c(std::span<std::byte const> bytes, pixel_row<sfloat_rgba16> &line) const noexcept
+{
+    static_assert(sizeof(sfloat_rgba16) == 8);
+
+    ttlet col0 = get<0>(_color_to_sRGB);
+    ttlet col1 = get<1>(_color_to_sRGB);
+    ttlet col2 = get<2>(_color_to_sRGB);
+    ttlet col3 = get<3>(_color_to_sRGB);
+    ttlet alpha_mul = f32x8::broadcast(_bit_depth == 16 ? 1.0f / 65535.0f : 1.0f / 255.0f);
+
+    int x = 0;
+    for (; x + 8 <= _width; x += 8) {
+        // Gather the transfer function values of 8 pixels, one vector per component.
+        auto red = f32x8{};
+        auto green = f32x8{};
+        auto blue = f32x8{};
+        auto alpha = f32x8{};
+        for (int i = 0; i != 8; ++i) {
+            ttlet value = extract_pixel_from_line(bytes, x + i);
+            red[i] = _transfer_function[value.x()];
+            green[i] = _transfer_function[value.y()];
+            blue[i] = _transfer_function[value.z()];
+            alpha[i] = static_cast<float>(value.w());
+        }
+        alpha = alpha * alpha_mul;
+
+        // Color conversion and pre-multiply alpha on all 8 pixels at once.
+        ttlet red_ = f32x8::broadcast(col0.x()) * red + f32x8::broadcast(col1.x()) * green +
+            f32x8::broadcast(col2.x()) * blue + f32x8::broadcast(col3.x());
+        ttlet green_ = f32x8::broadcast(col0.y()) * red + f32x8::broadcast(col1.y()) * green +
+            f32x8::broadcast(col2.y()) * blue + f32x8::broadcast(col3.y());
+        ttlet blue_ = f32x8::broadcast(col0.z()) * red + f32x8::broadcast(col1.z()) * green +
+            f32x8::broadcast(col2.z()) * blue + f32x8::broadcast(col3.z());
+
+        store_f16c(line.data() + x, red_ * alpha, green_ * alpha, blue_ * alpha, alpha);
+    }
+    return x;
+}
+#endif
+
+void png::data_to_image_line_scalar(std::span<std::byte const> bytes, pixel_row<sfloat_rgba16> &line, int first) const noexcept
 {
     ttlet alpha_mul = _bit_depth == 16 ? 1.0f/65535.0f : 1.0f/255.0f;
-    for (int x = 0; x != _width; ++x) {
+    for (auto x = first; x != _width; ++x) {
         ttlet value = extract_pixel_from_line(bytes, x);
 
         ttlet linear_color = color(
@@ -462,40 +450,242 @@ void png::data_to_image_line(std::span<std::byte const> bytes, pixel_row<sfloat_
     }
 }
 
-void png::data_to_image(bstring bytes, pixel_map<sfloat_rgba16> &image) const noexcept
+void png::data_to_image_line(std::span<std::byte const> bytes, pixel_row<sfloat_rgba16> &line) const noexcept
 {
-    auto bytes_span = std::span(bytes);
+    int x = 0;
+#if TT_X86_64_V2_5
+    if (cpu_has_f16c()) {
+        x = data_to_image_line_f16c(bytes, line);
+    }
+#endif
+    data_to_image_line_scalar(bytes, line, x);
+}
 
-    for (int y = 0; y != _height; ++y) {
-        int inv_y = _height - y - 1;
+ssize_t png::read_image_data(zlib_decoder &decoder, idat_iterator &it, std::span<std::byte> buffer) const
+{
+    ssize_t offset = 0;
+    while (offset != std::ssize(buffer) && !decoder.done()) {
+        if (decoder.need_input()) {
+            if (it == _idat_chunk_data.cend()) {
+                break;
+            }
+            decoder.feed(*it++);
+        }
 
-        auto bytes_line = bytes_span.subspan(inv_y * _stride + 1, _bytes_per_line);
-        auto pixel_line = image[y];
-        data_to_image_line(bytes_line, pixel_line);
+        offset += decoder.read(buffer.subspan(offset));
     }
+    return offset;
 }
 
 void png::decode_image(pixel_map<sfloat_rgba16> &image) const
 {
-    // There is a filter selection byte in front of every line.
-    ttlet image_data_size = _stride * _height;
+    // Only two scanlines are kept in memory: the line being decoded and the previous
+    // reconstructed line. There is a filter selection byte in front of every line.
+    auto line_buffer = bstring(narrow_cast<size_t>(_stride) * 2, std::byte{0});
+    auto line = std::span(line_buffer).first(_stride);
+    auto prev_line = std::span(line_buffer).last(_stride);
 
-    auto image_data = decompress_IDATs(image_data_size);
-    tt_parse_check(std::ssize(image_data) == image_data_size, "Uncompressed image data has incorrect size.");
+    auto decoder = zlib_decoder{_verify_checksum};
+    auto it = _idat_chunk_data.cbegin();
 
-    unfilter_lines(image_data);
+    for (int y = 0; y != _height; ++y) {
+        tt_parse_check(read_image_data(decoder, it, line) == _stride, "Uncompressed image data has incorrect size.");
+
+        unfilter_line(
+            std::span(reinterpret_cast<uint8_t *>(line.data()), line.size()),
+            std::span(reinterpret_cast<uint8_t const *>(prev_line.data()) + 1, _bytes_per_line));
+
+        // PNG images are stored top-to-bottom, pixel maps bottom-to-top.
+        auto row = image[_height - y - 1];
+        data_to_image_line(line.subspan(1), row);
 
-    data_to_image(image_data, image);
+        std::swap(line, prev_line);
+    }
 
+    auto trailing_byte = std::byte{};
+    tt_parse_check(
+        read_image_data(decoder, it, std::span(&trailing_byte, 1)) == 0, "Uncompressed image data has incorrect size.");
+    if (_verify_checksum) {
+        tt_parse_check(decoder.done(), "Image data is missing the zlib trailer.");
+    }
 }
 
-pixel_map<sfloat_rgba16> png::load(URL const &url)
+pixel_map<sfloat_rgba16> png::load(URL const &url, bool verify_checksum)
 {
-    ttlet png_data = png(url);
+    ttlet png_data = png(url, verify_checksum);
     auto image = pixel_map<sfloat_rgba16>{narrow_cast<ssize_t>(png_data.width()), narrow_cast<ssize_t>(png_data.height())};
     png_data.decode_image(image);
     return image;
 }
 
+/** Tables to convert a linear half-float to a sRGB gamma encoded sample, rounded to nearest.
+ * Indexed by the bits of the half-float.
+ */
+template<typename T>
+[[nodiscard]] static std::vector<T> png_linear16_to_gamma_table_generator() noexcept
+{
+    constexpr auto max_value = static_cast<float>(std::numeric_limits<T>::max());
+
+    auto r = std::vector<T>(65536, T{0});
+    for (int i = 0; i != 65536; ++i) {
+        ttlet u = static_cast<float>(float16::from_uint16_t(narrow_cast<uint16_t>(i)));
+        // Negative values and NaN are black.
+        if (u > 0.0f) {
+            r[i] = static_cast<T>(std::min(sRGB_linear_to_gamma(u), 1.0f) * max_value + 0.5f);
+        }
+    }
+    return r;
+}
+
+/** Convert a line of pixels to samples in sRGB with non-premultiplied alpha.
+ *
+ * @tparam T uint8_t or uint16_t
+ * @param row The row of the image.
+ * @param[out] line The samples as bytes, 16 bit samples are big-endian.
+ */
+template<typename T>
+static void png_image_to_data_line(pixel_row<sfloat_rgba16> const &row, std::span<uint8_t> line) noexcept
+{
+    static ttlet table = png_linear16_to_gamma_table_generator<T>();
+    constexpr auto max_value = static_cast<float>(std::numeric_limits<T>::max());
+    constexpr uint16_t opaque = 0x3c00; // 1.0 as half-float
+
+    auto ptr = line.data();
+    ttlet put = [&ptr](T value) {
+        if constexpr (sizeof(T) == 2) {
+            *ptr++ = static_cast<uint8_t>(value >> 8);
+        }
+        *ptr++ = static_cast<uint8_t>(value);
+    };
+
+    for (ssize_t x = 0; x != row.width(); ++x) {
+        ttlet &pixel = row[x].get();
+
+        if (pixel[3].get() == opaque) {
+            // Fast path, no need to un-premultiply.
+            put(table[pixel[0].get()]);
+            put(table[pixel[1].get()]);
+            put(table[pixel[2].get()]);
+            put(std::numeric_limits<T>::max());
+
+        } else {
+            auto color = static_cast<f32x4>(row[x]);
+            ttlet alpha = std::clamp(color.a(), 0.0f, 1.0f);
+            if (alpha > 0.0f) {
+                color = color / alpha;
+            }
+
+            ttlet color16 = f32x4_to_f16x8(color);
+            put(table[static_cast<uint16_t>(color16.x())]);
+            put(table[static_cast<uint16_t>(color16.y())]);
+            put(table[static_cast<uint16_t>(color16.z())]);
+            put(static_cast<T>(alpha * max_value + 0.5f));
+        }
+    }
+}
+
+static void png_write_chunk(bstring &output, char const *type, std::span<std::byte const> data) noexcept
+{
+    tt_axiom(std::strlen(type) == 4);
+
+    auto length = big_uint32_buf_t{};
+    length = narrow_cast<uint32_t>(data.size());
+    output.append(reinterpret_cast<std::byte const *>(&length), sizeof(length));
+
+    ttlet type_bytes = std::span(reinterpret_cast<std::byte const *>(type), 4);
+    output.append(type_bytes.data(), type_bytes.size());
+    output.append(data.data(), data.size());
+
+    auto crc = big_uint32_buf_t{};
+    crc = crc32(data, crc32(type_bytes));
+    output.append(reinterpret_cast<std::byte const *>(&crc), sizeof(crc));
+}
+
+template<typename T>
+static void png_write_struct_chunk(bstring &output, char const *type, T const &data) noexcept
+{
+    png_write_chunk(output, type, std::span(reinterpret_cast<std::byte const *>(&data), sizeof(T)));
+}
+
+bstring png::encode(pixel_map<sfloat_rgba16> const &image, int bit_depth, int level) noexcept
+{
+    tt_axiom(bit_depth == 8 || bit_depth == 16);
+
+    // Compressed data is collected until it fills an IDAT chunk of this size.
+    constexpr ssize_t idat_chunk_size = 0x4'0000;
+
+    ttlet width = image.width();
+    ttlet height = image.height();
+    ttlet bytes_per_pixel = bit_depth / 2;
+    ttlet bytes_per_line = width * bytes_per_pixel;
+
+    auto r = bstring{};
+    constexpr uint8_t signature[] = {137, 80, 78, 71, 13, 10, 26, 10};
+    r.append(reinterpret_cast<std::byte const *>(signature), sizeof(signature));
+
+    auto ihdr = IHDR{};
+    ihdr.width = narrow_cast<uint32_t>(width);
+    ihdr.height = narrow_cast<uint32_t>(height);
+    ihdr.bit_depth = narrow_cast<uint8_t>(bit_depth);
+    ihdr.color_type = 6; // RGBA
+    ihdr.compression_method = 0;
+    ihdr.filter_method = 0;
+    ihdr.interlace_method = 0;
+    png_write_struct_chunk(r, "IHDR", ihdr);
+
+    auto srgb = sRGB{};
+    srgb.rendering_intent = 0; // Perceptual
+    png_write_struct_chunk(r, "sRGB", srgb);
+
+    // The filter-type byte followed by the filtered line.
+    auto line = std::vector<uint8_t>(bytes_per_line, 0);
+    auto prev_line = std::vector<uint8_t>(bytes_per_line, 0);
+    auto filtered_line = std::vector<uint8_t>(bytes_per_line + 1, 0);
+
+    auto encoder = zlib_encoder{level, deflate_strategy::run_length, bytes_per_pixel};
+    auto idat = bstring{};
+    for (ssize_t y = 0; y != height; ++y) {
+        // PNG images are stored top-to-bottom, pixel maps bottom-to-top.
+        ttlet row = image[height - y - 1];
+        if (bit_depth == 16) {
+            png_image_to_data_line<uint16_t>(row, line);
+        } else {
+            png_image_to_data_line<uint8_t>(row, line);
+        }
+
+        ttlet filter_type = png_select_filter(line, prev_line, bytes_per_pixel);
+        filtered_line[0] = narrow_cast<uint8_t>(filter_type);
+        png_filter_line(filter_type, line, prev_line, bytes_per_pixel, std::span(filtered_line).subspan(1));
+
+        encoder.feed(std::span(reinterpret_cast<std::byte const *>(filtered_line.data()), filtered_line.size()));
+        idat.append(encoder.take());
+        if (std::ssize(idat) >= idat_chunk_size) {
+            png_write_chunk(r, "IDAT", idat);
+            idat.clear();
+        }
+
+        std::swap(line, prev_line);
+    }
+
+    encoder.finish();
+    idat.append(encoder.take());
+    png_write_chunk(r, "IDAT", idat);
+    png_write_chunk(r, "IEND", std::span<std::byte const>{});
+    return r;
+}
+
+void png::save(pixel_map<sfloat_rgba16> const &image, URL const &url, int level)
+{
+    ttlet bytes = encode(image, 16, level);
+    auto f = file(url, access_mode::truncate_or_create_for_write);
+    f.write(bytes.data(), std::ssize(bytes));
+}
+
+void png::save_sRGB8(pixel_map<sfloat_rgba16> const &image, URL const &url, int level)
+{
+    ttlet bytes = encode(image, 8, level);
+    auto f = file(url, access_mode::truncate_or_create_for_write);
+    f.write(bytes.data(), std::ssize(bytes));
+}
 
 }
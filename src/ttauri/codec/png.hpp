@@ -12,22 +12,27 @@
 #include "../resource_view.hpp"
 #include "../byte_string.hpp"
 #include "../strings.hpp"
+#include "zlib.hpp"
 #include <span>
 #include <vector>
 #include <cstddef>
 #include <cstdint>
-#include <numeric>
 
 namespace tt {
 
+/** PNG image decoder and encoder.
+ *
+ * When `verify_checksum` is set, the CRC-32 of each chunk and the Adler-32 of
+ * the image data are checked; use this for images from untrusted sources.
+ */
 class png {
 public:
-    [[nodiscard]] png(std::span<std::byte const> bytes);
+    [[nodiscard]] png(std::span<std::byte const> bytes, bool verify_checksum = false);
 
-    [[nodiscard]] png(std::unique_ptr<resource_view> view);
+    [[nodiscard]] png(std::unique_ptr<resource_view> view, bool verify_checksum = false);
 
-    [[nodiscard]] png(URL const &url) :
-        png(url.loadView()) {}
+    [[nodiscard]] png(URL const &url, bool verify_checksum = false) :
+        png(url.loadView(), verify_checksum) {}
 
     [[nodiscard]] size_t width() const noexcept
     {
@@ -41,7 +46,65 @@ public:
 
     void decode_image(pixel_map<sfloat_rgba16> &image) const;
 
-    [[nodiscard]] static pixel_map<sfloat_rgba16> load(URL const &url);
+    [[nodiscard]] static pixel_map<sfloat_rgba16> load(URL const &url, bool verify_checksum = false);
+
+    /** The compression level used when saving an image.
+     * Filtered image data compresses well with the fastest level.
+     */
+    constexpr static int default_level = 1;
+
+    /** Encode an image as a PNG file.
+     *
+     * The image is written as non-premultiplied RGBA in the sRGB color space, with an
+     * sRGB chunk. Colors outside the sRGB gamut are clamped.
+     *
+     * Each line is filtered with the filter type that has the lowest score, see
+     * `png_filter_scores()`, then passed to a streaming zlib encoder; so that only two
+     * unfiltered lines are kept in memory.
+     *
+     * @param image The image to encode.
+     * @param bit_depth The number of bits per sample, 8 or 16.
+     * @param level The deflate compression level between 0 (no compression) and 9 (best compression).
+     * @return The PNG file.
+     */
+    [[nodiscard]] static bstring
+    encode(pixel_map<sfloat_rgba16> const &image, int bit_depth = 16, int level = default_level) noexcept;
+
+    /** Save an image as a 16 bit sRGB PNG file.
+     *
+     * @see encode()
+     * @throw io_error When the file could not be written.
+     */
+    static void save(pixel_map<sfloat_rgba16> const &image, URL const &url, int level = default_level);
+
+    /** Save an image as an 8 bit sRGB PNG file.
+     *
+     * @see encode()
+     * @throw io_error When the file could not be written.
+     */
+    static void save_sRGB8(pixel_map<sfloat_rgba16> const &image, URL const &url, int level = default_level);
+
+    /** Convert the unfiltered samples of a line to pixels.
+     * Uses `data_to_image_line_f16c()` when the CPU supports F16C.
+     *
+     * @param bytes The samples of the line, without the filter-type byte.
+     * @param row The row of the image to write the pixels to.
+     */
+    void data_to_image_line(std::span<std::byte const> bytes, pixel_row<sfloat_rgba16> &row) const noexcept;
+
+    /** Convert the unfiltered samples of a line to pixels, one pixel at a time.
+     *
+     * @param bytes The samples of the line, without the filter-type byte.
+     * @param row The row of the image to write the pixels to.
+     * @param first The first pixel to convert.
+     */
+    void data_to_image_line_scalar(std::span<std::byte const> bytes, pixel_row<sfloat_rgba16> &row, int first = 0) const noexcept;
+
+    /** Convert the pixels of a line in batches of 8 pixels using F16C.
+     *
+     * @return The number of pixels converted, the rest of the line needs to be converted by the scalar path.
+     */
+    [[nodiscard]] int data_to_image_line_f16c(std::span<std::byte const> bytes, pixel_row<sfloat_rgba16> &row) const noexcept;
 
 private:
     /** Matrix to convert png color values to sRGB.
@@ -61,6 +124,8 @@ private:
     int _filter_method = 0;
     int _interlace_method = 0;
 
+    bool _verify_checksum = false;
+
     bool _has_alpha;
     bool _is_palletted;
     bool _is_color;
@@ -89,15 +154,17 @@ private:
     void generate_sRGB_transfer_function() noexcept;
     void generate_Rec2100_transfer_function() noexcept;
     void generate_gamma_transfer_function(float gamma) noexcept;
-    [[nodiscard]] bstring decompress_IDATs(ssize_t image_data_size) const;
-    void unfilter_lines(bstring &image_data) const;
+    using idat_iterator = std::vector<std::span<std::byte const>>::const_iterator;
+
+    /** Read decompressed image data.
+     *
+     * @param decoder The zlib decoder for the image data.
+     * @param[in,out] it The next IDAT chunk to feed to the decoder.
+     * @param buffer The buffer to fill.
+     * @return The number of bytes read; less than the size of the buffer at the end of the image data.
+     */
+    [[nodiscard]] ssize_t read_image_data(zlib_decoder &decoder, idat_iterator &it, std::span<std::byte> buffer) const;
     void unfilter_line(std::span<uint8_t> line, std::span<uint8_t const> prev_line) const;
-    void unfilter_line_sub(std::span<uint8_t> line, std::span<uint8_t const> prev_line) const noexcept;
-    void unfilter_line_up(std::span<uint8_t> line, std::span<uint8_t const> prev_line) const noexcept;
-    void unfilter_line_average(std::span<uint8_t> line, std::span<uint8_t const> prev_line) const noexcept;
-    void unfilter_line_paeth(std::span<uint8_t> line, std::span<uint8_t const> prev_line) const noexcept;
-    void data_to_image(bstring bytes, pixel_map<sfloat_rgba16> &image) const noexcept;
-    void data_to_image_line(std::span<std::byte const> bytes, pixel_row<sfloat_rgba16> &row) const noexcept;
     u16x4 extract_pixel_from_line(std::span<std::byte const> bytes, int x) const noexcept;
 
 };
@@ -0,0 +1,297 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "png_filter.hpp"
+#include "png_unfilter.hpp"
+#include "../assert.hpp"
+#include "../cast.hpp"
+#if TT_X86_64_V2
+#include <emmintrin.h> // SSE2
+#include <tmmintrin.h> // SSSE3
+#include <smmintrin.h> // SSE4.1
+#endif
+#include <algorithm>
+#include <cstdlib>
+
+namespace tt {
+namespace detail {
+
+[[nodiscard]] static uint8_t png_filter_predictor(int filter_type, uint8_t a, uint8_t b, uint8_t c) noexcept
+{
+    switch (filter_type) {
+    case 0: return 0;
+    case 1: return a;
+    case 2: return b;
+    case 3: return static_cast<uint8_t>((a + b) / 2);
+    case 4: return png_paeth_predictor(a, b, c);
+    default: tt_no_default();
+    }
+}
+
+/** Calculate the filtered byte at index `i`.
+ *
+ * Byte `a` is to the left, byte `b` is above, and byte `c` is above the byte to the left.
+ */
+[[nodiscard]] static uint8_t png_filter_byte(
+    int filter_type,
+    std::span<uint8_t const> line,
+    std::span<uint8_t const> prev_line,
+    int bytes_per_pixel,
+    ssize_t i) noexcept
+{
+    ttlet j = i - bytes_per_pixel;
+    ttlet a = j >= 0 ? line[j] : uint8_t{0};
+    ttlet b = prev_line[i];
+    ttlet c = j >= 0 ? prev_line[j] : uint8_t{0};
+    return static_cast<uint8_t>(line[i] - png_filter_predictor(filter_type, a, b, c));
+}
+
+static void png_filter_scores_scalar(
+    std::span<uint8_t const> line,
+    std::span<uint8_t const> prev_line,
+    int bytes_per_pixel,
+    ssize_t first,
+    ssize_t last,
+    std::array<uint64_t, png_nr_filter_types> &scores) noexcept
+{
+    for (ssize_t i = first; i < last; ++i) {
+        for (int filter_type = 0; filter_type != png_nr_filter_types; ++filter_type) {
+            ttlet filtered = png_filter_byte(filter_type, line, prev_line, bytes_per_pixel, i);
+            scores[filter_type] += static_cast<uint64_t>(std::abs(static_cast<int8_t>(filtered)));
+        }
+    }
+}
+
+static void png_filter_line_scalar(
+    int filter_type,
+    std::span<uint8_t const> line,
+    std::span<uint8_t const> prev_line,
+    int bytes_per_pixel,
+    std::span<uint8_t> output,
+    ssize_t first,
+    ssize_t last) noexcept
+{
+    for (ssize_t i = first; i < last; ++i) {
+        output[i] = png_filter_byte(filter_type, line, prev_line, bytes_per_pixel, i);
+    }
+}
+
+[[nodiscard]] std::array<uint64_t, png_nr_filter_types>
+png_filter_scores_scalar(std::span<uint8_t const> line, std::span<uint8_t const> prev_line, int bytes_per_pixel) noexcept
+{
+    tt_axiom(std::ssize(prev_line) >= std::ssize(line));
+
+    auto r = std::array<uint64_t, png_nr_filter_types>{};
+    png_filter_scores_scalar(line, prev_line, bytes_per_pixel, 0, std::ssize(line), r);
+    return r;
+}
+
+void png_filter_line_scalar(
+    int filter_type,
+    std::span<uint8_t const> line,
+    std::span<uint8_t const> prev_line,
+    int bytes_per_pixel,
+    std::span<uint8_t> output) noexcept
+{
+    tt_axiom(std::ssize(prev_line) >= std::ssize(line));
+    tt_axiom(std::ssize(output) >= std::ssize(line));
+
+    png_filter_line_scalar(filter_type, line, prev_line, bytes_per_pixel, output, 0, std::ssize(line));
+}
+
+#if TT_X86_64_V2
+[[nodiscard]] static __m128i png_load(uint8_t const *ptr) noexcept
+{
+    return _mm_loadu_si128(reinterpret_cast<__m128i const *>(ptr));
+}
+
+/** The average of two bytes, rounded down.
+ */
+[[nodiscard]] static __m128i png_average_predictor_sse(__m128i a, __m128i b) noexcept
+{
+    // _mm_avg_epu8() rounds up, subtract the rounding bit.
+    ttlet rounding = _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1));
+    return _mm_sub_epi8(_mm_avg_epu8(a, b), rounding);
+}
+
+/** Unsigned less-or-equal of bytes.
+ */
+[[nodiscard]] static __m128i png_le_epu8(__m128i lhs, __m128i rhs) noexcept
+{
+    return _mm_cmpeq_epi8(_mm_min_epu8(lhs, rhs), lhs);
+}
+
+/** Unsigned absolute difference of bytes.
+ */
+[[nodiscard]] static __m128i png_abs_diff_epu8(__m128i lhs, __m128i rhs) noexcept
+{
+    return _mm_sub_epi8(_mm_max_epu8(lhs, rhs), _mm_min_epu8(lhs, rhs));
+}
+
+/** The paeth predictor of 16 bytes.
+ *
+ * The distances are calculated in bytes without widening to 16 bit:
+ * pa = abs(b - c) and pb = abs(a - c) fit in a byte. pc = abs((b - c) + (a - c)) is
+ * the sum of pa and pb when a and b are on the same side of c, otherwise it is the
+ * difference. The sum is saturated, which does not change the result of the comparisons.
+ */
+[[nodiscard]] static __m128i png_paeth_predictor_sse(__m128i a, __m128i b, __m128i c) noexcept
+{
+    ttlet pa = png_abs_diff_epu8(b, c);
+    ttlet pb = png_abs_diff_epu8(a, c);
+
+    ttlet same_side = _mm_cmpeq_epi8(png_le_epu8(c, a), png_le_epu8(c, b));
+    ttlet pc = _mm_blendv_epi8(png_abs_diff_epu8(pa, pb), _mm_adds_epu8(pa, pb), same_side);
+
+    ttlet left = _mm_and_si128(png_le_epu8(pa, pb), png_le_epu8(pa, pc));
+    ttlet up = png_le_epu8(pb, pc);
+    return _mm_blendv_epi8(_mm_blendv_epi8(c, b, up), a, left);
+}
+
+/** Add the absolute values of the signed bytes to the two 64 bit sums.
+ */
+[[nodiscard]] static __m128i png_add_score(__m128i sum, __m128i filtered) noexcept
+{
+    return _mm_add_epi64(sum, _mm_sad_epu8(_mm_abs_epi8(filtered), _mm_setzero_si128()));
+}
+
+[[nodiscard]] std::array<uint64_t, png_nr_filter_types>
+png_filter_scores_sse(std::span<uint8_t const> line, std::span<uint8_t const> prev_line, int bytes_per_pixel) noexcept
+{
+    tt_axiom(std::ssize(prev_line) >= std::ssize(line));
+
+    ttlet size = std::ssize(line);
+    ttlet p = line.data();
+    ttlet q = prev_line.data();
+
+    auto r = std::array<uint64_t, png_nr_filter_types>{};
+
+    // The first pixel has no pixel to its left.
+    ttlet head = std::min(ssize_t{bytes_per_pixel}, size);
+    png_filter_scores_scalar(line, prev_line, bytes_per_pixel, 0, head, r);
+
+    auto none = _mm_setzero_si128();
+    auto sub = _mm_setzero_si128();
+    auto up = _mm_setzero_si128();
+    auto average = _mm_setzero_si128();
+    auto paeth = _mm_setzero_si128();
+
+    auto i = head;
+    for (; i + 16 <= size; i += 16) {
+        ttlet x = png_load(p + i);
+        ttlet a = png_load(p + i - bytes_per_pixel);
+        ttlet b = png_load(q + i);
+        ttlet c = png_load(q + i - bytes_per_pixel);
+
+        none = png_add_score(none, x);
+        sub = png_add_score(sub, _mm_sub_epi8(x, a));
+        up = png_add_score(up, _mm_sub_epi8(x, b));
+        average = png_add_score(average, _mm_sub_epi8(x, png_average_predictor_sse(a, b)));
+        paeth = png_add_score(paeth, _mm_sub_epi8(x, png_paeth_predictor_sse(a, b, c)));
+    }
+
+    ttlet horizontal_sum = [](__m128i sum) {
+        return static_cast<uint64_t>(_mm_cvtsi128_si64(sum)) + static_cast<uint64_t>(_mm_extract_epi64(sum, 1));
+    };
+    r[0] += horizontal_sum(none);
+    r[1] += horizontal_sum(sub);
+    r[2] += horizontal_sum(up);
+    r[3] += horizontal_sum(average);
+    r[4] += horizontal_sum(paeth);
+
+    png_filter_scores_scalar(line, prev_line, bytes_per_pixel, i, size, r);
+    return r;
+}
+
+template<int FilterType>
+static void png_filter_line_sse(
+    std::span<uint8_t const> line,
+    std::span<uint8_t const> prev_line,
+    int bytes_per_pixel,
+    std::span<uint8_t> output) noexcept
+{
+    ttlet size = std::ssize(line);
+    ttlet p = line.data();
+    ttlet q = prev_line.data();
+    ttlet o = output.data();
+
+    ttlet head = std::min(ssize_t{bytes_per_pixel}, size);
+    png_filter_line_scalar(FilterType, line, prev_line, bytes_per_pixel, output, 0, head);
+
+    auto i = head;
+    for (; i + 16 <= size; i += 16) {
+        ttlet x = png_load(p + i);
+        ttlet a = png_load(p + i - bytes_per_pixel);
+        ttlet b = png_load(q + i);
+
+        auto filtered = x;
+        if constexpr (FilterType == 1) {
+            filtered = _mm_sub_epi8(x, a);
+        } else if constexpr (FilterType == 2) {
+            filtered = _mm_sub_epi8(x, b);
+        } else if constexpr (FilterType == 3) {
+            filtered = _mm_sub_epi8(x, png_average_predictor_sse(a, b));
+        } else if constexpr (FilterType == 4) {
+            filtered = _mm_sub_epi8(x, png_paeth_predictor_sse(a, b, png_load(q + i - bytes_per_pixel)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(o + i), filtered);
+    }
+
+    png_filter_line_scalar(FilterType, line, prev_line, bytes_per_pixel, output, i, size);
+}
+
+void png_filter_line_sse(
+    int filter_type,
+    std::span<uint8_t const> line,
+    std::span<uint8_t const> prev_line,
+    int bytes_per_pixel,
+    std::span<uint8_t> output) noexcept
+{
+    tt_axiom(std::ssize(prev_line) >= std::ssize(line));
+    tt_axiom(std::ssize(output) >= std::ssize(line));
+
+    switch (filter_type) {
+    case 0: std::copy(line.begin(), line.end(), output.begin()); return;
+    case 1: return png_filter_line_sse<1>(line, prev_line, bytes_per_pixel, output);
+    case 2: return png_filter_line_sse<2>(line, prev_line, bytes_per_pixel, output);
+    case 3: return png_filter_line_sse<3>(line, prev_line, bytes_per_pixel, output);
+    case 4: return png_filter_line_sse<4>(line, prev_line, bytes_per_pixel, output);
+    default: tt_no_default();
+    }
+}
+#endif
+
+} // namespace detail
+
+[[nodiscard]] std::array<uint64_t, png_nr_filter_types>
+png_filter_scores(std::span<uint8_t const> line, std::span<uint8_t const> prev_line, int bytes_per_pixel) noexcept
+{
+#if TT_X86_64_V2
+    return detail::png_filter_scores_sse(line, prev_line, bytes_per_pixel);
+#else
+    return detail::png_filter_scores_scalar(line, prev_line, bytes_per_pixel);
+#endif
+}
+
+[[nodiscard]] int png_select_filter(std::span<uint8_t const> line, std::span<uint8_t const> prev_line, int bytes_per_pixel) noexcept
+{
+    ttlet scores = png_filter_scores(line, prev_line, bytes_per_pixel);
+    return narrow_cast<int>(std::min_element(scores.begin(), scores.end()) - scores.begin());
+}
+
+void png_filter_line(
+    int filter_type,
+    std::span<uint8_t const> line,
+    std::span<uint8_t const> prev_line,
+    int bytes_per_pixel,
+    std::span<uint8_t> output) noexcept
+{
+#if TT_X86_64_V2
+    detail::png_filter_line_sse(filter_type, line, prev_line, bytes_per_pixel, output);
+#else
+    detail::png_filter_line_scalar(filter_type, line, prev_line, bytes_per_pixel, output);
+#endif
+}
+
+} // namespace tt
@@ -0,0 +1,90 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "../required.hpp"
+#include "../architecture.hpp"
+#include <span>
+#include <array>
+#include <cstdint>
+
+namespace tt {
+
+/** The number of PNG filter types: none, sub, up, average and paeth.
+ */
+constexpr int png_nr_filter_types = 5;
+
+namespace detail {
+
+/** Calculate the score of each filter type one byte at a time.
+ */
+[[nodiscard]] std::array<uint64_t, png_nr_filter_types>
+png_filter_scores_scalar(std::span<uint8_t const> line, std::span<uint8_t const> prev_line, int bytes_per_pixel) noexcept;
+
+/** Filter a line one byte at a time.
+ */
+void png_filter_line_scalar(
+    int filter_type,
+    std::span<uint8_t const> line,
+    std::span<uint8_t const> prev_line,
+    int bytes_per_pixel,
+    std::span<uint8_t> output) noexcept;
+
+#if TT_X86_64_V2
+/** Calculate the score of each filter type 16 bytes at a time using SSE4.1.
+ */
+[[nodiscard]] std::array<uint64_t, png_nr_filter_types>
+png_filter_scores_sse(std::span<uint8_t const> line, std::span<uint8_t const> prev_line, int bytes_per_pixel) noexcept;
+
+/** Filter a line 16 bytes at a time using SSE4.1.
+ */
+void png_filter_line_sse(
+    int filter_type,
+    std::span<uint8_t const> line,
+    std::span<uint8_t const> prev_line,
+    int bytes_per_pixel,
+    std::span<uint8_t> output) noexcept;
+#endif
+
+} // namespace detail
+
+/** Calculate the score of each filter type for a line.
+ *
+ * The score is the sum of the absolute values of the filtered bytes, interpreted as
+ * signed bytes; the heuristic recommended by the PNG specification. All five filters
+ * are calculated at once without storing the filtered bytes; on x86-64 the absolute
+ * values are summed using the sum-of-absolute-differences instruction.
+ *
+ * @param line The unfiltered line.
+ * @param prev_line The previous unfiltered line, all zero for the first line.
+ * @param bytes_per_pixel The distance between a byte and the byte to its left.
+ * @return The score of each filter type, lower is better.
+ */
+[[nodiscard]] std::array<uint64_t, png_nr_filter_types>
+png_filter_scores(std::span<uint8_t const> line, std::span<uint8_t const> prev_line, int bytes_per_pixel) noexcept;
+
+/** Select the filter type with the lowest score for a line.
+ *
+ * @see png_filter_scores()
+ * @return The filter type between 0 and 4.
+ */
+[[nodiscard]] int png_select_filter(std::span<uint8_t const> line, std::span<uint8_t const> prev_line, int bytes_per_pixel) noexcept;
+
+/** Filter a line.
+ *
+ * @param filter_type The filter type between 0 and 4.
+ * @param line The unfiltered line.
+ * @param prev_line The previous unfiltered line, all zero for the first line.
+ * @param bytes_per_pixel The distance between a byte and the byte to its left.
+ * @param[out] output The filtered line, without the filter-type byte.
+ */
+void png_filter_line(
+    int filter_type,
+    std::span<uint8_t const> line,
+    std::span<uint8_t const> prev_line,
+    int bytes_per_pixel,
+    std::span<uint8_t> output) noexcept;
+
+} // namespace tt
@@ -0,0 +1,131 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/codec/png_filter.hpp"
+#include "ttauri/codec/png_unfilter.hpp"
+#include "ttauri/required.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace tt;
+
+static std::vector<uint8_t> random_line(std::mt19937 &engine, ssize_t size, int max_value)
+{
+    auto dist = std::uniform_int_distribution<int>{0, max_value};
+
+    auto r = std::vector<uint8_t>{};
+    r.reserve(size);
+    for (ssize_t i = 0; i != size; ++i) {
+        r.push_back(static_cast<uint8_t>(dist(engine)));
+    }
+    return r;
+}
+
+/** Check that the vectorized filters and scores are bit-exact with the scalar implementation,
+ * and that the filtered line is reconstructed to the original line.
+ */
+static void compare_filter(int bytes_per_pixel, int max_value = 255)
+{
+    auto engine = std::mt19937{42};
+
+    for (ttlet width : {0, 1, 2, 3, 4, 5, 7, 8, 15, 16, 17, 33, 100, 1023}) {
+        ttlet size = width * bytes_per_pixel;
+        ttlet line = random_line(engine, size, max_value);
+        ttlet prev_line = random_line(engine, size, max_value);
+
+        ttlet expected_scores = detail::png_filter_scores_scalar(line, prev_line, bytes_per_pixel);
+        ASSERT_EQ(png_filter_scores(line, prev_line, bytes_per_pixel), expected_scores)
+            << "bpp=" << bytes_per_pixel << " width=" << width;
+
+        for (int filter_type = 0; filter_type != png_nr_filter_types; ++filter_type) {
+            auto expected = std::vector<uint8_t>(size, 0);
+            auto result = std::vector<uint8_t>(size, 0);
+            detail::png_filter_line_scalar(filter_type, line, prev_line, bytes_per_pixel, expected);
+            png_filter_line(filter_type, line, prev_line, bytes_per_pixel, result);
+            ASSERT_EQ(result, expected) << "filter=" << filter_type << " bpp=" << bytes_per_pixel << " width=" << width;
+
+            switch (filter_type) {
+            case 1: png_unfilter_line_sub_scalar(result, bytes_per_pixel); break;
+            case 2: png_unfilter_line_up_scalar(result, prev_line); break;
+            case 3: png_unfilter_line_average_scalar(result, prev_line, bytes_per_pixel); break;
+            case 4: png_unfilter_line_paeth_scalar(result, prev_line, bytes_per_pixel); break;
+            default:;
+            }
+            ASSERT_EQ(result, line) << "filter=" << filter_type << " bpp=" << bytes_per_pixel << " width=" << width;
+        }
+    }
+}
+
+TEST(PNGFilter, RGB8)
+{
+    compare_filter(3);
+}
+
+TEST(PNGFilter, RGBA8)
+{
+    compare_filter(4);
+}
+
+TEST(PNGFilter, RGB16)
+{
+    compare_filter(6);
+}
+
+TEST(PNGFilter, RGBA16)
+{
+    compare_filter(8);
+}
+
+TEST(PNGFilter, Gray8)
+{
+    compare_filter(1);
+}
+
+TEST(PNGFilter, SmallValues)
+{
+    // Small values make many of the paeth distances equal.
+    compare_filter(4, 3);
+}
+
+TEST(PNGFilter, Select)
+{
+    auto engine = std::mt19937{42};
+    ttlet line = random_line(engine, 400, 255);
+
+    // A line equal to the previous line is best encoded with the up filter.
+    ASSERT_EQ(png_select_filter(line, line, 4), 2);
+
+    // A line of a single repeated color is best encoded with the sub filter.
+    ttlet zero_line = std::vector<uint8_t>(400, 0);
+    auto flat_line = std::vector<uint8_t>{};
+    for (int i = 0; i != 100; ++i) {
+        flat_line.insert(flat_line.end(), {200, 100, 50, 255});
+    }
+    ASSERT_EQ(png_select_filter(flat_line, zero_line, 4), 1);
+}
+
+TEST(PNGFilter, PaethExhaustive)
+{
+    // With one byte per pixel, each odd byte is filtered with a = line[i - 1], b = prev_line[i], c = prev_line[i - 1].
+    auto line = std::vector<uint8_t>(2 * 65536, 0);
+    auto prev_line = std::vector<uint8_t>(2 * 65536, 0);
+    for (int i = 0; i != 65536; ++i) {
+        prev_line[i * 2] = static_cast<uint8_t>(i);
+        prev_line[i * 2 + 1] = static_cast<uint8_t>(i >> 8);
+    }
+
+    auto expected = std::vector<uint8_t>(line.size(), 0);
+    auto result = std::vector<uint8_t>(line.size(), 0);
+    for (int a = 0; a != 256; ++a) {
+        for (int i = 0; i != 65536; ++i) {
+            line[i * 2] = static_cast<uint8_t>(a);
+        }
+
+        detail::png_filter_line_scalar(4, line, prev_line, 1, expected);
+        png_filter_line(4, line, prev_line, 1, result);
+        ASSERT_EQ(result, expected) << "a=" << a;
+    }
+}
@@ -0,0 +1,223 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "png_loader.hpp"
+#include "png.hpp"
+#include "../thread.hpp"
+#include "../logger.hpp"
+#include "../exception.hpp"
+#include <algorithm>
+
+namespace tt {
+
+[[nodiscard]] png_loader *png_loader::subsystem_init() noexcept
+{
+    // Leave a CPU for the GUI thread, which is often waiting for the images.
+    ttlet nr_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    return new png_loader("PNG loader", nr_threads, 64 * 1024 * 1024);
+}
+
+void png_loader::subsystem_deinit() noexcept
+{
+    if (auto tmp = _global.exchange(nullptr)) {
+        tmp->stop();
+        delete tmp;
+    }
+}
+
+png_loader::png_loader(std::string name, ssize_t nr_threads, size_t max_cache_size) noexcept :
+    _name(std::move(name)), _max_cache_size(max_cache_size)
+{
+    tt_axiom(nr_threads > 0);
+
+    _threads.reserve(nr_threads);
+    for (ssize_t i = 0; i != nr_threads; ++i) {
+        _threads.emplace_back([this, i](std::stop_token stop_token) {
+            set_thread_name(std::format("{} {}", _name, i));
+            return loop(stop_token);
+        });
+    }
+}
+
+png_loader::~png_loader()
+{
+    stop();
+}
+
+[[nodiscard]] png_loader::future_type png_loader::load(URL const &url) noexcept
+{
+    ttlet lock = std::scoped_lock(_mutex);
+
+    if (auto image = find_in_cache(url)) {
+        auto promise = std::promise<image_ptr>{};
+        promise.set_value(std::move(image));
+        return promise.get_future().share();
+
+    } else if (_stopped) {
+        auto promise = std::promise<image_ptr>{};
+        promise.set_exception(std::make_exception_ptr(cancel_error("PNG loader stopped before loading {}", url)));
+        return promise.get_future().share();
+
+    } else {
+        return find_or_add_job(url).future;
+    }
+}
+
+void png_loader::load(URL const &url, callback_type callback) noexcept
+{
+    auto lock = std::unique_lock(_mutex);
+
+    if (auto image = find_in_cache(url)) {
+        lock.unlock();
+        callback(image);
+
+    } else if (_stopped) {
+        lock.unlock();
+        callback(nullptr);
+
+    } else {
+        find_or_add_job(url).callbacks.push_back(std::move(callback));
+    }
+}
+
+void png_loader::clear_cache() noexcept
+{
+    ttlet lock = std::scoped_lock(_mutex);
+    _cache.clear();
+    _cache_index.clear();
+    _cache_size = 0;
+}
+
+void png_loader::stop() noexcept
+{
+    auto threads = std::vector<std::jthread>{};
+    {
+        ttlet lock = std::scoped_lock(_mutex);
+        _stopped = true;
+        std::swap(threads, _threads);
+    }
+
+    // The destructor of each jthread requests the thread to stop and joins it.
+    // Workers finish the job they are decoding before they stop.
+    threads.clear();
+
+    auto cancelled_jobs = std::deque<std::shared_ptr<job_type>>{};
+    {
+        ttlet lock = std::scoped_lock(_mutex);
+        std::swap(cancelled_jobs, _queue);
+        _jobs.clear();
+    }
+
+    for (ttlet &job : cancelled_jobs) {
+        job->promise.set_exception(std::make_exception_ptr(cancel_error("PNG loader stopped before loading {}", job->url)));
+        for (ttlet &callback : job->callbacks) {
+            callback(nullptr);
+        }
+    }
+}
+
+[[nodiscard]] png_loader::image_ptr png_loader::find_in_cache(URL const &url) noexcept
+{
+    ttlet it = _cache_index.find(url);
+    if (it == _cache_index.end()) {
+        return nullptr;
+    }
+
+    _cache.splice(_cache.begin(), _cache, it->second);
+    return it->second->image;
+}
+
+void png_loader::add_to_cache(URL const &url, image_ptr const &image) noexcept
+{
+    ttlet image_size = static_cast<size_t>(image->width() * image->height()) * sizeof(sfloat_rgba16);
+    if (image_size > _max_cache_size) {
+        return;
+    }
+
+    _cache.push_front(cache_entry{url, image});
+    _cache_index[url] = _cache.begin();
+    _cache_size += image_size;
+
+    while (_cache_size > _max_cache_size) {
+        ttlet &oldest = _cache.back();
+        _cache_size -= static_cast<size_t>(oldest.image->width() * oldest.image->height()) * sizeof(sfloat_rgba16);
+        _cache_index.erase(oldest.url);
+        _cache.pop_back();
+    }
+}
+
+[[nodiscard]] png_loader::job_type &png_loader::find_or_add_job(URL const &url) noexcept
+{
+    auto &job = _jobs[url];
+    if (!job) {
+        job = std::make_shared<job_type>(url);
+        _queue.push_back(job);
+        _condition.notify_one();
+    }
+    return *job;
+}
+
+void png_loader::loop(std::stop_token stop_token) noexcept
+{
+    while (true) {
+        auto job = std::shared_ptr<job_type>{};
+        {
+            auto lock = std::unique_lock(_mutex);
+            _condition.wait(lock, stop_token, [this] {
+                return _stopped || !_queue.empty();
+            });
+
+            // The wait also returns true when a stop was requested while jobs are queued.
+            // Those jobs are cancelled by `stop()`.
+            if (_stopped || stop_token.stop_requested()) {
+                break;
+            }
+
+            job = std::move(_queue.front());
+            _queue.pop_front();
+        }
+
+        run_job(*job);
+    }
+}
+
+void png_loader::run_job(job_type &job) noexcept
+{
+    auto image = image_ptr{};
+    auto exception = std::exception_ptr{};
+    try {
+        // The hash is calculated here, since a shared image can not be modified.
+        auto decoded = png::load(job.url);
+        decoded.update_hash();
+        image = std::make_shared<image_type const>(std::move(decoded));
+    } catch (std::exception const &e) {
+        tt_log_error("Could not load PNG image {}: {}", job.url, e.what());
+        exception = std::current_exception();
+    }
+
+    auto callbacks = std::vector<callback_type>{};
+    {
+        ttlet lock = std::scoped_lock(_mutex);
+
+        // Add the image to the cache and remove the job in one step, so that
+        // a new request for the same url either joins this job, or finds the image in the cache.
+        if (image) {
+            add_to_cache(job.url, image);
+        }
+        std::swap(callbacks, job.callbacks);
+        _jobs.erase(job.url);
+    }
+
+    if (image) {
+        job.promise.set_value(image);
+    } else {
+        job.promise.set_exception(exception);
+    }
+
+    for (ttlet &callback : callbacks) {
+        callback(image);
+    }
+}
+
+} // namespace tt
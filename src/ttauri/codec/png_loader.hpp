@@ -0,0 +1,169 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "../required.hpp"
+#include "../pixel_map.hpp"
+#include "../rapid/sfloat_rgba16.hpp"
+#include "../URL.hpp"
+#include "../subsystem.hpp"
+#include <memory>
+#include <future>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <string>
+
+namespace tt {
+
+/** Service for decoding PNG images on a pool of worker threads.
+ *
+ * Images are loaded asynchronously, so that an application can request all of its
+ * images up front, for example while building a window, and have them decoded in parallel.
+ *
+ * - Concurrent requests for the same URL share a single decode.
+ * - Decoded images are kept in a least-recently-used cache that is bounded by
+ *   the total size of the pixels in bytes.
+ *
+ * Images are shared between requests and must not be modified; use `pixel_map::copy()`
+ * to get a modifiable image. The hash of each image is calculated by the worker thread.
+ */
+class png_loader {
+public:
+    using image_type = pixel_map<sfloat_rgba16>;
+    using image_ptr = std::shared_ptr<image_type const>;
+    using future_type = std::shared_future<image_ptr>;
+
+    /** Callback called when the image has finished loading.
+     * The callback is called from a worker thread, or directly from `load()`
+     * when the image was already in the cache.
+     *
+     * @param image The loaded image, or nullptr if the image could not be loaded.
+     */
+    using callback_type = std::function<void(image_ptr const &image)>;
+
+    /** Create a png loader.
+     *
+     * @param name The name of the loader, used for naming the worker threads.
+     * @param nr_threads The number of worker threads.
+     * @param max_cache_size The maximum total size in bytes of the images kept in the cache.
+     */
+    png_loader(std::string name, ssize_t nr_threads, size_t max_cache_size) noexcept;
+    ~png_loader();
+
+    png_loader(png_loader const &) = delete;
+    png_loader(png_loader &&) = delete;
+    png_loader &operator=(png_loader const &) = delete;
+    png_loader &operator=(png_loader &&) = delete;
+
+    /** Load an image.
+     *
+     * @param url The location of the PNG file.
+     * @return A future to the decoded image. Calling `get()` on the future rethrows
+     *         the exception when the image could not be loaded.
+     */
+    [[nodiscard]] future_type load(URL const &url) noexcept;
+
+    /** Load an image.
+     *
+     * @param url The location of the PNG file.
+     * @param callback The function to call when the image has been loaded.
+     */
+    void load(URL const &url, callback_type callback) noexcept;
+
+    /** Remove all images from the cache.
+     * Images that are still referenced elsewhere remain valid.
+     */
+    void clear_cache() noexcept;
+
+    /** Stop the worker threads.
+     * Requests that were not started yet, or are made after stopping, fail with
+     * a `cancel_error`, or call the callback with nullptr.
+     */
+    void stop() noexcept;
+
+    static png_loader &global() noexcept
+    {
+        return *start_subsystem_or_terminate(_global, nullptr, subsystem_init, subsystem_deinit);
+    }
+
+private:
+    /** A request for an image that is queued or being decoded.
+     */
+    struct job_type {
+        URL url;
+        std::promise<image_ptr> promise;
+        future_type future;
+        std::vector<callback_type> callbacks;
+
+        job_type(URL const &url) noexcept : url(url), promise(), future(promise.get_future().share()), callbacks() {}
+    };
+
+    struct cache_entry {
+        URL url;
+        image_ptr image;
+    };
+
+    static inline std::atomic<png_loader *> _global;
+
+    std::string _name;
+    size_t _max_cache_size;
+
+    std::mutex _mutex;
+    std::condition_variable_any _condition;
+    std::vector<std::jthread> _threads;
+    bool _stopped = false;
+
+    /** Jobs that are waiting for a worker thread.
+     */
+    std::deque<std::shared_ptr<job_type>> _queue;
+
+    /** Jobs that are queued or being decoded, used to deduplicate requests.
+     */
+    std::unordered_map<URL, std::shared_ptr<job_type>> _jobs;
+
+    /** The cache, with the most recently used image at the front.
+     */
+    std::list<cache_entry> _cache;
+    std::unordered_map<URL, std::list<cache_entry>::iterator> _cache_index;
+    size_t _cache_size = 0;
+
+    /** Find the image in the cache and mark it as most recently used.
+     *
+     * @pre _mutex must be held.
+     * @return The image, or nullptr if the image is not in the cache.
+     */
+    [[nodiscard]] image_ptr find_in_cache(URL const &url) noexcept;
+
+    /** Add an image to the cache and evict the least recently used images.
+     *
+     * @pre _mutex must be held.
+     */
+    void add_to_cache(URL const &url, image_ptr const &image) noexcept;
+
+    /** Find or create the job for an url.
+     *
+     * @pre _mutex must be held, and the image is not in the cache.
+     */
+    [[nodiscard]] job_type &find_or_add_job(URL const &url) noexcept;
+
+    /** The thread procedure of the workers.
+     */
+    void loop(std::stop_token stop_token) noexcept;
+
+    /** Decode the image of a job and complete the job.
+     */
+    void run_job(job_type &job) noexcept;
+
+    [[nodiscard]] static png_loader *subsystem_init() noexcept;
+    static void subsystem_deinit() noexcept;
+};
+
+} // namespace tt
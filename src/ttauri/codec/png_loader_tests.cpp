@@ -0,0 +1,112 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/codec/png_loader.hpp"
+#include "ttauri/exception.hpp"
+#include "ttauri/required.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+using namespace std;
+using namespace tt;
+
+TEST(PNGLoader, Load)
+{
+    auto loader = png_loader("PNG loader test", 4, 1024 * 1024);
+
+    ttlet image = loader.load(URL("file:png_loader_test.png")).get();
+    ASSERT_NE(image, nullptr);
+    ASSERT_EQ(image->width(), 128);
+    ASSERT_EQ(image->height(), 128);
+}
+
+TEST(PNGLoader, Deduplicate)
+{
+    auto loader = png_loader("PNG loader test", 4, 1024 * 1024);
+
+    auto futures = std::vector<png_loader::future_type>{};
+    for (int i = 0; i != 16; ++i) {
+        futures.push_back(loader.load(URL("file:png_loader_test.png")));
+    }
+
+    ttlet first = futures.front().get();
+    for (auto &future : futures) {
+        ASSERT_EQ(future.get(), first);
+    }
+
+    // The image is now in the cache.
+    ASSERT_EQ(loader.load(URL("file:png_loader_test.png")).get(), first);
+
+    loader.clear_cache();
+    ASSERT_NE(loader.load(URL("file:png_loader_test.png")).get(), first);
+}
+
+TEST(PNGLoader, CacheLimit)
+{
+    // A 128x128 image does not fit in a 64 KiB cache, so each load decodes the image again.
+    auto loader = png_loader("PNG loader test", 1, 64 * 1024);
+
+    ttlet first = loader.load(URL("file:png_loader_test.png")).get();
+    ttlet second = loader.load(URL("file:png_loader_test.png")).get();
+    ASSERT_NE(first, second);
+}
+
+TEST(PNGLoader, Callback)
+{
+    auto loader = png_loader("PNG loader test", 2, 1024 * 1024);
+
+    auto promise = std::promise<png_loader::image_ptr>{};
+    loader.load(URL("file:png_loader_test.png"), [&promise](ttlet &image) {
+        promise.set_value(image);
+    });
+
+    ttlet image = promise.get_future().get();
+    ASSERT_NE(image, nullptr);
+    ASSERT_EQ(image->width(), 128);
+}
+
+TEST(PNGLoader, Error)
+{
+    auto loader = png_loader("PNG loader test", 2, 1024 * 1024);
+
+    auto future = loader.load(URL("file:png_loader_does_not_exist.png"));
+    ASSERT_ANY_THROW(future.get());
+
+    auto promise = std::promise<png_loader::image_ptr>{};
+    loader.load(URL("file:png_loader_does_not_exist.png"), [&promise](ttlet &image) {
+        promise.set_value(image);
+    });
+    ASSERT_EQ(promise.get_future().get(), nullptr);
+}
+
+TEST(PNGLoader, Stop)
+{
+    auto loader = png_loader("PNG loader test", 1, 1024 * 1024);
+    loader.stop();
+
+    ASSERT_THROW(loader.load(URL("file:png_loader_test.png")).get(), cancel_error);
+}
+
+TEST(PNGLoader, StopQueued)
+{
+    auto loader = png_loader("PNG loader test", 1, 1024 * 1024);
+
+    // Keep the only worker busy until the loader is stopped. A load after stopping
+    // returns a future that is ready immediately.
+    loader.load(URL("file:png_loader_test.png"), [&loader](ttlet &) {
+        while (loader.load(URL("file:png_loader_stop_probe.png")).wait_for(0s) != std::future_status::ready) {
+            std::this_thread::yield();
+        }
+    });
+
+    auto queued = loader.load(URL("file:png_loader_does_not_exist.png"));
+    loader.stop();
+
+    // The queued job is cancelled instead of being run by the worker.
+    ASSERT_THROW(queued.get(), cancel_error);
+}
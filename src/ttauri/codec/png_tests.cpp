@@ -0,0 +1,221 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/codec/png.hpp"
+#include "ttauri/color/sRGB.hpp"
+#include "ttauri/required.hpp"
+#if TT_PROCESSOR == TT_CPU_X64
+#include "ttauri/cpu_id.hpp"
+#endif
+#include <gtest/gtest.h>
+#include <random>
+#include <cmath>
+
+using namespace std;
+using namespace tt;
+
+/** An image with random colors and alpha values, with horizontal runs of equal pixels.
+ */
+static pixel_map<sfloat_rgba16> random_image(ssize_t width, ssize_t height)
+{
+    auto engine = std::mt19937{42};
+    auto dist = std::uniform_real_distribution<float>{0.0f, 1.0f};
+
+    auto r = pixel_map<sfloat_rgba16>{width, height};
+    for (ssize_t y = 0; y != height; ++y) {
+        auto row = r[y];
+        for (ssize_t x = 0; x != width; ++x) {
+            if (x % 4 == 0) {
+                // Half of the pixels are opaque.
+                ttlet alpha = dist(engine) < 0.5f ? 1.0f : dist(engine);
+                row[x] = f32x4{dist(engine) * alpha, dist(engine) * alpha, dist(engine) * alpha, alpha};
+            } else {
+                row[x] = row[x - 1];
+            }
+        }
+    }
+    return r;
+}
+
+static pixel_map<sfloat_rgba16> decode(bstring const &bytes)
+{
+    ttlet png_data = png(bytes, true);
+    auto r = pixel_map<sfloat_rgba16>{narrow_cast<ssize_t>(png_data.width()), narrow_cast<ssize_t>(png_data.height())};
+    png_data.decode_image(r);
+    return r;
+}
+
+/** Compare the pixels of two images, the color components are compared in sRGB gamma space.
+ */
+static void compare(pixel_map<sfloat_rgba16> const &lhs, pixel_map<sfloat_rgba16> const &rhs, float tolerance)
+{
+    ASSERT_EQ(lhs.width(), rhs.width());
+    ASSERT_EQ(lhs.height(), rhs.height());
+
+    for (ssize_t y = 0; y != lhs.height(); ++y) {
+        for (ssize_t x = 0; x != lhs.width(); ++x) {
+            ttlet l = static_cast<f32x4>(lhs[y][x]);
+            ttlet r = static_cast<f32x4>(rhs[y][x]);
+
+            ASSERT_NEAR(l.a(), r.a(), tolerance) << "x=" << x << " y=" << y;
+            if (l.a() > 0.0f) {
+                for (int i = 0; i != 3; ++i) {
+                    ASSERT_NEAR(sRGB_linear_to_gamma(l[i] / l.a()), sRGB_linear_to_gamma(r[i] / r.a()), tolerance)
+                        << "x=" << x << " y=" << y << " i=" << i;
+                }
+            }
+        }
+    }
+}
+
+TEST(PNG, Encode16)
+{
+    ttlet image = random_image(61, 37);
+    ttlet decoded = decode(png::encode(image, 16));
+    compare(decoded, image, 0.002f);
+}
+
+TEST(PNG, Encode8)
+{
+    ttlet image = random_image(61, 37);
+    ttlet decoded = decode(png::encode(image, 8));
+    compare(decoded, image, 1.0f / 255.0f);
+}
+
+TEST(PNG, EncodeLevels)
+{
+    ttlet image = random_image(100, 50);
+    for (ttlet level : {0, 1, 6, 9}) {
+        ttlet decoded = decode(png::encode(image, 8, level));
+        compare(decoded, image, 1.0f / 255.0f);
+    }
+}
+
+TEST(PNG, ReEncode8)
+{
+    // An 8 bit sRGB image is encoded to the same samples it was decoded from.
+    // Except for the colors of translucent pixels, which lose precision when pre-multiplied.
+    ttlet image = png::load(URL("file:png_loader_test.png"));
+    ttlet decoded = decode(png::encode(image, 8));
+
+    auto nr_opaque = 0;
+    for (ssize_t y = 0; y != image.height(); ++y) {
+        for (ssize_t x = 0; x != image.width(); ++x) {
+            ttlet &expected = image[y][x].get();
+            ttlet &result = decoded[y][x].get();
+            ASSERT_EQ(result[3].get(), expected[3].get()) << "x=" << x << " y=" << y;
+            if (static_cast<float>(expected[3]) == 1.0f) {
+                ASSERT_EQ(decoded[y][x], image[y][x]) << "x=" << x << " y=" << y;
+                ++nr_opaque;
+            }
+        }
+    }
+    ASSERT_GT(nr_opaque, 1000);
+}
+
+#if TT_X86_64_V2_5
+static void append_uint32(bstring &bytes, uint32_t value)
+{
+    for (int i = 24; i >= 0; i -= 8) {
+        bytes += static_cast<std::byte>((value >> i) & 0xff);
+    }
+}
+
+static void append_chunk(bstring &bytes, char const *type, std::initializer_list<uint32_t> values, bstring const &data = {})
+{
+    append_uint32(bytes, narrow_cast<uint32_t>(values.size() * 4 + data.size()));
+    for (auto i = 0; i != 4; ++i) {
+        bytes += static_cast<std::byte>(type[i]);
+    }
+    for (ttlet value : values) {
+        append_uint32(bytes, value);
+    }
+    bytes += data;
+    // The checksum is not verified.
+    append_uint32(bytes, 0);
+}
+
+/** A PNG file without image data, used to convert lines of samples to pixels.
+ */
+static bstring png_header(int width, int bit_depth, int color_type, bool wide_gamut)
+{
+    auto r = bstring{};
+    for (ttlet c : {137, 80, 78, 71, 13, 10, 26, 10}) {
+        r += static_cast<std::byte>(c);
+    }
+
+    auto ihdr = bstring{};
+    for (ttlet c : {bit_depth, color_type, 0, 0, 0}) {
+        ihdr += static_cast<std::byte>(c);
+    }
+    append_chunk(r, "IHDR", {narrow_cast<uint32_t>(width), 1}, ihdr);
+
+    if (wide_gamut) {
+        // Rec.2020 primaries with a D65 white point, some colors are outside of the sRGB gamut.
+        append_chunk(r, "cHRM", {31270, 32900, 70800, 29200, 17000, 79700, 13100, 4600});
+    }
+    append_chunk(r, "IEND", {});
+    return r;
+}
+
+TEST(PNG, DataToImageLineF16C)
+{
+    if (not cpu_has_f16c()) {
+        GTEST_SKIP() << "The CPU does not support F16C.";
+    }
+
+    for (ttlet bit_depth : {8, 16}) {
+        for (ttlet color_type : {0, 2, 4, 6}) {
+            for (ttlet wide_gamut : {false, true}) {
+                ttlet nr_values = 1 << bit_depth;
+                ttlet width = std::min(nr_values, 16384);
+                ttlet header = png_header(width, bit_depth, color_type, wide_gamut);
+                ttlet png_data = png(header);
+
+                auto expected = pixel_map<sfloat_rgba16>{width, 1};
+                auto result = pixel_map<sfloat_rgba16>{width, 1};
+                auto expected_row = expected[0];
+                auto result_row = result[0];
+
+                for (int first = 0; first != nr_values; first += width) {
+                    // Each sample of a pixel gets every value once over all the lines.
+                    auto line = bstring{};
+                    for (int x = 0; x != width; ++x) {
+                        ttlet i = first + x;
+                        auto samples = std::vector<int>{i};
+                        if (color_type & 2) {
+                            samples.push_back((i * 3 + 17) % nr_values);
+                            samples.push_back((i * 5 + 29) % nr_values);
+                        }
+                        if (color_type & 4) {
+                            samples.push_back((i * 7 + 101) % nr_values);
+                        }
+                        for (ttlet sample : samples) {
+                            if (bit_depth == 16) {
+                                line += static_cast<std::byte>(sample >> 8);
+                            }
+                            line += static_cast<std::byte>(sample & 0xff);
+                        }
+                    }
+
+                    png_data.data_to_image_line_scalar(line, expected_row);
+                    ASSERT_EQ(png_data.data_to_image_line_f16c(line, result_row), width);
+
+                    for (int x = 0; x != width; ++x) {
+                        for (int i = 0; i != 4; ++i) {
+                            ttlet e = expected_row[x].get()[i].get();
+                            ttlet r = result_row[x].get()[i].get();
+                            // Values which are denormal as half-float are flushed to zero by the scalar path only.
+                            ttlet flushed = (e & 0x7fff) == 0 and (r & 0x7c00) == 0;
+                            ASSERT_TRUE(e == r or flushed) << "bit_depth=" << bit_depth << " color_type=" << color_type
+                                                           << " wide_gamut=" << wide_gamut << " sample=" << first + x
+                                                           << " i=" << i << " expected=" << e << " result=" << r;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+#endif
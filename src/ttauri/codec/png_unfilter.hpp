@@ -0,0 +1,356 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "../required.hpp"
+#include "../assert.hpp"
+#include "../rapid/numeric_array.hpp"
+#include <span>
+#include <cstdint>
+#include <cstdlib>
+
+namespace tt {
+
+/** Reference implementation of the PNG sub-filter reconstruction.
+ */
+inline void png_unfilter_line_sub_scalar(std::span<uint8_t> line, int bytes_per_pixel) noexcept
+{
+    for (ssize_t i = bytes_per_pixel; i < std::ssize(line); ++i) {
+        line[i] += line[i - bytes_per_pixel];
+    }
+}
+
+/** Reference implementation of the PNG up-filter reconstruction.
+ */
+inline void png_unfilter_line_up_scalar(std::span<uint8_t> line, std::span<uint8_t const> prev_line) noexcept
+{
+    tt_axiom(std::ssize(prev_line) >= std::ssize(line));
+
+    for (ssize_t i = 0; i != std::ssize(line); ++i) {
+        line[i] += prev_line[i];
+    }
+}
+
+/** Reference implementation of the PNG average-filter reconstruction.
+ */
+inline void png_unfilter_line_average_scalar(std::span<uint8_t> line, std::span<uint8_t const> prev_line, int bytes_per_pixel) noexcept
+{
+    tt_axiom(std::ssize(prev_line) >= std::ssize(line));
+
+    for (ssize_t i = 0; i != std::ssize(line); ++i) {
+        ttlet j = i - bytes_per_pixel;
+
+        uint8_t prev_raw = j >= 0 ? line[j] : 0;
+        line[i] += (prev_raw + prev_line[i]) / 2;
+    }
+}
+
+[[nodiscard]] inline uint8_t png_paeth_predictor(uint8_t _a, uint8_t _b, uint8_t _c) noexcept
+{
+    auto a = static_cast<int>(_a);
+    auto b = static_cast<int>(_b);
+    auto c = static_cast<int>(_c);
+
+    auto p = a + b - c;
+    auto pa = std::abs(p - a);
+    auto pb = std::abs(p - b);
+    auto pc = std::abs(p - c);
+
+    if (pa <= pb && pa <= pc) {
+        return static_cast<uint8_t>(a);
+    } else if (pb <= pc) {
+        return static_cast<uint8_t>(b);
+    } else {
+        return static_cast<uint8_t>(c);
+    }
+}
+
+/** Reference implementation of the PNG paeth-filter reconstruction.
+ */
+inline void png_unfilter_line_paeth_scalar(std::span<uint8_t> line, std::span<uint8_t const> prev_line, int bytes_per_pixel) noexcept
+{
+    tt_axiom(std::ssize(prev_line) >= std::ssize(line));
+
+    for (ssize_t i = 0; i != std::ssize(line); ++i) {
+        ttlet j = i - bytes_per_pixel;
+
+        uint8_t up = prev_line[i];
+        uint8_t left = j >= 0 ? line[j] : 0;
+        uint8_t left_up = j >= 0 ? prev_line[j] : 0;
+        line[i] += png_paeth_predictor(left, up, left_up);
+    }
+}
+
+namespace detail {
+
+/** Shuffle indices to shift bytes towards higher indices within a chunk, shifting in zeros.
+ * Bytes beyond the chunk are zeroed.
+ */
+[[nodiscard]] constexpr i8x16 png_shift_indices(int shift, int chunk_size) noexcept
+{
+    auto r = i8x16{};
+    for (int i = 0; i != 16; ++i) {
+        r[i] = static_cast<int8_t>(i >= shift && i < chunk_size ? i - shift : -1);
+    }
+    return r;
+}
+
+/** Shuffle indices to repeat the last pixel of a chunk over the whole chunk.
+ * Bytes beyond the chunk are zeroed.
+ */
+[[nodiscard]] constexpr i8x16 png_repeat_last_pixel_indices(int bytes_per_pixel, int chunk_size) noexcept
+{
+    auto r = i8x16{};
+    for (int i = 0; i != 16; ++i) {
+        r[i] = static_cast<int8_t>(i < chunk_size ? chunk_size - bytes_per_pixel + i % bytes_per_pixel : -1);
+    }
+    return r;
+}
+
+/** Shuffle indices to take the low byte of each 16 bit lane.
+ */
+[[nodiscard]] constexpr i8x16 png_narrow_indices() noexcept
+{
+    auto r = i8x16{};
+    for (int i = 0; i != 16; ++i) {
+        r[i] = static_cast<int8_t>(i < 8 ? i * 2 : -1);
+    }
+    return r;
+}
+
+/** Zero extend the first 8 bytes to 16 bit lanes.
+ */
+[[nodiscard]] inline i16x8 png_widen(i8x16 bytes) noexcept
+{
+    return bit_cast<i16x8>(i8x16::interleave_lo(bytes, i8x16{}));
+}
+
+/** Load a pixel, zero extending each byte to a 16 bit lane.
+ *
+ * @tparam LoadSize The number of bytes to load, at least the size of the pixel. Loading
+ *                  a power-of-two number of bytes is much faster than loading 3 or 6 bytes.
+ */
+template<int LoadSize>
+[[nodiscard]] i16x8 png_load_pixel(std::byte const *ptr) noexcept
+{
+    return png_widen(i8x16::load<LoadSize>(ptr));
+}
+
+/** Store the low bytes of the 16 bit lanes of a pixel.
+ *
+ * Exactly the bytes of the pixel are stored, so that the following pixels can be loaded
+ * without waiting for the store to complete.
+ */
+template<int BytesPerPixel>
+void png_store_pixel(std::byte *ptr, i16x8 pixel) noexcept
+{
+    constexpr auto narrow_indices = png_narrow_indices();
+
+    shuffle(bit_cast<i8x16>(pixel), narrow_indices).template store<BytesPerPixel>(ptr);
+}
+
+/** Reconstruct a line one pixel at a time.
+ *
+ * @param func A function `i16x8(i16x8 raw, i16x8 up)` returning the reconstructed pixel, with
+ *             each byte zero extended to a 16 bit lane. Lanes beyond the pixel may contain garbage.
+ */
+template<int BytesPerPixel, typename Func>
+void png_unfilter_line_pixels(std::span<uint8_t> line, std::span<uint8_t const> prev_line, Func func) noexcept
+{
+    static_assert(BytesPerPixel <= 8);
+    constexpr int load_size = BytesPerPixel <= 4 ? 4 : 8;
+
+    tt_axiom(std::ssize(prev_line) >= std::ssize(line));
+    tt_axiom(std::ssize(line) % BytesPerPixel == 0);
+
+    ttlet size = std::ssize(line);
+    auto ptr = reinterpret_cast<std::byte *>(line.data());
+    ttlet prev_ptr = reinterpret_cast<std::byte const *>(prev_line.data());
+
+    ssize_t i = 0;
+    for (; i + load_size <= size; i += BytesPerPixel) {
+        ttlet pixel = func(png_load_pixel<load_size>(ptr + i), png_load_pixel<load_size>(prev_ptr + i));
+        png_store_pixel<BytesPerPixel>(ptr + i, pixel);
+    }
+
+    for (; i != size; i += BytesPerPixel) {
+        ttlet pixel = func(png_load_pixel<BytesPerPixel>(ptr + i), png_load_pixel<BytesPerPixel>(prev_ptr + i));
+        png_store_pixel<BytesPerPixel>(ptr + i, pixel);
+    }
+}
+
+} // namespace detail
+
+/** Reconstruct a sub-filtered line.
+ *
+ * The line is processed in chunks of whole pixels that fit in 16 bytes. A prefix sum is
+ * calculated within the chunk in log2(pixels-per-chunk) shift-and-add steps, after which
+ * the last pixel of the previous chunk is added to every pixel in the chunk.
+ *
+ * @tparam BytesPerPixel The distance between a byte and the byte to its left.
+ * @param line The filtered line, without the filter-type byte.
+ */
+template<int BytesPerPixel>
+void png_unfilter_line_sub(std::span<uint8_t> line) noexcept
+{
+    constexpr int chunk_size = (16 / BytesPerPixel) * BytesPerPixel;
+    constexpr auto shift_1_indices = detail::png_shift_indices(BytesPerPixel, chunk_size);
+    constexpr auto shift_2_indices = detail::png_shift_indices(BytesPerPixel * 2, chunk_size);
+    constexpr auto shift_4_indices = detail::png_shift_indices(BytesPerPixel * 4, chunk_size);
+    constexpr auto repeat_indices = detail::png_repeat_last_pixel_indices(BytesPerPixel, chunk_size);
+
+    ttlet size = std::ssize(line);
+    auto ptr = reinterpret_cast<std::byte *>(line.data());
+
+    // The bytes beyond the chunk are not modified by the shuffles, so that the whole
+    // 16 bytes can be stored back.
+    auto prev = i8x16{};
+    ssize_t i = 0;
+    for (; i + 16 <= size; i += chunk_size) {
+        auto chunk = i8x16::load(ptr + i);
+        chunk += shuffle(chunk, shift_1_indices);
+        if constexpr (BytesPerPixel * 2 < chunk_size) {
+            chunk += shuffle(chunk, shift_2_indices);
+        }
+        if constexpr (BytesPerPixel * 4 < chunk_size) {
+            chunk += shuffle(chunk, shift_4_indices);
+        }
+        chunk += shuffle(prev, repeat_indices);
+        chunk.store(ptr + i);
+        prev = chunk;
+    }
+
+    for (i = std::max(i, ssize_t{BytesPerPixel}); i < size; ++i) {
+        line[i] += line[i - BytesPerPixel];
+    }
+}
+
+/** Reconstruct an up-filtered line.
+ *
+ * @param line The filtered line, without the filter-type byte.
+ * @param prev_line The previous reconstructed line.
+ */
+inline void png_unfilter_line_up(std::span<uint8_t> line, std::span<uint8_t const> prev_line) noexcept
+{
+    tt_axiom(std::ssize(prev_line) >= std::ssize(line));
+
+    ttlet size = std::ssize(line);
+    auto ptr = reinterpret_cast<std::byte *>(line.data());
+    ttlet prev_ptr = reinterpret_cast<std::byte const *>(prev_line.data());
+
+    ssize_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        (i8x16::load(ptr + i) + i8x16::load(prev_ptr + i)).store(ptr + i);
+    }
+
+    for (; i < size; ++i) {
+        line[i] += prev_line[i];
+    }
+}
+
+/** Reconstruct an average-filtered line.
+ *
+ * Each pixel depends on the pixel to its left, so the pixels are reconstructed one at a
+ * time; with the bytes of a pixel zero extended to 16 bit lanes.
+ *
+ * @tparam BytesPerPixel The distance between a byte and the byte to its left.
+ * @param line The filtered line, without the filter-type byte.
+ * @param prev_line The previous reconstructed line.
+ */
+template<int BytesPerPixel>
+void png_unfilter_line_average(std::span<uint8_t> line, std::span<uint8_t const> prev_line) noexcept
+{
+    auto left = i16x8{};
+    detail::png_unfilter_line_pixels<BytesPerPixel>(line, prev_line, [&left](i16x8 raw, i16x8 up) {
+        left = (raw + ((left + up) >> 1)) & int16_t{0xff};
+        return left;
+    });
+}
+
+/** Reconstruct a paeth-filtered line.
+ *
+ * Each pixel depends on the pixel to its left, so the pixels are reconstructed one at a
+ * time; with the bytes of a pixel zero extended to 16 bit lanes. The predictor is selected
+ * without branches using the sign of the differences between the distances.
+ *
+ * @tparam BytesPerPixel The distance between a byte and the byte to its left.
+ * @param line The filtered line, without the filter-type byte.
+ * @param prev_line The previous reconstructed line.
+ */
+template<int BytesPerPixel>
+void png_unfilter_line_paeth(std::span<uint8_t> line, std::span<uint8_t const> prev_line) noexcept
+{
+    auto left = i16x8{};
+    auto left_up = i16x8{};
+    detail::png_unfilter_line_pixels<BytesPerPixel>(line, prev_line, [&left, &left_up](i16x8 raw, i16x8 up) {
+        // p = left + up - left_up
+        // pa = abs(p - left), pb = abs(p - up), pc = abs(p - left_up)
+        ttlet up_diff = up - left_up;
+        ttlet left_diff = left - left_up;
+        ttlet pa = abs(up_diff);
+        ttlet pb = abs(left_diff);
+        ttlet pc = abs(up_diff + left_diff);
+
+        // All bits in a lane are set when the condition is true.
+        ttlet not_left = ((pb - pa) | (pc - pa)) >> 15;
+        ttlet not_up = (pc - pb) >> 15;
+
+        ttlet up_or_left_up =
+            bit_cast<i16x8>(blend(bit_cast<i8x16>(up), bit_cast<i8x16>(left_up), bit_cast<i8x16>(not_up)));
+        ttlet predictor =
+            bit_cast<i16x8>(blend(bit_cast<i8x16>(left), bit_cast<i8x16>(up_or_left_up), bit_cast<i8x16>(not_left)));
+
+        left = (raw + predictor) & int16_t{0xff};
+        left_up = up;
+        return left;
+    });
+}
+
+/** Reconstruct a sub-filtered line.
+ *
+ * Dispatches to the vectorized implementation for 3, 4, 6 and 8 bytes per pixel.
+ */
+inline void png_unfilter_line_sub(std::span<uint8_t> line, int bytes_per_pixel) noexcept
+{
+    switch (bytes_per_pixel) {
+    case 3: return png_unfilter_line_sub<3>(line);
+    case 4: return png_unfilter_line_sub<4>(line);
+    case 6: return png_unfilter_line_sub<6>(line);
+    case 8: return png_unfilter_line_sub<8>(line);
+    default: return png_unfilter_line_sub_scalar(line, bytes_per_pixel);
+    }
+}
+
+/** Reconstruct an average-filtered line.
+ *
+ * Dispatches to the vectorized implementation for 3, 4, 6 and 8 bytes per pixel.
+ */
+inline void png_unfilter_line_average(std::span<uint8_t> line, std::span<uint8_t const> prev_line, int bytes_per_pixel) noexcept
+{
+    switch (bytes_per_pixel) {
+    case 3: return png_unfilter_line_average<3>(line, prev_line);
+    case 4: return png_unfilter_line_average<4>(line, prev_line);
+    case 6: return png_unfilter_line_average<6>(line, prev_line);
+    case 8: return png_unfilter_line_average<8>(line, prev_line);
+    default: return png_unfilter_line_average_scalar(line, prev_line, bytes_per_pixel);
+    }
+}
+
+/** Reconstruct a paeth-filtered line.
+ *
+ * Dispatches to the vectorized implementation for 3, 4, 6 and 8 bytes per pixel.
+ */
+inline void png_unfilter_line_paeth(std::span<uint8_t> line, std::span<uint8_t const> prev_line, int bytes_per_pixel) noexcept
+{
+    switch (bytes_per_pixel) {
+    case 3: return png_unfilter_line_paeth<3>(line, prev_line);
+    case 4: return png_unfilter_line_paeth<4>(line, prev_line);
+    case 6: return png_unfilter_line_paeth<6>(line, prev_line);
+    case 8: return png_unfilter_line_paeth<8>(line, prev_line);
+    default: return png_unfilter_line_paeth_scalar(line, prev_line, bytes_per_pixel);
+    }
+}
+
+}
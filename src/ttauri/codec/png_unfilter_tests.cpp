@@ -0,0 +1,105 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/codec/png_unfilter.hpp"
+#include "ttauri/required.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace tt;
+
+static std::vector<uint8_t> random_line(std::mt19937 &engine, ssize_t size, int max_value)
+{
+    auto dist = std::uniform_int_distribution<int>{0, max_value};
+
+    auto r = std::vector<uint8_t>{};
+    r.reserve(size);
+    for (ssize_t i = 0; i != size; ++i) {
+        r.push_back(static_cast<uint8_t>(dist(engine)));
+    }
+    return r;
+}
+
+/** Check that the vectorized reconstruction of each filter-type is bit-exact with the scalar reconstruction.
+ */
+static void compare_unfilter(int bytes_per_pixel, int max_value = 255)
+{
+    auto engine = std::mt19937{42};
+
+    for (ttlet width : {0, 1, 2, 3, 4, 5, 7, 8, 15, 16, 17, 33, 100, 1023}) {
+        ttlet size = width * bytes_per_pixel;
+        ttlet line = random_line(engine, size, max_value);
+        ttlet prev_line = random_line(engine, size, max_value);
+
+        {
+            auto expected = line;
+            auto result = line;
+            png_unfilter_line_sub_scalar(expected, bytes_per_pixel);
+            png_unfilter_line_sub(result, bytes_per_pixel);
+            ASSERT_EQ(result, expected) << "sub bpp=" << bytes_per_pixel << " width=" << width;
+        }
+
+        {
+            auto expected = line;
+            auto result = line;
+            png_unfilter_line_up_scalar(expected, prev_line);
+            png_unfilter_line_up(result, prev_line);
+            ASSERT_EQ(result, expected) << "up bpp=" << bytes_per_pixel << " width=" << width;
+        }
+
+        {
+            auto expected = line;
+            auto result = line;
+            png_unfilter_line_average_scalar(expected, prev_line, bytes_per_pixel);
+            png_unfilter_line_average(result, prev_line, bytes_per_pixel);
+            ASSERT_EQ(result, expected) << "average bpp=" << bytes_per_pixel << " width=" << width;
+        }
+
+        {
+            auto expected = line;
+            auto result = line;
+            png_unfilter_line_paeth_scalar(expected, prev_line, bytes_per_pixel);
+            png_unfilter_line_paeth(result, prev_line, bytes_per_pixel);
+            ASSERT_EQ(result, expected) << "paeth bpp=" << bytes_per_pixel << " width=" << width;
+        }
+    }
+}
+
+TEST(PNGUnfilter, RGB8)
+{
+    compare_unfilter(3);
+}
+
+TEST(PNGUnfilter, RGBA8)
+{
+    compare_unfilter(4);
+}
+
+TEST(PNGUnfilter, RGB16)
+{
+    compare_unfilter(6);
+}
+
+TEST(PNGUnfilter, RGBA16)
+{
+    compare_unfilter(8);
+}
+
+TEST(PNGUnfilter, Gray)
+{
+    compare_unfilter(1);
+    compare_unfilter(2);
+}
+
+/** Small sample values cause many ties between the paeth predictors.
+ */
+TEST(PNGUnfilter, PaethTies)
+{
+    compare_unfilter(3, 3);
+    compare_unfilter(4, 3);
+    compare_unfilter(6, 3);
+    compare_unfilter(8, 3);
+}
@@ -4,8 +4,10 @@
 
 #include "zlib.hpp"
 #include "inflate.hpp"
+#include "adler32.hpp"
 #include "../endian.hpp"
 #include "../placement.hpp"
+#include <algorithm>
 
 namespace tt {
 
@@ -14,29 +16,160 @@ struct zlib_header {
     uint8_t FLG;
 };
 
-bstring zlib_decompress(std::span<std::byte const> bytes, ssize_t max_size)
+static void zlib_check_header(zlib_header const &header)
+{
+    ttlet header_chksum = header.CMF * 256 + header.FLG;
+    tt_parse_check(header_chksum % 31 == 0, "zlib header checksum failed.");
+
+    tt_parse_check((header.CMF & 0xf) == 8, "zlib compression method must be 8");
+    tt_parse_check(((header.CMF >> 4) & 0xf) <= 7, "zlib LZ77 window too large");
+    tt_parse_check((header.FLG & 0x20) == 0, "zlib must not use a preset dicationary");
+}
+
+bstring zlib_decompress(std::span<std::byte const> bytes, ssize_t max_size, bool verify_checksum)
 {
     ssize_t offset = 0;
 
     ttlet header = make_placement_ptr<zlib_header>(bytes, offset);
+    zlib_check_header(*header);
 
-    ttlet header_chksum = header->CMF * 256 + header->FLG;
-    tt_parse_check(header_chksum % 31 == 0, "zlib header checksum failed.");
+    auto r = inflate(bytes, offset, max_size);
+
+    ttlet ADLER32 = make_placement_ptr<big_uint32_buf_t>(bytes, offset);
+    if (verify_checksum) {
+        tt_parse_check(ADLER32->value() == adler32(r), "zlib Adler-32 checksum mismatch.");
+    }
+
+    return r;
+}
 
-    tt_parse_check((header->CMF & 0xf) == 8, "zlib compression method must be 8");
-    tt_parse_check(((header->CMF >> 4) & 0xf) <= 7, "zlib LZ77 window too large");
-    tt_parse_check((header->FLG & 0x20) == 0, "zlib must not use a preset dicationary");
+[[nodiscard]] bstring zlib_compress(std::span<std::byte const> bytes, int level)
+{
+    auto encoder = zlib_encoder{level};
+    encoder.feed(bytes);
+    encoder.finish();
+    return encoder.take();
+}
+
+zlib_encoder::zlib_encoder(int level, deflate_strategy strategy, int pixel_size) noexcept :
+    _deflate(level, strategy, pixel_size)
+{
+    // 32 KiB window with the deflate method, and the level in the FLEVEL field.
+    ttlet CMF = uint8_t{0x78};
+    ttlet FLEVEL = level <= 1 ? 0 : level <= 5 ? 1 : level == 6 ? 2 : 3;
+    auto FLG = static_cast<uint8_t>(FLEVEL << 6);
+    FLG += static_cast<uint8_t>(31 - (CMF * 256 + FLG) % 31);
+
+    _output.push_back(static_cast<std::byte>(CMF));
+    _output.push_back(static_cast<std::byte>(FLG));
+}
 
-    if (header->FLG & 0x20) {
-        [[maybe_unused]] auto FDICT = make_placement_ptr<big_uint32_buf_t>(bytes, offset);
+void zlib_encoder::feed(std::span<std::byte const> bytes) noexcept
+{
+    _adler = adler32(bytes, _adler);
+    _deflate.feed(bytes);
+}
+
+void zlib_encoder::finish() noexcept
+{
+    _deflate.finish();
+    _output.append(_deflate.take());
+
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        _output.push_back(static_cast<std::byte>((_adler >> shift) & 0xff));
     }
+}
 
-    auto r = inflate(bytes, offset, max_size);
+[[nodiscard]] bstring zlib_encoder::take() noexcept
+{
+    _output.append(_deflate.take());
+    return std::exchange(_output, bstring{});
+}
 
-    [[maybe_unused]] auto ADLER32 = make_placement_ptr<big_uint32_buf_t>(bytes, offset);
+void zlib_decoder::feed(std::span<std::byte const> bytes) noexcept
+{
+    tt_axiom(_input.empty());
+    _input = bytes;
+    _need_input = false;
+}
 
-    return r;
+/** Copy input into the buffer, until the buffer contains `size` bytes.
+ *
+ * @return false when more input is needed.
+ */
+[[nodiscard]] bool zlib_decoder::fill_buffer(ssize_t size) noexcept
+{
+    ttlet todo = std::min(size - _buffer_size, std::ssize(_input));
+    std::copy_n(_input.begin(), todo, _buffer.begin() + _buffer_size);
+    _input = _input.subspan(todo);
+    _buffer_size += todo;
+
+    if (_buffer_size != size) {
+        _need_input = true;
+        return false;
+    }
+
+    _buffer_size = 0;
+    return true;
 }
 
+[[nodiscard]] ssize_t zlib_decoder::read(std::span<std::byte> buffer)
+{
+    ssize_t offset = 0;
 
-}
\ No newline at end of file
+    while (true) {
+        switch (_state) {
+        case state_type::header:
+            if (!fill_buffer(ssizeof(zlib_header))) {
+                return offset;
+            }
+
+            zlib_check_header(*reinterpret_cast<zlib_header const *>(_buffer.data()));
+            _state = state_type::body;
+            break;
+
+        case state_type::body:
+            if (_inflate.need_input()) {
+                if (_input.empty()) {
+                    _need_input = true;
+                    return offset;
+                }
+                _inflate.feed(_input);
+                _input = {};
+            }
+
+            {
+                ttlet size = _inflate.read(buffer.subspan(offset));
+                if (_verify_checksum) {
+                    _adler = adler32(buffer.subspan(offset, size), _adler);
+                }
+                offset += size;
+            }
+
+            if (_inflate.done()) {
+                _input = _inflate.remaining();
+                _state = state_type::trailer;
+            } else if (!_inflate.need_input()) {
+                // The output buffer is full.
+                return offset;
+            }
+            break;
+
+        case state_type::trailer: {
+            if (!fill_buffer(4)) {
+                return offset;
+            }
+
+            ttlet ADLER32 = reinterpret_cast<big_uint32_buf_t const *>(_buffer.data())->value();
+            if (_verify_checksum) {
+                tt_parse_check(ADLER32 == _adler, "zlib Adler-32 checksum mismatch.");
+            }
+            _state = state_type::done;
+        } break;
+
+        case state_type::done: return offset;
+        }
+    }
+}
+
+}
@@ -7,14 +7,153 @@
 #include "../URL.hpp"
 #include "../byte_string.hpp"
 #include "../file_view.hpp"
+#include "inflate.hpp"
+#include "deflate.hpp"
 #include <cstddef>
+#include <array>
 
 namespace tt {
 
-bstring zlib_decompress(std::span<std::byte const> bytes, ssize_t max_size=0x01000000);
+/** Decompress data in the zlib format.
+ *
+ * @param bytes The zlib data.
+ * @param max_size The maximum size of the decompressed data.
+ * @param verify_checksum Check the Adler-32 of the decompressed data against the trailer.
+ * @return The decompressed data.
+ * @throw parse_error When the zlib data is invalid.
+ */
+bstring zlib_decompress(std::span<std::byte const> bytes, ssize_t max_size=0x01000000, bool verify_checksum=false);
 
-inline bstring zlib_decompress(URL const &url, ssize_t max_size=0x01000000) {
-    return zlib_decompress(file_view(url), max_size);
+inline bstring zlib_decompress(URL const &url, ssize_t max_size=0x01000000, bool verify_checksum=false) {
+    return zlib_decompress(file_view(url), max_size, verify_checksum);
 }
 
+/** Compress data into the zlib format.
+ *
+ * @param bytes The data to compress.
+ * @param level The compression level between 0 (no compression) and 9 (best compression).
+ * @return The zlib data.
+ */
+[[nodiscard]] bstring zlib_compress(std::span<std::byte const> bytes, int level = deflate_default_level);
+
+/** Incremental decoder for the zlib format.
+ *
+ * @see inflate_decoder for the usage of `feed()` and `read()`.
+ */
+class zlib_decoder {
+public:
+    zlib_decoder() = default;
+
+    /**
+     * @param verify_checksum Check the Adler-32 of the decompressed data against the trailer.
+     */
+    explicit zlib_decoder(bool verify_checksum) noexcept : _verify_checksum(verify_checksum) {}
+
+    zlib_decoder(zlib_decoder const &) = delete;
+    zlib_decoder(zlib_decoder &&) noexcept = default;
+    zlib_decoder &operator=(zlib_decoder const &) = delete;
+    zlib_decoder &operator=(zlib_decoder &&) noexcept = default;
+
+    /** Pass the next chunk of zlib data to the decoder.
+     *
+     * @pre All previous input must have been consumed.
+     * @param bytes The next chunk of zlib data, must remain valid until consumed.
+     */
+    void feed(std::span<std::byte const> bytes) noexcept;
+
+    /** Decompress data.
+     *
+     * @param buffer The buffer to write the decompressed data into.
+     * @return The number of bytes written into the buffer.
+     * @throw parse_error When the zlib data is invalid, or the checksum does not match.
+     */
+    [[nodiscard]] ssize_t read(std::span<std::byte> buffer);
+
+    /** Check if the decoder needs more input to continue.
+     */
+    [[nodiscard]] bool need_input() const noexcept
+    {
+        return _need_input;
+    }
+
+    /** Check if the end of the zlib stream was reached.
+     */
+    [[nodiscard]] bool done() const noexcept
+    {
+        return _state == state_type::done;
+    }
+
+    /** The input that follows the end of the zlib stream.
+     */
+    [[nodiscard]] std::span<std::byte const> remaining() const noexcept
+    {
+        return _input;
+    }
+
+private:
+    enum class state_type { header, body, trailer, done };
+
+    state_type _state = state_type::header;
+    bool _need_input = true;
+    bool _verify_checksum = false;
+    std::span<std::byte const> _input;
+    inflate_decoder _inflate;
+
+    /** The Adler-32 of the decompressed data so far.
+     */
+    uint32_t _adler = 1;
+
+    /** Header or trailer bytes that are split between chunks of input.
+     */
+    std::array<std::byte, 4> _buffer = {};
+    ssize_t _buffer_size = 0;
+
+    [[nodiscard]] bool fill_buffer(ssize_t size) noexcept;
+};
+
+/** Incremental encoder for the zlib format.
+ *
+ * @see deflate_encoder for the usage of `feed()`, `finish()` and `take()`.
+ */
+class zlib_encoder {
+public:
+    /**
+     * @param level The compression level between 0 (no compression) and 9 (best compression).
+     * @param strategy The way to search for matches.
+     * @param pixel_size The number of bytes in a pixel, for the `deflate_strategy::run_length` strategy.
+     */
+    explicit zlib_encoder(
+        int level = deflate_default_level,
+        deflate_strategy strategy = deflate_strategy::normal,
+        int pixel_size = 1) noexcept;
+
+    zlib_encoder(zlib_encoder const &) = delete;
+    zlib_encoder(zlib_encoder &&) noexcept = default;
+    zlib_encoder &operator=(zlib_encoder const &) = delete;
+    zlib_encoder &operator=(zlib_encoder &&) noexcept = default;
+
+    /** Pass the next chunk of data to the encoder.
+     */
+    void feed(std::span<std::byte const> bytes) noexcept;
+
+    /** Compress the rest of the data and write the trailer.
+     */
+    void finish() noexcept;
+
+    /** Take the zlib data produced so far.
+     */
+    [[nodiscard]] bstring take() noexcept;
+
+private:
+    deflate_encoder _deflate;
+
+    /** The Adler-32 of the data so far.
+     */
+    uint32_t _adler = 1;
+
+    /** The header or trailer which has not been taken yet.
+     */
+    bstring _output;
+};
+
 }
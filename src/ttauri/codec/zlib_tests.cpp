@@ -0,0 +1,57 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/codec/zlib.hpp"
+#include "ttauri/exception.hpp"
+#include "ttauri/required.hpp"
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace tt;
+
+/** "hello" in a single stored deflate block.
+ */
+static bstring zlib_hello() noexcept
+{
+    auto r = bstring{};
+    for (ttlet c : {0x78, 0x01, 0x01, 0x05, 0x00, 0xfa, 0xff, 0x68, 0x65, 0x6c, 0x6c, 0x6f, 0x06, 0x2c, 0x02, 0x15}) {
+        r.push_back(static_cast<std::byte>(c));
+    }
+    return r;
+}
+
+TEST(ZLib, Decompress)
+{
+    ttlet compressed = zlib_hello();
+    ASSERT_EQ(zlib_decompress(compressed, 0x01000000, true), to_bstring("hello"));
+}
+
+TEST(ZLib, VerifyChecksum)
+{
+    auto compressed = zlib_hello();
+    compressed.back() ^= std::byte{1};
+
+    ASSERT_EQ(zlib_decompress(compressed), to_bstring("hello"));
+    ASSERT_THROW(zlib_decompress(compressed, 0x01000000, true), parse_error);
+
+    auto decoder = zlib_decoder{true};
+    auto buffer = bstring(16, std::byte{0});
+    decoder.feed(compressed);
+    ASSERT_THROW((void)decoder.read(buffer), parse_error);
+}
+
+TEST(ZLib, Encoder)
+{
+    for (ttlet level : {0, 1, 6}) {
+        auto encoder = zlib_encoder{level};
+        auto compressed = encoder.take();
+        encoder.feed(to_bstring("hel"));
+        compressed.append(encoder.take());
+        encoder.feed(to_bstring("lo"));
+        encoder.finish();
+        compressed.append(encoder.take());
+
+        ASSERT_EQ(zlib_decompress(compressed, 0x01000000, true), to_bstring("hello")) << "level=" << level;
+    }
+}
@@ -1,16 +0,0 @@
-// Copyright Take Vos 2019.
-// Distributed under the Boost Software License, Version 1.0.
-// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
-
-#include "cpu_id.hpp"
-
-namespace tt {
-
-struct {
-
-};
-
-tt_cpu_id(
-
-
-};
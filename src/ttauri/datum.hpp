@@ -14,10 +14,11 @@
 #include "algorithm.hpp"
 #include "byte_string.hpp"
 #include "codec/base_n.hpp"
+#include "flat_map.hpp"
 #include <chrono>
 #include <vector>
-#include <unordered_map>
 #include <memory>
+#include <memory_resource>
 #include <cstring>
 #include <cstdint>
 #include <variant>
@@ -110,7 +111,7 @@ struct std::formatter<tt::datum_type_t, CharT> : std::formatter<char const *, Ch
  *  - Undefined
  *  - String
  *  - Vector of datum
- *  - Unordered map of datum:datum.
+ *  - Map of datum:datum, in insertion order.
  *  - YearMonthDay.
  *  - Bytes.
  *
@@ -139,7 +140,7 @@ private:
         uint64_t x = 0;
         for (uint64_t i = 0; i < len; i++) {
             x <<= 8;
-            x |= str[i];
+            x |= static_cast<uint8_t>(str[i]);
         }
         return (string_mask + (len << 40)) | x;
     }
@@ -155,6 +156,20 @@ private:
         return mask | (reinterpret_cast<uint64_t>(ptr) & pointer_mask);
     }
 
+    /** Construct an object in an arena and encode its pointer into a uint64_t.
+     *
+     * @param mask A mask signifying the type of the pointer.
+     * @param arena The arena to allocate the object in.
+     * @param args The arguments passed to the constructor of the object.
+     * @return Encoded pointer, marked as owned by the arena.
+     */
+    template<typename O, typename... Args>
+    static uint64_t make_arena_pointer(uint64_t mask, std::pmr::memory_resource &arena, Args &&...args)
+    {
+        auto *const p = new (arena.allocate(sizeof(O), alignof(O))) O(std::forward<Args>(args)...);
+        return make_pointer(mask, p) | arena_bit;
+    }
+
     /** Convert an type_id to a mask.
      *
      * @param id Type id
@@ -189,6 +204,12 @@ private:
     static constexpr uint16_t exponent_mask = 0b0111'1111'1111'0000;
     static constexpr uint64_t pointer_mask = 0x0000'ffff'ffff'ffff;
 
+    /** The bit in a pointer that marks an object owned by an arena.
+     * Objects are at least 2 byte aligned, so this bit is not part of the address. An object
+     * owned by an arena is not deleted by the datum, instead the arena is released as a whole.
+     */
+    static constexpr uint64_t arena_bit = 1;
+
     static constexpr uint64_t small_undefined = 0;
     static constexpr uint64_t small_null = 1;
     static constexpr uint64_t small_true = 2;
@@ -359,7 +380,7 @@ private:
     template<typename O>
     O *get_pointer() const
     {
-        return std::launder(reinterpret_cast<O *>(get_signed_integer()));
+        return std::launder(reinterpret_cast<O *>(get_signed_integer() & ~static_cast<int64_t>(arena_bit)));
     }
 
     /** Delete the object that the datum is pointing to.
@@ -368,9 +389,13 @@ private:
     void delete_pointer() noexcept
     {
         if constexpr (HasLargeObjects) {
+            if (u64 & arena_bit) {
+                return;
+            }
+
             switch (type_id()) {
             case phy_integer_ptr_id: delete get_pointer<int64_t>(); break;
-            case phy_string_ptr_id: delete get_pointer<std::string>(); break;
+            case phy_string_ptr_id: delete get_pointer<std::pmr::string>(); break;
             case phy_url_ptr_id: delete get_pointer<URL>(); break;
             case phy_vector_ptr_id: delete get_pointer<datum_impl::vector>(); break;
             case phy_map_ptr_id: delete get_pointer<datum_impl::map>(); break;
@@ -396,7 +421,7 @@ private:
             } break;
 
             case phy_string_ptr_id: {
-                auto *const p = new std::string(*other.get_pointer<std::string>());
+                auto *const p = new std::pmr::string(*other.get_pointer<std::pmr::string>());
                 u64 = make_pointer(string_ptr_mask, p);
             } break;
 
@@ -431,8 +456,13 @@ private:
     }
 
 public:
-    using vector = std::vector<datum_impl>;
-    using map = std::unordered_map<datum_impl, datum_impl>;
+    using vector = std::pmr::vector<datum_impl>;
+    using map = flat_map<
+        datum_impl,
+        datum_impl,
+        std::hash<datum_impl>,
+        std::equal_to<datum_impl>,
+        std::pmr::polymorphic_allocator<std::pair<datum_impl, datum_impl>>>;
     struct undefined {
     };
     struct null {
@@ -491,6 +521,10 @@ public:
     datum_impl &operator=(datum_impl &&other) noexcept
     {
         tt_return_on_self_assignment(other);
+        if (is_phy_pointer()) {
+            [[unlikely]] delete_pointer();
+        }
+
         // We do a memcpy, because we don't know the type in the union.
         std::memcpy(this, &other, sizeof(*this));
         other.u64 = undefined_mask;
@@ -585,7 +619,7 @@ public:
     {
         if (u64 == 0) {
             if constexpr (HasLargeObjects) {
-                auto *const p = new std::string(value);
+                auto *const p = new std::pmr::string(value);
                 u64 = make_pointer(string_ptr_mask, p);
             } else {
                 throw std::overflow_error(std::format("Constructing string {} to datum, larger than 6 characters", value));
@@ -638,6 +672,49 @@ public:
         u64 = make_pointer(map_ptr_mask, p);
     }
 
+    /** Construct an integer, allocated in an arena when it does not fit in the datum.
+     * @see datum_document
+     */
+    template<bool P = HasLargeObjects, std::enable_if_t<P, int> = 0>
+    datum_impl(signed long long value, std::pmr::memory_resource &arena) noexcept :
+        u64(integer_mask | (static_cast<uint64_t>(value) & 0x0000ffff'ffffffff))
+    {
+        if (value < minimum_int || value > maximum_int) {
+            [[unlikely]] u64 = make_arena_pointer<int64_t>(integer_ptr_mask, arena, value);
+        }
+    }
+
+    /** Construct a string, allocated in an arena when it does not fit in the datum.
+     * @see datum_document
+     */
+    template<bool P = HasLargeObjects, std::enable_if_t<P, int> = 0>
+    datum_impl(std::string_view value, std::pmr::memory_resource &arena) noexcept : u64(make_string(value))
+    {
+        if (u64 == 0) {
+            u64 = make_arena_pointer<std::pmr::string>(string_ptr_mask, arena, value, &arena);
+        }
+    }
+
+    /** Construct a vector allocated in an arena.
+     * The items of the vector should be allocated in the same arena.
+     * @see datum_document
+     */
+    template<bool P = HasLargeObjects, std::enable_if_t<P, int> = 0>
+    datum_impl(datum_impl::vector &&value, std::pmr::memory_resource &arena) noexcept :
+        u64(make_arena_pointer<datum_impl::vector>(vector_ptr_mask, arena, std::move(value), &arena))
+    {
+    }
+
+    /** Construct a map allocated in an arena.
+     * The keys and values of the map should be allocated in the same arena.
+     * @see datum_document
+     */
+    template<bool P = HasLargeObjects, std::enable_if_t<P, int> = 0>
+    datum_impl(datum_impl::map &&value, std::pmr::memory_resource &arena) noexcept :
+        u64(make_arena_pointer<datum_impl::map>(map_ptr_mask, arena, std::move(value), &arena))
+    {
+    }
+
     datum_impl &operator=(datum_impl::undefined rhs) noexcept
     {
         if (is_phy_pointer()) {
@@ -833,7 +910,7 @@ public:
         u64 = make_string(rhs);
         if (u64 == 0) {
             if constexpr (HasLargeObjects) {
-                auto *const p = new std::string(rhs);
+                auto *const p = new std::pmr::string(rhs);
                 u64 = make_pointer(string_ptr_mask, p);
             } else {
                 throw std::overflow_error(std::format("Assigning string {} to datum, larger than 6 characters", rhs));
@@ -1131,7 +1208,7 @@ public:
         if (is_phy_string() && size() == 1) {
             return u64 & 0xff;
         } else if (is_phy_string_ptr() && size() == 1) {
-            return get_pointer<std::string>()->at(0);
+            return get_pointer<std::pmr::string>()->at(0);
         } else {
             throw operation_error(
                 "Value {} of type {} can not be converted to a char", this->repr(), this->type_name());
@@ -1187,7 +1264,7 @@ public:
 
         case phy_string_ptr_id:
             if constexpr (HasLargeObjects) {
-                return *get_pointer<std::string>();
+                return std::string{*get_pointer<std::pmr::string>()};
             } else {
                 tt_no_default();
             }
@@ -1227,21 +1304,13 @@ public:
 
         case phy_map_ptr_id:
             if constexpr (HasLargeObjects) {
-                // We sort the map based on keys before creating a string
-                // so that the representation of a map is stable between implementations.
-                std::vector<std::pair<datum_impl, datum_impl>> items;
-                items.reserve(size());
-                std::copy(map_begin(), map_end(), std::back_inserter(items));
-                std::sort(items.begin(), items.end(), [](auto &a, auto &b) {
-                    return a.first < b.first;
-                });
-
                 // The string representation for a map is like a json object.
                 // Enclosed with braces '{' and '}' Each pair is separated with
                 // comma ',' and key and value separated with ':'.
+                // The items are in insertion order, which is stable between implementations.
                 std::string r = "{";
                 auto count = 0;
-                for (auto &item : items) {
+                for (ttlet &item : *get_pointer<datum_impl::map>()) {
                     if (count++ > 0) {
                         r += ", ";
                     }
@@ -1802,7 +1871,7 @@ public:
     {
         switch (type_id()) {
         case phy_string_id: return (u64 >> 40) & 0xff;
-        case phy_string_ptr_id: return get_pointer<std::string>()->size();
+        case phy_string_ptr_id: return get_pointer<std::pmr::string>()->size();
         case phy_vector_ptr_id: return get_pointer<datum_impl::vector>()->size();
         case phy_map_ptr_id: return get_pointer<datum_impl::map>()->size();
         case phy_bytes_ptr_id: return get_pointer<bstring>()->size();
@@ -1858,7 +1927,7 @@ public:
         } else if (is_phy_pointer()) {
             [[unlikely]] switch (type_id())
             {
-            case phy_string_ptr_id: return std::hash<std::string>{}(*get_pointer<std::string>());
+            case phy_string_ptr_id: return std::hash<std::string_view>{}(*get_pointer<std::pmr::string>());
             case phy_url_ptr_id: return std::hash<URL>{}(*get_pointer<URL>());
             case phy_vector_ptr_id:
                 return std::accumulate(vector_begin(), vector_end(), size_t{0}, [](size_t a, auto x) {
@@ -0,0 +1,68 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "datum.hpp"
+#include <memory_resource>
+#include <memory>
+#include <algorithm>
+
+namespace tt {
+
+/** A read-only datum tree of which all strings, vectors and maps are allocated in a single arena.
+ *
+ * Parsers like `parse_JSON_document()` build the tree using the arena constructors of
+ * `datum` with `arena()`. Since the arena is monotonic the nodes of the tree are
+ * allocated next to each other in the order they are parsed, and freeing the document
+ * releases the arena without visiting the nodes of the tree.
+ *
+ * Copying a value out of the document makes a normal, heap allocated, copy.
+ */
+class datum_document {
+public:
+    /**
+     * @param initial_size The size of the first block of the arena; for example the size of the text being parsed.
+     */
+    explicit datum_document(size_t initial_size = 0x1000) noexcept :
+        _arena(std::make_unique<std::pmr::monotonic_buffer_resource>(std::max(initial_size, size_t{0x100})))
+    {
+    }
+
+    datum_document(datum_document const &) = delete;
+    datum_document(datum_document &&) noexcept = default;
+    datum_document &operator=(datum_document const &) = delete;
+    datum_document &operator=(datum_document &&) noexcept = default;
+
+    /** The arena in which the values of the document are allocated.
+     */
+    [[nodiscard]] std::pmr::memory_resource &arena() const noexcept
+    {
+        return *_arena;
+    }
+
+    /** The root of the document.
+     */
+    [[nodiscard]] datum const &root() const noexcept
+    {
+        return _root;
+    }
+
+    /** Set the root of the document.
+     * @param root A value of which all objects are allocated in `arena()`.
+     */
+    void set_root(datum &&root) noexcept
+    {
+        _root = std::move(root);
+    }
+
+private:
+    // The arena is allocated on the heap, so that the pointers into it remain valid when the document is moved.
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> _arena;
+
+    // Destroyed before the arena, this does not delete the objects in the arena.
+    datum _root;
+};
+
+} // namespace tt
@@ -3,6 +3,7 @@
 // (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
 
 #include "ttauri/datum.hpp"
+#include "ttauri/datum_document.hpp"
 #include "ttauri/exception.hpp"
 #include <gtest/gtest.h>
 #include <iostream>
@@ -143,3 +144,28 @@ TEST(Datum, ArrayOperations) {
     ASSERT_EQ(v[-2], 14);
     ASSERT_EQ(v[-1], 15);
 }
+
+TEST(Datum, ArenaOperations) {
+    auto document = datum_document{};
+    auto &arena = document.arena();
+
+    auto v = datum::vector(&arena);
+    v.emplace_back("a string longer than five characters", arena);
+    v.emplace_back(0x7fff'ffff'ffff'ffffLL, arena);
+    v.emplace_back("short", arena);
+    auto m = datum::map(&arena);
+    m.emplace(datum{"key", arena}, datum{std::move(v), arena});
+    document.set_root(datum{std::move(m), arena});
+
+    ttlet &root = document.root();
+    ASSERT_EQ(root["key"][0], "a string longer than five characters");
+    ASSERT_EQ(root["key"][1], 0x7fff'ffff'ffff'ffffLL);
+    ASSERT_EQ(root["key"][2], "short");
+    ASSERT_EQ(root["key"].size(), 3);
+
+    // A copy is allocated on the heap, and remains valid after the document is destroyed.
+    auto copy = datum{root["key"]};
+    document = datum_document{};
+    ASSERT_EQ(copy[0], "a string longer than five characters");
+    ASSERT_EQ(copy[1], 0x7fff'ffff'ffff'ffffLL);
+}
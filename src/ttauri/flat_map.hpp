@@ -0,0 +1,452 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "required.hpp"
+#include "assert.hpp"
+#include "architecture.hpp"
+#if TT_X86_64_V2
+#include <emmintrin.h> // SSE2
+#endif
+#include <vector>
+#include <memory>
+#include <utility>
+#include <functional>
+#include <stdexcept>
+#include <bit>
+#include <cstdint>
+
+namespace tt {
+
+/** A map which stores its items in a contiguous array in insertion order.
+ *
+ * Most maps in configuration and theme files have only a few keys; for those
+ * a search through an array is faster than the buckets of a `std::unordered_map`,
+ * and uses much less memory. Next to each item a 8-bit tag of the hash of the key is stored,
+ * the tags are compared 16 at a time and only the keys with a matching tag are compared.
+ *
+ * When the map grows beyond `index_threshold` items an open-addressing hash table
+ * of indices into the array is added, so that large maps still have constant time lookup.
+ *
+ * Iteration is in insertion order. Like a `std::vector`, inserting or erasing an item
+ * invalidates iterators. Erasing an item is linear in the size of the map.
+ *
+ * @tparam Key The type of the key.
+ * @tparam T The type of the value.
+ * @tparam Hash The hash function for the key.
+ * @tparam KeyEqual The function to compare two keys for equality.
+ * @tparam Allocator Allocator for `std::pair<Key, T>`; it is also used for the tags and the index.
+ */
+template<
+    typename Key,
+    typename T,
+    typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>,
+    typename Allocator = std::allocator<std::pair<Key, T>>>
+class flat_map {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+    using reference = value_type &;
+    using const_reference = value_type const &;
+
+private:
+    using items_type = std::vector<value_type, allocator_type>;
+    using tag_allocator_type = typename std::allocator_traits<allocator_type>::template rebind_alloc<uint8_t>;
+    using index_allocator_type = typename std::allocator_traits<allocator_type>::template rebind_alloc<uint32_t>;
+
+public:
+    using iterator = typename items_type::iterator;
+    using const_iterator = typename items_type::const_iterator;
+
+    /** The number of items above which a hash table is used for lookup.
+     */
+    static constexpr size_t index_threshold = 32;
+
+    flat_map() : flat_map(allocator_type{}) {}
+
+    explicit flat_map(allocator_type const &allocator) :
+        _items(allocator), _tags(tag_allocator_type(allocator)), _index(index_allocator_type(allocator))
+    {
+    }
+
+    flat_map(flat_map const &other) = default;
+    flat_map(flat_map &&other) noexcept = default;
+    flat_map &operator=(flat_map const &other) = default;
+    flat_map &operator=(flat_map &&other) = default;
+
+    flat_map(flat_map const &other, allocator_type const &allocator) :
+        _items(other._items, allocator),
+        _tags(other._tags, tag_allocator_type(allocator)),
+        _index(other._index, index_allocator_type(allocator))
+    {
+    }
+
+    flat_map(flat_map &&other, allocator_type const &allocator) :
+        _items(std::move(other._items), allocator),
+        _tags(std::move(other._tags), tag_allocator_type(allocator)),
+        _index(std::move(other._index), index_allocator_type(allocator))
+    {
+    }
+
+    flat_map(std::initializer_list<value_type> init, allocator_type const &allocator = allocator_type{}) :
+        flat_map(allocator)
+    {
+        reserve(init.size());
+        for (ttlet &item : init) {
+            insert(item);
+        }
+    }
+
+    [[nodiscard]] allocator_type get_allocator() const noexcept
+    {
+        return _items.get_allocator();
+    }
+
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return _items.size();
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return _items.empty();
+    }
+
+    [[nodiscard]] iterator begin() noexcept
+    {
+        return _items.begin();
+    }
+
+    [[nodiscard]] const_iterator begin() const noexcept
+    {
+        return _items.begin();
+    }
+
+    [[nodiscard]] const_iterator cbegin() const noexcept
+    {
+        return _items.cbegin();
+    }
+
+    [[nodiscard]] iterator end() noexcept
+    {
+        return _items.end();
+    }
+
+    [[nodiscard]] const_iterator end() const noexcept
+    {
+        return _items.end();
+    }
+
+    [[nodiscard]] const_iterator cend() const noexcept
+    {
+        return _items.cend();
+    }
+
+    void clear() noexcept
+    {
+        _items.clear();
+        _tags.clear();
+        _index.clear();
+    }
+
+    void reserve(size_t new_capacity)
+    {
+        _items.reserve(new_capacity);
+        _tags.reserve(new_capacity);
+    }
+
+    [[nodiscard]] iterator find(key_type const &key) noexcept
+    {
+        return _items.begin() + find_index(key, mix(_hash(key)));
+    }
+
+    [[nodiscard]] const_iterator find(key_type const &key) const noexcept
+    {
+        return _items.begin() + find_index(key, mix(_hash(key)));
+    }
+
+    [[nodiscard]] bool contains(key_type const &key) const noexcept
+    {
+        return find(key) != end();
+    }
+
+    [[nodiscard]] size_t count(key_type const &key) const noexcept
+    {
+        return contains(key) ? 1 : 0;
+    }
+
+    /** Get the value of an item.
+     *
+     * @throw std::out_of_range When the key is not in the map.
+     */
+    [[nodiscard]] mapped_type &at(key_type const &key)
+    {
+        ttlet i = find(key);
+        if (i == end()) {
+            throw std::out_of_range("flat_map::at");
+        }
+        return i->second;
+    }
+
+    /** Get the value of an item.
+     *
+     * @throw std::out_of_range When the key is not in the map.
+     */
+    [[nodiscard]] mapped_type const &at(key_type const &key) const
+    {
+        ttlet i = find(key);
+        if (i == end()) {
+            throw std::out_of_range("flat_map::at");
+        }
+        return i->second;
+    }
+
+    mapped_type &operator[](key_type const &key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    mapped_type &operator[](key_type &&key)
+    {
+        return try_emplace(std::move(key)).first->second;
+    }
+
+    /** Insert an item if the key is not yet in the map.
+     *
+     * @return An iterator to the item with the key, and true if the item was inserted.
+     */
+    template<typename K, typename... Args>
+    std::pair<iterator, bool> try_emplace(K &&key, Args &&...args)
+    {
+        ttlet hash = mix(_hash(key));
+        ttlet i = find_index(key, hash);
+        if (i != size()) {
+            return {_items.begin() + i, false};
+        }
+
+        _items.emplace_back(
+            std::piecewise_construct,
+            std::forward_as_tuple(std::forward<K>(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+        push_back_tag(hash);
+        return {_items.end() - 1, true};
+    }
+
+    template<typename M>
+    std::pair<iterator, bool> insert_or_assign(key_type const &key, M &&value)
+    {
+        auto r = try_emplace(key, std::forward<M>(value));
+        if (!r.second) {
+            r.first->second = std::forward<M>(value);
+        }
+        return r;
+    }
+
+    template<typename M>
+    std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&value)
+    {
+        auto r = try_emplace(std::move(key), std::forward<M>(value));
+        if (!r.second) {
+            r.first->second = std::forward<M>(value);
+        }
+        return r;
+    }
+
+    std::pair<iterator, bool> insert(value_type const &item)
+    {
+        return try_emplace(item.first, item.second);
+    }
+
+    std::pair<iterator, bool> insert(value_type &&item)
+    {
+        return try_emplace(std::move(item.first), std::move(item.second));
+    }
+
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(Args &&...args)
+    {
+        auto item = value_type(std::forward<Args>(args)...);
+        return insert(std::move(item));
+    }
+
+    /** Erase an item; the order of the other items is retained.
+     *
+     * @return An iterator to the item after the erased item.
+     */
+    iterator erase(const_iterator pos)
+    {
+        ttlet i = std::distance(_items.cbegin(), pos);
+        _tags.erase(_tags.begin() + i);
+        auto r = _items.erase(pos);
+        build_index();
+        return r;
+    }
+
+    size_t erase(key_type const &key)
+    {
+        ttlet i = find(key);
+        if (i == end()) {
+            return 0;
+        }
+        erase(i);
+        return 1;
+    }
+
+    /** Compare two maps, the order of the items is ignored.
+     */
+    [[nodiscard]] friend bool operator==(flat_map const &lhs, flat_map const &rhs) noexcept
+    {
+        if (lhs.size() != rhs.size()) {
+            return false;
+        }
+        for (ttlet &item : lhs) {
+            ttlet i = rhs.find(item.first);
+            if (i == rhs.end() || !(i->second == item.second)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    items_type _items;
+
+    /** The tag of the key of each item; the top 8 bits of the mixed hash.
+     */
+    std::vector<uint8_t, tag_allocator_type> _tags;
+
+    /** Open-addressing hash table of item indices, plus one so that zero is an empty slot.
+     * The table is empty when the map has `index_threshold` or fewer items.
+     */
+    std::vector<uint32_t, index_allocator_type> _index;
+
+    [[no_unique_address]] hasher _hash;
+    [[no_unique_address]] key_equal _key_equal;
+
+    /** Spread the bits of the hash, since std::hash of integers may be the identity function.
+     */
+    [[nodiscard]] static uint64_t mix(size_t hash) noexcept
+    {
+        return static_cast<uint64_t>(hash) * 0x9e37'79b9'7f4a'7c15ULL;
+    }
+
+    [[nodiscard]] static uint8_t make_tag(uint64_t hash) noexcept
+    {
+        return static_cast<uint8_t>(hash >> 56);
+    }
+
+    [[nodiscard]] size_t index_mask() const noexcept
+    {
+        return _index.size() - 1;
+    }
+
+    [[nodiscard]] static size_t index_start(uint64_t hash) noexcept
+    {
+        return static_cast<size_t>(hash >> 24);
+    }
+
+    /** Find the index of the item with the key.
+     *
+     * @return The index of the item, or `size()` when not found.
+     */
+    template<typename K>
+    [[nodiscard]] size_t find_index(K const &key, uint64_t hash) const noexcept
+    {
+        ttlet tag = make_tag(hash);
+
+        if (_index.empty()) {
+            return find_linear(key, tag);
+        }
+
+        for (auto slot = index_start(hash) & index_mask(); _index[slot] != 0; slot = (slot + 1) & index_mask()) {
+            ttlet i = _index[slot] - 1;
+            if (_tags[i] == tag && _key_equal(_items[i].first, key)) {
+                return i;
+            }
+        }
+        return size();
+    }
+
+    template<typename K>
+    [[nodiscard]] size_t find_linear(K const &key, uint8_t tag) const noexcept
+    {
+        ttlet size_ = size();
+        size_t i = 0;
+
+#if TT_X86_64_V2
+        ttlet tag_ = _mm_set1_epi8(static_cast<char>(tag));
+        for (; i + 16 <= size_; i += 16) {
+            ttlet tags = _mm_loadu_si128(reinterpret_cast<__m128i const *>(_tags.data() + i));
+            auto match_mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(tags, tag_)));
+            while (match_mask != 0) {
+                ttlet j = i + std::countr_zero(match_mask);
+                if (_key_equal(_items[j].first, key)) {
+                    return j;
+                }
+                match_mask &= match_mask - 1;
+            }
+        }
+#endif
+
+        for (; i != size_; ++i) {
+            if (_tags[i] == tag && _key_equal(_items[i].first, key)) {
+                return i;
+            }
+        }
+        return size_;
+    }
+
+    void insert_index(size_t i, uint64_t hash) noexcept
+    {
+        auto slot = index_start(hash) & index_mask();
+        while (_index[slot] != 0) {
+            slot = (slot + 1) & index_mask();
+        }
+        _index[slot] = static_cast<uint32_t>(i + 1);
+    }
+
+    /** Add the tag of the last inserted item, and add it to the index.
+     */
+    void push_back_tag(uint64_t hash)
+    {
+        try {
+            _tags.push_back(make_tag(hash));
+        } catch (...) {
+            _items.pop_back();
+            throw;
+        }
+
+        if (size() * 2 > _index.size()) {
+            // The index is not used, or it is more than half full.
+            build_index();
+        } else {
+            insert_index(size() - 1, hash);
+        }
+    }
+
+    /** Build or remove the index, depending on the number of items.
+     */
+    void build_index()
+    {
+        _index.clear();
+        if (size() <= index_threshold) {
+            return;
+        }
+
+        _index.resize(std::bit_ceil(size() * 2));
+        for (size_t i = 0; i != size(); ++i) {
+            insert_index(i, mix(_hash(_items[i].first)));
+        }
+    }
+};
+
+} // namespace tt
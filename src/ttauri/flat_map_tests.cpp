@@ -0,0 +1,96 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/flat_map.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <memory_resource>
+
+using namespace std;
+using namespace tt;
+
+TEST(FlatMap, InsertionOrder)
+{
+    flat_map<std::string, int> items;
+    ASSERT_TRUE(items.empty());
+
+    ASSERT_TRUE(items.try_emplace("foo", 1).second);
+    ASSERT_TRUE(items.try_emplace("bar", 2).second);
+    ASSERT_FALSE(items.try_emplace("foo", 3).second);
+    items["baz"] = 4;
+    items.insert_or_assign("bar", 5);
+    ASSERT_EQ(items.size(), 3);
+
+    auto i = items.begin();
+    ASSERT_EQ(i->first, "foo");
+    ASSERT_EQ(i->second, 1);
+    ++i;
+    ASSERT_EQ(i->first, "bar");
+    ASSERT_EQ(i->second, 5);
+    ++i;
+    ASSERT_EQ(i->first, "baz");
+    ASSERT_EQ(i->second, 4);
+    ++i;
+    ASSERT_EQ(i, items.end());
+
+    ASSERT_EQ(items.at("baz"), 4);
+    ASSERT_TRUE(items.contains("foo"));
+    ASSERT_FALSE(items.contains("qux"));
+    ASSERT_EQ(items.find("qux"), items.end());
+    ASSERT_THROW((void)items.at("qux"), std::out_of_range);
+
+    ASSERT_EQ(items.erase("foo"), 1);
+    ASSERT_EQ(items.erase("foo"), 0);
+    ASSERT_EQ(items.size(), 2);
+    ASSERT_EQ(items.begin()->first, "bar");
+    ASSERT_EQ(items.at("baz"), 4);
+}
+
+TEST(FlatMap, Equality)
+{
+    ttlet a = flat_map<int, int>{{1, 10}, {2, 20}};
+    ttlet b = flat_map<int, int>{{2, 20}, {1, 10}};
+    ttlet c = flat_map<int, int>{{1, 10}, {2, 21}};
+    ASSERT_EQ(a, b);
+    ASSERT_NE(a, c);
+}
+
+TEST(FlatMap, Large)
+{
+    // More items than index_threshold, so that the hash table is used.
+    flat_map<int, int> items;
+    for (int i = 0; i != 1000; ++i) {
+        items[i * 7] = i;
+    }
+    ASSERT_EQ(items.size(), 1000);
+
+    for (int i = 0; i != 1000; ++i) {
+        ASSERT_EQ(items.at(i * 7), i);
+        ASSERT_FALSE(items.contains(i * 7 + 1));
+    }
+
+    // Erase down to below the threshold; the order of the remaining items is retained.
+    for (int i = 0; i != 990; ++i) {
+        items.erase(i * 7);
+    }
+    ASSERT_EQ(items.size(), 10);
+    ASSERT_EQ(items.begin()->first, 990 * 7);
+    for (int i = 990; i != 1000; ++i) {
+        ASSERT_EQ(items.at(i * 7), i);
+    }
+}
+
+TEST(FlatMap, Allocator)
+{
+    auto arena = std::pmr::monotonic_buffer_resource{};
+    auto items = flat_map<int, int, std::hash<int>, std::equal_to<int>, std::pmr::polymorphic_allocator<std::pair<int, int>>>(&arena);
+    for (int i = 0; i != 100; ++i) {
+        items[i] = i * 2;
+    }
+    ASSERT_EQ(items.get_allocator().resource(), &arena);
+
+    auto copy = decltype(items)(items, std::pmr::get_default_resource());
+    ASSERT_EQ(copy.get_allocator().resource(), std::pmr::get_default_resource());
+    ASSERT_EQ(copy, items);
+}
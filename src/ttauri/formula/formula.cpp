@@ -68,21 +68,21 @@ namespace tt {
 
 static std::unique_ptr<formula_node> parse_formula_1(formula_parse_context& context, std::unique_ptr<formula_node> lhs, uint8_t min_precedence);
 
-[[nodiscard]] std::pair<uint8_t,bool> operator_precedence(token_t const &token, bool binary) noexcept {
+[[nodiscard]] std::pair<uint8_t,bool> operator_precedence(token_view const &token, bool binary) noexcept {
     if (token != tokenizer_name_t::Operator) {
         return {uint8_t{0}, false};
     } else {
-        auto [precedence, left_to_right] = operator_precedence(token.value.data(), binary);
+        auto [precedence, left_to_right] = operator_precedence(token.value, binary);
         return {static_cast<uint8_t>(std::numeric_limits<uint8_t>::max() - precedence), left_to_right};
     }
 }
 
 static std::unique_ptr<formula_node> parse_operation_formula(
-    formula_parse_context& context, std::unique_ptr<formula_node> lhs, token_t const& op, std::unique_ptr<formula_node> rhs
+    formula_parse_context& context, std::unique_ptr<formula_node> lhs, token_view const& op, std::unique_ptr<formula_node> rhs
 ) {
     if (lhs) {
         // Binary operator
-        switch (operator_to_int(op.value.data())) {
+        switch (operator_to_int(op.value)) {
         case operator_to_int("."): return std::make_unique<formula_member_node>(op.location, std::move(lhs), std::move(rhs));
         case operator_to_int("**"): return std::make_unique<formula_pow_node>(op.location, std::move(lhs), std::move(rhs));
         case operator_to_int("*"): return std::make_unique<formula_mul_node>(op.location, std::move(lhs), std::move(rhs));
@@ -123,7 +123,7 @@ static std::unique_ptr<formula_node> parse_operation_formula(
         }
     } else {
         // Unary operator
-        switch (operator_to_int(op.value.data())) {
+        switch (operator_to_int(op.value)) {
         case operator_to_int("+"): return std::make_unique<formula_plus_node>(op.location, std::move(rhs));
         case operator_to_int("-"): return std::make_unique<formula_minus_node>(op.location, std::move(rhs));
         case operator_to_int("~"): return std::make_unique<formula_invert_node>(op.location, std::move(rhs));
@@ -147,17 +147,27 @@ static std::unique_ptr<formula_node> parse_operation_formula(
     */
 static std::unique_ptr<formula_node> parse_primary_formula(formula_parse_context& context)
 {
-    ttlet &location = context->location;
+    // A copy, the current token is replaced when the context is incremented.
+    ttlet location = context->location;
 
     switch (context->name) {
-    case tokenizer_name_t::IntegerLiteral:
-        return std::make_unique<formula_literal_node>(location, static_cast<long long>(*context++));
+    case tokenizer_name_t::IntegerLiteral: {
+        auto value = static_cast<long long>(*context);
+        ++context;
+        return std::make_unique<formula_literal_node>(location, std::move(value));
+    }
 
-    case tokenizer_name_t::FloatLiteral:
-        return std::make_unique<formula_literal_node>(location, static_cast<double>(*context++));
+    case tokenizer_name_t::FloatLiteral: {
+        auto value = static_cast<double>(*context);
+        ++context;
+        return std::make_unique<formula_literal_node>(location, std::move(value));
+    }
 
-    case tokenizer_name_t::StringLiteral:
-        return std::make_unique<formula_literal_node>(location, static_cast<std::string>(*context++));
+    case tokenizer_name_t::StringLiteral: {
+        auto value = static_cast<std::string>(*context);
+        ++context;
+        return std::make_unique<formula_literal_node>(location, std::move(value));
+    }
 
     case tokenizer_name_t::Name:
         if (*context == "true") {
@@ -177,7 +187,9 @@ static std::unique_ptr<formula_node> parse_primary_formula(formula_parse_context
             return std::make_unique<formula_literal_node>(location, datum{});
 
         } else {
-            return std::make_unique<formula_name_node>(location, (context++)->value);
+            ttlet name = context->value;
+            ++context;
+            return std::make_unique<formula_name_node>(location, name);
         }
 
     case tokenizer_name_t::Operator:
@@ -340,7 +352,7 @@ static bool parse_formula_is_at_end(formula_parse_context& context)
  */
 static std::unique_ptr<formula_node> parse_formula_1(formula_parse_context& context, std::unique_ptr<formula_node> lhs, uint8_t min_precedence)
 {
-    token_t lookahead;
+    token_view lookahead;
     uint8_t lookahead_precedence;
     bool lookahead_left_to_right;
 
@@ -8,13 +8,155 @@
 #include "../datum.hpp"
 #include "../exception.hpp"
 #include <unordered_map>
+#include <optional>
+#include <cstdint>
 #include <vector>
 #include <string_view>
 
 namespace tt {
 
+/** The layout of the local variables of a function or block.
+ * While the function is post-processed each variable used inside of it is given a slot.
+ */
+struct formula_frame {
+    std::vector<std::string> names;
+
+    [[nodiscard]] ssize_t find(std::string_view name) const noexcept {
+        for (ssize_t i = 0; i != std::ssize(names); ++i) {
+            if (names[i] == name) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    /** Find or add the slot for a variable.
+     */
+    size_t add(std::string const &name) {
+        ttlet i = find(name);
+        if (i >= 0) {
+            return static_cast<size_t>(i);
+        }
+
+        names.push_back(name);
+        return names.size() - 1;
+    }
+};
+
+/** The location of a variable, resolved while post-processing a formula.
+ * Accessing a local variable through its slot is an array index, instead of a hash-table lookup.
+ * Global variables, and local variables of a scope which does not match the frame
+ * the variable was resolved for, are looked up by name.
+ */
+struct formula_slot {
+    enum class kind_type : uint8_t {
+        /** Unresolved, the variable is looked up by name.
+         */
+        name,
+
+        /** A variable inside a function; a local variable in `frame`, falling back to a global variable.
+         */
+        local,
+
+        /** A loop variable such as `$i` or `$$first`.
+         */
+        loop
+    };
+
+    enum class loop_field_type : uint8_t { count, first, size, last };
+
+    kind_type kind = kind_type::name;
+    loop_field_type loop_field = loop_field_type::count;
+
+    /** The number of loops to skip, one less than the number of '$' in the name.
+     */
+    uint16_t loop_depth = 0;
+
+    uint32_t local = 0;
+    formula_frame const *frame = nullptr;
+};
+
 struct formula_evaluation_context {
-    using scope = std::unordered_map<std::string, datum>;
+    /** The variables of a function-call, or the global variables.
+     * Only the variables of a function-call have a frame.
+     */
+    struct scope {
+        /** The layout of the slots, nullptr when all variables are stored by name.
+         */
+        formula_frame const *frame = nullptr;
+
+        /** Variables by slot, an empty slot has not been assigned yet.
+         */
+        std::vector<std::optional<datum>> slots;
+
+        /** Variables without a slot in the frame.
+         */
+        std::unordered_map<std::string, datum> names;
+
+        scope() noexcept = default;
+        explicit scope(formula_frame const *frame) : frame(frame), slots(frame != nullptr ? frame->names.size() : 0) {}
+
+        [[nodiscard]] datum const *find(size_t slot) const noexcept {
+            if (slot < slots.size() && slots[slot]) {
+                return &*slots[slot];
+            } else {
+                return nullptr;
+            }
+        }
+
+        [[nodiscard]] datum *find(size_t slot) noexcept {
+            if (slot < slots.size() && slots[slot]) {
+                return &*slots[slot];
+            } else {
+                return nullptr;
+            }
+        }
+
+        datum &set(size_t slot, datum const &value) {
+            if (slot >= slots.size()) {
+                slots.resize(slot + 1);
+            }
+            return *(slots[slot] = value);
+        }
+
+        [[nodiscard]] datum const *find(std::string const &name) const noexcept {
+            if (frame != nullptr) {
+                ttlet slot = frame->find(name);
+                if (slot >= 0) {
+                    return find(static_cast<size_t>(slot));
+                }
+            }
+
+            ttlet i = names.find(name);
+            return i != names.end() ? &i->second : nullptr;
+        }
+
+        [[nodiscard]] datum *find(std::string const &name) noexcept {
+            if (frame != nullptr) {
+                ttlet slot = frame->find(name);
+                if (slot >= 0) {
+                    return find(static_cast<size_t>(slot));
+                }
+            }
+
+            ttlet i = names.find(name);
+            return i != names.end() ? &i->second : nullptr;
+        }
+
+        datum &set(std::string const &name, datum const &value) {
+            if (frame != nullptr) {
+                ttlet slot = frame->find(name);
+                if (slot >= 0) {
+                    return set(static_cast<size_t>(slot), value);
+                }
+            }
+
+            return names[name] = value;
+        }
+
+        [[nodiscard]] friend bool operator==(scope const &lhs, scope const &rhs) noexcept = default;
+    };
+
     using stack = std::vector<scope>;
 
     ssize_t output_disable_count = 0;
@@ -88,8 +230,11 @@ struct formula_evaluation_context {
         loop_stack.pop_back();
     }
 
-    void push() {
-        local_stack.emplace_back();
+    /** Push a new scope for the local variables of a function.
+     * @param frame The layout of the local variables, resolved during post-processing.
+     */
+    void push(formula_frame const *frame = nullptr) {
+        local_stack.emplace_back(frame);
         loop_push();
     }
 
@@ -113,41 +258,80 @@ struct formula_evaluation_context {
         return local_stack.back();
     }
 
-    [[nodiscard]] datum const &loop_get(std::string_view name) const {
-        tt_axiom(name.size() > 0);
-        if (name.back() == '$') {
-            throw operation_error("Invalid loop variable '{}'", name);
+    /** Resolve the name of a loop variable such as `$i` or `$$first`.
+     * @return The slot of the loop variable, or empty if the name is not a valid loop variable.
+     */
+    [[nodiscard]] static std::optional<formula_slot> loop_slot(std::string_view name) noexcept {
+        if (name.size() < 2 || name.front() != '$' || name.back() == '$') {
+            return {};
         }
 
-        std::string_view short_name = name.substr(1);
-        auto i = loop_stack.crbegin();
+        auto r = formula_slot{};
+        r.kind = formula_slot::kind_type::loop;
 
+        std::string_view short_name = name.substr(1);
         while (short_name[0] == '$') {
-            if (i == loop_stack.crend() || i->count.is_undefined()) {
-                throw operation_error("Accessing loop variable {} while not in loop", name);
-            }
-
             short_name = short_name.substr(1);
-            i++;
+            ++r.loop_depth;
         }
 
         if (short_name == "i" || short_name == "count") {
-            return i->count;
+            r.loop_field = formula_slot::loop_field_type::count;
         } else if (short_name == "first") {
-            return i->first;
+            r.loop_field = formula_slot::loop_field_type::first;
         } else if (short_name == "size" || short_name == "length") {
-            if (i->size.is_undefined()) {
+            r.loop_field = formula_slot::loop_field_type::size;
+        } else if (short_name == "last") {
+            r.loop_field = formula_slot::loop_field_type::last;
+        } else {
+            return {};
+        }
+        return r;
+    }
+
+    [[nodiscard]] datum const &loop_get(formula_slot const &slot, std::string_view name) const {
+        tt_axiom(slot.kind == formula_slot::kind_type::loop);
+
+        if (slot.loop_depth >= loop_stack.size()) {
+            throw operation_error("Accessing loop variable {} while not in loop", name);
+        }
+
+        // The loops that are skipped over must be actual loops.
+        for (size_t depth = 0; depth != slot.loop_depth; ++depth) {
+            if (loop_stack[loop_stack.size() - 1 - depth].count.is_undefined()) {
+                throw operation_error("Accessing loop variable {} while not in loop", name);
+            }
+        }
+
+        ttlet &info = loop_stack[loop_stack.size() - 1 - slot.loop_depth];
+        switch (slot.loop_field) {
+        case formula_slot::loop_field_type::count: return info.count;
+        case formula_slot::loop_field_type::first: return info.first;
+        case formula_slot::loop_field_type::size:
+            if (info.size.is_undefined()) {
                 throw operation_error("Accessing loop variable {} only available in #for loops", name);
             }
-            return i->size;
-        } else if (short_name == "last") {
-            if (i->last.is_undefined()) {
+            return info.size;
+        case formula_slot::loop_field_type::last:
+            if (info.last.is_undefined()) {
                 throw operation_error("Accessing loop variable {} only available in #for loops", name);
             }
-            return i->last;
-        } else {
+            return info.last;
+        default: tt_no_default();
+        }
+    }
+
+    [[nodiscard]] datum const &loop_get(std::string_view name) const {
+        tt_axiom(name.size() > 0);
+        if (name.back() == '$') {
+            throw operation_error("Invalid loop variable '{}'", name);
+        }
+
+        ttlet slot = loop_slot(name);
+        if (!slot) {
             throw operation_error("Unknown loop variable {}", name);
         }
+        return loop_get(*slot, name);
     }
 
     [[nodiscard]] datum const& get(std::string const &name) const {
@@ -158,15 +342,13 @@ struct formula_evaluation_context {
         }
 
         if (has_locals()) {
-            ttlet i = locals().find(name);
-            if (i != locals().end()) {
-                return i->second;
+            if (ttlet r = locals().find(name)) {
+                return *r;
             }
         }
 
-        ttlet j = globals.find(name);
-        if (j != globals.end()) {
-            return j->second;
+        if (ttlet r = globals.find(name)) {
+            return *r;
         }
 
         throw operation_error("Could not find {} in local or global scope.", name);
@@ -176,35 +358,80 @@ struct formula_evaluation_context {
         tt_assert(name.size() > 0);
 
         if (has_locals()) {
-            ttlet i = locals().find(name);
-            if (i != locals().end()) {
-                return i->second;
+            if (ttlet r = locals().find(name)) {
+                return *r;
             }
         }
 
-        ttlet j = globals.find(name);
-        if (j != globals.end()) {
-            return j->second;
+        if (ttlet r = globals.find(name)) {
+            return *r;
         }
 
         throw operation_error("Could not find {} in local or global scope.", name);
     }
 
+    /** Get a variable through its resolved slot.
+     * Falls back to looking up the variable by name.
+     */
+    [[nodiscard]] datum const &get(formula_slot const &slot, std::string const &name) const {
+        switch (slot.kind) {
+        case formula_slot::kind_type::local:
+            if (has_locals() && locals().frame == slot.frame) {
+                if (ttlet r = locals().find(slot.local)) {
+                    return *r;
+                } else if (ttlet g = globals.find(name)) {
+                    return *g;
+                }
+                throw operation_error("Could not find {} in local or global scope.", name);
+            }
+            break;
+
+        case formula_slot::kind_type::loop: return loop_get(slot, name);
+        case formula_slot::kind_type::name: break;
+        }
+
+        return get(name);
+    }
+
+    [[nodiscard]] datum &get(formula_slot const &slot, std::string const &name) {
+        if (slot.kind == formula_slot::kind_type::local && has_locals() && locals().frame == slot.frame) {
+            if (ttlet r = locals().find(slot.local)) {
+                return *r;
+            } else if (ttlet g = globals.find(name)) {
+                return *g;
+            }
+            throw operation_error("Could not find {} in local or global scope.", name);
+        }
+
+        return get(name);
+    }
+
     template<typename T>
     void set_local(std::string const &name, T &&value) {
-        locals()[name] = std::forward<T>(value);
+        locals().set(name, datum{std::forward<T>(value)});
     }
 
     template<typename T>
     void set_global(std::string const& name, T &&value) {
-        globals[name] = std::forward<T>(value);
+        globals.set(name, datum{std::forward<T>(value)});
     }
 
     datum &set(std::string const &name, datum const &value) {
         if (has_locals()) {
-            return locals()[name] = value;
+            return locals().set(name, value);
+        } else {
+            return globals.set(name, value);
+        }
+    }
+
+    /** Set a variable through its resolved slot.
+     * Falls back to setting the variable by name.
+     */
+    datum &set(formula_slot const &slot, std::string const &name, datum const &value) {
+        if (slot.kind == formula_slot::kind_type::local && has_locals() && locals().frame == slot.frame) {
+            return locals().set(slot.local, value);
         } else {
-            return globals[name] = value;
+            return set(name, value);
         }
     }
 };
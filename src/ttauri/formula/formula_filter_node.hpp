@@ -24,7 +24,8 @@ struct formula_filter_node final : formula_binary_operator_node {
     }
 
     void post_process(formula_post_process_context& context) override {
-        formula_binary_operator_node::post_process(context);
+        // The right hand side is the name of a filter, not a variable.
+        lhs->post_process(context);
 
         filter = context.get_filter(rhs_name->name);
         if (!filter) {
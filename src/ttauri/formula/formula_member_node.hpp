@@ -21,7 +21,15 @@ struct formula_member_node final : formula_binary_operator_node {
         }
     }
 
+    /** The right hand side is the name of a member, not a variable.
+     */
+    void post_process(formula_post_process_context& context) override {
+        lhs->post_process(context);
+    }
+
     void resolve_function_pointer(formula_post_process_context& context) override {
+        lhs->post_process(context);
+
         method = context.get_method(rhs_name->name);
         if (!method) {
             throw parse_error("{}: Could not find method .{}().", location, rhs_name->name);
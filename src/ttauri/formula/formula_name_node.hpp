@@ -12,9 +12,17 @@ struct formula_name_node final : formula_node {
     std::string name;
     mutable formula_post_process_context::function_type function;
 
+    /** The location of the variable, resolved during post-processing.
+     */
+    formula_slot slot;
+
     formula_name_node(parse_location location, std::string_view name) :
         formula_node(std::move(location)), name(name) {}
 
+    void post_process(formula_post_process_context& context) override {
+        slot = context.resolve_variable(name);
+    }
+
     void resolve_function_pointer(formula_post_process_context& context) override {
         function = context.get_function(name);
         if (!function) {
@@ -26,7 +34,7 @@ struct formula_name_node final : formula_node {
         ttlet &const_context = context;
 
         try {
-            return const_context.get(name);
+            return const_context.get(slot, name);
         } catch (std::exception const &e) {
             throw operation_error("{}: Can not evaluate function.\n{}", location, e.what());
         }
@@ -34,7 +42,7 @@ struct formula_name_node final : formula_node {
 
     datum &evaluate_lvalue(formula_evaluation_context& context) const override {
         try {
-            return context.get(name);
+            return context.get(slot, name);
         } catch (std::exception const &e) {
             throw operation_error("{}: Can not evaluate function.\n{}", location, e.what());
         }
@@ -48,7 +56,7 @@ struct formula_name_node final : formula_node {
     */
     datum const &evaluate_xvalue(formula_evaluation_context const& context) const override {
         try {
-            return context.get(name);
+            return context.get(slot, name);
         } catch (std::exception const &e) {
             throw operation_error("{}: Can not evaluate function.\n{}", location, e.what());
         }
@@ -56,7 +64,7 @@ struct formula_name_node final : formula_node {
 
     datum &assign(formula_evaluation_context& context, datum const &rhs) const override {
         try {
-            return context.set(name, rhs);
+            return context.set(slot, name, rhs);
         } catch (std::exception const &e) {
             throw operation_error("{}: Can not evaluate function.\n{}", location, e.what());
         }
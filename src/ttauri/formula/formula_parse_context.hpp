@@ -6,43 +6,35 @@
 
 #include "../required.hpp"
 #include "../tokenizer.hpp"
-#include <vector>
 #include <string_view>
 
 namespace tt {
 
 struct formula_parse_context {
-    using const_iterator = typename std::vector<token_t>::const_iterator;
-
     std::string_view::const_iterator first;
     std::string_view::const_iterator last;
 
-    std::vector<token_t> tokens;
-    const_iterator token_it;
+    /** The tokens are parsed on demand, while the formula is being parsed.
+     * The values of the tokens are views into the text.
+     */
+    lazy_tokenizer tokens;
 
     formula_parse_context(std::string_view::const_iterator first, std::string_view::const_iterator last) :
-        first(first), last(last), tokens(parseTokens(first, last)), token_it(tokens.begin()) {}
+        first(first), last(last), tokens(std::string_view{first, last}) {}
 
-    [[nodiscard]] token_t const& operator*() const noexcept {
-        return *token_it;
+    [[nodiscard]] token_view const& operator*() const noexcept {
+        return *tokens;
     }
 
-    [[nodiscard]] token_t const *operator->() const noexcept {
-        return &(*token_it);
+    [[nodiscard]] token_view const *operator->() const noexcept {
+        return tokens.operator->();
     }
 
     formula_parse_context& operator++() noexcept {
-        tt_axiom(token_it != tokens.end());
-        tt_axiom(*token_it != tokenizer_name_t::End);
-        ++token_it;
+        tt_axiom(*tokens != tokenizer_name_t::End);
+        ++tokens;
         return *this;
     }
-
-    formula_parse_context operator++(int) noexcept {
-        auto tmp = *this;
-        ++(*this);
-        return tmp;
-    }
 };
 
-}
\ No newline at end of file
+}
@@ -8,6 +8,7 @@
 #include "../required.hpp"
 #include "../datum.hpp"
 #include "../strings.hpp"
+#include "../cast.hpp"
 #include <functional>
 #include <unordered_map>
 #include <vector>
@@ -27,6 +28,11 @@ struct formula_post_process_context {
 
     function_table functions;
     function_stack super_stack;
+
+    /** The frames of the functions which are being post-processed.
+     */
+    std::vector<formula_frame *> frame_stack;
+
     static function_table global_functions;
     static method_table global_methods;
     static filter_table global_filters;
@@ -68,6 +74,36 @@ struct formula_post_process_context {
         super_stack.pop_back();
     }
 
+    /** Start resolving the variables of a function into the slots of its frame.
+     */
+    void push_frame(formula_frame &frame) noexcept {
+        frame_stack.push_back(&frame);
+    }
+
+    void pop_frame() noexcept {
+        tt_axiom(frame_stack.size() > 0);
+        frame_stack.pop_back();
+    }
+
+    /** Resolve a variable into a slot.
+     * Inside a function the variable is given a slot in the frame of the function,
+     * outside of a function the variable is looked up by name.
+     */
+    [[nodiscard]] formula_slot resolve_variable(std::string const &name) {
+        if (name.size() > 0 && name.front() == '$') {
+            // Invalid loop variables are reported when evaluated.
+            return formula_evaluation_context::loop_slot(name).value_or(formula_slot{});
+        }
+
+        auto r = formula_slot{};
+        if (frame_stack.size() > 0) {
+            r.kind = formula_slot::kind_type::local;
+            r.frame = frame_stack.back();
+            r.local = narrow_cast<uint32_t>(frame_stack.back()->add(name));
+        }
+        return r;
+    }
+
     [[nodiscard]] filter_type get_filter(std::string const &name) const noexcept {
         ttlet i = global_filters.find(name);
         if (i != global_filters.end()) {
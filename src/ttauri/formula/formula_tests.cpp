@@ -36,6 +36,11 @@ TEST(Formula, Literals) {
     ASSERT_EQ(e->string(), "foo");
 }
 
+TEST(Formula, InvalidCharacter) {
+    ASSERT_THROW(parse_formula("x '* 2"), parse_error);
+    ASSERT_THROW(parse_formula("x ' 2"), parse_error);
+}
+
 TEST(Formula, BinaryOperatorsLeftToRightAssociativity) {
     std::unique_ptr<formula_node> e;
     datum r;
@@ -462,3 +467,53 @@ TEST(Formula, Map) {
     ASSERT_NO_THROW(e = parse_formula("{1: 1.1, 2: 2.2, }"));
     ASSERT_EQ(e->string(), "{1: 1.1, 2: 2.2}");
 }
+
+TEST(Formula, Slots) {
+    std::unique_ptr<formula_node> e;
+    ASSERT_NO_THROW(e = parse_formula("a = b + 1"));
+
+    // Resolve the variables as if the formula is part of a function.
+    formula_frame frame;
+    auto post_process_context = formula_post_process_context();
+    post_process_context.push_frame(frame);
+    e->post_process(post_process_context);
+    post_process_context.pop_frame();
+    ASSERT_EQ(frame.names, (std::vector<std::string>{"a", "b"}));
+
+    formula_evaluation_context context;
+    context.set_global("b", 41);
+
+    // 'b' is not a local variable, so it falls back to the global variable.
+    context.push(&frame);
+    ASSERT_EQ(e->evaluate(context), 42);
+    ASSERT_EQ(context.get("a"), 42);
+    context.pop();
+    ASSERT_THROW((void)context.get("a"), operation_error);
+
+    // A scope without the frame, the variables are looked up by name.
+    context.push();
+    context.set_local("b", 1);
+    ASSERT_EQ(e->evaluate(context), 2);
+    ASSERT_EQ(context.get("a"), 2);
+    context.pop();
+
+    // Outside of a function the variables are looked up by name.
+    ASSERT_NO_THROW(e = parse_formula("c = b * 2"));
+    e->post_process(post_process_context);
+    ASSERT_EQ(frame.names.size(), 2);
+    ASSERT_EQ(e->evaluate(context), 82);
+    ASSERT_EQ(context.get("c"), 82);
+
+    ttlet slot = formula_evaluation_context::loop_slot("$$first");
+    ASSERT_TRUE(slot);
+    ASSERT_EQ(slot->loop_depth, 1);
+    ASSERT_EQ(slot->loop_field, formula_slot::loop_field_type::first);
+    ASSERT_FALSE(formula_evaluation_context::loop_slot("$foo"));
+    ASSERT_FALSE(formula_evaluation_context::loop_slot("$i$"));
+
+    ASSERT_NO_THROW(e = parse_formula("$i + $$i * 10"));
+    ASSERT_THROW((void)e->evaluate(context), operation_error);
+    context.loop_push(2);
+    context.loop_push(3);
+    ASSERT_EQ(e->evaluate(context), 23);
+}
@@ -2,11 +2,17 @@
 // Distributed under the Boost Software License, Version 1.0.
 // (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
 
+#pragma once
+
 #include "required.hpp"
 #include "bits.hpp"
 #include "cast.hpp"
+#include "check.hpp"
 #include <span>
 #include <vector>
+#include <algorithm>
+#include <array>
+#include <utility>
 
 namespace tt {
 
@@ -157,6 +163,232 @@ public:
     }
 };
 
+/** A table driven canonical-huffman decoder.
+ *
+ * Instead of walking a tree one bit at a time, this decoder peeks at the
+ * next `primary_bits` bits of the stream and uses them as an index in
+ * the primary table. Codes that are longer than `primary_bits` are resolved
+ * through a second lookup in a sub-table, indexed by the remaining bits of the code.
+ *
+ * The table is build from the same code-lengths as `huffman_tree`, which is kept as
+ * a reference implementation for validating this decoder.
+ */
+template<typename T>
+class huffman_table {
+    static_assert(std::is_integral_v<T> && std::is_signed_v<T>);
+
+public:
+    /** Default number of bits used to index the primary table.
+     */
+    constexpr static int default_primary_bits = 9;
+
+    /** The maximum length of a code in bits.
+     */
+    constexpr static int max_code_length = 15;
+
+    huffman_table() noexcept = default;
+
+    /** Get a symbol from the huffman-table.
+     *
+     * The caller must make sure that at least `max_length()` bits are available
+     * in `bytes` starting at `bit_offset`.
+     *
+     * @param bytes The huffman encoded stream.
+     * @param bit_offset The offset in bits of the next code in the stream, advanced
+     *                   by the length of the code.
+     * @return The decoded symbol.
+     * @throw parse_error on invalid code-bit sequence.
+     */
+    [[nodiscard]] int get_symbol(std::span<std::byte const> bytes, ssize_t &bit_offset) const
+    {
+        ttlet [symbol, length] = lookup(peek_bits(bytes, bit_offset, _max_length));
+        if (length == 0) {
+            throw parse_error("Code not in huffman table.");
+        }
+
+        bit_offset += length;
+        return symbol;
+    }
+
+    /** Get a symbol from the huffman-table.
+     *
+     * The caller must make sure that the reader holds at least
+     * `max_length()` bits, see `bit_reader::refill()`.
+     *
+     * @param reader The reader of the huffman encoded stream.
+     * @return The decoded symbol.
+     * @throw parse_error on invalid code-bit sequence.
+     */
+    [[nodiscard]] int get_symbol(bit_reader &reader) const
+    {
+        tt_axiom(reader.size() >= _max_length);
+
+        ttlet [symbol, length] = lookup(static_cast<uint32_t>(reader.peek()));
+        if (length == 0) {
+            throw parse_error("Code not in huffman table.");
+        }
+
+        reader.skip(length);
+        return symbol;
+    }
+
+    /** Look up a code in the huffman-table.
+     *
+     * When fewer than `max_length()` bits are available, the missing bits
+     * should be zero. The result is only valid if the returned length
+     * is not larger than the number of bits that were available.
+     *
+     * @param code The next bits of the huffman encoded stream, LSB first.
+     * @return The symbol and the length of its code in bits, or a length
+     *         of zero when the code is not in the table.
+     */
+    [[nodiscard]] std::pair<int, int> lookup(uint32_t code) const noexcept
+    {
+        auto e = table[code & _primary_mask];
+        if (e.length < 0) {
+            e = table[e.value + ((code >> _primary_bits) & ((1 << -e.length) - 1))];
+        }
+        return {e.value, e.length};
+    }
+
+    /** The length of the longest code in the table.
+     */
+    [[nodiscard]] int max_length() const noexcept
+    {
+        return _max_length;
+    }
+
+    /** Build a canonical-huffman table from a set of lengths.
+     *
+     * @param lengths The length of the code for each symbol, zero when the symbol is unused.
+     * @param nr_symbols The number of symbols.
+     * @param primary_bits The number of bits used to index the primary table.
+     * @throw parse_error When the code lengths are over-subscribed.
+     */
+    [[nodiscard]] static huffman_table
+    from_lengths(int const *lengths, ssize_t nr_symbols, int primary_bits = default_primary_bits)
+    {
+        tt_axiom(primary_bits >= 1 && primary_bits <= max_code_length);
+
+        // Count the number of codes per code-length.
+        auto length_count = std::array<int, max_code_length + 1>{};
+        auto max_length = 0;
+        for (ssize_t symbol = 0; symbol != nr_symbols; ++symbol) {
+            ttlet length = lengths[symbol];
+            tt_parse_check(length >= 0 && length <= max_code_length, "Huffman code length out of range");
+            ++length_count[length];
+            max_length = std::max(max_length, length);
+        }
+        length_count[0] = 0;
+
+        // Determine the first canonical code of each code-length.
+        auto next_code = std::array<int, max_code_length + 1>{};
+        auto code = 0;
+        for (auto length = 1; length <= max_code_length; ++length) {
+            code = (code + length_count[length - 1]) << 1;
+            next_code[length] = code;
+            tt_parse_check(code + length_count[length] <= (1 << length), "Over-subscribed huffman code lengths");
+        }
+
+        auto r = huffman_table{};
+        r._max_length = max_length;
+        r._primary_bits = std::min(primary_bits, std::max(max_length, 1));
+        r._primary_mask = (1 << r._primary_bits) - 1;
+        r.table.resize(1_uz << r._primary_bits);
+
+        // Find the longest code for each primary index that overflows into a sub-table.
+        auto codes = std::vector<int>(nr_symbols, 0);
+        auto sub_table_bits = std::vector<int>(r.table.size(), 0);
+        for (ssize_t symbol = 0; symbol != nr_symbols; ++symbol) {
+            ttlet length = lengths[symbol];
+            if (length == 0) {
+                continue;
+            }
+
+            ttlet reversed_code = reverse_bits(next_code[length]++, length);
+            codes[symbol] = reversed_code;
+            if (length > r._primary_bits) {
+                auto &bits = sub_table_bits[reversed_code & r._primary_mask];
+                bits = std::max(bits, length - r._primary_bits);
+            }
+        }
+
+        // Allocate the sub-tables behind the primary table.
+        for (size_t i = 0; i != sub_table_bits.size(); ++i) {
+            if (ttlet bits = sub_table_bits[i]) {
+                r.table[i] = entry{narrow_cast<T>(r.table.size()), narrow_cast<int8_t>(-bits)};
+                r.table.resize(r.table.size() + (1_uz << bits));
+            }
+        }
+
+        // Fill in the symbols, repeating each code for every combination of the unused index bits.
+        for (ssize_t symbol = 0; symbol != nr_symbols; ++symbol) {
+            ttlet length = lengths[symbol];
+            if (length == 0) {
+                continue;
+            }
+
+            ttlet reversed_code = codes[symbol];
+            ttlet e = entry{narrow_cast<T>(symbol), narrow_cast<int8_t>(length)};
+
+            if (length <= r._primary_bits) {
+                for (auto i = reversed_code; i < (1 << r._primary_bits); i += 1 << length) {
+                    r.table[i] = e;
+                }
+            } else {
+                ttlet &sub_table = r.table[reversed_code & r._primary_mask];
+                ttlet sub_code = reversed_code >> r._primary_bits;
+                ttlet sub_length = length - r._primary_bits;
+                for (auto i = sub_code; i < (1 << -sub_table.length); i += 1 << sub_length) {
+                    r.table[sub_table.value + i] = e;
+                }
+            }
+        }
+
+        return r;
+    }
+
+    [[nodiscard]] static huffman_table from_lengths(std::vector<int> const &lengths, int primary_bits = default_primary_bits)
+    {
+        return from_lengths(lengths.data(), std::ssize(lengths), primary_bits);
+    }
+
+private:
+    /** An entry in the table.
+     *
+     * - length > 0: value is the symbol, length is the number of bits of the code.
+     * - length < 0: value is the offset of the sub-table, -length is the number of
+     *               bits used to index the sub-table.
+     * - length == 0: The code is not in the table.
+     */
+    struct entry {
+        T value = 0;
+        int8_t length = 0;
+    };
+
+    /** The primary table followed by all the sub-tables.
+     */
+    std::vector<entry> table;
+
+    int _max_length = 0;
+    int _primary_bits = 0;
+    uint32_t _primary_mask = 0;
+
+    /** Reverse the bits of a code.
+     * Huffman codes are stored in the stream starting with the most significant bit,
+     * while the rest of the stream is read least significant bit first.
+     */
+    [[nodiscard]] static int reverse_bits(int code, int length) noexcept
+    {
+        auto r = 0;
+        for (auto i = 0; i != length; ++i) {
+            r = (r << 1) | (code & 1);
+            code >>= 1;
+        }
+        return r;
+    }
+};
+
 
 
 }
@@ -0,0 +1,66 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/huffman.hpp"
+#include "ttauri/file_view.hpp"
+#include "ttauri/required.hpp"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+using namespace tt;
+
+static std::vector<int> fixed_literal_lengths()
+{
+    auto r = std::vector<int>(288, 8);
+    std::fill(r.begin() + 144, r.begin() + 256, 9);
+    std::fill(r.begin() + 256, r.begin() + 280, 7);
+    return r;
+}
+
+static std::vector<int> skewed_lengths()
+{
+    auto r = std::vector<int>{};
+    for (int i = 1; i <= 15; ++i) {
+        r.push_back(i);
+    }
+    r.push_back(15);
+    return r;
+}
+
+/** Decode the compressed bytes of the gzip test data as a stream of huffman codes.
+ */
+template<typename Decoder>
+static void huffman_decode(benchmark::State &state, std::vector<int> const &lengths)
+{
+    ttlet view = file_view(URL("file:gzip_test7.bin.gz"));
+    ttlet bytes = view.bytes();
+    ttlet decoder = Decoder::from_lengths(lengths);
+    ttlet nr_bits = std::ssize(bytes) * 8 - 15;
+
+    int64_t nr_symbols = 0;
+    for (auto _ : state) {
+        ssize_t bit_offset = 0;
+        while (bit_offset < nr_bits) {
+            benchmark::DoNotOptimize(decoder.get_symbol(bytes, bit_offset));
+            ++nr_symbols;
+        }
+    }
+    state.SetItemsProcessed(nr_symbols);
+    state.SetBytesProcessed(state.iterations() * std::ssize(bytes));
+}
+
+static void huffman_tree_decode(benchmark::State &state, std::vector<int> const &lengths)
+{
+    huffman_decode<huffman_tree<int16_t>>(state, lengths);
+}
+
+static void huffman_table_decode(benchmark::State &state, std::vector<int> const &lengths)
+{
+    huffman_decode<huffman_table<int16_t>>(state, lengths);
+}
+
+BENCHMARK_CAPTURE(huffman_tree_decode, fixed, fixed_literal_lengths());
+BENCHMARK_CAPTURE(huffman_table_decode, fixed, fixed_literal_lengths());
+BENCHMARK_CAPTURE(huffman_tree_decode, skewed, skewed_lengths());
+BENCHMARK_CAPTURE(huffman_table_decode, skewed, skewed_lengths());
@@ -0,0 +1,105 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/huffman.hpp"
+#include "ttauri/file_view.hpp"
+#include "ttauri/required.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace tt;
+
+static std::vector<int> fixed_literal_lengths()
+{
+    auto r = std::vector<int>(288, 8);
+    std::fill(r.begin() + 144, r.begin() + 256, 9);
+    std::fill(r.begin() + 256, r.begin() + 280, 7);
+    return r;
+}
+
+/** A complete code with code lengths from 1 up to and including 15 bits.
+ */
+static std::vector<int> skewed_lengths()
+{
+    auto r = std::vector<int>{};
+    for (int i = 1; i <= 15; ++i) {
+        r.push_back(i);
+    }
+    r.push_back(15);
+    return r;
+}
+
+/** Decode a stream with both the tree and the table, and check that both return the same symbols.
+ */
+static void compare_decoders(std::vector<int> const &lengths, std::span<std::byte const> bytes, int primary_bits)
+{
+    ttlet tree = huffman_tree<int16_t>::from_lengths(lengths);
+    ttlet table = huffman_table<int16_t>::from_lengths(lengths, primary_bits);
+
+    ttlet nr_bits = std::ssize(bytes) * 8 - table.max_length();
+    ssize_t tree_offset = 0;
+    ssize_t table_offset = 0;
+    while (tree_offset < nr_bits) {
+        ttlet tree_symbol = tree.get_symbol(bytes, tree_offset);
+        ttlet table_symbol = table.get_symbol(bytes, table_offset);
+        ASSERT_EQ(tree_symbol, table_symbol);
+        ASSERT_EQ(tree_offset, table_offset);
+    }
+}
+
+/** Decode a stream with the bit offset and with the bit reader, and check that both return the same symbols.
+ */
+static void compare_readers(std::vector<int> const &lengths, std::span<std::byte const> bytes)
+{
+    ttlet table = huffman_table<int16_t>::from_lengths(lengths);
+
+    ssize_t offset = 0;
+    auto reader = bit_reader{bytes};
+    while (reader.refill()) {
+        ttlet symbol = table.get_symbol(bytes, offset);
+        ASSERT_EQ(table.get_symbol(reader), symbol);
+    }
+
+    reader.unread();
+    ASSERT_LT(reader.size(), 8);
+    ASSERT_EQ((std::ssize(bytes) - std::ssize(reader.remaining())) * 8 - reader.size(), offset);
+}
+
+TEST(Huffman, FixedLiteralTable)
+{
+    ttlet view = file_view(URL("file:gzip_test4.bin.gz"));
+
+    compare_decoders(fixed_literal_lengths(), view.bytes(), 9);
+    compare_decoders(fixed_literal_lengths(), view.bytes(), 7);
+    compare_readers(fixed_literal_lengths(), view.bytes());
+}
+
+TEST(Huffman, SkewedTable)
+{
+    ttlet view = file_view(URL("file:gzip_test5.bin.gz"));
+
+    compare_decoders(skewed_lengths(), view.bytes(), 9);
+    compare_decoders(skewed_lengths(), view.bytes(), 4);
+    compare_decoders(skewed_lengths(), view.bytes(), 15);
+    compare_readers(skewed_lengths(), view.bytes());
+}
+
+TEST(Huffman, IncompleteTable)
+{
+    // Only a single code '0' of a single bit.
+    ttlet table = huffman_table<int16_t>::from_lengths(std::vector<int>{0, 1});
+    ttlet bytes = std::array<std::byte, 1>{std::byte{0x02}};
+
+    ssize_t offset = 0;
+    ASSERT_EQ(table.get_symbol(bytes, offset), 1);
+    ASSERT_EQ(offset, 1);
+    ASSERT_THROW((void)table.get_symbol(bytes, offset), parse_error);
+}
+
+TEST(Huffman, OverSubscribedTable)
+{
+    ASSERT_THROW((void)huffman_table<int16_t>::from_lengths(std::vector<int>{1, 1, 1}), parse_error);
+}
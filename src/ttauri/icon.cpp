@@ -3,7 +3,7 @@
 // (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
 
 #include "icon.hpp"
-#include "codec/png.hpp"
+#include <chrono>
 
 namespace tt {
 
@@ -14,7 +14,7 @@ icon::icon(pixel_map<sfloat_rgba16> &&image) noexcept : _image(std::move(image))
 
 icon::icon(font_glyph_ids const &image) noexcept : _image(image) {}
 
-icon::icon(URL const &url) : icon(png::load(url)) {}
+icon::icon(URL const &url) noexcept : _image(png_image{url, png_loader::global().load(url)}) {}
 
 icon::icon(elusive_icon const &icon) noexcept : icon(to_font_glyph_ids(icon)) {}
 
@@ -29,6 +29,9 @@ icon::icon(icon const &other) noexcept
     } else if (auto pixmap = std::get_if<pixel_map<sfloat_rgba16>>(&other._image)) {
         _image = pixmap->copy();
 
+    } else if (auto image = std::get_if<png_image>(&other._image)) {
+        _image = *image;
+
     } else if (std::holds_alternative<std::monostate>(other._image)) {
         _image = std::monostate{};
 
@@ -46,6 +49,9 @@ icon &icon::operator=(icon const &other) noexcept
     } else if (auto pixmap = std::get_if<pixel_map<sfloat_rgba16>>(&other._image)) {
         _image = pixmap->copy();
 
+    } else if (auto image = std::get_if<png_image>(&other._image)) {
+        _image = *image;
+
     } else if (std::holds_alternative<std::monostate>(other._image)) {
         _image = std::monostate{};
 
@@ -55,4 +61,35 @@ icon &icon::operator=(icon const &other) noexcept
     return *this;
 }
 
+[[nodiscard]] bool icon::is_loading() const noexcept
+{
+    if (auto image = std::get_if<png_image>(&_image)) {
+        return image->future.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+    } else {
+        return false;
+    }
+}
+
+[[nodiscard]] pixel_map<sfloat_rgba16> const *icon::pixmap() const noexcept
+{
+    if (auto pixmap = std::get_if<pixel_map<sfloat_rgba16>>(&_image)) {
+        return pixmap;
+
+    } else if (auto image = std::get_if<png_image>(&_image)) {
+        if (image->future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return nullptr;
+        }
+
+        try {
+            return image->future.get().get();
+        } catch (...) {
+            // The error was logged by the png_loader.
+            return nullptr;
+        }
+
+    } else {
+        return nullptr;
+    }
+}
+
 } // namespace tt
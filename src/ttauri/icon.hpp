@@ -6,6 +6,7 @@
 
 #include "URL.hpp"
 #include "pixel_map.hpp"
+#include "codec/png_loader.hpp"
 #include "rapid/sfloat_rgba16.hpp"
 #include "text/font_glyph_ids.hpp"
 #include "text/elusive_icon.hpp"
@@ -18,7 +19,11 @@ namespace tt {
  */
 class icon {
 public:
-    icon(URL const &url);
+    /** Load an icon from a PNG file.
+     * The image is decoded asynchronously by `png_loader::global()`, and is shared
+     * with other icons of the same file. This does not wait for the image to be decoded.
+     */
+    icon(URL const &url) noexcept;
     icon(pixel_map<sfloat_rgba16> &&image) noexcept;
     icon(font_glyph_ids const &glyph) noexcept;
     icon(elusive_icon const &icon) noexcept;
@@ -36,6 +41,18 @@ public:
         return !std::holds_alternative<std::monostate>(_image);
     }
 
+    /** Check if the image of the icon is still being decoded.
+     */
+    [[nodiscard]] bool is_loading() const noexcept;
+
+    /** Get the image of the icon.
+     * This does not wait for the image of a PNG file to be decoded.
+     *
+     * @return The image, or nullptr when the icon is not an image, when the image is
+     *         still being decoded, or when the image could not be decoded.
+     */
+    [[nodiscard]] pixel_map<sfloat_rgba16> const *pixmap() const noexcept;
+
     [[nodiscard]] friend bool operator==(icon const &lhs, icon const &rhs) noexcept
     {
         return lhs._image == rhs._image;
@@ -60,7 +77,19 @@ public:
     }
 
 private:
-    using image_type = std::variant<std::monostate, font_glyph_ids, pixel_map<sfloat_rgba16>>;
+    /** An image which is decoded by `png_loader`.
+     */
+    struct png_image {
+        URL url;
+        png_loader::future_type future;
+
+        [[nodiscard]] friend bool operator==(png_image const &lhs, png_image const &rhs) noexcept
+        {
+            return lhs.url == rhs.url;
+        }
+    };
+
+    using image_type = std::variant<std::monostate, font_glyph_ids, pixel_map<sfloat_rgba16>, png_image>;
 
     image_type _image;
 
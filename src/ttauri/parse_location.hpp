@@ -112,9 +112,9 @@ public:
         _column = line_and_column.second - 1;
     }
 
-    void increment_column() noexcept
+    void increment_column(int count = 1) noexcept
     {
-        ++_column;
+        _column += count;
     }
 
     void tab_column() noexcept
@@ -171,7 +171,11 @@ public:
 
     friend std::string to_string(parse_location const &l) noexcept
     {
-        return std::format("{0}:{1}:{2}", l.file(), l.line(), l.column());
+        if (l.has_file()) {
+            return std::format("{0}:{1}:{2}", l.file(), l.line(), l.column());
+        } else {
+            return std::format("{0}:{1}", l.line(), l.column());
+        }
     }
 
     friend std::ostream &operator<<(std::ostream &os, parse_location const &l)
@@ -4,6 +4,7 @@
 
 #include "preferences.hpp"
 #include "codec/JSON.hpp"
+#include "codec/JSON_writer.hpp"
 #include "file.hpp"
 #include "timer.hpp"
 #include "logger.hpp"
@@ -32,11 +33,11 @@ void preferences::save() const noexcept
 
     ttlet tmp_location = _location.urlByAppendingExtension(".tmp");
 
-    auto text = format_JSON(serialize());
-
     try {
         auto file = tt::file(tmp_location, access_mode::truncate_or_create_for_write | access_mode::rename);
-        file.write(text);
+        auto writer = JSON_writer{file};
+        writer.value(serialize());
+        writer.flush();
         file.flush();
         file.rename(_location, true);
 
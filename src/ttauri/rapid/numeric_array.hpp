@@ -908,6 +908,14 @@ public:
 
     [[nodiscard]] friend constexpr numeric_array abs(numeric_array const &rhs) noexcept
     {
+        if (!std::is_constant_evaluated()) {
+            if constexpr (x86_64_v2 and is_i16x8) {
+                return numeric_array{_mm_abs_epi16(rhs.reg())};
+            } else if constexpr (x86_64_v2 and is_i8x16) {
+                return numeric_array{_mm_abs_epi8(rhs.reg())};
+            }
+        }
+
         auto neg_rhs = -rhs;
 
         auto r = numeric_array{};
@@ -1386,6 +1394,10 @@ public:
         if (!std::is_constant_evaluated()) {
             if constexpr (x86_64_v2_5 and lhs.is_f32x8 and rhs.is_f32x8) {
                 return numeric_array{_mm256_add_ps(lhs.reg(), rhs.reg())};
+            } else if constexpr (x86_64_v2 and (is_i16x8 or is_u16x8)) {
+                return numeric_array{_mm_add_epi16(lhs.reg(), rhs.reg())};
+            } else if constexpr (x86_64_v2 and (is_i8x16 or is_u8x16)) {
+                return numeric_array{_mm_add_epi8(lhs.reg(), rhs.reg())};
             }
         }
 
@@ -1485,6 +1497,10 @@ public:
         if (!std::is_constant_evaluated()) {
             if constexpr (x86_64_v2_5 and lhs.is_f32x8 and rhs.is_f32x8) {
                 return numeric_array{_mm256_sub_ps(lhs.reg(), rhs.reg())};
+            } else if constexpr (x86_64_v2 and (is_i16x8 or is_u16x8)) {
+                return numeric_array{_mm_sub_epi16(lhs.reg(), rhs.reg())};
+            } else if constexpr (x86_64_v2 and (is_i8x16 or is_u8x16)) {
+                return numeric_array{_mm_sub_epi8(lhs.reg(), rhs.reg())};
             }
         }
 
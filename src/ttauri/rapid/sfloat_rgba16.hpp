@@ -44,6 +44,13 @@ public:
         return *this;
     }
 
+    /** The red, green, blue and alpha components.
+     */
+    [[nodiscard]] std::array<float16, 4> const &get() const noexcept
+    {
+        return v;
+    }
+
     explicit operator f32x4() const noexcept
     {
         auto tmp = i16x8::load<sizeof(v)>(reinterpret_cast<std::byte const*>(v.data()));
@@ -0,0 +1,111 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/skeleton/skeleton.hpp"
+#include "ttauri/tokenizer.hpp"
+#include "ttauri/cast.hpp"
+#include "ttauri/required.hpp"
+#include <benchmark/benchmark.h>
+#include <string>
+
+using namespace tt;
+
+/** A template with placeholders, statements and string literals, repeated to make a large template.
+ */
+[[nodiscard]] static std::string make_template(benchmark::State &state)
+{
+    auto r = std::string{};
+    for (int64_t i = 0; i != state.range(0); ++i) {
+        r +=
+            "#function item(name, value)\n"
+            "    <item name=\"${name}\" value=\"${value * 2 + 1}\"/>\n"
+            "#end\n"
+            "# count = 0\n"
+            "#for x: [1, 2, 3, 4, 5]\n"
+            "#if x % 2 == 0 && count < 10\n"
+            "${item(\"even\\t\" + string(x), x)}\n"
+            "#elif x == 3\n"
+            "${item(\"three\", {\"a\": 1.5, \"b\": [x, count]}[\"a\"])}\n"
+            "#else\n"
+            "# count += 1\n"
+            "#end\n"
+            "#end\n";
+    }
+    return r;
+}
+
+static void skeleton_parse(benchmark::State &state)
+{
+    ttlet text = make_template(state);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parse_skeleton(URL("none:"), text));
+    }
+    state.SetBytesProcessed(narrow_cast<int64_t>(state.iterations() * text.size()));
+}
+
+static void skeleton_parse_tokens(benchmark::State &state)
+{
+    ttlet text = make_template(state);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parseTokens(text));
+    }
+    state.SetBytesProcessed(narrow_cast<int64_t>(state.iterations() * text.size()));
+}
+
+static void skeleton_lazy_tokenizer(benchmark::State &state)
+{
+    ttlet text = make_template(state);
+
+    for (auto _ : state) {
+        for (auto tokens = lazy_tokenizer(text); *tokens != tokenizer_name_t::End; ++tokens) {
+            benchmark::DoNotOptimize(tokens->value);
+        }
+    }
+    state.SetBytesProcessed(narrow_cast<int64_t>(state.iterations() * text.size()));
+}
+
+static void skeleton_evaluate(benchmark::State &state)
+{
+    ttlet text = make_template(state);
+    ttlet skeleton = parse_skeleton(URL("none:"), text);
+
+    for (auto _ : state) {
+        auto context = formula_evaluation_context{};
+        benchmark::DoNotOptimize(skeleton->evaluate_output(context));
+    }
+}
+
+/** A function which does most of its work on local variables.
+ */
+static void skeleton_evaluate_locals(benchmark::State &state)
+{
+    ttlet text = std::string{
+        "locals\n"
+        "#function f(a, b, c)\n"
+        "# d = a + b\n"
+        "# e = d * c + a - b\n"
+        "#for i: [1, 2, 3, 4, 5, 6, 7, 8]\n"
+        "# d = d + e * i + a\n"
+        "#end\n"
+        "#return d + e\n"
+        "#end\n"
+        "#for x: [1, 2, 3, 4, 5, 6, 7, 8, 9, 10]\n"
+        "${f(x, 2, 3)}\n"
+        "#end\n"};
+    ttlet skeleton = parse_skeleton(URL("none:"), text);
+
+    for (auto _ : state) {
+        auto context = formula_evaluation_context{};
+        benchmark::DoNotOptimize(skeleton->evaluate_output(context));
+    }
+}
+
+// The argument is the number of times the template is repeated.
+BENCHMARK(skeleton_parse)->Arg(1)->Arg(100);
+BENCHMARK(skeleton_parse_tokens)->Arg(100);
+BENCHMARK(skeleton_lazy_tokenizer)->Arg(100);
+BENCHMARK(skeleton_evaluate)->Arg(100);
+BENCHMARK(skeleton_evaluate_locals);
@@ -15,6 +15,10 @@ struct skeleton_block_node final: skeleton_node {
     formula_post_process_context::function_type function;
     formula_post_process_context::function_type super_function;
 
+    /** The slots of the local variables.
+     */
+    formula_frame frame;
+
     skeleton_block_node(parse_location location, formula_post_process_context &context, std::unique_ptr<formula_node> name_expression) noexcept :
         skeleton_node(std::move(location)), name(name_expression->get_name())
     {
@@ -42,11 +46,13 @@ struct skeleton_block_node final: skeleton_node {
         function = context.get_function(name);
         tt_assert(function);
 
+        context.push_frame(frame);
         context.push_super(super_function);
         for (ttlet &child: children) {
             child->post_process(context);
         }
         context.pop_super();
+        context.pop_frame();
     }
 
     datum evaluate(formula_evaluation_context &context) override {
@@ -73,7 +79,7 @@ struct skeleton_block_node final: skeleton_node {
     }
 
     datum evaluate_call(formula_evaluation_context &context, datum::vector const &arguments) {
-        context.push();
+        context.push(&frame);
         auto tmp = evaluate_children(context, children);
         context.pop();
 
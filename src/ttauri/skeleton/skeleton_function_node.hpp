@@ -15,6 +15,10 @@ struct skeleton_function_node final: skeleton_node {
 
     formula_post_process_context::function_type super_function;
 
+    /** The slots of the local variables.
+     */
+    formula_frame frame;
+
     skeleton_function_node(parse_location location, formula_post_process_context &context, std::unique_ptr<formula_node> function_declaration_expression) noexcept :
         skeleton_node(std::move(location))
     {
@@ -49,11 +53,18 @@ struct skeleton_function_node final: skeleton_node {
             children.back()->left_align();
         }
 
+        // The arguments are the first local variables.
+        for (ttlet &argument_name: argument_names) {
+            frame.add(argument_name);
+        }
+
+        context.push_frame(frame);
         context.push_super(super_function);
         for (ttlet &child: children) {
             child->post_process(context);
         }
         context.pop_super();
+        context.pop_frame();
     }
 
     datum evaluate(formula_evaluation_context &context) override {
@@ -61,7 +72,7 @@ struct skeleton_function_node final: skeleton_node {
     }
 
     datum evaluate_call(formula_evaluation_context &context, datum::vector const &arguments) {
-        context.push();
+        context.push(&frame);
         if (std::ssize(argument_names) != std::ssize(arguments)) {
             throw operation_error("{}: Invalid number of arguments to function {}() expecting {} got {}.", location, name, argument_names.size(), arguments.size());
         }
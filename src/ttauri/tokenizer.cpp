@@ -3,6 +3,11 @@
 // (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
 
 #include "tokenizer.hpp"
+#include "architecture.hpp"
+#if TT_X86_64_V2
+#include <tmmintrin.h> // SSSE3
+#endif
+#include <bit>
 
 namespace tt {
 
@@ -756,12 +761,12 @@ constexpr std::array<tokenizer_transition_t,256> calculateTransitionTable_Operat
 {
 #define LAST_CHAR\
     transition.next = tokenizer_state_t::Initial;\
-    transition.action = tokenizer_action_t::Found | tokenizer_action_t::Read | tokenizer_action_t::Capture;\
+    transition.action = tokenizer_action_t::Found | tokenizer_action_t::Read | tokenizer_action_t::Capture | tokenizer_action_t::Start;\
     transition.name = tokenizer_name_t::Operator
 
 #define MORE_CHARS\
     transition.next = tokenizer_state_t::OperatorSecondChar;\
-    transition.action = tokenizer_action_t::Read | tokenizer_action_t::Capture;
+    transition.action = tokenizer_action_t::Read | tokenizer_action_t::Capture | tokenizer_action_t::Start;
 
     std::array<tokenizer_transition_t,256> r{};
 
@@ -800,7 +805,8 @@ constexpr std::array<tokenizer_transition_t,256> calculateTransitionTable_Operat
         default:
             // If we don't recognize the operator, it means this character is invalid.
             transition.next = tokenizer_state_t::Initial;
-            transition.action = tokenizer_action_t::Read | tokenizer_action_t::Capture;
+            transition.action =
+                tokenizer_action_t::Found | tokenizer_action_t::Read | tokenizer_action_t::Capture | tokenizer_action_t::Start;
             transition.name = tokenizer_name_t::ErrorInvalidCharacter;
         }
 
@@ -954,67 +960,224 @@ constexpr transitionTable_t buildTransitionTable()
 
 constexpr transitionTable_t transitionTable = buildTransitionTable();
 
+/** A run of characters which the tokenizer consumes without leaving a state.
+ *
+ * In these runs each character is read, and optionally captured, with a single column
+ * increment; like white space, the characters of a name or the body of a comment or string.
+ * Such a run is consumed all at once, instead of one transition at a time.
+ */
+struct tokenizer_run_t {
+    /** Bit (c >> 4) of entry (c & 0xf) is set when the ASCII character c is part of a run.
+     */
+    std::array<uint8_t, 16> ascii_bitmap;
+
+    /** All non-ASCII characters are part of a run.
+     */
+    bool non_ascii;
+
+    /** The characters of a run are captured.
+     */
+    bool capture;
+
+    [[nodiscard]] constexpr bool empty() const noexcept
+    {
+        for (ttlet row : ascii_bitmap) {
+            if (row != 0) {
+                return false;
+            }
+        }
+        return not non_ascii;
+    }
 
-struct tokenizer {
-    using iterator = typename std::string_view::const_iterator;
+    [[nodiscard]] constexpr bool contains(char c) const noexcept
+    {
+        ttlet c_ = static_cast<uint8_t>(c);
+        if (c_ < 0x80) {
+            return ((ascii_bitmap[c_ & 0xf] >> (c_ >> 4)) & 1) != 0;
+        } else {
+            return non_ascii;
+        }
+    }
+};
 
-    tokenizer_state_t state;
-    iterator index;
-    iterator end;
-    parse_location location;
-    parse_location captureLocation;
+constexpr tokenizer_run_t calculateRun(tokenizer_state_t state)
+{
+    ttlet loops = [state](uint16_t i, tokenizer_action_t action) {
+        ttlet &transition = transitionTable[get_offset(state, static_cast<char>(i))];
+        return transition.next == state and transition.action == action and transition.c == static_cast<char>(i);
+    };
 
-    tokenizer(iterator begin, iterator end) :
-        state(tokenizer_state_t::Initial), index(begin), end(end) {}
+    ttlet read = tokenizer_action_t::Read;
+    ttlet read_capture = tokenizer_action_t::Read | tokenizer_action_t::Capture;
 
-    /*! Parse a token.
-    */
-    [[nodiscard]] token_t getNextToken() {
-        auto token = token_t{};
+    tokenizer_run_t r{};
+    for (uint16_t i = 1; i < 256; i++) {
+        r.capture |= loops(i, read_capture);
+    }
 
-        auto transition = tokenizer_transition_t{};
-        while (index != end) {
-            transition = transitionTable[get_offset(state, *index)];
-            state = transition.next;
+    ttlet action = r.capture ? read_capture : read;
+    for (uint16_t i = 1; i < 0x80; i++) {
+        if (loops(i, action)) {
+            r.ascii_bitmap[i & 0xf] |= static_cast<uint8_t>(1 << (i >> 4));
+        }
+    }
 
-            auto action = transition.action;
-            if (action >= tokenizer_action_t::Start) {
-                token.location = location;
-                token.value.clear();
-            }
+    r.non_ascii = true;
+    for (uint16_t i = 0x80; i < 256; i++) {
+        r.non_ascii &= loops(i, action);
+    }
+    return r;
+}
 
-            if (action >= tokenizer_action_t::Capture) {
-                token.value += transition.c;
-            }
+constexpr std::array<tokenizer_run_t, NR_TOKENIZER_STATES> calculateRunTable()
+{
+    std::array<tokenizer_run_t, NR_TOKENIZER_STATES> r{};
+    for (size_t i = 0; i < r.size(); i++) {
+        r[i] = calculateRun(static_cast<tokenizer_state_t>(i));
+    }
+    return r;
+}
+
+constexpr std::array<tokenizer_run_t, NR_TOKENIZER_STATES> runTable = calculateRunTable();
+
+/** Find the end of a run of characters.
+ *
+ * @param run The characters of the run.
+ * @param first The first character of the run.
+ * @param last The end of the text.
+ * @return The first character which is not part of the run.
+ */
+[[nodiscard]] static char const *find_end_of_run(tokenizer_run_t const &run, char const *first, char const *last) noexcept
+{
+#if TT_X86_64_V2
+    // The low nibble of each character selects a row from the bitmap, the high nibble selects the bit in the row.
+    // Non-ASCII characters select an empty row and an empty bit.
+    ttlet bitmap = _mm_loadu_si128(reinterpret_cast<__m128i const *>(run.ascii_bitmap.data()));
+    ttlet bit_select = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+    ttlet low_nibble_mask = _mm_set1_epi8(0xf);
+
+    for (; last - first >= 16; first += 16) {
+        ttlet chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(first));
+        ttlet row = _mm_shuffle_epi8(bitmap, chunk);
+        ttlet bit = _mm_shuffle_epi8(bit_select, _mm_and_si128(_mm_srli_epi16(chunk, 4), low_nibble_mask));
+        ttlet in_run = _mm_and_si128(row, bit);
+        auto outside_run = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(in_run, _mm_setzero_si128())));
+        if (run.non_ascii) {
+            outside_run &= ~static_cast<unsigned int>(_mm_movemask_epi8(chunk));
+        }
 
-            if (action >= tokenizer_action_t::Read) {
-                if (action >= tokenizer_action_t::LineFeed) {
-                    location.increment_line();
-                } else if (action >= tokenizer_action_t::Tab) {
-                    location.tab_column();
-                } else {
-                    location.increment_column();
-                }
-                ++index;
+        if (outside_run != 0) {
+            return first + std::countr_zero(outside_run);
+        }
+    }
+#endif
+
+    while (first != last and run.contains(*first)) {
+        ++first;
+    }
+    return first;
+}
+
+
+/** Parse the next token.
+ *
+ * @param state The state of the tokenizer, between tokens.
+ * @param index The current character in the text.
+ * @param end The end of the text.
+ * @param location The location of the current character.
+ * @param token_location [out] The location of the token found.
+ * @param capture [out] The characters captured for the token found.
+ * @return The name of the token found.
+ */
+[[nodiscard]] static tokenizer_name_t parse_token(
+    tokenizer_state_t &state,
+    char const *&index,
+    char const *end,
+    parse_location &location,
+    parse_location &token_location,
+    detail::tokenizer_capture &capture) noexcept
+{
+    capture.start(index);
+
+    auto transition = tokenizer_transition_t{};
+    while (index != end) {
+        if (ttlet &run = runTable[static_cast<size_t>(state)]; run.contains(*index)) {
+            ttlet run_last = find_end_of_run(run, index, end);
+            if (run.capture) {
+                capture.append(index, run_last);
+            }
+            location.increment_column(narrow_cast<int>(run_last - index));
+            index = run_last;
+            if (index == end) {
+                break;
             }
+        }
+
+        transition = transitionTable[get_offset(state, *index)];
+        state = transition.next;
+
+        auto action = transition.action;
+        if (action >= tokenizer_action_t::Start) {
+            token_location = location;
+            // When the character is read without being captured, like an opening quote, the capture starts after it.
+            ttlet skip = action >= tokenizer_action_t::Read and not (action >= tokenizer_action_t::Capture);
+            capture.start(skip ? index + 1 : index);
+        }
 
-            if (action >= tokenizer_action_t::Found) {
-                token.name = transition.name;
-                return token;
+        if (action >= tokenizer_action_t::Capture) {
+            capture.append(transition.c);
+        }
+
+        if (action >= tokenizer_action_t::Read) {
+            if (action >= tokenizer_action_t::LineFeed) {
+                location.increment_line();
+            } else if (action >= tokenizer_action_t::Tab) {
+                location.tab_column();
+            } else {
+                location.increment_column();
             }
+            ++index;
         }
 
-        // Complete the token at the current state. Or an end-token at the initial state.
-        if (state == tokenizer_state_t::Initial) {
-            // Mark the current offset as the position of the end-token.
-            token.location = location;
-            token.value.clear();
+        if (action >= tokenizer_action_t::Found) {
+            return transition.name;
         }
+    }
 
-        transition = transitionTable[get_offset(state)];
-        state = transition.next;
+    // Complete the token at the current state. Or an end-token at the initial state.
+    if (state == tokenizer_state_t::Initial) {
+        // Mark the current offset as the position of the end-token.
+        token_location = location;
+        capture.start(index);
+    }
+
+    transition = transitionTable[get_offset(state)];
+    state = transition.next;
+    return transition.name;
+}
+
+struct tokenizer {
+    tokenizer_state_t state;
+    char const *index;
+    char const *end;
+    parse_location location;
+    detail::tokenizer_capture capture;
+
+    tokenizer(std::string_view text, parse_location location = {}) :
+        state(tokenizer_state_t::Initial),
+        index(text.data()),
+        end(text.data() + text.size()),
+        location(std::move(location)),
+        capture(text)
+    {
+    }
 
-        token.name = transition.name;
+    /*! Parse a token.
+    */
+    [[nodiscard]] token_t getNextToken() {
+        auto token = token_t{};
+        token.name = parse_token(state, index, end, location, token.location, capture);
+        token.value = capture.view();
         return token;
     }
 
@@ -1036,12 +1199,45 @@ struct tokenizer {
 
 [[nodiscard]] std::vector<token_t> parseTokens(std::string_view::const_iterator first, std::string_view::const_iterator last) noexcept
 {
-    return tokenizer(first, last).getTokens();
+    return tokenizer(std::string_view{first, last}).getTokens();
+}
+
+[[nodiscard]] token_t
+parseToken(std::string_view::const_iterator first, std::string_view::const_iterator last, parse_location location) noexcept
+{
+    return tokenizer(std::string_view{first, last}, std::move(location)).getNextToken();
 }
 
 [[nodiscard]] std::vector<token_t> parseTokens(std::string_view text) noexcept
 {
-    return parseTokens(text.cbegin(), text.cend());
+    return tokenizer(text).getTokens();
+}
+
+lazy_tokenizer::lazy_tokenizer(std::string_view text, parse_location location) noexcept :
+    _state(tokenizer_state_t::Initial),
+    _index(text.data()),
+    _end(text.data() + text.size()),
+    _location(std::move(location)),
+    _capture(text),
+    _copies(),
+    _token()
+{
+    ++(*this);
+}
+
+lazy_tokenizer &lazy_tokenizer::operator++() noexcept
+{
+    if (_token.name == tokenizer_name_t::End) {
+        return *this;
+    }
+
+    _token.name = parse_token(_state, _index, _end, _location, _token.location, _capture);
+    if (_capture.is_copy) {
+        _token.value = _copies.emplace_back(_capture.buffer);
+    } else {
+        _token.value = _capture.view();
+    }
+    return *this;
 }
 
 }
@@ -18,6 +18,7 @@
 #include <string_view>
 #include <charconv>
 #include <array>
+#include <deque>
 
 namespace tt {
 
@@ -286,6 +287,218 @@ struct parse_result {
 [[nodiscard]] std::vector<token_t>
 parseTokens(std::string_view::const_iterator first, std::string_view::const_iterator last) noexcept;
 
+/** Parse a single token from a text.
+ *
+ * @param first The start of the text.
+ * @param last The end of the text.
+ * @param location The location of `first`.
+ * @return The first token found in the text; or an End-token when there are no tokens.
+ */
+[[nodiscard]] token_t parseToken(
+    std::string_view::const_iterator first,
+    std::string_view::const_iterator last,
+    parse_location location = {}) noexcept;
+
+/** A token which refers to the text it was parsed from.
+ *
+ * The value is a view into the text. Only when the value differs from the text,
+ * like a string literal with escape sequences, the value is a view into a buffer
+ * owned by the `lazy_tokenizer` that produced the token.
+ */
+struct token_view {
+    tokenizer_name_t name = tokenizer_name_t::NotAssigned;
+    std::string_view value = {};
+    parse_location location = {};
+
+    explicit operator double() const
+    {
+        try {
+            return std::stod(std::string{value});
+
+        } catch (...) {
+            throw parse_error("Could not convert token {} to double", *this);
+        }
+    }
+
+    template<std::integral T>
+    explicit operator T() const
+    {
+        try {
+            return tt::from_string<T>(value);
+
+        } catch (...) {
+            throw parse_error("Could not convert token {} to {}", *this, typeid(T).name());
+        }
+    }
+
+    explicit operator std::string() const noexcept
+    {
+        return std::string{value};
+    }
+
+    std::string repr() const noexcept
+    {
+        std::string r = to_const_string(name);
+        if (value.size() > 0) {
+            r += '\"';
+            r += value;
+            r += '\"';
+        }
+        return r;
+    }
+
+    friend inline std::ostream &operator<<(std::ostream &lhs, token_view const &rhs)
+    {
+        return lhs << rhs.repr();
+    }
+
+    [[nodiscard]] friend bool operator==(token_view const &lhs, tokenizer_name_t const &rhs) noexcept
+    {
+        return lhs.name == rhs;
+    }
+
+    [[nodiscard]] friend bool operator==(token_view const &lhs, const char *rhs) noexcept
+    {
+        return lhs.value == rhs;
+    }
+};
+
+enum class tokenizer_state_t : uint8_t;
+
+namespace detail {
+
+/** The characters captured for a token.
+ *
+ * The capture is a slice of the text for as long as each captured character is the
+ * next character in the text. When this is no longer the case, for example after an escape
+ * sequence or a digit separator, the captured characters are copied into a buffer.
+ */
+struct tokenizer_capture {
+    char const *text_first;
+    char const *text_last;
+    char const *first;
+    char const *last;
+    bool is_copy;
+    std::string buffer;
+
+    tokenizer_capture(std::string_view text) noexcept :
+        text_first(text.data()),
+        text_last(text.data() + text.size()),
+        first(text_first),
+        last(text_first),
+        is_copy(false),
+        buffer()
+    {
+    }
+
+    void start(char const *ptr) noexcept
+    {
+        first = last = ptr;
+        is_copy = false;
+    }
+
+    void append(char c) noexcept
+    {
+        if (not is_copy) {
+            if (last != text_last and *last == c) {
+                ++last;
+                return;
+            } else if (first == last and first != text_first and first[-1] == c) {
+                // A character which was read before the capture was started.
+                --first;
+                return;
+            }
+
+            buffer.assign(first, last);
+            is_copy = true;
+        }
+        buffer += c;
+    }
+
+    /** Capture a run of characters from the text.
+     */
+    void append(char const *run_first, char const *run_last) noexcept
+    {
+        if (not is_copy) {
+            if (last == run_first) {
+                last = run_last;
+                return;
+            }
+
+            buffer.assign(first, last);
+            is_copy = true;
+        }
+        buffer.append(run_first, run_last);
+    }
+
+    [[nodiscard]] std::string_view view() const noexcept
+    {
+        if (is_copy) {
+            return buffer;
+        } else {
+            return {first, narrow_cast<size_t>(last - first)};
+        }
+    }
+};
+
+} // namespace detail
+
+/** A pull-based tokenizer.
+ *
+ * The tokenizer produces one token at a time while the parser consumes them, the token values
+ * are views into the text without allocating memory. The tokens produced remain valid for as
+ * long as both the text and the tokenizer are alive.
+ *
+ * The tokenizer recognizes the same tokens as `parseTokens()`.
+ */
+class lazy_tokenizer {
+public:
+    lazy_tokenizer(lazy_tokenizer const &) = delete;
+    lazy_tokenizer(lazy_tokenizer &&) noexcept = default;
+    lazy_tokenizer &operator=(lazy_tokenizer const &) = delete;
+    lazy_tokenizer &operator=(lazy_tokenizer &&) noexcept = default;
+
+    /** Start tokenizing a text.
+     *
+     * @param text The text to tokenize, it must outlive the tokenizer.
+     * @param location The location of the start of the text.
+     * @post The first token is available.
+     */
+    lazy_tokenizer(std::string_view text, parse_location location = {}) noexcept;
+
+    /** The current token.
+     */
+    [[nodiscard]] token_view const &operator*() const noexcept
+    {
+        return _token;
+    }
+
+    [[nodiscard]] token_view const *operator->() const noexcept
+    {
+        return &_token;
+    }
+
+    /** Parse the next token.
+     *
+     * After the End-token is reached, the End-token is returned forever.
+     */
+    lazy_tokenizer &operator++() noexcept;
+
+private:
+    tokenizer_state_t _state;
+    char const *_index;
+    char const *_end;
+    parse_location _location;
+    detail::tokenizer_capture _capture;
+
+    /** Values of tokens which are not a slice of the text.
+     * A deque is used so that views into earlier values remain valid.
+     */
+    std::deque<std::string> _copies;
+
+    token_view _token;
+};
+
 } // namespace tt
 
 namespace std {
@@ -298,5 +511,12 @@ struct std::formatter<tt::token_t, CharT> : std::formatter<std::string_view, Cha
     }
 };
 
+template<typename CharT>
+struct std::formatter<tt::token_view, CharT> : std::formatter<std::string_view, CharT> {
+    auto format(tt::token_view const &t, auto &fc)
+    {
+        return std::formatter<std::string_view, CharT>::format(t.repr(), fc);
+    }
+};
 
 } // namespace std
@@ -324,6 +324,18 @@ TEST(Tokenizer, ParseSlash) {
     ASSERT_TOKEN_EQ(tokens[3], End, "");
 }
 
+TEST(Tokenizer, ParseInvalidCharacter) {
+    auto str = "x '* 2";
+    auto v = std::string_view(str);
+    auto tokens = parseTokens(v);
+    ASSERT_TOKEN_EQ(tokens[0], Name, "x");
+    ASSERT_TOKEN_EQ(tokens[1], ErrorInvalidCharacter, "'");
+    ASSERT_EQ(tokens[1].location.column(), 3);
+    ASSERT_TOKEN_EQ(tokens[2], Operator, "*");
+    ASSERT_TOKEN_EQ(tokens[3], IntegerLiteral, "2");
+    ASSERT_TOKEN_EQ(tokens[4], End, "");
+}
+
 
 TEST(Tokenizer, ParseWhitespace) {
     auto str = "++     ++";
@@ -382,3 +394,87 @@ TEST(Tokenizer, ParseFQName) {
     ASSERT_TOKEN_EQ(tokens[3], End, "");
 }
 
+
+TEST(Tokenizer, LazyTokenizer) {
+    auto texts = std::array{
+        "++12345++ 0x1_000 1'000.5 2020-01-10 12:30 1-2 3:a",
+        "foo(bar, \"baz\\n\", \"\", \"a\\\"b\") /* comment */ // comment\n x.y-z",
+        "\"\"\"block \"quoted\" string\"\"\" + 'c'",
+        "\"unterminated",
+        ""};
+
+    for (ttlet text : texts) {
+        ttlet v = std::string_view(text);
+        ttlet expected = parseTokens(v);
+
+        auto tokens = lazy_tokenizer(v);
+        auto values = std::vector<std::string_view>{};
+        for (ttlet &expected_token : expected) {
+            ASSERT_EQ(tokens->name, expected_token.name);
+            ASSERT_EQ(tokens->value, expected_token.value);
+            ASSERT_EQ(tokens->location.line(), expected_token.location.line());
+            ASSERT_EQ(tokens->location.column(), expected_token.location.column());
+            values.push_back(tokens->value);
+            ++tokens;
+        }
+        ASSERT_EQ(*tokens, tokenizer_name_t::End);
+
+        // Values of earlier tokens remain valid.
+        for (size_t i = 0; i != expected.size(); ++i) {
+            ASSERT_EQ(values[i], expected[i].value);
+        }
+    }
+}
+
+TEST(Tokenizer, LazyTokenizerZeroCopy) {
+    auto str = "foo + \"bar\" * 12 - \"b\\az\"";
+    auto v = std::string_view(str);
+    auto tokens = lazy_tokenizer(v);
+
+    auto is_view_of_text = [&](token_view const &token) {
+        return token.value.data() >= v.data() and token.value.data() + token.value.size() <= v.data() + v.size();
+    };
+
+    ASSERT_EQ(*tokens, "foo");
+    ASSERT_TRUE(is_view_of_text(*tokens));
+    ++tokens;
+    ASSERT_EQ(*tokens, "+");
+    ASSERT_TRUE(is_view_of_text(*tokens));
+    ++tokens;
+    ASSERT_EQ(*tokens, "bar");
+    ASSERT_TRUE(is_view_of_text(*tokens));
+    ++tokens;
+    ASSERT_EQ(*tokens, "*");
+    ++tokens;
+    ASSERT_EQ(*tokens, "12");
+    ASSERT_TRUE(is_view_of_text(*tokens));
+    ++tokens;
+    ASSERT_EQ(*tokens, "-");
+    ASSERT_TRUE(is_view_of_text(*tokens));
+    ++tokens;
+    // The escape sequence requires a copy.
+    ASSERT_EQ(*tokens, "b\az");
+    ASSERT_FALSE(is_view_of_text(*tokens));
+    ++tokens;
+    ASSERT_EQ(*tokens, tokenizer_name_t::End);
+}
+
+TEST(Tokenizer, ParseLongRuns) {
+    auto str =
+        "                                    a_very_long_identifier_name_which_spans_chunks\n"
+        "/* A block comment with non-ASCII characters: \xc3\xa9\xe2\x82\xac, longer than a chunk. */\n"
+        "\"A string literal with non-ASCII characters: \xc3\xa9\xe2\x82\xac, and an escape\\n.\" 1234567890123456789";
+    auto v = std::string_view(str);
+    auto tokens = parseTokens(v);
+    ASSERT_TOKEN_EQ(tokens[0], Name, "a_very_long_identifier_name_which_spans_chunks");
+    ASSERT_EQ(tokens[0].location.line(), 1);
+    ASSERT_EQ(tokens[0].location.column(), 37);
+    ASSERT_TOKEN_EQ(
+        tokens[1], StringLiteral, "A string literal with non-ASCII characters: \xc3\xa9\xe2\x82\xac, and an escape\n.");
+    ASSERT_EQ(tokens[1].location.line(), 3);
+    ASSERT_EQ(tokens[1].location.column(), 1);
+    ASSERT_TOKEN_EQ(tokens[2], IntegerLiteral, "1234567890123456789");
+    ASSERT_EQ(tokens[2].location.line(), 3);
+    ASSERT_EQ(tokens[2].location.column(), 71);
+    ASSERT_TOKEN_EQ(tokens[3], End, "");
+}
@@ -0,0 +1,114 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "tree_digest.hpp"
+#include "file.hpp"
+#include "file_view.hpp"
+#include "glob.hpp"
+#include "codec/SHA2.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace tt {
+
+/** A file that is part of the tree.
+ */
+struct tree_digest_file {
+    URL url;
+
+    /** The path relative to the base directory of the glob.
+     */
+    std::string name;
+
+    size_t size = 0;
+    bstring hash;
+    std::exception_ptr exception;
+
+    void calculate() noexcept
+    {
+        try {
+            auto h = SHA256{};
+            size = file::file_size(url);
+            if (size == 0) {
+                // An empty file can not be mapped into memory.
+                h.add(bstring_view{});
+            } else {
+                ttlet view = file_view{url};
+                h.add(view.bytes());
+            }
+            hash = h.get_bytes();
+
+        } catch (...) {
+            exception = std::current_exception();
+        }
+    }
+};
+
+[[nodiscard]] bstring tree_digest(URL const &glob, ssize_t nr_threads)
+{
+    ttlet base_path = basePathOfGlob(glob.path());
+
+    auto files = std::vector<tree_digest_file>{};
+    for (auto &url : glob.urlsByScanningWithGlobPattern()) {
+        auto name = url.path();
+        if (name.starts_with(base_path)) {
+            name.erase(0, base_path.size());
+            if (name.starts_with('/')) {
+                name.erase(0, 1);
+            }
+        }
+        files.push_back(tree_digest_file{std::move(url), std::move(name)});
+    }
+
+    // The order of scanning directories depends on the operating system.
+    std::sort(files.begin(), files.end(), [](ttlet &lhs, ttlet &rhs) {
+        return lhs.name < rhs.name;
+    });
+
+    if (nr_threads <= 0) {
+        nr_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    nr_threads = std::min(nr_threads, std::ssize(files));
+
+    // Each thread, including the current thread, takes the next file that has not been hashed yet,
+    // so that a few large files do not leave the other threads idle.
+    auto next_file = std::atomic<size_t>{0};
+    ttlet worker = [&files, &next_file] {
+        for (auto i = next_file.fetch_add(1, std::memory_order::relaxed); i < files.size();
+             i = next_file.fetch_add(1, std::memory_order::relaxed)) {
+            files[i].calculate();
+        }
+    };
+
+    {
+        auto threads = std::vector<std::jthread>{};
+        for (ssize_t i = 1; i < nr_threads; ++i) {
+            threads.emplace_back(worker);
+        }
+        worker();
+    }
+
+    auto digest = SHA256{};
+    for (ttlet &file : files) {
+        if (file.exception) {
+            std::rethrow_exception(file.exception);
+        }
+
+        auto size_bytes = std::array<std::byte, 8>{};
+        for (int i = 0; i != 8; ++i) {
+            size_bytes[i] = static_cast<std::byte>(static_cast<uint64_t>(file.size) >> (7 - i) * 8);
+        }
+
+        digest.add(std::string_view{file.name.c_str(), file.name.size() + 1}, false);
+        digest.add(std::span<std::byte const>{size_bytes}, false);
+        digest.add(file.hash, false);
+    }
+    digest.add(bstring_view{});
+    return digest.get_bytes();
+}
+
+} // namespace tt
@@ -0,0 +1,33 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include "URL.hpp"
+#include "byte_string.hpp"
+#include "required.hpp"
+
+namespace tt {
+
+/** Calculate a digest over the contents of the files that match a glob pattern.
+ *
+ * Each file is mapped into memory with `file_view` and hashed with SHA-256; the files are
+ * divided over a number of threads. The digest is the SHA-256 of the following, for each file
+ * in order of path:
+ *  - The path of the file relative to the base directory of the glob, terminated by a nul.
+ *  - The size of the file, as a 64 bit big-endian integer.
+ *  - The SHA-256 of the contents of the file.
+ *
+ * The digest changes when a file is added, removed, renamed or modified, which makes it
+ * useful for validating a cache of the files. Since the paths are relative, the digest
+ * does not change when the directory is moved as a whole.
+ *
+ * @param glob A file: URL with a glob pattern, see `URL::urlsByScanningWithGlobPattern()`.
+ * @param nr_threads The number of threads to use, zero for one thread per CPU.
+ * @return The 32 byte digest.
+ * @throw io_error When a file could not be read.
+ */
+[[nodiscard]] bstring tree_digest(URL const &glob, ssize_t nr_threads = 0);
+
+} // namespace tt
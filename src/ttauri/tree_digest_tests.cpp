@@ -0,0 +1,50 @@
+// Copyright Take Vos 2021.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at https://www.boost.org/LICENSE_1_0.txt)
+
+#include "ttauri/tree_digest.hpp"
+#include "ttauri/file_view.hpp"
+#include "ttauri/codec/SHA2.hpp"
+#include "ttauri/required.hpp"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace tt;
+
+TEST(tree_digest, single_file)
+{
+    ttlet glob = URL::urlFromExecutableDirectory() / "file_view.t*";
+
+    ttlet view = file_view(URL::urlFromExecutableDirectory() / "file_view.txt");
+    auto file_hash = SHA256{};
+    file_hash.add(view.bytes());
+
+    ttlet size = static_cast<uint64_t>(view.size());
+    auto size_bytes = bstring{};
+    for (int i = 7; i >= 0; --i) {
+        size_bytes += static_cast<std::byte>(size >> i * 8);
+    }
+
+    auto expected = SHA256{};
+    expected.add(std::string_view{"file_view.txt\0", 14}, false);
+    expected.add(size_bytes, false);
+    expected.add(file_hash.get_bytes());
+
+    ASSERT_EQ(tree_digest(glob), expected.get_bytes());
+}
+
+TEST(tree_digest, threads)
+{
+    ttlet directory = URL::urlFromExecutableDirectory() / "tree_digest";
+    ttlet glob = directory / "**" / "*.txt";
+
+    ttlet digest = tree_digest(glob, 1);
+    ASSERT_EQ(digest.size(), 32);
+    ASSERT_EQ(tree_digest(glob, 4), digest);
+    ASSERT_EQ(tree_digest(glob), digest);
+
+    ASSERT_NE(tree_digest(directory / "*.txt"), digest);
+    ASSERT_NE(tree_digest(directory / "**" / "*"), digest);
+}
@@ -27,15 +27,16 @@ void icon_widget::init() noexcept
     if (super::constrain(display_time_point, need_reconstrain)) {
         ttlet &icon_ = *icon;
 
-        if (holds_alternative<std::monostate>(icon_)) {
+        if (icon_.is_loading()) {
+            // The image is still being decoded by the png_loader, retry on the next frame.
             _icon_type = icon_type::no;
             _glyph = {};
             _pixmap_hash = 0;
             _pixmap_backing = {};
-            // For uniform scaling issues, make sure the size is not zero.
             _icon_bounding_box = {};
+            _request_constrain = true;
 
-        } else if (holds_alternative<pixel_map<sfloat_rgba16>>(icon_)) {
+        } else if (ttlet pixmap = icon_.pixmap()) {
             // XXX very ugly, please fix.
             // This requires access to internals of vulkan, wtf.
             ttlet lock = std::scoped_lock(gfx_system_mutex);
@@ -43,8 +44,6 @@ void icon_widget::init() noexcept
             _icon_type = icon_type::pixmap;
             _glyph = {};
 
-            ttlet &pixmap = get<pixel_map<sfloat_rgba16>>(icon_);
-
             gfx_device_vulkan *device = nullptr;
             if (window.surface) {
                 device = narrow_cast<gfx_device_vulkan *>(window.surface->device());
@@ -58,11 +57,11 @@ void icon_widget::init() noexcept
                 _icon_bounding_box = {};
                 _request_constrain = true;
 
-            } else if (pixmap.hash() != _pixmap_hash) {
-                _pixmap_hash = pixmap.hash();
-                _pixmap_backing = device->imagePipeline->makeImage(pixmap.width(), pixmap.height());
+            } else if (pixmap->hash() != _pixmap_hash) {
+                _pixmap_hash = pixmap->hash();
+                _pixmap_backing = device->imagePipeline->makeImage(pixmap->width(), pixmap->height());
 
-                _pixmap_backing.upload(pixmap);
+                _pixmap_backing.upload(*pixmap);
                 _icon_bounding_box = aarectangle{
                     extent2{narrow_cast<float>(_pixmap_backing.width_in_px), narrow_cast<float>(_pixmap_backing.height_in_px)}};
             }
@@ -77,7 +76,13 @@ void icon_widget::init() noexcept
                 scale(pipeline_SDF::device_shared::getBoundingBox(_glyph), theme::global(theme_text_style::label).scaled_size());
 
         } else {
-            tt_no_default();
+            // No icon, or an image which could not be decoded.
+            _icon_type = icon_type::no;
+            _glyph = {};
+            _pixmap_hash = 0;
+            _pixmap_backing = {};
+            // For uniform scaling issues, make sure the size is not zero.
+            _icon_bounding_box = {};
         }
 
         _minimum_size = {0.0f, 0.0f};